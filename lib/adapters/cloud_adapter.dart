@@ -51,6 +51,10 @@ abstract class ICloudAdapter {
   // ===========================================================================
 
   /// Performs a fast, server-side copy within the same cloud service.
+  ///
+  /// Returns the new file's ID once it exists, or null if the provider refused the copy
+  /// (nothing was created, so the caller may fall back to streaming the bytes). Throws if
+  /// the copy was accepted but its outcome is unknown.
   Future<String?> copyFileNative({
     required String sourceFileId,
     required String destinationParentId,
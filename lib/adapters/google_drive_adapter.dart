@@ -992,7 +992,9 @@ class GoogleDriveAdapter implements ICloudAdapter {
       }
 
       return response.id;
-    } catch (e) {
+    } on drive.ApiRequestError {
+      // Drive answered and refused the copy. Anything else (e.g. the connection dropping
+      // mid-request) propagates: the copy may have been made, and a fallback could duplicate it
       return null;
     }
   }
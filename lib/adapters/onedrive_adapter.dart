@@ -1066,12 +1066,19 @@ class OneDriveAdapter implements ICloudAdapter {
   // NATIVE COPY (Same-Provider Only)
   // ===========================================================================
 
+  /// Copies the file on OneDrive's side and returns the new item's id
+  ///
+  /// Returns null if OneDrive refused the copy (nothing was created). OneDrive copies
+  /// asynchronously, so an accepted copy is followed through its monitor URL until the
+  /// new item exists; this throws if the copy was accepted but did not finish in time
+  /// or its outcome could not be read, since a fallback copy could then duplicate it.
   @override
   Future<String?> copyFileNative({
     required String sourceFileId,
     required String destinationParentId,
     String? newName,
   }) async {
+    final http.Response response;
     try {
 
       // Get source file metadata to get the name
@@ -1082,7 +1089,7 @@ class OneDriveAdapter implements ICloudAdapter {
       // POST /items/{item-id}/copy
       final copyEndpoint = "$_baseUrl/items/$sourceFileId/copy";
 
-      final response = await http.post(
+      response = await http.post(
         Uri.parse(copyEndpoint),
         headers: {
           'Authorization': 'Bearer ${await _getAccessToken()}',
@@ -1095,19 +1102,74 @@ class OneDriveAdapter implements ICloudAdapter {
           "name": finalName
         }),
       );
-
-      if (response.statusCode == 202 || response.statusCode == 200) {
-        // OneDrive returns 202 Accepted for async copy
-        // The file will be copied in the background
-        return sourceFileId;
-      } else if (response.statusCode == 201) {
-        return null;
-      } else {
-        return null;
-      }
     } catch (e) {
       return null;
     }
+
+    if (response.statusCode == 200 || response.statusCode == 201) {
+      // Copied synchronously: the body is the new item
+      return (jsonDecode(response.body) as Map<String, dynamic>)['id'] as String?;
+    }
+    if (response.statusCode != 202) {
+      return null;
+    }
+
+    // 202 Accepted: the copy runs in the background, tracked by the monitor URL
+    final monitorUrl = response.headers['location'];
+    if (monitorUrl == null) {
+      throw Exception("OneDrive: copy accepted without a monitor URL");
+    }
+    return await _waitForCopy(monitorUrl);
+  }
+
+  /// Poll an asynchronous copy's monitor URL until the new item's id is known
+  ///
+  /// The monitor URL is pre-authenticated, so no access token is sent. Returns null if
+  /// OneDrive reports the copy as failed; throws if it is still running after [timeout].
+  Future<String?> _waitForCopy(
+    String monitorUrl, {
+    Duration timeout = const Duration(minutes: 30),
+  }) async {
+    final deadline = DateTime.now().add(timeout);
+    var delay = const Duration(milliseconds: 500);
+
+    while (true) {
+      final request = http.Request('GET', Uri.parse(monitorUrl))..followRedirects = false;
+      final response = await http.Response.fromStream(await request.send());
+
+      if (response.statusCode == 303) {
+        // Finished: redirected to the new item (.../items/{id})
+        final location = response.headers['location'] ?? '';
+        final match = RegExp(r'/items/([^/?]+)').firstMatch(location);
+        if (match != null) {
+          return Uri.decodeComponent(match.group(1)!);
+        }
+      }
+      if (response.statusCode != 200 && response.statusCode != 202 && response.statusCode != 303) {
+        throw Exception("OneDrive: copy status unavailable (${response.statusCode})");
+      }
+
+      final status = response.body.isEmpty
+          ? const <String, dynamic>{}
+          : jsonDecode(response.body) as Map<String, dynamic>;
+      switch (status['status']) {
+        case 'completed':
+          final resourceId = status['resourceId'] as String?;
+          if (resourceId != null) {
+            return resourceId;
+          }
+          break;
+        case 'failed':
+          return null;
+      }
+
+      if (DateTime.now().isAfter(deadline)) {
+        throw Exception("OneDrive: copy still running after ${timeout.inMinutes} minutes");
+      }
+      await Future.delayed(delay);
+      // Back off up to 5s between polls
+      delay = Duration(milliseconds: min(delay.inMilliseconds * 2, 5000));
+    }
   }
 
   // ===========================================================================
@@ -1765,19 +1765,18 @@ class TaskService extends ChangeNotifier {
     if (!isCrossProviderCopy) {
       // SAME PROVIDER: Use native copy (instant, no bandwidth)
       
-      try {
-        final newFileId = await destAdapter.copyFileNative(
-          sourceFileId: sourceFileId,
-          destinationParentId: destinationParentId,
-          newName: newName,
-        );
-        
-        if (newFileId != null) {
-          _updateProgressTimeBased(task, 1.0);
-          return;
-        } else {
-        }
-      } catch (e) {
+      // A null result means the provider refused the copy, so stream it instead. A throw
+      // means the copy may already have been accepted: let it fail the task rather than
+      // streaming a second copy
+      final newFileId = await destAdapter.copyFileNative(
+        sourceFileId: sourceFileId,
+        destinationParentId: destinationParentId,
+        newName: newName,
+      );
+
+      if (newFileId != null) {
+        _updateProgressTimeBased(task, 1.0);
+        return;
       }
     }
     
@@ -217,6 +217,32 @@ class UnifiedCopyService {
     // Validate chunk size
     chunkSize = chunkSize.clamp(64 * 1024, 10 * 1024 * 1024);
 
+    // Same account on both ends: let the provider copy the file (no bytes through the device)
+    if (_canCopyServerSide(sourceAdapter, destAdapter)) {
+      final String? fileId;
+      try {
+        fileId = await _performServerSideCopy(
+          sourceAdapter: sourceAdapter,
+          sourceFileId: sourceFileId,
+          sourceFileSize: sourceFileSize,
+          destParentId: destParentId,
+          destFileName: destFileName,
+          onProgress: onProgress,
+          cancelFlag: cancelFlag,
+        );
+      } catch (e) {
+        // The provider may already have accepted the copy; streaming it as well could
+        // leave a duplicate, so only an explicit refusal falls back
+        return null;
+      }
+      if (fileId != null) {
+        return fileId;
+      }
+      if (cancelFlag != null && cancelFlag()) {
+        return null;
+      }
+      // Provider refused the copy: fall back to streaming the bytes
+    }
 
     try {
       // Allocate buffer in native memory
@@ -286,6 +312,53 @@ class UnifiedCopyService {
     }
   }
 
+  /// Whether a copy can be done provider-side
+  ///
+  /// Adapters are created once per account, so the same adapter instance on both ends
+  /// means the same provider account, where the provider's own copy API applies.
+  bool _canCopyServerSide(ICloudAdapter sourceAdapter, ICloudAdapter destAdapter) {
+    return identical(sourceAdapter, destAdapter);
+  }
+
+  /// Perform a provider-side copy using the adapter's native copy API
+  ///
+  /// Reports progress like the chunked path (start and completion, since providers
+  /// copy the file as a whole) and honours cancellation before the request is sent.
+  /// Returns null if the provider refused the copy (nothing was created); throws if the
+  /// copy was accepted but its outcome is unknown (see [ICloudAdapter.copyFileNative]).
+  Future<String?> _performServerSideCopy({
+    required ICloudAdapter sourceAdapter,
+    required String sourceFileId,
+    required int sourceFileSize,
+    required String destParentId,
+    required String destFileName,
+    Function(CopyProgress)? onProgress,
+    bool Function()? cancelFlag,
+  }) async {
+    if (cancelFlag != null && cancelFlag()) {
+      return null;
+    }
+
+    onProgress?.call(CopyProgress.initial(totalBytes: sourceFileSize, totalFiles: 1));
+
+    final fileId = await sourceAdapter.copyFileNative(
+      sourceFileId: sourceFileId,
+      destinationParentId: destParentId,
+      newName: destFileName,
+    );
+    if (fileId == null) {
+      return null;
+    }
+
+    onProgress?.call(CopyProgress(
+      bytesCopied: sourceFileSize,
+      totalBytes: sourceFileSize,
+      filesProcessed: 1,
+      totalFiles: 1,
+    ));
+    return fileId;
+  }
+
   /// Perform chunked copy using cloud adapter streams
   Future<String?> _performChunkedCopy({
     required ICloudAdapter sourceAdapter,
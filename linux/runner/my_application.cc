@@ -1,5 +1,6 @@
 #include "my_application.h"
 
+#include <dlfcn.h>
 #include <flutter_linux/flutter_linux.h>
 #ifdef GDK_WINDOWING_X11
 #include <gdk/gdkx.h>
@@ -14,6 +15,30 @@ struct _MyApplication {
 
 G_DEFINE_TYPE(MyApplication, my_application, GTK_TYPE_APPLICATION)
 
+// Exported by libcloud_nexus_encryption.so (native/src/preload.rs).
+typedef int32_t (*PreloadStartFunc)();
+
+// Loads the native library and lets it warm up while the engine starts. The
+// handle is never closed, so Dart's DynamicLibrary.open reuses the loaded copy.
+static gpointer native_preload_thread(gpointer data) {
+  void* library = dlopen("libcloud_nexus_encryption.so", RTLD_NOW);
+  if (library == nullptr) {
+    return nullptr;
+  }
+  PreloadStartFunc preload_start = reinterpret_cast<PreloadStartFunc>(
+      dlsym(library, "cloud_nexus_preload_start"));
+  if (preload_start != nullptr) {
+    preload_start();
+  }
+  return nullptr;
+}
+
+// Starts the native preload on a background thread.
+static void start_native_preload() {
+  g_autoptr(GThread) thread =
+      g_thread_new("cn-preload", native_preload_thread, nullptr);
+}
+
 // Called when first Flutter frame received.
 static void first_frame_cb(MyApplication* self, FlView* view) {
   gtk_widget_show(gtk_widget_get_toplevel(GTK_WIDGET(view)));
@@ -22,6 +47,9 @@ static void first_frame_cb(MyApplication* self, FlView* view) {
 // Implements GApplication::activate.
 static void my_application_activate(GApplication* application) {
   MyApplication* self = MY_APPLICATION(application);
+  // Kick this off first so it overlaps with window and engine creation.
+  start_native_preload();
+
   GtkWindow* window =
       GTK_WINDOW(gtk_application_window_new(GTK_APPLICATION(application)));
 
@@ -0,0 +1,59 @@
+//! Shared helpers for the CloudNexus benchmarks
+//!
+//! Every bench prints a table and, when CN_BENCH_JSON names a file, appends one JSON
+//! object per case to it (JSON lines), tagged with the crate version so results from
+//! different releases can be diffed by a script.
+
+#![allow(dead_code)]
+
+use std::fs::{File, OpenOptions};
+use std::io::Write;
+use std::path::PathBuf;
+
+/// Read a numeric tuning knob from the environment
+pub fn env_usize(name: &str, default: usize) -> usize {
+    std::env::var(name).ok().and_then(|v| v.parse().ok()).unwrap_or(default)
+}
+
+/// Directory for on-disk fixtures (CN_BENCH_DIR, or the system temp dir)
+pub fn fixture_dir(name: &str) -> PathBuf {
+    let base = std::env::var_os("CN_BENCH_DIR").map(PathBuf::from).unwrap_or_else(std::env::temp_dir);
+    base.join(format!("cn_bench_{}", name))
+}
+
+/// Results of one benchmark binary
+pub struct Report {
+    bench: &'static str,
+    json: Option<File>,
+}
+
+impl Report {
+    pub fn new(bench: &'static str) -> Self {
+        let json = std::env::var_os("CN_BENCH_JSON").map(|path| {
+            OpenOptions::new()
+                .create(true)
+                .append(true)
+                .open(&path)
+                .unwrap_or_else(|e| panic!("cannot open CN_BENCH_JSON file: {}", e))
+        });
+        println!("{} (cloud_nexus_encryption {})", bench, env!("CARGO_PKG_VERSION"));
+        println!("{:<36} {:>10} {:>10} {:>12} {:>14}", "case", "iters", "secs", "MB/s", "ops/s");
+        Report { bench, json }
+    }
+
+    /// Record one case: `iterations` operations moving `bytes` bytes in `seconds`
+    pub fn record(&mut self, case: &str, iterations: u64, bytes: u64, seconds: f64) {
+        let seconds = seconds.max(1e-9);
+        let mb_per_s = bytes as f64 / (1024.0 * 1024.0) / seconds;
+        let ops_per_s = iterations as f64 / seconds;
+        println!("{:<36} {:>10} {:>10.3} {:>12.1} {:>14.1}", case, iterations, seconds, mb_per_s, ops_per_s);
+
+        if let Some(json) = self.json.as_mut() {
+            let line = format!(
+                "{{\"bench\":\"{}\",\"case\":\"{}\",\"version\":\"{}\",\"iterations\":{},\"bytes\":{},\"seconds\":{:.6},\"mb_per_s\":{:.3},\"ops_per_s\":{:.3}}}\n",
+                self.bench, case, env!("CARGO_PKG_VERSION"), iterations, bytes, seconds, mb_per_s, ops_per_s
+            );
+            json.write_all(line.as_bytes()).expect("cannot write CN_BENCH_JSON file");
+        }
+    }
+}
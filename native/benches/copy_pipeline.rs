@@ -0,0 +1,75 @@
+//! Unified copy benchmark for CloudNexus
+//!
+//! Streams a multi-GB synthetic file through unified_copy_file with mock read/write
+//! callbacks standing in for the source and destination clouds. Each callback can sleep to
+//! simulate request latency, which is where overlapped reads and writes pay off.
+//!
+//! Run with: cargo bench --bench copy_pipeline
+//! Set CN_BENCH_MB for the stream size (default 4096), CN_BENCH_CHUNK_MB for the chunk
+//! size (default 8), CN_BENCH_LATENCY_US for the simulated per-call latency of the
+//! latency cases (default 2000), CN_BENCH_JSON=<file> for machine-readable output.
+
+mod common;
+
+use std::ffi::c_void;
+use std::ptr;
+use std::time::{Duration, Instant};
+
+use cloud_nexus_encryption::{unified_copy_file, unified_copy_free, unified_copy_init_with_depth};
+use common::{env_usize, Report};
+
+/// State shared by the mock callbacks
+struct MockCloud {
+    latency: Duration,
+    written: u64,
+    checksum: u64,
+}
+
+extern "C" fn mock_read(buffer: *mut u8, buffer_size: usize, offset: u64, user_data: *mut c_void) -> isize {
+    let cloud = unsafe { &*(user_data as *const MockCloud) };
+    if !cloud.latency.is_zero() {
+        std::thread::sleep(cloud.latency);
+    }
+    // Cheap fill that still touches every byte, as a real download would
+    unsafe { ptr::write_bytes(buffer, (offset / 4096) as u8, buffer_size) };
+    buffer_size as isize
+}
+
+extern "C" fn mock_write(data: *const u8, data_len: usize, offset: u64, user_data: *mut c_void) -> i32 {
+    let cloud = unsafe { &mut *(user_data as *mut MockCloud) };
+    if !cloud.latency.is_zero() {
+        std::thread::sleep(cloud.latency);
+    }
+    let slice = unsafe { std::slice::from_raw_parts(data, data_len) };
+    cloud.checksum = cloud.checksum.wrapping_add(slice[0] as u64 + slice[data_len - 1] as u64 + offset);
+    cloud.written += data_len as u64;
+    0
+}
+
+fn main() {
+    let total_bytes = env_usize("CN_BENCH_MB", 4096) as u64 * 1024 * 1024;
+    let chunk_size = env_usize("CN_BENCH_CHUNK_MB", 8) * 1024 * 1024;
+    let latency_us = env_usize("CN_BENCH_LATENCY_US", 2000) as u64;
+    let mut report = Report::new("copy_pipeline");
+
+    let mut buffer = vec![0u8; chunk_size];
+    for &(latency, depth) in &[(0u64, 1u32), (0, 4), (latency_us, 1), (latency_us, 4)] {
+        // Latency cases move fewer bytes so they finish in comparable time
+        let bytes = if latency == 0 { total_bytes } else { (total_bytes / 8).max(chunk_size as u64) };
+        let mut cloud = MockCloud { latency: Duration::from_micros(latency), written: 0, checksum: 0 };
+
+        let ctx = unified_copy_init_with_depth(bytes, 1, chunk_size, depth, ptr::null());
+        assert!(!ctx.is_null(), "unified_copy_init_with_depth failed");
+        let start = Instant::now();
+        let rc = unified_copy_file(ctx, buffer.as_mut_ptr(), buffer.len(), bytes,
+                                   Some(mock_read), Some(mock_write), None,
+                                   &mut cloud as *mut MockCloud as *mut c_void);
+        let seconds = start.elapsed().as_secs_f64();
+        unified_copy_free(ctx);
+        assert_eq!(rc, 0, "unified_copy_file failed");
+        assert_eq!(cloud.written, bytes, "short copy");
+
+        let chunks = (bytes + chunk_size as u64 - 1) / chunk_size as u64;
+        report.record(&format!("copy_latency{}us_depth{}", latency, depth), chunks, bytes, seconds);
+    }
+}
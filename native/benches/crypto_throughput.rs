@@ -0,0 +1,87 @@
+//! Crypto throughput benchmark for CloudNexus
+//!
+//! Reports encrypt/decrypt MB/s for single chunks from 64KB to 16MB together with the
+//! AES-GCM backend picked on this machine, so a build that silently lost AES-NI (or a
+//! slowdown in the chunk hot path) shows up before release.
+//!
+//! Run with: cargo bench --bench crypto_throughput
+//! Set CN_BENCH_MB to change the data volume per chunk size (default 256),
+//! CN_BENCH_JSON=<file> for machine-readable output.
+
+mod common;
+
+use std::ffi::CStr;
+use std::time::Instant;
+
+use cloud_nexus_encryption::{
+    crypto_get_backend_name, decrypt_chunk_into, decrypt_file_finalize, decrypt_file_init,
+    encrypt_chunk_into, encrypt_chunk_output_size, encrypt_file_finalize, encrypt_file_get_wrapped_fek,
+    encrypt_file_init, free_buffer,
+};
+use common::{env_usize, Report};
+
+const CHUNK_SIZES: [usize; 5] = [64 * 1024, 256 * 1024, 1024 * 1024, 4 * 1024 * 1024, 16 * 1024 * 1024];
+
+fn main() {
+    let backend = unsafe { CStr::from_ptr(crypto_get_backend_name()) };
+    println!("AES-GCM backend: {}", backend.to_string_lossy());
+
+    let volume_mb = env_usize("CN_BENCH_MB", 256);
+
+    // Matching encrypt/decrypt contexts: build the file header the same way a caller would
+    let master_key = [0x42u8; 32];
+    let mut header_len = 0usize;
+    let enc_ctx = encrypt_file_init(master_key.as_ptr(), master_key.len(), &mut header_len);
+    assert!(!enc_ctx.is_null(), "encrypt_file_init failed");
+    let mut fek_len = 0usize;
+    let wrapped_fek = encrypt_file_get_wrapped_fek(enc_ctx, &mut fek_len);
+    assert!(!wrapped_fek.is_null(), "encrypt_file_get_wrapped_fek failed");
+
+    let mut file_header = Vec::with_capacity(header_len);
+    file_header.extend_from_slice(&0x434E4552u32.to_le_bytes()); // "CNER"
+    file_header.extend_from_slice(&[1, 0, 0, 0]); // version + reserved
+    file_header.extend_from_slice(&(fek_len as u32).to_le_bytes());
+    file_header.extend_from_slice(unsafe { std::slice::from_raw_parts(wrapped_fek, fek_len) });
+    free_buffer(wrapped_fek);
+
+    let dec_ctx = decrypt_file_init(file_header.as_ptr(), file_header.len(), master_key.as_ptr(), master_key.len());
+    assert!(!dec_ctx.is_null(), "decrypt_file_init failed");
+
+    let mut report = Report::new("crypto_throughput");
+
+    for &chunk_size in CHUNK_SIZES.iter() {
+        let iterations = ((volume_mb * 1024 * 1024) / chunk_size).max(4);
+        let plaintext: Vec<u8> = (0..chunk_size).map(|i| (i % 251) as u8).collect();
+        let mut encrypted = vec![0u8; encrypt_chunk_output_size(chunk_size)];
+        let mut decrypted = vec![0u8; chunk_size];
+        let (mut encrypted_len, mut decrypted_len) = (0usize, 0usize);
+
+        // Warm-up (page faults, key schedule, CPU frequency)
+        encrypt_chunk_into(enc_ctx, plaintext.as_ptr(), chunk_size, 0,
+                           encrypted.as_mut_ptr(), encrypted.len(), &mut encrypted_len);
+
+        let start = Instant::now();
+        for index in 0..iterations {
+            let rc = encrypt_chunk_into(enc_ctx, plaintext.as_ptr(), chunk_size, index as u32,
+                                        encrypted.as_mut_ptr(), encrypted.len(), &mut encrypted_len);
+            assert_eq!(rc, 0, "encrypt_chunk_into failed");
+        }
+        let encrypt_secs = start.elapsed().as_secs_f64();
+
+        let start = Instant::now();
+        for _ in 0..iterations {
+            let rc = decrypt_chunk_into(dec_ctx, encrypted.as_ptr(), encrypted_len,
+                                        decrypted.as_mut_ptr(), decrypted.len(), &mut decrypted_len);
+            assert_eq!(rc, 0, "decrypt_chunk_into failed");
+        }
+        let decrypt_secs = start.elapsed().as_secs_f64();
+        assert_eq!(decrypted, plaintext, "roundtrip mismatch");
+
+        let bytes = (iterations * chunk_size) as u64;
+        report.record(&format!("encrypt_{}k", chunk_size / 1024), iterations as u64, bytes, encrypt_secs);
+        report.record(&format!("decrypt_{}k", chunk_size / 1024), iterations as u64, bytes, decrypt_secs);
+    }
+
+    encrypt_file_finalize(enc_ctx);
+    decrypt_file_finalize(dec_ctx);
+}
@@ -0,0 +1,77 @@
+//! Folder scan benchmark for CloudNexus
+//!
+//! Creates a deep directory tree once (fanout^depth folders with small files in each) and
+//! times serial and parallel scans of it, which is what every "upload folder" starts with.
+//!
+//! Run with: cargo bench --bench folder_scan
+//! Set CN_BENCH_SCAN_DEPTH / CN_BENCH_SCAN_FANOUT / CN_BENCH_SCAN_FILES to shape the tree,
+//! CN_BENCH_DIR for where it lives, CN_BENCH_JSON=<file> for machine-readable output.
+
+mod common;
+
+use std::fs;
+use std::path::Path;
+use std::time::Instant;
+
+use cloud_nexus_encryption::{scan_folder_parallel, scan_folder_sync};
+use common::{env_usize, fixture_dir, Report};
+
+const ITERATIONS: usize = 3;
+
+fn build_tree(dir: &Path, depth: usize, fanout: usize, files: usize) -> usize {
+    fs::create_dir_all(dir).expect("cannot create fixture folder");
+    let mut created = 0;
+    for i in 0..files {
+        fs::write(dir.join(format!("file_{:03}.dat", i)), vec![b'x'; 64 + i]).expect("cannot write fixture file");
+        created += 1;
+    }
+    if depth > 0 {
+        for i in 0..fanout {
+            created += build_tree(&dir.join(format!("folder_{:02}", i)), depth - 1, fanout, files);
+        }
+    }
+    created
+}
+
+fn main() {
+    let depth = env_usize("CN_BENCH_SCAN_DEPTH", 6);
+    let fanout = env_usize("CN_BENCH_SCAN_FANOUT", 4);
+    let files = env_usize("CN_BENCH_SCAN_FILES", 16);
+    let mut report = Report::new("folder_scan");
+
+    // The tree is reused across runs with the same shape
+    let root = fixture_dir(&format!("scan_d{}_f{}_n{}", depth, fanout, files));
+    let marker = root.join(".complete");
+    if !marker.exists() {
+        let _ = fs::remove_dir_all(&root);
+        let start = Instant::now();
+        let created = build_tree(&root, depth, fanout, files);
+        fs::write(&marker, b"").expect("cannot write fixture marker");
+        println!("created {} files in {:.1}s at {}", created, start.elapsed().as_secs_f64(), root.display());
+    }
+    let root_str = root.to_str().expect("fixture path is not UTF-8");
+
+    let threads = std::thread::available_parallelism().map(|n| n.get()).unwrap_or(1);
+    let mut cases: Vec<(String, usize)> = vec![("scan_serial".to_string(), 1)];
+    if threads > 1 {
+        cases.push((format!("scan_parallel_{}t", threads), threads));
+    }
+
+    for (case, case_threads) in cases {
+        let mut items = 0u64;
+        let mut bytes = 0u64;
+        let start = Instant::now();
+        for _ in 0..ITERATIONS {
+            let result = if case_threads == 1 {
+                scan_folder_sync(root_str, None)
+            } else {
+                scan_folder_parallel(root_str, None, case_threads)
+            }
+            .expect("scan failed");
+            items += result.items.len() as u64;
+            bytes += result.total_size;
+        }
+        // ops/s is items listed per second
+        report.record(&case, items, bytes, start.elapsed().as_secs_f64());
+    }
+}
@@ -0,0 +1,123 @@
+//! Search index benchmark for CloudNexus
+//!
+//! Builds a SearchIndex over synthetic cloud file names (1M documents by default, spread
+//! over several accounts and a folder hierarchy) and times indexing plus exact, prefix,
+//! fuzzy and per-account queries.
+//!
+//! Run with: cargo bench --bench search_index
+//! Set CN_BENCH_DOCS to change the index size, CN_BENCH_QUERIES the queries per case,
+//! CN_BENCH_JSON=<file> for machine-readable output.
+
+mod common;
+
+use std::time::Instant;
+
+use cloud_nexus_encryption::{SearchDocument, SearchIndex};
+use common::{env_usize, Report};
+
+const WORDS: [&str; 32] = [
+    "invoice", "report", "holiday", "photo", "backup", "project", "draft", "final",
+    "budget", "meeting", "notes", "scan", "contract", "resume", "music", "video",
+    "family", "trip", "design", "mockup", "release", "archive", "tax", "receipt",
+    "lecture", "slides", "thesis", "dataset", "export", "summary", "plan", "roadmap",
+];
+const EXTENSIONS: [&str; 8] = ["pdf", "docx", "jpg", "png", "mp4", "xlsx", "zip", "txt"];
+const ACCOUNTS: usize = 8;
+const FILES_PER_FOLDER: usize = 64;
+
+/// Deterministic xorshift so every run indexes the same corpus
+struct Rng(u64);
+
+impl Rng {
+    fn next(&mut self) -> u64 {
+        self.0 ^= self.0 << 13;
+        self.0 ^= self.0 >> 7;
+        self.0 ^= self.0 << 17;
+        self.0
+    }
+
+    fn word(&mut self) -> &'static str {
+        WORDS[(self.next() % WORDS.len() as u64) as usize]
+    }
+}
+
+fn synthetic_documents(count: usize) -> Vec<SearchDocument> {
+    let mut rng = Rng(0x9e3779b97f4a7c15);
+    let mut docs = Vec::with_capacity(count);
+    for i in 0..count {
+        let account = i % ACCOUNTS;
+        let folder = i / FILES_PER_FOLDER;
+        let is_folder = i % FILES_PER_FOLDER == 0;
+        let name = if is_folder {
+            format!("{} {}", rng.word(), folder)
+        } else {
+            let ext = EXTENSIONS[(rng.next() % EXTENSIONS.len() as u64) as usize];
+            format!("{}_{}_{}.{}", rng.word(), rng.word(), i, ext)
+        };
+        docs.push(SearchDocument {
+            node_id: format!("node-{}", i),
+            account_id: format!("account-{}", account),
+            provider: ["gdrive", "onedrive", "dropbox"][account % 3].to_string(),
+            email: format!("user{}@example.com", account),
+            name,
+            is_folder,
+            parent_id: (folder > 0).then(|| format!("node-{}", (folder / 8) * FILES_PER_FOLDER)),
+        });
+    }
+    docs
+}
+
+fn main() {
+    let doc_count = env_usize("CN_BENCH_DOCS", 1_000_000);
+    let queries = env_usize("CN_BENCH_QUERIES", 200);
+    let mut report = Report::new("search_index");
+
+    let docs = synthetic_documents(doc_count);
+    let name_bytes: u64 = docs.iter().map(|d| d.name.len() as u64).sum();
+
+    let mut index = SearchIndex::new();
+    let start = Instant::now();
+    for batch in docs.chunks(10_000) {
+        index.add_documents(batch.to_vec());
+    }
+    report.record(&format!("index_{}_docs", doc_count), doc_count as u64, name_bytes,
+                  start.elapsed().as_secs_f64());
+    assert_eq!(index.len(), doc_count);
+
+    let mut rng = Rng(42);
+    let terms: Vec<String> = (0..queries).map(|_| format!("{}_{}", rng.word(), rng.word())).collect();
+    let prefixes: Vec<String> = (0..queries).map(|_| rng.word()[..3].to_string()).collect();
+    // One transposition away from a real word
+    let typos: Vec<String> = (0..queries)
+        .map(|_| {
+            let mut chars: Vec<char> = rng.word().chars().collect();
+            chars.swap(1, 2);
+            chars.into_iter().collect()
+        })
+        .collect();
+
+    let mut run = |case: &str, count: usize, f: &mut dyn FnMut(usize) -> usize| {
+        let start = Instant::now();
+        let mut hits = 0usize;
+        for i in 0..count {
+            hits += f(i);
+        }
+        report.record(case, count as u64, 0, start.elapsed().as_secs_f64());
+        assert!(hits > 0, "{} returned no hits", case);
+    };
+
+    run("search_exact_top50", queries, &mut |i| index.search_exact(&terms[i], 50).len());
+    run("search_prefix_top50", queries, &mut |i| index.search_prefix(&prefixes[i], 50).len());
+    // Fuzzy queries scan every name: a tenth as many keeps the run short at 1M documents
+    run("search_fuzzy_d2_top50", (queries / 10).max(1), &mut |i| index.search_fuzzy(&typos[i], 2, 50).len());
+    run("search_by_account_top50", queries, &mut |i| {
+        index.search_by_account(&terms[i], &format!("account-{}", i % ACCOUNTS), 50).len()
+    });
+
+    let start = Instant::now();
+    let removals = (doc_count / 100).max(1);
+    for i in 0..removals {
+        index.remove_document(&format!("node-{}", i * 97 % doc_count));
+    }
+    report.record("remove_documents", removals as u64, 0, start.elapsed().as_secs_f64());
+}
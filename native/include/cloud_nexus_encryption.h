@@ -21,6 +21,8 @@ extern "C" {
 #define KEY_SIZE 32
 #define NONCE_SIZE 12
 #define MAC_SIZE 16
+#define CHUNK_PREFIX_SIZE 20   // index (4) + size (4) + nonce (12), precedes ciphertext
+#define CHUNK_OVERHEAD 36      // CHUNK_PREFIX_SIZE + MAC_SIZE
 
 /**
  * Encrypt data with AES-256-GCM
@@ -164,6 +166,174 @@ uint8_t* decrypt_file_streaming(
     void* user_data
 );
 
+/**
+ * Encrypt file using streaming encryption on multiple worker threads
+ *
+ * Output is byte-for-byte the same format as encrypt_file_streaming(); chunks are
+ * encrypted independently and written straight to their final offsets.
+ *
+ * @param file_data Pointer to file data to encrypt
+ * @param file_len Length of file data
+ * @param master_key Pointer to 32-byte Master Key
+ * @param master_key_len Length of master key (must be 32)
+ * @param num_threads Worker thread count (0 = one per core, 1 = calling thread only)
+ * @param output_len Pointer to store output length
+ * @param progress_callback Optional progress callback (can be NULL), invoked on the calling thread
+ * @param user_data User data to pass to progress callback
+ * @return Pointer to encrypted file data (caller must free with free_buffer)
+ */
+uint8_t* encrypt_file_streaming_parallel(
+    const uint8_t* file_data,
+    size_t file_len,
+    const uint8_t* master_key,
+    size_t master_key_len,
+    uint32_t num_threads,
+    size_t* output_len,
+    ProgressCallback progress_callback,
+    void* user_data
+);
+
+/**
+ * Decrypt file encrypted with streaming encryption on multiple worker threads
+ *
+ * @param encrypted_data Pointer to encrypted file data
+ * @param encrypted_len Length of encrypted data
+ * @param master_key Pointer to 32-byte Master Key
+ * @param master_key_len Length of master key (must be 32)
+ * @param num_threads Worker thread count (0 = one per core, 1 = calling thread only)
+ * @param output_len Pointer to store output length
+ * @param progress_callback Optional progress callback (can be NULL), invoked on the calling thread
+ * @param user_data User data to pass to progress callback
+ * @return Pointer to decrypted file data (caller must free with free_buffer)
+ */
+uint8_t* decrypt_file_streaming_parallel(
+    const uint8_t* encrypted_data,
+    size_t encrypted_len,
+    const uint8_t* master_key,
+    size_t master_key_len,
+    uint32_t num_threads,
+    size_t* output_len,
+    ProgressCallback progress_callback,
+    void* user_data
+);
+
+/**
+ * Encrypt a file on disk into the streaming format without loading it into memory
+ *
+ * Uses positional reads/writes, so peak memory is about one chunk per worker thread.
+ * Output is the same format as encrypt_file_streaming().
+ *
+ * @param input_path Path to the plaintext file (UTF-8)
+ * @param output_path Path of the encrypted file to create (must not be the input file)
+ * @param master_key Pointer to 32-byte Master Key
+ * @param master_key_len Length of master key (must be 32)
+ * @param chunk_size Plaintext bytes per chunk (0 = 1MB default)
+ * @param num_threads Worker thread count (0 = one per core, 1 = calling thread only)
+ * @param progress_callback Optional progress callback (can be NULL), invoked on the calling thread
+ * @param user_data User data to pass to progress callback
+ * @return SUCCESS or error code (ERROR_INVALID_PATH if output is the input; partial output is removed)
+ */
+int encrypt_file_from_path(
+    const char* input_path,
+    const char* output_path,
+    const uint8_t* master_key,
+    size_t master_key_len,
+    size_t chunk_size,
+    uint32_t num_threads,
+    ProgressCallback progress_callback,
+    void* user_data
+);
+
+/**
+ * Decrypt a streaming-format file on disk without loading it into memory
+ *
+ * @param input_path Path to the encrypted file (UTF-8)
+ * @param output_path Path of the plaintext file to create (must not be the input file)
+ * @param master_key Pointer to 32-byte Master Key
+ * @param master_key_len Length of master key (must be 32)
+ * @param num_threads Worker thread count (0 = one per core, 1 = calling thread only)
+ * @param progress_callback Optional progress callback (can be NULL), invoked on the calling thread
+ * @param user_data User data to pass to progress callback
+ * @return SUCCESS or error code (ERROR_INVALID_PATH if output is the input; partial output is removed)
+ */
+int decrypt_file_from_path(
+    const char* input_path,
+    const char* output_path,
+    const uint8_t* master_key,
+    size_t master_key_len,
+    uint32_t num_threads,
+    ProgressCallback progress_callback,
+    void* user_data
+);
+
+/**
+ * One input file of a batch call
+ */
+typedef struct CryptoBatchItem {
+    const uint8_t* data;
+    size_t len;
+} CryptoBatchItem;
+
+/**
+ * Encrypt many (small) files in one call
+ *
+ * Files are encrypted in parallel, each with its own FEK, into one contiguous arena.
+ * File i's encrypted output (same format as encrypt_file) is
+ * arena[offsets[i] .. offsets[i + 1]].
+ *
+ * @param items Array of count input descriptors
+ * @param count Number of files
+ * @param master_key Pointer to 32-byte Master Key
+ * @param master_key_len Length of master key (must be 32)
+ * @param num_threads Worker thread count (0 = one per core)
+ * @param offsets Caller-provided array of count + 1 entries
+ * @param arena_len Pointer to store the total arena length
+ * @param progress_callback Optional progress callback (can be NULL), invoked on the calling thread
+ * @param user_data User data to pass to progress callback
+ * @return Pointer to the arena (caller must free with free_buffer), or NULL on error
+ */
+uint8_t* encrypt_files_batch(
+    const CryptoBatchItem* items,
+    size_t count,
+    const uint8_t* master_key,
+    size_t master_key_len,
+    uint32_t num_threads,
+    size_t* offsets,
+    size_t* arena_len,
+    ProgressCallback progress_callback,
+    void* user_data
+);
+
+/**
+ * Decrypt many files in one call (inverse of encrypt_files_batch)
+ *
+ * A file that fails does not fail the batch; its statuses entry holds the error code.
+ *
+ * @param items Array of count encrypted files
+ * @param count Number of files
+ * @param master_key Pointer to 32-byte Master Key
+ * @param master_key_len Length of master key (must be 32)
+ * @param num_threads Worker thread count (0 = one per core)
+ * @param offsets Caller-provided array of count + 1 entries
+ * @param statuses Caller-provided array of count per-file result codes
+ * @param arena_len Pointer to store the total arena length
+ * @param progress_callback Optional progress callback (can be NULL), invoked on the calling thread
+ * @param user_data User data to pass to progress callback
+ * @return Pointer to the arena (caller must free with free_buffer), or NULL on error
+ */
+uint8_t* decrypt_files_batch(
+    const CryptoBatchItem* items,
+    size_t count,
+    const uint8_t* master_key,
+    size_t master_key_len,
+    uint32_t num_threads,
+    size_t* offsets,
+    int* statuses,
+    size_t* arena_len,
+    ProgressCallback progress_callback,
+    void* user_data
+);
+
 /**
  * Simple wrapper for encrypting a file (backward compatible)
  * Uses streaming encryption internally
@@ -227,6 +397,31 @@ int derive_key_from_password(
  */
 void free_buffer(uint8_t* buffer);
 
+// ============================================================================
+// CRYPTO BACKEND DETECTION
+// ============================================================================
+
+#define CRYPTO_BACKEND_SOFTWARE 0
+#define CRYPTO_BACKEND_AESNI_CLMUL 1
+#define CRYPTO_BACKEND_ARMV8_CRYPTO 2
+
+/**
+ * Detect which AES-GCM backend is used on this CPU
+ *
+ * AES-GCM picks its implementation at runtime; this reports the result so builds can
+ * log or assert that hardware acceleration is in use.
+ *
+ * @return CRYPTO_BACKEND_SOFTWARE, CRYPTO_BACKEND_AESNI_CLMUL or CRYPTO_BACKEND_ARMV8_CRYPTO
+ */
+int crypto_get_backend(void);
+
+/**
+ * Get a human-readable name for the AES-GCM backend
+ *
+ * @return Static null-terminated string (must NOT be freed)
+ */
+const char* crypto_get_backend_name(void);
+
 // ============================================================================
 // TRUE STREAMING ENCRYPTION API (for low-memory chunk-by-chunk processing)
 // ============================================================================
@@ -304,6 +499,72 @@ uint8_t* encrypt_chunk(
     size_t* output_len
 );
 
+/**
+ * Get the size of an encrypted chunk for a given plaintext length
+ *
+ * Use this to size one reusable buffer for encrypt_chunk_into() / encrypt_chunk_in_place().
+ *
+ * @param plaintext_len Length of the plaintext chunk
+ * @return Required output size in bytes (plaintext_len + CHUNK_OVERHEAD)
+ */
+size_t encrypt_chunk_output_size(size_t plaintext_len);
+
+/**
+ * Get the size of the plaintext contained in an encrypted chunk
+ *
+ * @param chunk_len Length of the encrypted chunk (including chunk header)
+ * @return Plaintext size in bytes, or 0 if the chunk is too short to be valid
+ */
+size_t decrypt_chunk_output_size(size_t chunk_len);
+
+/**
+ * Encrypt a single chunk into a caller-provided buffer (no allocation)
+ *
+ * Same output format as encrypt_chunk(). Input and output may overlap.
+ *
+ * @param context Pointer to EncryptionContext from encrypt_file_init()
+ * @param chunk_data Pointer to chunk data to encrypt
+ * @param chunk_len Length of chunk data
+ * @param chunk_index Index of this chunk (must increment for each chunk)
+ * @param output Buffer to receive the encrypted chunk
+ * @param output_capacity Size of output (at least encrypt_chunk_output_size(chunk_len))
+ * @param output_len Pointer to store output length
+ * @return SUCCESS, or ERROR_BUFFER_TOO_SMALL / other error code on failure
+ */
+int encrypt_chunk_into(
+    EncryptionContext* context,
+    const uint8_t* chunk_data,
+    size_t chunk_len,
+    uint32_t chunk_index,
+    uint8_t* output,
+    size_t output_capacity,
+    size_t* output_len
+);
+
+/**
+ * Encrypt a single chunk in place
+ *
+ * The plaintext must already be at buffer + CHUNK_PREFIX_SIZE, so file data can be
+ * read straight into a reusable buffer. On success buffer[0..*output_len] holds the
+ * encrypted chunk.
+ *
+ * @param context Pointer to EncryptionContext from encrypt_file_init()
+ * @param buffer Buffer holding the plaintext at offset CHUNK_PREFIX_SIZE
+ * @param buffer_capacity Size of buffer (at least encrypt_chunk_output_size(plaintext_len))
+ * @param plaintext_len Length of plaintext at buffer + CHUNK_PREFIX_SIZE
+ * @param chunk_index Index of this chunk (must increment for each chunk)
+ * @param output_len Pointer to store output length
+ * @return SUCCESS, or error code on failure
+ */
+int encrypt_chunk_in_place(
+    EncryptionContext* context,
+    uint8_t* buffer,
+    size_t buffer_capacity,
+    size_t plaintext_len,
+    uint32_t chunk_index,
+    size_t* output_len
+);
+
 /**
  * Finalize encryption context and free memory
  *
@@ -353,6 +614,42 @@ uint8_t* decrypt_chunk(
     size_t* output_len
 );
 
+/**
+ * Decrypt a single chunk into a caller-provided buffer (no allocation)
+ *
+ * @param context Pointer to DecryptionContext from decrypt_file_init()
+ * @param encrypted_chunk Pointer to encrypted chunk data (must include chunk header)
+ * @param chunk_len Length of encrypted chunk data
+ * @param output Buffer to receive the plaintext (must not overlap the input)
+ * @param output_capacity Size of output (at least decrypt_chunk_output_size(chunk_len))
+ * @param output_len Pointer to store plaintext length
+ * @return SUCCESS, or ERROR_BUFFER_TOO_SMALL / other error code on failure
+ */
+int decrypt_chunk_into(
+    DecryptionContext* context,
+    const uint8_t* encrypted_chunk,
+    size_t chunk_len,
+    uint8_t* output,
+    size_t output_capacity,
+    size_t* output_len
+);
+
+/**
+ * Decrypt a single chunk in place
+ *
+ * @param context Pointer to DecryptionContext from decrypt_file_init()
+ * @param buffer Buffer holding one encrypted chunk (including chunk header)
+ * @param chunk_len Length of the encrypted chunk
+ * @param output_len Pointer to store plaintext length
+ * @return Pointer to the plaintext inside buffer (buffer + CHUNK_PREFIX_SIZE), or NULL on error
+ */
+uint8_t* decrypt_chunk_in_place(
+    DecryptionContext* context,
+    uint8_t* buffer,
+    size_t chunk_len,
+    size_t* output_len
+);
+
 /**
  * Finalize decryption context and free memory
  *
@@ -360,6 +657,167 @@ uint8_t* decrypt_chunk(
  */
 void decrypt_file_finalize(DecryptionContext* context);
 
+// ============================================================================
+// FEK CACHE API (reuse unwrapped keys when re-opening the same file)
+// ============================================================================
+
+/**
+ * Opaque, thread-safe cache of unwrapped FEKs and initialized ciphers
+ */
+typedef struct FekCache FekCache;
+
+/**
+ * Create a FEK cache
+ *
+ * Entries are keyed by a hash of master key + wrapped FEK and zeroized on eviction.
+ *
+ * @param max_entries Maximum number of cached keys (0 = 64, least recently used evicted)
+ * @param ttl_ms Evict keys unused for this many milliseconds (0 = no expiry)
+ * @return Pointer to FekCache (free with fek_cache_free)
+ */
+FekCache* fek_cache_create(uint32_t max_entries, uint64_t ttl_ms);
+
+/**
+ * Same as decrypt_file_init(), but skips key unwrapping and cipher setup
+ * when the file's key is already cached
+ *
+ * @param cache Pointer to FekCache from fek_cache_create()
+ * @param encrypted_data Pointer to encrypted file data (must include header and wrapped FEK)
+ * @param encrypted_len Length of encrypted data
+ * @param master_key Pointer to 32-byte Master Key
+ * @param master_key_len Length of master key (must be 32)
+ * @return Pointer to DecryptionContext (free with decrypt_file_finalize), or NULL on error
+ */
+DecryptionContext* decrypt_file_init_cached(
+    const FekCache* cache,
+    const uint8_t* encrypted_data,
+    size_t encrypted_len,
+    const uint8_t* master_key,
+    size_t master_key_len
+);
+
+/**
+ * Evict and zeroize every cached key
+ *
+ * @param cache Pointer to FekCache
+ */
+void fek_cache_clear(FekCache* cache);
+
+/**
+ * Get cache statistics
+ *
+ * @param cache Pointer to FekCache
+ * @param entries Pointer to store the number of cached keys (can be NULL)
+ * @param hits Pointer to store the hit count (can be NULL)
+ * @param misses Pointer to store the miss count (can be NULL)
+ * @return 0 on success, error code on failure
+ */
+int fek_cache_get_stats(FekCache* cache, size_t* entries, uint64_t* hits, uint64_t* misses);
+
+/**
+ * Free a FEK cache (decryption contexts created from it stay valid)
+ *
+ * @param cache Pointer to FekCache
+ */
+void fek_cache_free(FekCache* cache);
+
+// ============================================================================
+// SEEKABLE DECRYPTION API (random-access range decrypt of streaming files)
+// ============================================================================
+
+/**
+ * Opaque context for seekable decryption
+ */
+typedef struct SeekableDecryptContext SeekableDecryptContext;
+
+/**
+ * Number of leading file bytes needed by seekable_decrypt_init()
+ * (main header + wrapped FEK + first chunk header)
+ */
+size_t seekable_decrypt_probe_size(void);
+
+/**
+ * Initialize a seekable decryption context
+ *
+ * The chunk offset table is computed from the first chunk header and the file size,
+ * so only the first seekable_decrypt_probe_size() bytes are needed (e.g. one HTTP
+ * range request).
+ *
+ * @param file_prefix Leading bytes of the encrypted file
+ * @param prefix_len Length of file_prefix
+ * @param encrypted_file_size Total size of the encrypted file
+ * @param master_key Pointer to 32-byte Master Key
+ * @param master_key_len Length of master key (must be 32)
+ * @return Pointer to SeekableDecryptContext, or NULL on error or if the file size rules
+ *         out a fixed chunk size. Other variable-size files (adaptive or content-defined
+ *         uploads) are rejected by seekable_decrypt_range() with ERROR_INVALID_FORMAT.
+ */
+SeekableDecryptContext* seekable_decrypt_init(
+    const uint8_t* file_prefix,
+    size_t prefix_len,
+    uint64_t encrypted_file_size,
+    const uint8_t* master_key,
+    size_t master_key_len
+);
+
+/**
+ * Get the plaintext size of the file
+ *
+ * @param context Pointer to SeekableDecryptContext
+ * @return Plaintext size in bytes, or 0 if invalid context
+ */
+uint64_t seekable_decrypt_get_plaintext_size(SeekableDecryptContext* context);
+
+/**
+ * Get the encrypted byte range that covers a plaintext range
+ *
+ * @param context Pointer to SeekableDecryptContext
+ * @param plaintext_offset Start of the plaintext range
+ * @param plaintext_len Length of the plaintext range (clamped to end of file)
+ * @param encrypted_offset Pointer to store the file offset to read from
+ * @param encrypted_len Pointer to store the number of bytes to read (0 for empty range)
+ * @return SUCCESS or error code
+ */
+int seekable_decrypt_range_for(
+    SeekableDecryptContext* context,
+    uint64_t plaintext_offset,
+    uint64_t plaintext_len,
+    uint64_t* encrypted_offset,
+    uint64_t* encrypted_len
+);
+
+/**
+ * Decrypt a plaintext range from the bytes reported by seekable_decrypt_range_for()
+ *
+ * @param context Pointer to SeekableDecryptContext
+ * @param encrypted_data Encrypted bytes fetched from the reported range
+ * @param encrypted_data_len Length of encrypted_data (must equal the reported length)
+ * @param plaintext_offset Start of the plaintext range
+ * @param plaintext_len Length of the plaintext range
+ * @param output Buffer to receive the plaintext
+ * @param output_capacity Size of output
+ * @param output_len Pointer to store plaintext bytes written
+ * @return SUCCESS, ERROR_INVALID_FORMAT if the range does not match the layout,
+ *         ERROR_BUFFER_TOO_SMALL or ERROR_DECRYPTION_FAILED
+ */
+int seekable_decrypt_range(
+    SeekableDecryptContext* context,
+    const uint8_t* encrypted_data,
+    size_t encrypted_data_len,
+    uint64_t plaintext_offset,
+    uint64_t plaintext_len,
+    uint8_t* output,
+    size_t output_capacity,
+    size_t* output_len
+);
+
+/**
+ * Free seekable decryption context
+ *
+ * @param context Pointer to SeekableDecryptContext
+ */
+void seekable_decrypt_free(SeekableDecryptContext* context);
+
 // ============================================================================
 // FOLDER SCANNING API
 // ============================================================================
@@ -385,6 +843,23 @@ FolderScanContext* scan_folder_init(
     uint32_t max_depth
 );
 
+/**
+ * Initialize a folder scan that reads directories on several worker threads
+ *
+ * Items within a directory keep the scan_folder_init ordering; directories may
+ * appear in any order.
+ *
+ * @param folder_path Path to the folder to scan (null-terminated)
+ * @param max_depth Maximum scan depth (0 for unlimited)
+ * @param num_threads Worker thread count (0 = one per core, 1 = serial scan)
+ * @return Pointer to FolderScanContext, or NULL on error
+ */
+FolderScanContext* scan_folder_init_parallel(
+    const char* folder_path,
+    uint32_t max_depth,
+    uint32_t num_threads
+);
+
 /**
  * Get the JSON representation of scan results
  *
@@ -496,6 +971,227 @@ char* scan_folder_quick(
     size_t* output_len
 );
 
+/**
+ * Quick scan with directory reads spread over several worker threads
+ *
+ * @param folder_path Path to the folder to scan (null-terminated)
+ * @param max_depth Maximum scan depth (0 for unlimited)
+ * @param num_threads Worker thread count (0 = one per core, 1 = serial scan)
+ * @param output_len Pointer to store output length
+ * @return Pointer to JSON string (caller must free with scan_folder_free_string), or NULL on error
+ */
+char* scan_folder_quick_parallel(
+    const char* folder_path,
+    uint32_t max_depth,
+    uint32_t num_threads,
+    size_t* output_len
+);
+
+// ----------------------------------------------------------------------------
+// Streaming scan results (poll batches while the scan is still running)
+// ----------------------------------------------------------------------------
+
+#define SCAN_STREAM_DONE 0
+#define SCAN_STREAM_BATCH 1
+#define SCAN_STREAM_PENDING 2
+
+/**
+ * Opaque handle for a scan running in the background
+ */
+typedef struct FolderScanStream FolderScanStream;
+
+/**
+ * One scanned item; strings live in the owning batch's string pool
+ *
+ * relative path = strings[path_offset .. path_offset + path_len] (UTF-8, '/' separated)
+ * name          = relative path from name_offset on
+ * absolute path = scan root + '/' + relative path
+ */
+typedef struct ScanRecord {
+    uint64_t size;
+    uint32_t path_offset;
+    uint32_t path_len;
+    uint32_t name_offset;
+    uint8_t is_folder;
+    uint8_t reserved[3];
+} ScanRecord;
+
+/**
+ * A batch of scan results (records plus string pool)
+ */
+typedef struct ScanBatch {
+    const ScanRecord* records;
+    size_t count;
+    const uint8_t* strings;
+    size_t strings_len;
+} ScanBatch;
+
+/**
+ * Start a folder scan on a background thread
+ *
+ * @param folder_path Path to the folder to scan (null-terminated)
+ * @param max_depth Maximum scan depth (0 for unlimited)
+ * @param num_threads Worker thread count (0 = one per core, 1 = serial scan)
+ * @return Pointer to FolderScanStream (free with scan_folder_stream_free),
+ *         or NULL if the path is not a directory
+ */
+FolderScanStream* scan_folder_stream_start(
+    const char* folder_path,
+    uint32_t max_depth,
+    uint32_t num_threads
+);
+
+/**
+ * Poll the next batch of results
+ *
+ * @param stream Pointer to FolderScanStream
+ * @param max_items Maximum records per batch (0 = 4096)
+ * @param timeout_ms Maximum time to wait for new results (0 = don't wait)
+ * @param batch_out Receives the batch on SCAN_STREAM_BATCH (free with scan_batch_free)
+ * @return SCAN_STREAM_BATCH, SCAN_STREAM_PENDING (nothing yet), SCAN_STREAM_DONE
+ *         (scan complete, all items returned), or negative error code
+ */
+int32_t scan_folder_stream_next(
+    FolderScanStream* stream,
+    uint32_t max_items,
+    uint32_t timeout_ms,
+    ScanBatch** batch_out
+);
+
+/**
+ * Get running totals (items found so far, including ones not yet polled)
+ *
+ * @param stream Pointer to FolderScanStream
+ * @param file_count Pointer to store file count (can be NULL)
+ * @param folder_count Pointer to store folder count (can be NULL)
+ * @param total_size Pointer to store total file size in bytes (can be NULL)
+ */
+void scan_folder_stream_get_progress(
+    FolderScanStream* stream,
+    uint64_t* file_count,
+    uint64_t* folder_count,
+    uint64_t* total_size
+);
+
+/**
+ * Free a batch returned by scan_folder_stream_next()
+ *
+ * @param batch Pointer to ScanBatch
+ */
+void scan_batch_free(ScanBatch* batch);
+
+/**
+ * Stop the scan if still running and free the stream
+ * (batches already returned stay valid until freed)
+ *
+ * @param stream Pointer to FolderScanStream
+ */
+void scan_folder_stream_free(FolderScanStream* stream);
+
+// ----------------------------------------------------------------------------
+// Incremental rescan (persisted snapshot of the previous scan)
+// ----------------------------------------------------------------------------
+
+/**
+ * Rescan a folder against the snapshot at snapshot_path and update the snapshot
+ *
+ * Only directories whose mtime changed are listed again, plus those modified within
+ * about 2 seconds of the previous scan (a change in the same timestamp tick keeps the
+ * mtime). Without a snapshot every item is reported as added.
+ *
+ * @param folder_path Path to the folder to scan (null-terminated)
+ * @param snapshot_path Path of the snapshot file (null-terminated, created if missing)
+ * @param verify_files Non-zero to stat files in unchanged directories (detects in-place edits)
+ * @param output_len Pointer to store output length
+ * @return Pointer to JSON diff (caller must free with scan_folder_free_string), or NULL on error
+ *
+ * JSON format:
+ * {
+ *   "root_path": "C:/path/to/folder",
+ *   "added": [ { same fields as scan_folder_get_json items } ],
+ *   "modified": [ { ... } ],
+ *   "removed": [ "subfolder/old.txt" ],
+ *   "directories_read": 3,
+ *   "directories_skipped": 1200,
+ *   "directories_failed": 0,
+ *   "scan_duration_ms": 40
+ * }
+ */
+char* scan_folder_rescan(
+    const char* folder_path,
+    const char* snapshot_path,
+    int32_t verify_files,
+    size_t* output_len
+);
+
+// ----------------------------------------------------------------------------
+// Change notifications (inotify / ReadDirectoryChangesW / FSEvents)
+// ----------------------------------------------------------------------------
+
+/**
+ * Opaque handle for a folder being watched
+ */
+typedef struct FsWatcher FsWatcher;
+
+/**
+ * Start watching a folder tree for changes
+ *
+ * Raw OS events are coalesced per path and released once the tree has been quiet
+ * for debounce_ms. Falls back to periodic snapshot rescans where the native
+ * notification API is unavailable.
+ *
+ * @param folder_path Path to the folder to watch (null-terminated)
+ * @param debounce_ms Quiet period before changes are released (0 = 200ms)
+ * @return Pointer to FsWatcher (free with fs_watcher_free), or NULL on error
+ */
+FsWatcher* fs_watcher_start(const char* folder_path, uint32_t debounce_ms);
+
+/**
+ * Take the next debounced changes
+ *
+ * @param watcher Pointer to FsWatcher
+ * @param max_events Maximum number of events to return (0 = all available)
+ * @param timeout_ms Maximum time to wait for changes (0 = don't wait)
+ * @param output_len Pointer to store output length (including the NUL, as scan_folder_get_json)
+ * @return Pointer to JSON array (caller must free with scan_folder_free_string),
+ *         "[]" if nothing changed within the timeout, NULL on error
+ *
+ * JSON format:
+ * [
+ *   { "path": "subfolder/file.txt", "kind": "created" | "modified" | "removed" | "rescan" }
+ * ]
+ *
+ * Paths are relative to the watched folder ("" = the folder itself). "rescan" means
+ * events were dropped and the subtree must be rescanned (see scan_folder_rescan).
+ */
+char* fs_watcher_next_events(
+    FsWatcher* watcher,
+    uint32_t max_events,
+    uint32_t timeout_ms,
+    size_t* output_len
+);
+
+/**
+ * Get watcher statistics
+ *
+ * @param watcher Pointer to FsWatcher
+ * @param raw_events Pointer to store the number of OS events received (can be NULL)
+ * @param delivered_events Pointer to store the number of coalesced events returned (can be NULL)
+ * @return 0 on success, error code on failure
+ */
+int32_t fs_watcher_get_stats(
+    FsWatcher* watcher,
+    uint64_t* raw_events,
+    uint64_t* delivered_events
+);
+
+/**
+ * Stop watching and free the watcher
+ *
+ * @param watcher Pointer to FsWatcher
+ */
+void fs_watcher_free(FsWatcher* watcher);
+
 // ============================================================================
 // UPLOAD API (streaming file uploads with optional encryption)
 // ============================================================================
@@ -517,6 +1213,8 @@ typedef struct UploadContext UploadContext;
 
 /**
  * Initialize upload context
+ *
+ * chunk_size is the plaintext bytes per chunk (0 = 1MB default, clamped to 64KB..64MB).
  */
 UploadContext* upload_init(
     const char* local_file_path,
@@ -542,6 +1240,90 @@ intptr_t upload_process_chunk(
     void* user_data
 );
 
+/**
+ * Configure chunk sizing for an upload
+ *
+ * Call before the first upload_process_chunk() and before upload_enable_pipeline().
+ *
+ * @param context Pointer to UploadContext
+ * @param chunk_alignment Round chunk sizes down to a multiple of this (327680 for OneDrive), 0 for none
+ * @param adaptive 1 to resize chunks from measured throughput, 0 for a fixed size
+ * @param min_chunk_size Smallest adaptive chunk size (0 = 64KB)
+ * @param max_chunk_size Largest adaptive chunk size (0 = 64MB)
+ * @return SUCCESS or error code
+ */
+int32_t upload_configure_chunking(
+    UploadContext* context,
+    size_t chunk_alignment,
+    int32_t adaptive,
+    size_t min_chunk_size,
+    size_t max_chunk_size
+);
+
+/**
+ * Get the plaintext size of the next upload chunk
+ */
+size_t upload_get_chunk_size(UploadContext* context);
+
+/**
+ * Get the buffer size upload_process_chunk() needs for any chunk of this upload
+ */
+size_t upload_get_chunk_buffer_size(UploadContext* context);
+
+/**
+ * Switch an upload to pipelined mode
+ *
+ * Reads and encrypts the next chunks on background threads while the caller sends the
+ * current one. upload_process_chunk() output is unchanged. At most max_in_flight chunk
+ * buffers (chunk size + CHUNK_OVERHEAD bytes each) are allocated.
+ *
+ * @param context Pointer to UploadContext
+ * @param max_in_flight Maximum chunk buffers in flight (0 = default of 4, minimum 2)
+ * @return SUCCESS or error code
+ */
+int32_t upload_enable_pipeline(UploadContext* context, uint32_t max_in_flight);
+
+/**
+ * Cut an upload at content-defined boundaries and track its chunk manifest
+ *
+ * With the manifest of the previously uploaded version, the previous FEK is kept so
+ * unchanged chunks stay valid; see upload_last_chunk_unchanged(). The FEK is only kept
+ * if remote_header, the first bytes of the object stored now (12-byte header plus
+ * wrapped FEK), matches the manifest; otherwise the upload is a full one with a new
+ * FEK. Unencrypted objects have no header; the caller must know the manifest is
+ * current. Only in-place edits are skipped: chunks that moved (after an insertion or
+ * deletion) are sent again. Call before the first chunk; not available in pipelined mode.
+ *
+ * @param context Pointer to UploadContext
+ * @param avg_chunk_size Average chunk size (0 = 1MB default, chunks range from avg/4 to avg*4)
+ * @param previous_manifest_path Manifest of the last uploaded version (can be NULL)
+ * @param remote_header Leading bytes of the stored object (can be NULL: no FEK reuse)
+ * @param remote_header_len Length of remote_header
+ * @return SUCCESS or error code
+ */
+int32_t upload_enable_content_chunking(
+    UploadContext* context,
+    size_t avg_chunk_size,
+    const char* previous_manifest_path,
+    const uint8_t* remote_header,
+    size_t remote_header_len
+);
+
+/**
+ * Whether the chunk returned by the last upload_process_chunk() is unchanged
+ *
+ * Chunks count as unchanged only at the same position (in-place edits); a chunk that
+ * moved is reported as changed.
+ *
+ * @return 1 if the stored copy of this chunk at this position is still valid, 0 otherwise
+ */
+int32_t upload_last_chunk_unchanged(UploadContext* context);
+
+/**
+ * Save the chunk manifest of a content-chunked upload (call after the last chunk)
+ */
+int32_t upload_save_manifest(UploadContext* context, const char* manifest_path);
+
 /**
  * Get header and wrapped FEK for upload
  */
@@ -575,6 +1357,9 @@ size_t upload_get_bytes_processed(UploadContext* context);
 
 /**
  * Copy file streaming for local copies
+ *
+ * The OS copy offload is tried first (reflink/copy_file_range on Linux, CopyFileEx
+ * on Windows, clonefile on macOS); the chunked loop is the fallback.
  */
 int32_t copy_file_streaming(
     const char* source_path,
@@ -585,6 +1370,135 @@ int32_t copy_file_streaming(
     void* user_data
 );
 
+// ============================================================================
+// CONTENT-DEFINED CHUNKING (delta uploads)
+// ============================================================================
+
+/**
+ * Chunk manifest: offset, length and SHA-256 of every content-defined chunk of a file,
+ * plus where each chunk sits in the encrypted object
+ */
+typedef struct ChunkManifest ChunkManifest;
+
+/**
+ * Build the manifest of a local file
+ *
+ * @param file_path Path to the file
+ * @param avg_chunk_size Average chunk size (0 = 1MB default)
+ * @return Manifest (free with cdc_manifest_free), or NULL on error
+ */
+ChunkManifest* cdc_manifest_build(const char* file_path, size_t avg_chunk_size);
+
+/**
+ * Load a saved manifest (NULL if missing or corrupt)
+ */
+ChunkManifest* cdc_manifest_load(const char* manifest_path);
+
+/**
+ * Save a manifest (replaced atomically)
+ */
+int32_t cdc_manifest_save(const ChunkManifest* manifest, const char* manifest_path);
+
+/**
+ * Get the number of chunks in a manifest
+ */
+size_t cdc_manifest_chunk_count(const ChunkManifest* manifest);
+
+/**
+ * Get one chunk of a manifest
+ *
+ * @param offset Receives the plaintext offset (can be NULL)
+ * @param len Receives the plaintext length (can be NULL)
+ * @param hash_out Receives the 32-byte SHA-256 (can be NULL)
+ * @return SUCCESS or error code
+ */
+int32_t cdc_manifest_get_chunk(
+    const ChunkManifest* manifest,
+    size_t index,
+    uint64_t* offset,
+    uint32_t* len,
+    uint8_t* hash_out
+);
+
+/**
+ * List the chunks of current whose content is not in previous
+ *
+ * @param indices_out Receives chunk indices of current (can be NULL to query the count)
+ * @param capacity Number of entries indices_out can hold
+ * @return Total number of changed chunks (may exceed capacity), or negative error code
+ */
+intptr_t cdc_manifest_changed_chunks(
+    const ChunkManifest* current,
+    const ChunkManifest* previous,
+    uint32_t* indices_out,
+    size_t capacity
+);
+
+/**
+ * Free a manifest
+ */
+void cdc_manifest_free(ChunkManifest* manifest);
+
+// ============================================================================
+// METRICS (per-stage timers and counters)
+// ============================================================================
+
+#define METRICS_STAGE_DISK_READ 0
+#define METRICS_STAGE_ENCRYPT 1
+#define METRICS_STAGE_DECRYPT 2
+#define METRICS_STAGE_DISK_WRITE 3
+#define METRICS_STAGE_CALLBACK_WAIT 4
+#define METRICS_STAGE_QUEUE_WAIT 5
+#define METRICS_STAGE_COUNT 6
+
+/** Bucket i counts samples below 2^i microseconds, the last bucket everything slower */
+#define METRICS_HISTOGRAM_BUCKETS 24
+
+/**
+ * Snapshot of one stage; throughput is bytes / total_ns
+ */
+typedef struct MetricsStageSnapshot {
+    uint64_t count;
+    uint64_t bytes;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint64_t histogram[METRICS_HISTOGRAM_BUCKETS];
+} MetricsStageSnapshot;
+
+/**
+ * Snapshot of a metrics registry, stages indexed by METRICS_STAGE_*
+ */
+typedef struct MetricsSnapshot {
+    MetricsStageSnapshot stages[METRICS_STAGE_COUNT];
+    uint64_t chunks;
+    uint64_t allocations;
+    uint64_t allocated_bytes;
+    uint64_t queue_depth;
+    uint64_t queue_depth_max;
+} MetricsSnapshot;
+
+/**
+ * Take a snapshot of the process-wide metrics (all transfers since start or reset)
+ *
+ * Diff two snapshots taken a second apart for live per-stage rates.
+ */
+int32_t metrics_snapshot(MetricsSnapshot* out);
+
+/**
+ * Reset the process-wide metrics
+ */
+void metrics_reset(void);
+
+/**
+ * Turn stage timers on (1) or off (0); counters keep counting
+ */
+void metrics_set_enabled(int32_t enabled);
+
+/**
+ * Take a snapshot of one upload's metrics
+ */
+int32_t upload_get_metrics(UploadContext* context, MetricsSnapshot* out);
+
 // ============================================================================
 // DOWNLOAD API (streaming file downloads with optional decryption)
 // ============================================================================
@@ -648,6 +1562,35 @@ int32_t download_append_decrypted(
     void* user_data
 );
 
+/**
+ * Switch to parallel mode: ranges may then be appended in any order and are
+ * decrypted on num_threads workers (0 = all cores) into a preallocated file.
+ * Requires download_init_with_size with the encrypted file size.
+ * file_prefix holds at least seekable_decrypt_probe_size() leading bytes.
+ */
+int32_t download_enable_parallel(
+    DownloadContext* context,
+    const uint8_t* file_prefix,
+    size_t prefix_len,
+    uint32_t num_threads,
+    uint32_t max_queued_chunks
+);
+
+/**
+ * Append a chunk-aligned range of the encrypted file (parallel mode only)
+ *
+ * Each chunk must arrive exactly once: overlapping ranges return ERROR_INVALID_PATH and
+ * download_finalize() fails if any chunk is missing.
+ */
+int32_t download_append_range(
+    DownloadContext* context,
+    const uint8_t* data,
+    size_t data_len,
+    uint64_t encrypted_offset,
+    DownloadProgressCallback progress_callback,
+    void* user_data
+);
+
 /**
  * Finalize download and clean up resources
  */
@@ -673,6 +1616,11 @@ size_t download_get_total_bytes(DownloadContext* context);
  */
 void download_set_total_bytes(DownloadContext* context, size_t total_bytes);
 
+/**
+ * Take a snapshot of one download's metrics
+ */
+int32_t download_get_metrics(DownloadContext* context, MetricsSnapshot* out);
+
 // ============================================================================
 // COPY API (file and folder copy operations)
 // ============================================================================
@@ -689,6 +1637,51 @@ int32_t folder_copy_finalize(CopyContext* context);
 
 void copy_free(CopyContext* context);
 
+/**
+ * Progress callback for folder copies
+ * @param bytes_copied Bytes copied so far across all files
+ * @param total_bytes Total bytes to copy
+ * @param files_processed Files completed so far
+ * @param total_files Total number of files
+ * @param user_data User-provided data pointer
+ */
+typedef void (*CopyProgressCallback)(
+    size_t bytes_copied,
+    size_t total_bytes,
+    size_t files_processed,
+    size_t total_files,
+    void* user_data
+);
+
+/**
+ * Copy a whole folder tree on a native worker pool
+ *
+ * Single-call replacement for the folder_copy_init / folder_copy_next_file loop.
+ * The destination directory tree is created up front, then up to max_workers
+ * threads copy the files; files of 64MB and more are cloned whole where the
+ * filesystem supports it and otherwise split into 16MB ranges copied in parallel,
+ * and the OS copy offload is used where available. Large files copied only in
+ * part are removed again when the copy fails or is cancelled.
+ * progress_callback reports aggregate progress (throttled, called from worker
+ * threads one at a time) plus a final update.
+ *
+ * @param source_folder Source folder path
+ * @param dest_folder Destination folder path (created if missing)
+ * @param max_workers Maximum number of worker threads (0 = default of 8, maximum 64)
+ * @param progress_callback Optional progress callback
+ * @param cancel_flag Cancellation flag (AtomicBool pointer, can be NULL)
+ * @param user_data User data for the callback
+ * @return 0 on success, first error code encountered on failure
+ */
+int32_t folder_copy_parallel(
+    const char* source_folder,
+    const char* dest_folder,
+    uint32_t max_workers,
+    CopyProgressCallback progress_callback,
+    void* cancel_flag,
+    void* user_data
+);
+
 // ============================================================================
 // CHUNKED STREAMING COPY API (for cross-account transfers)
 // ============================================================================
@@ -731,6 +1724,24 @@ ChunkedCopyContext* chunked_copy_init(
  */
 int32_t chunked_copy_open_source(ChunkedCopyContext* context);
 
+/**
+ * Copy the whole file with the OS copy offload instead of chunk by chunk
+ *
+ * Call before the first chunk is read or written. Progress and cancellation are
+ * reported as for the chunked calls.
+ *
+ * @param context Pointer to ChunkedCopyContext
+ * @param progress_callback Optional progress callback
+ * @param user_data User data for callback
+ * @return 0 if copied, 1 if the OS cannot copy this file (continue with
+ *         chunked_copy_read_chunk/chunked_copy_write_chunk), negative error code on failure
+ */
+int32_t chunked_copy_offload(
+    ChunkedCopyContext* context,
+    UploadProgressCallback progress_callback,
+    void* user_data
+);
+
 /**
  * Read next chunk from source file
  *
@@ -852,6 +1863,22 @@ CloudCopyContext* cloud_copy_init(
     void* cancel_flag
 );
 
+/**
+ * Overlap reads and writes of a cloud-to-cloud copy
+ *
+ * The first cloud_copy_process_chunk call afterwards starts a background thread that
+ * keeps reading ahead into a ring of `depth` buffers with that call's read_callback,
+ * buffer_size and user_data; each later call writes the next chunk already read.
+ * Later calls must pass the same read_callback and user_data. The read callback is
+ * invoked from the background thread, so it must be a native function (a Dart
+ * callback may only run on its isolate's thread).
+ *
+ * @param context Pointer to CloudCopyContext (before the first chunk)
+ * @param depth Number of ring buffers (0 = default of 3, minimum 2, maximum 16)
+ * @return 0 on success, error code on failure
+ */
+int32_t cloud_copy_enable_pipeline(CloudCopyContext* context, uint32_t depth);
+
 /**
  * Execute one chunk of cloud-to-cloud copy
  *
@@ -912,6 +1939,7 @@ void cloud_copy_get_progress(
 #define ERROR_CANCELLED -10
 #define ERROR_INVALID_PATH -11
 #define ERROR_DISK_FULL -12
+#define ERROR_BUFFER_TOO_SMALL -13
 
 // ============================================================================
 // UNIFIED CLOUD COPY API (single method for all copy operations)
@@ -973,6 +2001,23 @@ typedef int32_t (*UnifiedWriteCallback)(
     void* user_data
 );
 
+/**
+ * Server-side copy callback: the provider copies the file itself
+ * (same provider and account on both ends, no bytes pass through the device)
+ * Called repeatedly until it returns 0, from unified_copy_files workers (native only)
+ * @param bytes_done Set to the bytes the provider reports as copied so far (may be left untouched)
+ * @param user_data User data
+ * @return 1 while the copy is running, 0 when complete, negative on error
+ *         (ERROR_SERVER_COPY_UNSUPPORTED falls back to chunked copy; bytes reported
+ *         before it are taken back out of the progress)
+ */
+typedef int32_t (*UnifiedServerCopyCallback)(
+    uint64_t* bytes_done,
+    void* user_data
+);
+
+#define ERROR_SERVER_COPY_UNSUPPORTED -14
+
 /**
  * Initialize unified copy context
  *
@@ -989,6 +2034,30 @@ UnifiedCopyContext* unified_copy_init(
     void* cancel_flag
 );
 
+/**
+ * Initialize unified copy context with overlapped read/write
+ *
+ * With a depth above 1, each file copy reads up to `pipeline_depth` chunks ahead on a
+ * background thread while the calling thread writes, so the read callback is invoked
+ * from that thread and must be a native function (a Dart callback may only run on its
+ * isolate's thread; Dart overlaps files with unified_copy_batch_begin instead).
+ * A depth of 0 or 1 behaves like unified_copy_init.
+ *
+ * @param total_bytes Total bytes to copy across all files
+ * @param total_files Total number of files to copy
+ * @param chunk_size Size of chunks in bytes (64KB minimum, 10MB maximum)
+ * @param pipeline_depth Number of chunk buffers in flight per file (maximum 16)
+ * @param cancel_flag Pointer to AtomicBool for cancellation (can be NULL)
+ * @return Pointer to UnifiedCopyContext, or NULL on error
+ */
+UnifiedCopyContext* unified_copy_init_with_depth(
+    uint64_t total_bytes,
+    uint32_t total_files,
+    size_t chunk_size,
+    uint32_t pipeline_depth,
+    void* cancel_flag
+);
+
 /**
  * Process one file copy operation
  *
@@ -1020,6 +2089,134 @@ int32_t unified_copy_file(
     void* user_data
 );
 
+/**
+ * One file for unified_copy_files
+ * Each file has its own callbacks and user data. Files with a server_copy_callback
+ * are copied provider-side (scheduled first); the read/write callbacks are then
+ * only used if the provider returns ERROR_SERVER_COPY_UNSUPPORTED and may be NULL.
+ */
+typedef struct {
+    uint64_t file_size;                    // Size of the file in bytes
+    UnifiedReadCallback read_callback;     // Downloads chunks of this file
+    UnifiedWriteCallback write_callback;   // Uploads chunks of this file
+    void* user_data;                       // Passed to this file's callbacks
+    UnifiedServerCopyCallback server_copy_callback; // Provider-side copy, or NULL
+} UnifiedCopyJob;
+
+/**
+ * Copy many files concurrently
+ *
+ * Up to max_active_files files are in flight at once, each on its own worker thread
+ * with its own chunk buffer. Files of up to two chunks are copied first (smallest
+ * first), larger files follow largest first to balance the workers.
+ * Callbacks are called from worker threads and must be safe to call concurrently
+ * for different files, so they must be native functions (a Dart callback may only
+ * run on its isolate's thread; Dart uses unified_copy_batch_begin). The progress callback reports aggregate progress, one call
+ * at a time. Setting cancel_flag stops every worker after its current chunk.
+ *
+ * @param context Pointer to UnifiedCopyContext
+ * @param jobs Array of files to copy
+ * @param job_count Number of files in jobs
+ * @param max_active_files Maximum files in flight (0 = default of 4, capped at 32)
+ * @param results_out Optional array of job_count results (0 = copied, negative error code)
+ * @param progress_callback Optional progress callback
+ * @param progress_user_data User data for the progress callback
+ * @return 0 if every file was copied, otherwise the first error code
+ */
+int32_t unified_copy_files(
+    UnifiedCopyContext* context,
+    const UnifiedCopyJob* jobs,
+    size_t job_count,
+    uint32_t max_active_files,
+    int32_t* results_out,
+    UnifiedProgressCallback progress_callback,
+    void* progress_user_data
+);
+
+/** Step kinds of UnifiedCopyStep */
+#define UNIFIED_COPY_STEP_CHUNK 0
+#define UNIFIED_COPY_STEP_SERVER_COPY 1
+
+/**
+ * One piece of work handed out by unified_copy_batch_next
+ * CHUNK: download length bytes at offset into buffer, then upload them from there.
+ * SERVER_COPY: copy the whole file provider-side (buffer is NULL).
+ * The buffer belongs to the batch and stays valid until the step is completed.
+ */
+typedef struct {
+    uint32_t file_index;   // Index of the file in the batch
+    int32_t kind;          // UNIFIED_COPY_STEP_*
+    uint64_t offset;       // File offset of the chunk
+    size_t length;         // Bytes to copy (file size for SERVER_COPY)
+    uint8_t* buffer;       // Chunk buffer, or NULL
+} UnifiedCopyStep;
+
+typedef struct UnifiedCopyBatch UnifiedCopyBatch;
+
+/**
+ * Start copying many files under a schedule driven from the calling thread
+ *
+ * Counterpart of unified_copy_files without callbacks, for callers whose code must
+ * stay on one thread (Dart). unified_copy_batch_next hands out the next chunk or
+ * provider-side copy, the caller performs it (several may run concurrently as async
+ * transfers) and reports it with unified_copy_batch_complete. Files start in the
+ * unified_copy_files order, at most max_active_files at a time, with one step per
+ * file outstanding so every file is written in order. Progress is kept in the context.
+ *
+ * @param context Pointer to UnifiedCopyContext (must outlive the batch)
+ * @param file_sizes Size of every file
+ * @param server_side Optional array, nonzero for files to copy provider-side first
+ * @param file_count Number of files
+ * @param max_active_files Maximum files in progress (0 = default of 4, capped at 32)
+ * @return Batch handle (free with unified_copy_batch_finish), or NULL on error
+ */
+UnifiedCopyBatch* unified_copy_batch_begin(
+    UnifiedCopyContext* context,
+    const uint64_t* file_sizes,
+    const uint8_t* server_side,
+    size_t file_count,
+    uint32_t max_active_files
+);
+
+/**
+ * Get the next step of a batch
+ *
+ * @param batch Batch handle
+ * @param step_out Receives the step
+ * @return 1 if a step was stored, 0 if none is available until an outstanding step
+ *         completes (every file is done when none is outstanding), ERROR_CANCELLED
+ *         once cancel_flag is set, ERROR_NULL_POINTER on invalid arguments
+ */
+int32_t unified_copy_batch_next(UnifiedCopyBatch* batch, UnifiedCopyStep* step_out);
+
+/**
+ * Report a step of a batch as done
+ *
+ * @param batch Batch handle
+ * @param step The step from unified_copy_batch_next
+ * @param bytes_done Bytes of a chunk step that were copied (fewer than length continues
+ *        the file from there, 0 ends it); ignored for server copies
+ * @param result 0 on success, negative error code to fail the file
+ *        (ERROR_SERVER_COPY_UNSUPPORTED on a server copy falls back to chunk steps)
+ * @return 0 on success, ERROR_NULL_POINTER if the step is not outstanding
+ */
+int32_t unified_copy_batch_complete(
+    UnifiedCopyBatch* batch,
+    const UnifiedCopyStep* step,
+    uint64_t bytes_done,
+    int32_t result
+);
+
+/**
+ * Free a batch and collect its results
+ *
+ * @param batch Batch handle
+ * @param results_out Optional array of file_count results
+ *        (0 = copied, negative error code, ERROR_CANCELLED if not finished)
+ * @return 0 if every file was copied, otherwise the first error code
+ */
+int32_t unified_copy_batch_finish(UnifiedCopyBatch* batch, int32_t* results_out);
+
 /**
  * Finalize copy operation and send final progress update
  *
@@ -1090,6 +2287,160 @@ uint32_t unified_copy_get_files_processed(UnifiedCopyContext* context);
  */
 uint32_t unified_copy_get_total_files(UnifiedCopyContext* context);
 
+// ============================================================================
+// ASYNC JOB API (shared runtime, completion callbacks)
+// ============================================================================
+
+/**
+ * Opaque handle of a submitted job
+ *
+ * Submit functions return immediately; the operation runs on one shared runtime sized to
+ * the machine. Completion and progress callbacks run on runtime threads (from Dart, use
+ * NativeCallable.listener). Free the handle with job_free().
+ */
+typedef struct Job Job;
+
+#define JOB_STATUS_PENDING 0
+#define JOB_STATUS_RUNNING 1
+#define JOB_STATUS_SUCCEEDED 2
+#define JOB_STATUS_FAILED 3
+#define JOB_STATUS_CANCELLED 4
+
+/**
+ * Completion callback
+ *
+ * @param job_id Id of the job (see job_get_id())
+ * @param status Final status (JOB_STATUS_*)
+ * @param result Operation result (>= 0 on success, its error code otherwise)
+ * @param user_data User data passed at submit time
+ */
+typedef void (*JobCompletionCallback)(uint64_t job_id, int32_t status, int64_t result, void* user_data);
+
+/**
+ * Submit a file copy (see copy_file())
+ */
+Job* job_submit_copy_file(
+    const char* source_path,
+    const char* dest_path,
+    size_t chunk_size,
+    CopyProgressCallback progress_callback,
+    JobCompletionCallback completion_callback,
+    void* user_data
+);
+
+/**
+ * Submit a parallel folder copy (see folder_copy_parallel())
+ */
+Job* job_submit_folder_copy(
+    const char* source_folder,
+    const char* dest_folder,
+    uint32_t max_workers,
+    CopyProgressCallback progress_callback,
+    JobCompletionCallback completion_callback,
+    void* user_data
+);
+
+/**
+ * Submit a path-to-path encryption (see encrypt_file_from_path())
+ *
+ * The key is copied. Cancelling only takes effect before the job starts.
+ */
+Job* job_submit_encrypt_file(
+    const char* input_path,
+    const char* output_path,
+    const uint8_t* master_key,
+    size_t master_key_len,
+    size_t chunk_size,
+    uint32_t num_threads,
+    ProgressCallback progress_callback,
+    JobCompletionCallback completion_callback,
+    void* user_data
+);
+
+/**
+ * Submit a path-to-path decryption (see decrypt_file_from_path())
+ *
+ * The key is copied. Cancelling only takes effect before the job starts.
+ */
+Job* job_submit_decrypt_file(
+    const char* input_path,
+    const char* output_path,
+    const uint8_t* master_key,
+    size_t master_key_len,
+    uint32_t num_threads,
+    ProgressCallback progress_callback,
+    JobCompletionCallback completion_callback,
+    void* user_data
+);
+
+/**
+ * Submit a folder scan (same result as scan_folder_init_parallel())
+ *
+ * The job result is the number of files found; collect the scan with
+ * job_take_scan_context(). Directories are read on the shared job runtime
+ * (num_threads = 1 reads them serially on the job's thread instead).
+ */
+Job* job_submit_scan_folder(
+    const char* folder_path,
+    uint32_t max_depth,
+    uint32_t num_threads,
+    JobCompletionCallback completion_callback,
+    void* user_data
+);
+
+/**
+ * Take the result of a finished scan job (caller frees with scan_folder_free())
+ *
+ * @return Scan context, or NULL if unfinished, not a scan, or already taken
+ */
+FolderScanContext* job_take_scan_context(Job* job);
+
+/**
+ * Get a job's id
+ */
+uint64_t job_get_id(Job* job);
+
+/**
+ * Get a job's status (JOB_STATUS_*), or -1 for NULL
+ */
+int32_t job_get_status(Job* job);
+
+/**
+ * Get a finished job's result (>= 0 on success, the operation's error code otherwise)
+ */
+int64_t job_get_result(Job* job);
+
+/**
+ * Ask a job to stop: a pending job never starts, a running one stops at its next check
+ */
+void job_cancel(Job* job);
+
+/**
+ * Block until a job finishes or timeout_ms passes (0 = wait indefinitely)
+ *
+ * @return The job's status after waiting, or -1 for NULL
+ */
+int32_t job_wait(Job* job, uint64_t timeout_ms);
+
+/**
+ * Release a job handle (a running job keeps running and still calls back)
+ */
+void job_free(Job* job);
+
+// ============================================================================
+// COLD-START PRELOAD (called by the desktop runners before the engine starts)
+// ============================================================================
+
+/**
+ * Warm up the library in the background while the Flutter engine starts
+ *
+ * Primes the crypto backend and starts the job runtime. Only the first call
+ * does anything.
+ *
+ * @return 0 on success (or already started), error code on failure
+ */
+int32_t cloud_nexus_preload_start(void);
+
 #ifdef __cplusplus
 }
 #endif
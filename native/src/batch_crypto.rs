@@ -0,0 +1,394 @@
+/// Batch encryption/decryption of many small files in one FFI call
+///
+/// Uploading a folder of small files through `encrypt_file` pays FFI marshaling, header
+/// setup and a malloc/free per file. The batch entry points take an array of input
+/// descriptors, process the files in parallel and write every result into one
+/// contiguous arena:
+///
+/// ```text
+/// arena: [file 0 output][file 1 output]...[file n-1 output]
+/// offsets[i]..offsets[i + 1] = output of file i   (offsets has count + 1 entries)
+/// ```
+///
+/// Each encrypted entry is a complete streaming-format file with its own FEK, identical to
+/// what `encrypt_file` produces. The arena is released with a single `free_buffer`.
+use std::ffi::{c_int, c_void};
+use std::ptr;
+use std::slice;
+
+use aes_gcm::{aead::{KeyInit, OsRng}, Aes256Gcm};
+use rand::RngCore;
+use zeroize::Zeroize;
+
+use crate::{build_header, decrypt_chunk_into_with, encrypt_chunk_in_place_impl, encrypted_chunk_len,
+            parse_header, run_chunk_jobs, unwrap_key_with, wrap_key_with, ProgressCallback,
+            CHUNK_HEADER_SIZE, CHUNK_PREFIX_SIZE, DEFAULT_CHUNK_SIZE, ERROR_DECRYPTION_FAILED,
+            ERROR_INVALID_FORMAT, HEADER_SIZE, KEY_SIZE, MAC_SIZE, MAGIC, NONCE_SIZE, SUCCESS, VERSION};
+
+/// Size of a wrapped FEK: nonce + FEK + MAC
+const WRAPPED_FEK_SIZE: usize = NONCE_SIZE + KEY_SIZE + MAC_SIZE;
+
+/// One input file of a batch
+#[repr(C)]
+pub struct CryptoBatchItem {
+    pub data: *const u8,
+    pub len: usize,
+}
+
+/// Encrypted size of a file of `plaintext_len` bytes in streaming format
+fn encrypted_file_len(plaintext_len: usize) -> usize {
+    let chunk_count = (plaintext_len + DEFAULT_CHUNK_SIZE - 1) / DEFAULT_CHUNK_SIZE;
+    HEADER_SIZE + WRAPPED_FEK_SIZE + plaintext_len + chunk_count * CHUNK_HEADER_SIZE
+}
+
+/// Plaintext size of a streaming-format file, found by walking its chunk headers
+fn decrypted_file_len(encrypted: &[u8]) -> Option<usize> {
+    let fek_length = match parse_header(encrypted) {
+        Ok((MAGIC, VERSION, fek_length)) => fek_length,
+        _ => return None,
+    };
+
+    let mut pos = HEADER_SIZE.checked_add(fek_length)?;
+    let mut plaintext_len = 0usize;
+    while pos < encrypted.len() {
+        let header = encrypted.get(pos..pos + CHUNK_PREFIX_SIZE)?;
+        let size = u32::from_le_bytes([header[4], header[5], header[6], header[7]]) as usize;
+        if size < MAC_SIZE {
+            return None;
+        }
+        plaintext_len += size - MAC_SIZE;
+        pos += CHUNK_PREFIX_SIZE + size;
+    }
+
+    if pos == encrypted.len() { Some(plaintext_len) } else { None }
+}
+
+/// Build the item slices and validate the offsets output
+unsafe fn batch_inputs<'a>(items: *const CryptoBatchItem, count: usize) -> Option<Vec<&'a [u8]>> {
+    if items.is_null() && count > 0 {
+        return None;
+    }
+
+    let mut inputs = Vec::with_capacity(count);
+    for i in 0..count {
+        let item = &*items.add(i);
+        if item.data.is_null() && item.len > 0 {
+            return None;
+        }
+        inputs.push(if item.len == 0 { &[][..] } else { slice::from_raw_parts(item.data, item.len) });
+    }
+    Some(inputs)
+}
+
+/// Allocate the arena and carve it into one output slot per item
+///
+/// Fills `offsets` (count + 1 entries) and returns the arena pointer with its slots.
+unsafe fn allocate_arena<'a>(sizes: &[usize], offsets: *mut usize) -> Option<(*mut u8, usize, Vec<&'a mut [u8]>)> {
+    let total_size: usize = sizes.iter().sum();
+
+    // At least 1 byte so an empty batch still yields a valid pointer
+    let arena = libc::malloc(total_size.max(1)) as *mut u8;
+    if arena.is_null() {
+        return None;
+    }
+
+    let mut remaining = slice::from_raw_parts_mut(arena, total_size);
+    let mut slots = Vec::with_capacity(sizes.len());
+    let mut offset = 0usize;
+    for (i, &size) in sizes.iter().enumerate() {
+        *offsets.add(i) = offset;
+        let (slot, rest) = remaining.split_at_mut(size);
+        slots.push(slot);
+        remaining = rest;
+        offset += size;
+    }
+    *offsets.add(sizes.len()) = offset;
+
+    Some((arena, total_size, slots))
+}
+
+/// Encrypt one file into its arena slot (same layout as encrypt_file_streaming)
+fn encrypt_into_slot(data: &[u8], slot: &mut [u8], master_cipher: &Aes256Gcm) -> Option<()> {
+    let mut fek = [0u8; KEY_SIZE];
+    OsRng.fill_bytes(&mut fek);
+    let wrapped_fek = wrap_key_with(&fek, master_cipher);
+
+    let result = (|| {
+        if wrapped_fek.len() != WRAPPED_FEK_SIZE {
+            return None;
+        }
+
+        let (prefix, mut remaining) = slot.split_at_mut(HEADER_SIZE + WRAPPED_FEK_SIZE);
+        prefix[..HEADER_SIZE].copy_from_slice(&build_header(WRAPPED_FEK_SIZE as u32));
+        prefix[HEADER_SIZE..].copy_from_slice(&wrapped_fek);
+
+        for (chunk_index, chunk_data) in data.chunks(DEFAULT_CHUNK_SIZE).enumerate() {
+            let (chunk_slot, rest) = remaining.split_at_mut(encrypted_chunk_len(chunk_data.len()));
+            chunk_slot[CHUNK_PREFIX_SIZE..CHUNK_PREFIX_SIZE + chunk_data.len()].copy_from_slice(chunk_data);
+            encrypt_chunk_in_place_impl(chunk_slot, chunk_data.len(), &fek, chunk_index as u32)?;
+            remaining = rest;
+        }
+        Some(())
+    })();
+
+    fek.zeroize();
+    result
+}
+
+/// Decrypt one file into its arena slot
+fn decrypt_into_slot(encrypted: &[u8], slot: &mut [u8], master_cipher: &Aes256Gcm) -> c_int {
+    let fek_length = match parse_header(encrypted) {
+        Ok((_, _, fek_length)) => fek_length,
+        Err(_) => return ERROR_INVALID_FORMAT,
+    };
+    let data_offset = HEADER_SIZE + fek_length;
+
+    let fek = match unwrap_key_with(&encrypted[HEADER_SIZE..data_offset], master_cipher) {
+        Ok(fek) => fek,
+        Err(_) => return ERROR_DECRYPTION_FAILED,
+    };
+    let cipher = Aes256Gcm::new_from_slice(&fek);
+    drop(fek);
+    let cipher = match cipher {
+        Ok(cipher) => cipher,
+        Err(_) => return ERROR_DECRYPTION_FAILED,
+    };
+
+    // Chunk sizes were validated by decrypted_file_len
+    let mut pos = data_offset;
+    let mut out = 0usize;
+    while pos < encrypted.len() {
+        let size = u32::from_le_bytes([encrypted[pos + 4], encrypted[pos + 5], encrypted[pos + 6], encrypted[pos + 7]]) as usize;
+        let chunk = &encrypted[pos..pos + CHUNK_PREFIX_SIZE + size];
+        match decrypt_chunk_into_with(chunk, &mut slot[out..], &cipher) {
+            Some(n) => out += n,
+            None => return ERROR_DECRYPTION_FAILED,
+        }
+        pos += chunk.len();
+    }
+
+    SUCCESS
+}
+
+/// Encrypt many files in one call
+///
+/// # Arguments
+/// * `items` - Array of `count` input descriptors
+/// * `count` - Number of files
+/// * `master_key` - Pointer to 32-byte Master Key
+/// * `master_key_len` - Length of master key (must be 32)
+/// * `num_threads` - Worker threads (0 = one per available core)
+/// * `offsets` - Caller-provided array of `count + 1` entries; file i's output is
+///   `arena[offsets[i]..offsets[i + 1]]`
+/// * `arena_len` - Pointer to store the total arena length
+/// * `progress_callback` - Optional progress callback (plaintext bytes processed)
+/// * `user_data` - User data for the callback
+///
+/// # Returns
+/// Pointer to the arena (caller must free with free_buffer), or null on error
+#[no_mangle]
+pub extern "C" fn encrypt_files_batch(
+    items: *const CryptoBatchItem,
+    count: usize,
+    master_key: *const u8,
+    master_key_len: usize,
+    num_threads: u32,
+    offsets: *mut usize,
+    arena_len: *mut usize,
+    progress_callback: Option<ProgressCallback>,
+    user_data: *mut c_void,
+) -> *mut u8 {
+    if master_key.is_null() || offsets.is_null() || arena_len.is_null() || master_key_len != KEY_SIZE {
+        return ptr::null_mut();
+    }
+
+    let inputs = match unsafe { batch_inputs(items, count) } {
+        Some(inputs) => inputs,
+        None => return ptr::null_mut(),
+    };
+    let master_key_slice = unsafe { slice::from_raw_parts(master_key, master_key_len) };
+    let master_cipher = match Aes256Gcm::new_from_slice(master_key_slice) {
+        Ok(cipher) => cipher,
+        Err(_) => return ptr::null_mut(),
+    };
+
+    // Every output size is known up front
+    let sizes: Vec<usize> = inputs.iter().map(|data| encrypted_file_len(data.len())).collect();
+    let (arena, total_size, slots) = match unsafe { allocate_arena(&sizes, offsets) } {
+        Some(result) => result,
+        None => return ptr::null_mut(),
+    };
+
+    let total_bytes = inputs.iter().map(|data| data.len()).sum();
+    let jobs: Vec<_> = inputs.into_iter().zip(slots).collect();
+    let ok = run_chunk_jobs(
+        jobs,
+        num_threads,
+        total_bytes,
+        |(data, slot)| encrypt_into_slot(data, slot, &master_cipher).map(|_| data.len()),
+        progress_callback,
+        user_data,
+    );
+
+    if !ok {
+        unsafe { libc::free(arena as *mut c_void) };
+        return ptr::null_mut();
+    }
+
+    unsafe { *arena_len = total_size; }
+    arena
+}
+
+/// Decrypt many files in one call
+///
+/// A file that fails to decrypt does not fail the batch: its status entry is set and its
+/// slot length is 0 (malformed input) or its slot contents are undefined (wrong key, tampering).
+///
+/// # Arguments
+/// * `items` - Array of `count` encrypted files (complete streaming-format files)
+/// * `count` - Number of files
+/// * `master_key` - Pointer to 32-byte Master Key
+/// * `master_key_len` - Length of master key (must be 32)
+/// * `num_threads` - Worker threads (0 = one per available core)
+/// * `offsets` - Caller-provided array of `count + 1` entries (see encrypt_files_batch)
+/// * `statuses` - Caller-provided array of `count` per-file result codes (0 = success)
+/// * `arena_len` - Pointer to store the total arena length
+/// * `progress_callback` - Optional progress callback (encrypted bytes processed)
+/// * `user_data` - User data for the callback
+///
+/// # Returns
+/// Pointer to the arena (caller must free with free_buffer), or null on error
+#[no_mangle]
+pub extern "C" fn decrypt_files_batch(
+    items: *const CryptoBatchItem,
+    count: usize,
+    master_key: *const u8,
+    master_key_len: usize,
+    num_threads: u32,
+    offsets: *mut usize,
+    statuses: *mut c_int,
+    arena_len: *mut usize,
+    progress_callback: Option<ProgressCallback>,
+    user_data: *mut c_void,
+) -> *mut u8 {
+    if master_key.is_null() || offsets.is_null() || statuses.is_null() || arena_len.is_null()
+        || master_key_len != KEY_SIZE {
+        return ptr::null_mut();
+    }
+
+    let inputs = match unsafe { batch_inputs(items, count) } {
+        Some(inputs) => inputs,
+        None => return ptr::null_mut(),
+    };
+    let master_key_slice = unsafe { slice::from_raw_parts(master_key, master_key_len) };
+    let master_cipher = match Aes256Gcm::new_from_slice(master_key_slice) {
+        Ok(cipher) => cipher,
+        Err(_) => return ptr::null_mut(),
+    };
+
+    // Malformed files get an empty slot and are reported without being decrypted
+    let statuses = unsafe { slice::from_raw_parts_mut(statuses, count) };
+    let mut sizes = Vec::with_capacity(count);
+    for (data, status) in inputs.iter().zip(statuses.iter_mut()) {
+        match decrypted_file_len(data) {
+            Some(size) => {
+                *status = SUCCESS;
+                sizes.push(size);
+            }
+            None => {
+                *status = ERROR_INVALID_FORMAT;
+                sizes.push(0);
+            }
+        }
+    }
+
+    let (arena, total_size, slots) = match unsafe { allocate_arena(&sizes, offsets) } {
+        Some(result) => result,
+        None => return ptr::null_mut(),
+    };
+
+    let total_bytes = inputs.iter().map(|data| data.len()).sum();
+    let jobs: Vec<_> = inputs
+        .into_iter()
+        .zip(slots)
+        .zip(statuses.iter_mut())
+        .map(|((data, slot), status)| (data, slot, status))
+        .collect();
+    run_chunk_jobs(
+        jobs,
+        num_threads,
+        total_bytes,
+        |(data, slot, status)| {
+            if *status == SUCCESS {
+                *status = decrypt_into_slot(data, slot, &master_cipher);
+            }
+            Some(data.len())
+        },
+        progress_callback,
+        user_data,
+    );
+
+    unsafe { *arena_len = total_size; }
+    arena
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::{decrypt_file, free_buffer};
+
+    #[test]
+    fn test_batch_roundtrip() {
+        let master_key = [7u8; 32];
+        let files: Vec<Vec<u8>> = (0..40usize)
+            .map(|n| (0..(n * 97)).map(|i| (i % 211) as u8).collect())
+            .collect();
+        let items: Vec<CryptoBatchItem> = files
+            .iter()
+            .map(|f| CryptoBatchItem { data: f.as_ptr(), len: f.len() })
+            .collect();
+
+        let mut offsets = vec![0usize; files.len() + 1];
+        let mut arena_len = 0usize;
+        let arena = encrypt_files_batch(items.as_ptr(), items.len(), master_key.as_ptr(), 32, 4,
+                                        offsets.as_mut_ptr(), &mut arena_len, None, ptr::null_mut());
+        assert!(!arena.is_null());
+        assert_eq!(offsets[files.len()], arena_len);
+        let encrypted: Vec<Vec<u8>> = (0..files.len())
+            .map(|i| unsafe { slice::from_raw_parts(arena.add(offsets[i]), offsets[i + 1] - offsets[i]) }.to_vec())
+            .collect();
+        free_buffer(arena);
+
+        // Each entry is a standalone encrypted file
+        let mut out_len = 0usize;
+        let decoded = decrypt_file(encrypted[5].as_ptr(), encrypted[5].len(), master_key.as_ptr(), 32, &mut out_len);
+        assert!(!decoded.is_null());
+        assert_eq!(unsafe { slice::from_raw_parts(decoded, out_len) }, &files[5][..]);
+        free_buffer(decoded);
+
+        // Batch decrypt, with one corrupted entry
+        let mut inputs = encrypted.clone();
+        let truncated_len = inputs[3].len() - 1;
+        inputs[3].truncate(truncated_len);
+        let items: Vec<CryptoBatchItem> = inputs
+            .iter()
+            .map(|f| CryptoBatchItem { data: f.as_ptr(), len: f.len() })
+            .collect();
+        let mut statuses = vec![0 as c_int; files.len()];
+        let arena = decrypt_files_batch(items.as_ptr(), items.len(), master_key.as_ptr(), 32, 0,
+                                        offsets.as_mut_ptr(), statuses.as_mut_ptr(), &mut arena_len,
+                                        None, ptr::null_mut());
+        assert!(!arena.is_null());
+        for (i, file) in files.iter().enumerate() {
+            if i == 3 {
+                assert_eq!(statuses[i], ERROR_INVALID_FORMAT);
+                assert_eq!(offsets[i + 1] - offsets[i], 0);
+                continue;
+            }
+            assert_eq!(statuses[i], SUCCESS);
+            let out = unsafe { slice::from_raw_parts(arena.add(offsets[i]), offsets[i + 1] - offsets[i]) };
+            assert_eq!(out, &file[..]);
+        }
+        free_buffer(arena);
+    }
+}
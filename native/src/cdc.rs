@@ -0,0 +1,546 @@
+/// Content-defined chunking for CloudNexus delta uploads
+///
+/// FastCDC (gear rolling hash with normalized chunking) cuts files at boundaries chosen
+/// by their content, so an edit only changes the chunks around it. A chunk manifest
+/// (offset, length and SHA-256 of every chunk, plus where the chunk sits in the
+/// encrypted object) is kept next to the encrypted object and compared on the next
+/// sync to find the chunks that actually changed.
+use std::collections::HashSet;
+use std::ffi::c_char;
+use std::fs::{self, File};
+use std::io::{self, Read, Write};
+use std::path::{Path, PathBuf};
+use std::ptr;
+
+use sha2::{Digest, Sha256};
+
+use crate::file_io::{ERROR_NULL_POINTER, ERROR_INVALID_PATH, ERROR_IO_FAILED, SUCCESS, c_str_to_path};
+
+/// Default average chunk size (1MB)
+pub const CDC_DEFAULT_AVG_CHUNK: usize = 1024 * 1024;
+/// Smallest and largest configurable average chunk size
+const CDC_MIN_AVG_CHUNK: usize = 8 * 1024;
+const CDC_MAX_AVG_CHUNK: usize = 16 * 1024 * 1024;
+
+/// Manifest file format: "CNCM" + version
+const MANIFEST_MAGIC: &[u8; 4] = b"CNCM";
+const MANIFEST_VERSION: u8 = 1;
+/// Bytes per serialized chunk entry
+const ENTRY_SIZE: usize = 8 + 4 + 32 + 8 + 4;
+
+/// Gear table: 256 pseudo-random 64-bit values (splitmix64), fixed so cut points are
+/// stable across runs and platforms
+const GEAR: [u64; 256] = {
+    let mut table = [0u64; 256];
+    let mut state: u64 = 0x434E_4344_435F_4745; // "CNCDC_GE"
+    let mut i = 0;
+    while i < 256 {
+        state = state.wrapping_add(0x9E37_79B9_7F4A_7C15);
+        let mut z = state;
+        z = (z ^ (z >> 30)).wrapping_mul(0xBF58_476D_1CE4_E5B9);
+        z = (z ^ (z >> 27)).wrapping_mul(0x94D0_49BB_1331_11EB);
+        table[i] = z ^ (z >> 31);
+        i += 1;
+    }
+    table
+};
+
+/// FastCDC chunker
+///
+/// Cuts never fall below `min_size` or beyond `max_size`. Before the average size the
+/// stricter mask applies, after it the looser one, which keeps chunk sizes close to the
+/// average (normalized chunking).
+#[derive(Debug, Clone, Copy)]
+pub struct FastCdc {
+    min_size: usize,
+    avg_size: usize,
+    max_size: usize,
+    mask_strict: u64,
+    mask_loose: u64,
+}
+
+impl FastCdc {
+    /// Chunker for an average chunk size (rounded to a power of two; min = avg/4, max = avg*4)
+    pub fn new(avg_chunk_size: usize) -> Self {
+        let avg = match avg_chunk_size {
+            0 => CDC_DEFAULT_AVG_CHUNK,
+            n => n.max(CDC_MIN_AVG_CHUNK).min(CDC_MAX_AVG_CHUNK).next_power_of_two(),
+        };
+        let bits = avg.trailing_zeros();
+        // Masks over the top bits: those depend on the last 64 bytes of input
+        let top_mask = |n: u32| ((1u64 << n) - 1) << (64 - n);
+        FastCdc {
+            min_size: avg / 4,
+            avg_size: avg,
+            max_size: avg * 4,
+            mask_strict: top_mask(bits + 1),
+            mask_loose: top_mask(bits - 1),
+        }
+    }
+
+    pub fn avg_size(&self) -> usize {
+        self.avg_size
+    }
+
+    pub fn max_size(&self) -> usize {
+        self.max_size
+    }
+
+    /// Length of the next chunk at the start of `data`
+    ///
+    /// `data` should hold at least `max_size` bytes unless it is the end of the file;
+    /// shorter input is cut at its end when no boundary is found.
+    pub fn cut(&self, data: &[u8]) -> usize {
+        if data.len() <= self.min_size {
+            return data.len();
+        }
+        let end = data.len().min(self.max_size);
+        let normal = self.avg_size.min(end);
+
+        let mut hash = 0u64;
+        let mut i = self.min_size;
+        while i < normal {
+            hash = (hash << 1).wrapping_add(GEAR[data[i] as usize]);
+            if hash & self.mask_strict == 0 {
+                return i + 1;
+            }
+            i += 1;
+        }
+        while i < end {
+            hash = (hash << 1).wrapping_add(GEAR[data[i] as usize]);
+            if hash & self.mask_loose == 0 {
+                return i + 1;
+            }
+            i += 1;
+        }
+        end
+    }
+}
+
+/// Reads a file chunk by chunk at content-defined boundaries
+pub struct CdcReader<R: Read> {
+    reader: R,
+    chunker: FastCdc,
+    buffer: Vec<u8>,
+    start: usize,
+    end: usize,
+    eof: bool,
+}
+
+impl<R: Read> CdcReader<R> {
+    pub fn new(reader: R, chunker: FastCdc) -> Self {
+        CdcReader {
+            reader,
+            chunker,
+            buffer: vec![0u8; chunker.max_size() * 2],
+            start: 0,
+            end: 0,
+            eof: false,
+        }
+    }
+
+    /// Next chunk (empty at EOF); the slice is valid until the next call
+    pub fn next_chunk(&mut self) -> io::Result<&[u8]> {
+        let max = self.chunker.max_size();
+        if self.end - self.start < max && !self.eof {
+            // Keep the unconsumed tail and refill behind it
+            self.buffer.copy_within(self.start..self.end, 0);
+            self.end -= self.start;
+            self.start = 0;
+            while self.end < self.buffer.len() && !self.eof {
+                match self.reader.read(&mut self.buffer[self.end..]) {
+                    Ok(0) => self.eof = true,
+                    Ok(n) => self.end += n,
+                    Err(e) if e.kind() == io::ErrorKind::Interrupted => {}
+                    Err(e) => return Err(e),
+                }
+            }
+        }
+
+        let len = self.chunker.cut(&self.buffer[self.start..self.end]);
+        let chunk = &self.buffer[self.start..self.start + len];
+        self.start += len;
+        Ok(chunk)
+    }
+}
+
+/// One chunk of a manifest
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct ChunkEntry {
+    /// Offset of the chunk in the plaintext file
+    pub offset: u64,
+    /// Plaintext length
+    pub len: u32,
+    /// SHA-256 of the plaintext
+    pub hash: [u8; 32],
+    /// Offset of the chunk in the uploaded (encrypted) object
+    pub encrypted_offset: u64,
+    /// Length of the chunk in the uploaded object
+    pub encrypted_len: u32,
+}
+
+/// Chunk list of one version of a file
+#[derive(Debug, Clone, Default, PartialEq, Eq)]
+pub struct ChunkManifest {
+    pub avg_chunk_size: u32,
+    pub file_size: u64,
+    /// Wrapped FEK of the uploaded object (empty if unencrypted), so a delta upload can
+    /// keep the key and with it the still-valid chunks
+    pub wrapped_fek: Vec<u8>,
+    pub chunks: Vec<ChunkEntry>,
+}
+
+/// FNV-1a over the manifest body, detects truncated or corrupt files
+fn checksum(data: &[u8]) -> u64 {
+    let mut hash = 0xCBF2_9CE4_8422_2325u64;
+    for &byte in data {
+        hash ^= byte as u64;
+        hash = hash.wrapping_mul(0x0000_0100_0000_01B3);
+    }
+    hash
+}
+
+impl ChunkManifest {
+    pub fn new(avg_chunk_size: usize) -> Self {
+        ChunkManifest { avg_chunk_size: avg_chunk_size as u32, ..Default::default() }
+    }
+
+    /// Chunk a local file (plaintext positions only; encrypted positions equal them)
+    pub fn from_file(path: &Path, chunker: FastCdc) -> io::Result<Self> {
+        let mut manifest = ChunkManifest::new(chunker.avg_size());
+        let mut reader = CdcReader::new(File::open(path)?, chunker);
+        loop {
+            let chunk = reader.next_chunk()?;
+            if chunk.is_empty() {
+                break;
+            }
+            let offset = manifest.file_size;
+            let len = chunk.len() as u32;
+            manifest.push(chunk, offset, len as u32);
+        }
+        Ok(manifest)
+    }
+
+    /// Append a chunk at `encrypted_offset` / `encrypted_len` in the uploaded object
+    pub fn push(&mut self, data: &[u8], encrypted_offset: u64, encrypted_len: u32) -> &ChunkEntry {
+        let hash: [u8; 32] = Sha256::digest(data).into();
+        self.chunks.push(ChunkEntry {
+            offset: self.file_size,
+            len: data.len() as u32,
+            hash,
+            encrypted_offset,
+            encrypted_len,
+        });
+        self.file_size += data.len() as u64;
+        self.chunks.last().unwrap()
+    }
+
+    /// Indices of chunks whose content does not appear anywhere in `previous`
+    pub fn changed_chunks(&self, previous: &ChunkManifest) -> Vec<usize> {
+        let known: HashSet<&[u8; 32]> = previous.chunks.iter().map(|c| &c.hash).collect();
+        (0..self.chunks.len()).filter(|&i| !known.contains(&self.chunks[i].hash)).collect()
+    }
+
+    /// Whether chunk `index` is byte-identical to the same chunk of `previous` in the
+    /// uploaded object: same content at the same plaintext and encrypted position
+    ///
+    /// Position-bound on purpose: the stored object is one byte range, so a chunk whose
+    /// content merely moved (see `changed_chunks`) still has to be written again.
+    pub fn chunk_unchanged(&self, index: usize, previous: &ChunkManifest) -> bool {
+        match (self.chunks.get(index), previous.chunks.get(index)) {
+            (Some(current), Some(old)) => current == old,
+            _ => false,
+        }
+    }
+
+    pub fn to_bytes(&self) -> Vec<u8> {
+        let mut out = Vec::with_capacity(32 + self.wrapped_fek.len() + self.chunks.len() * ENTRY_SIZE);
+        out.extend_from_slice(MANIFEST_MAGIC);
+        out.push(MANIFEST_VERSION);
+        out.extend_from_slice(&self.avg_chunk_size.to_le_bytes());
+        out.extend_from_slice(&self.file_size.to_le_bytes());
+        out.extend_from_slice(&(self.wrapped_fek.len() as u32).to_le_bytes());
+        out.extend_from_slice(&self.wrapped_fek);
+        out.extend_from_slice(&(self.chunks.len() as u32).to_le_bytes());
+        for chunk in &self.chunks {
+            out.extend_from_slice(&chunk.offset.to_le_bytes());
+            out.extend_from_slice(&chunk.len.to_le_bytes());
+            out.extend_from_slice(&chunk.hash);
+            out.extend_from_slice(&chunk.encrypted_offset.to_le_bytes());
+            out.extend_from_slice(&chunk.encrypted_len.to_le_bytes());
+        }
+        let sum = checksum(&out);
+        out.extend_from_slice(&sum.to_le_bytes());
+        out
+    }
+
+    pub fn from_bytes(data: &[u8]) -> Option<Self> {
+        if data.len() < 8 + 5 || &data[..4] != MANIFEST_MAGIC || data[4] != MANIFEST_VERSION {
+            return None;
+        }
+        let (body, sum) = data.split_at(data.len() - 8);
+        if checksum(body) != u64::from_le_bytes(sum.try_into().ok()?) {
+            return None;
+        }
+
+        let mut pos = 5;
+        let mut take = |n: usize| -> Option<&[u8]> {
+            let bytes = body.get(pos..pos + n)?;
+            pos += n;
+            Some(bytes)
+        };
+        let avg_chunk_size = u32::from_le_bytes(take(4)?.try_into().ok()?);
+        let file_size = u64::from_le_bytes(take(8)?.try_into().ok()?);
+        let fek_len = u32::from_le_bytes(take(4)?.try_into().ok()?) as usize;
+        let wrapped_fek = take(fek_len)?.to_vec();
+        let count = u32::from_le_bytes(take(4)?.try_into().ok()?) as usize;
+
+        let mut chunks = Vec::with_capacity(count.min(body.len() / ENTRY_SIZE));
+        for _ in 0..count {
+            let entry = take(ENTRY_SIZE)?;
+            chunks.push(ChunkEntry {
+                offset: u64::from_le_bytes(entry[0..8].try_into().ok()?),
+                len: u32::from_le_bytes(entry[8..12].try_into().ok()?),
+                hash: entry[12..44].try_into().ok()?,
+                encrypted_offset: u64::from_le_bytes(entry[44..52].try_into().ok()?),
+                encrypted_len: u32::from_le_bytes(entry[52..56].try_into().ok()?),
+            });
+        }
+        Some(ChunkManifest { avg_chunk_size, file_size, wrapped_fek, chunks })
+    }
+
+    pub fn load(path: &Path) -> io::Result<Self> {
+        let data = fs::read(path)?;
+        ChunkManifest::from_bytes(&data)
+            .ok_or_else(|| io::Error::new(io::ErrorKind::InvalidData, "invalid chunk manifest"))
+    }
+
+    /// Write atomically (temporary file + rename)
+    pub fn save(&self, path: &Path) -> io::Result<()> {
+        let mut tmp = PathBuf::from(path);
+        tmp.set_extension("cncm.tmp");
+        {
+            let mut file = File::create(&tmp)?;
+            file.write_all(&self.to_bytes())?;
+            file.sync_all()?;
+        }
+        fs::rename(&tmp, path)
+    }
+}
+
+// ============================================================================
+// FFI
+// ============================================================================
+
+/// Chunk a local file and build its manifest
+///
+/// # Arguments
+/// * `file_path` - Path to the local file
+/// * `avg_chunk_size` - Average chunk size (0 = 1MB default, 8KB..16MB, rounded to a power of two)
+///
+/// # Returns
+/// Pointer to ChunkManifest (free with cdc_manifest_free), or null on error
+#[no_mangle]
+pub extern "C" fn cdc_manifest_build(file_path: *const c_char, avg_chunk_size: usize) -> *mut ChunkManifest {
+    if file_path.is_null() {
+        return ptr::null_mut();
+    }
+    let path = match unsafe { c_str_to_path(file_path) } {
+        Ok(p) => p,
+        Err(_) => return ptr::null_mut(),
+    };
+    match ChunkManifest::from_file(&path, FastCdc::new(avg_chunk_size)) {
+        Ok(manifest) => Box::into_raw(Box::new(manifest)),
+        Err(_) => ptr::null_mut(),
+    }
+}
+
+/// Load a manifest saved with cdc_manifest_save or upload_save_manifest
+///
+/// # Returns
+/// Pointer to ChunkManifest, or null if missing or corrupt
+#[no_mangle]
+pub extern "C" fn cdc_manifest_load(manifest_path: *const c_char) -> *mut ChunkManifest {
+    if manifest_path.is_null() {
+        return ptr::null_mut();
+    }
+    let path = match unsafe { c_str_to_path(manifest_path) } {
+        Ok(p) => p,
+        Err(_) => return ptr::null_mut(),
+    };
+    match ChunkManifest::load(&path) {
+        Ok(manifest) => Box::into_raw(Box::new(manifest)),
+        Err(_) => ptr::null_mut(),
+    }
+}
+
+/// Save a manifest (atomically replaces `manifest_path`)
+///
+/// # Returns
+/// 0 on success, error code on failure
+#[no_mangle]
+pub extern "C" fn cdc_manifest_save(manifest: *const ChunkManifest, manifest_path: *const c_char) -> i32 {
+    if manifest.is_null() || manifest_path.is_null() {
+        return ERROR_NULL_POINTER;
+    }
+    let path = match unsafe { c_str_to_path(manifest_path) } {
+        Ok(p) => p,
+        Err(_) => return ERROR_INVALID_PATH,
+    };
+    match unsafe { &*manifest }.save(&path) {
+        Ok(()) => SUCCESS,
+        Err(_) => ERROR_IO_FAILED,
+    }
+}
+
+/// Number of chunks in a manifest
+#[no_mangle]
+pub extern "C" fn cdc_manifest_chunk_count(manifest: *const ChunkManifest) -> usize {
+    if manifest.is_null() {
+        return 0;
+    }
+    unsafe { &*manifest }.chunks.len()
+}
+
+/// Get one chunk of a manifest
+///
+/// # Arguments
+/// * `manifest` - Pointer to ChunkManifest
+/// * `index` - Chunk index
+/// * `offset` - Receives the plaintext offset (can be null)
+/// * `len` - Receives the plaintext length (can be null)
+/// * `hash_out` - Receives the 32-byte SHA-256 (can be null)
+///
+/// # Returns
+/// 0 on success, error code on failure
+#[no_mangle]
+pub extern "C" fn cdc_manifest_get_chunk(
+    manifest: *const ChunkManifest,
+    index: usize,
+    offset: *mut u64,
+    len: *mut u32,
+    hash_out: *mut u8,
+) -> i32 {
+    if manifest.is_null() {
+        return ERROR_NULL_POINTER;
+    }
+    let chunk = match unsafe { &*manifest }.chunks.get(index) {
+        Some(chunk) => chunk,
+        None => return ERROR_INVALID_PATH,
+    };
+    unsafe {
+        if !offset.is_null() {
+            *offset = chunk.offset;
+        }
+        if !len.is_null() {
+            *len = chunk.len;
+        }
+        if !hash_out.is_null() {
+            ptr::copy_nonoverlapping(chunk.hash.as_ptr(), hash_out, 32);
+        }
+    }
+    SUCCESS
+}
+
+/// List the chunks of `current` whose content is not in `previous`
+///
+/// # Arguments
+/// * `current` - Manifest of the new version
+/// * `previous` - Manifest of the last synced version
+/// * `indices_out` - Receives chunk indices of `current` (can be null to query the count)
+/// * `capacity` - Number of entries `indices_out` can hold
+///
+/// # Returns
+/// Total number of changed chunks (may exceed `capacity`), or negative error code
+#[no_mangle]
+pub extern "C" fn cdc_manifest_changed_chunks(
+    current: *const ChunkManifest,
+    previous: *const ChunkManifest,
+    indices_out: *mut u32,
+    capacity: usize,
+) -> isize {
+    if current.is_null() || previous.is_null() {
+        return ERROR_NULL_POINTER as isize;
+    }
+    let changed = unsafe { &*current }.changed_chunks(unsafe { &*previous });
+    if !indices_out.is_null() {
+        for (i, &index) in changed.iter().take(capacity).enumerate() {
+            unsafe { *indices_out.add(i) = index as u32; }
+        }
+    }
+    changed.len() as isize
+}
+
+/// Free a manifest
+#[no_mangle]
+pub extern "C" fn cdc_manifest_free(manifest: *mut ChunkManifest) {
+    if !manifest.is_null() {
+        unsafe {
+            let _ = Box::from_raw(manifest);
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    /// Deterministic pseudo-random bytes
+    fn sample(len: usize, seed: u64) -> Vec<u8> {
+        let mut state = seed;
+        (0..len)
+            .map(|_| {
+                state ^= state << 13;
+                state ^= state >> 7;
+                state ^= state << 17;
+                state as u8
+            })
+            .collect()
+    }
+
+    fn chunk_all(data: &[u8], chunker: FastCdc) -> ChunkManifest {
+        let mut manifest = ChunkManifest::new(chunker.avg_size());
+        let mut reader = CdcReader::new(data, chunker);
+        loop {
+            let chunk = reader.next_chunk().unwrap().to_vec();
+            if chunk.is_empty() {
+                return manifest;
+            }
+            let offset = manifest.file_size;
+            manifest.push(&chunk, offset, chunk.len() as u32);
+        }
+    }
+
+    #[test]
+    fn test_cdc_edit_changes_few_chunks() {
+        let chunker = FastCdc::new(8 * 1024);
+        let original = sample(1024 * 1024, 7);
+        let before = chunk_all(&original, chunker);
+        assert_eq!(before.file_size, original.len() as u64);
+        assert!(before.chunks.iter().all(|c| c.len as usize <= chunker.max_size()));
+        assert!(before.chunks.len() > 40);
+
+        // Insert bytes in the middle: boundaries resynchronize after the edit
+        let mut edited = original.clone();
+        edited.splice(500_000..500_000, b"inserted bytes".iter().copied());
+        let after = chunk_all(&edited, chunker);
+        let changed = after.changed_chunks(&before);
+        assert!(!changed.is_empty() && changed.len() <= 3, "changed {:?}", changed);
+
+        // Same input, same chunks
+        assert!(chunk_all(&original, chunker).changed_chunks(&before).is_empty());
+    }
+
+    #[test]
+    fn test_manifest_roundtrip_and_corruption() {
+        let mut manifest = chunk_all(&sample(100_000, 3), FastCdc::new(8 * 1024));
+        manifest.wrapped_fek = vec![9u8; 60];
+        let bytes = manifest.to_bytes();
+        assert_eq!(ChunkManifest::from_bytes(&bytes), Some(manifest.clone()));
+
+        let mut corrupt = bytes.clone();
+        corrupt[20] ^= 1;
+        assert_eq!(ChunkManifest::from_bytes(&corrupt), None);
+        assert_eq!(ChunkManifest::from_bytes(&bytes[..bytes.len() - 1]), None);
+    }
+}
@@ -3,7 +3,9 @@
 use std::fs::{self, File, DirBuilder};
 use std::io::{Read, Write, BufReader, BufWriter};
 use std::path::{Path, PathBuf};
-use std::sync::atomic::AtomicBool;
+use std::sync::atomic::{AtomicBool, AtomicI32, AtomicUsize, Ordering};
+use std::sync::{mpsc, Arc, Mutex};
+use std::thread::JoinHandle;
 use std::ffi::{c_char, c_void};
 use std::ptr;
 use std::slice;
@@ -11,6 +13,7 @@ use std::slice;
 use crate::file_io::{ProgressThrottler, ERROR_NULL_POINTER, ERROR_FILE_NOT_FOUND, 
                      ERROR_PERMISSION_DENIED, ERROR_IO_FAILED, ERROR_CANCELLED, 
                      ERROR_INVALID_PATH, SUCCESS, c_str_to_path, is_cancelled};
+use crate::copy_offload::{offload_clone, offload_copy, offload_copy_range, Offload};
 
 /// Progress callback for copy operations
 /// For files: bytes_copied, total_bytes, user_data
@@ -49,6 +52,9 @@ impl CopyContext {
 
 /// Copy a single file with streaming
 ///
+/// The kernel copy offload is tried first (reflink / copy_file_range, CopyFileEx,
+/// clonefile); the chunked loop only runs where the OS cannot copy the file itself.
+///
 /// # Arguments
 /// * `source_path` - Source file path
 /// * `dest_path` - Destination file path
@@ -96,6 +102,25 @@ pub extern "C" fn copy_file_streaming(
     let mut throttler = ProgressThrottler::new(500);
     let mut bytes_copied = 0;
 
+    // Let the OS copy the data when it can
+    let offloaded = offload_copy(&src, &dst, total_bytes as u64, cancel_flag, &mut |done| {
+        if let Some(cb) = progress_callback {
+            if throttler.should_update(done as usize, total_bytes) {
+                cb(done as usize, total_bytes, 1, 1, user_data);
+            }
+        }
+    });
+    match offloaded {
+        Ok(Offload::Copied) => {
+            if let Some(cb) = progress_callback {
+                cb(total_bytes, total_bytes, 1, 1, user_data);
+            }
+            return SUCCESS;
+        }
+        Ok(Offload::Unsupported) => {}
+        Err(code) => return code,
+    }
+
     // Open source file
     let src_file = match File::open(&src) {
         Ok(f) => f,
@@ -344,8 +369,9 @@ fn copy_next_file_impl(
 
         if src_path.is_file() {
             // Copy file
-            if let Err(_) = copy_single_file(&src_path, &dest_path) {
-                return ERROR_IO_FAILED;
+            let result = copy_single_file(&src_path, &dest_path, ctx.cancel_flag);
+            if result != SUCCESS {
+                return result;
             }
 
             let metadata = src_path.metadata().unwrap();
@@ -398,7 +424,23 @@ fn copy_next_file_impl(
     0
 }
 
-fn copy_single_file(src: &Path, dst: &Path) -> Result<(), std::io::Error> {
+/// Copy one file of a folder copy, offloaded to the OS when possible
+fn copy_single_file(src: &Path, dst: &Path, cancel_flag: *const AtomicBool) -> i32 {
+    let total_bytes = match src.metadata() {
+        Ok(m) => m.len(),
+        Err(_) => return ERROR_FILE_NOT_FOUND,
+    };
+    match offload_copy(src, dst, total_bytes, cancel_flag, &mut |_| {}) {
+        Ok(Offload::Copied) => SUCCESS,
+        Ok(Offload::Unsupported) => match copy_single_file_buffered(src, dst) {
+            Ok(()) => SUCCESS,
+            Err(_) => ERROR_IO_FAILED,
+        },
+        Err(code) => code,
+    }
+}
+
+fn copy_single_file_buffered(src: &Path, dst: &Path) -> Result<(), std::io::Error> {
     let src_file = File::open(src)?;
     let dst_file = File::create(dst)?;
 
@@ -570,6 +612,471 @@ pub extern "C" fn get_file_size(path: *const c_char) -> usize {
     0
 }
 
+// ============================================================================
+// PARALLEL FOLDER COPY (native worker pool)
+// ============================================================================
+
+/// Default and maximum number of folder copy workers
+const DEFAULT_FOLDER_COPY_WORKERS: u32 = 8;
+const MAX_FOLDER_COPY_WORKERS: u32 = 64;
+
+/// Files at least this large are split into ranges copied by several workers
+const RANGE_SPLIT_MIN_BYTES: u64 = 64 * 1024 * 1024;
+/// Size of one range of a split file
+const RANGE_BYTES: u64 = 16 * 1024 * 1024;
+/// Buffer per worker for copies the OS cannot offload
+const FOLDER_COPY_BUFFER_BYTES: usize = 1024 * 1024;
+
+/// A file split into ranges copied by several workers
+///
+/// Nothing is opened while planning. The first range claimed tries a whole-file clone
+/// and otherwise opens both files (preallocating the destination) for the workers to
+/// share; the last range copied closes them. Only files with ranges in flight hold
+/// descriptors, however many large files the tree has.
+struct SplitFile {
+    src: PathBuf,
+    dst: PathBuf,
+    size: u64,
+    state: Mutex<SplitFileState>,
+    /// Ranges not copied yet; the worker finishing the last one counts the file
+    ranges_left: AtomicUsize,
+}
+
+enum SplitFileState {
+    /// No range claimed yet
+    Pending,
+    /// Copying range by range through the shared handles
+    Open(Arc<SplitHandles>),
+    /// Cloned whole or copied completely; remaining ranges have nothing to do
+    Done,
+}
+
+struct SplitHandles {
+    source: File,
+    dest: File,
+}
+
+/// What a worker does with a range it claimed
+enum SplitClaim {
+    /// The whole file was cloned by this claim
+    Cloned,
+    /// Nothing left to copy
+    Skip,
+    /// Copy the range through these handles
+    Copy(Arc<SplitHandles>),
+}
+
+impl SplitFile {
+    fn lock_state(&self) -> std::sync::MutexGuard<'_, SplitFileState> {
+        match self.state.lock() {
+            Ok(guard) => guard,
+            Err(poisoned) => poisoned.into_inner(),
+        }
+    }
+
+    fn claim(&self) -> Result<SplitClaim, i32> {
+        let mut state = self.lock_state();
+        match &*state {
+            SplitFileState::Open(handles) => return Ok(SplitClaim::Copy(handles.clone())),
+            SplitFileState::Done => return Ok(SplitClaim::Skip),
+            SplitFileState::Pending => {}
+        }
+
+        // Copy-on-write clone: constant time, shares the source extents
+        if offload_clone(&self.src, &self.dst)? == Offload::Copied {
+            *state = SplitFileState::Done;
+            return Ok(SplitClaim::Cloned);
+        }
+
+        // Preallocate so ranges can be written at their offsets in any order
+        let source = File::open(&self.src).map_err(|_| ERROR_FILE_NOT_FOUND)?;
+        let dest = File::create(&self.dst).map_err(|_| ERROR_PERMISSION_DENIED)?;
+        if dest.set_len(self.size).is_err() {
+            drop(dest);
+            let _ = fs::remove_file(&self.dst);
+            return Err(ERROR_IO_FAILED);
+        }
+        let handles = Arc::new(SplitHandles { source, dest });
+        *state = SplitFileState::Open(handles.clone());
+        Ok(SplitClaim::Copy(handles))
+    }
+
+    /// Close the handles after the last range
+    fn finish(&self) {
+        *self.lock_state() = SplitFileState::Done;
+    }
+
+    /// Remove a preallocated destination whose ranges did not all complete
+    fn discard(&self) {
+        let mut state = self.lock_state();
+        if let SplitFileState::Open(_) = &*state {
+            // Workers have exited, so this drops the last handles (Windows cannot remove open files)
+            *state = SplitFileState::Pending;
+            let _ = fs::remove_file(&self.dst);
+        }
+    }
+}
+
+/// One unit of work for the folder copy workers
+enum FolderCopyItem {
+    /// A whole file (offloaded to the OS when possible)
+    File { src: PathBuf, dst: PathBuf, size: u64 },
+    /// One range of a large file
+    Range { file: usize, offset: u64, len: u64 },
+}
+
+/// Plan of a parallel folder copy
+struct FolderCopyPlan {
+    items: Vec<FolderCopyItem>,
+    split_files: Vec<SplitFile>,
+    total_bytes: u64,
+    total_files: usize,
+}
+
+/// Walk the source tree, create the destination tree and plan the copy
+///
+/// The whole directory tree is created before any file is copied, so workers never race
+/// on directory creation. Files of at least `split_min` bytes are split into ranges of
+/// `range_bytes` (opened when their first range is claimed). Ranges of large files come first, then whole files largest first, so the long transfers start early
+/// and small files fill in behind them.
+fn plan_folder_copy(src_root: &Path, dst_root: &Path, split_min: u64, range_bytes: u64) -> Result<FolderCopyPlan, i32> {
+    let mut dirs = vec![dst_root.to_path_buf()];
+    let mut files: Vec<(PathBuf, PathBuf, u64)> = Vec::new();
+    let mut pending = vec![(src_root.to_path_buf(), dst_root.to_path_buf())];
+
+    while let Some((src_dir, dst_dir)) = pending.pop() {
+        let entries = fs::read_dir(&src_dir).map_err(|_| ERROR_IO_FAILED)?;
+        for entry in entries {
+            let entry = entry.map_err(|_| ERROR_IO_FAILED)?;
+            let src_path = entry.path();
+            let dst_path = dst_dir.join(entry.file_name());
+            // Follows symlinks, like count_files_and_size
+            let metadata = match fs::metadata(&src_path) {
+                Ok(m) => m,
+                Err(_) => continue,
+            };
+            if metadata.is_dir() {
+                dirs.push(dst_path.clone());
+                pending.push((src_path, dst_path));
+            } else if metadata.is_file() {
+                files.push((src_path, dst_path, metadata.len()));
+            }
+        }
+    }
+
+    // Parents come before their children
+    for dir in &dirs {
+        if fs::create_dir_all(dir).is_err() {
+            return Err(ERROR_PERMISSION_DENIED);
+        }
+    }
+
+    let total_bytes = files.iter().map(|f| f.2).sum();
+    let total_files = files.len();
+    files.sort_by_key(|f| std::cmp::Reverse(f.2));
+
+    let mut items = Vec::new();
+    let mut whole = Vec::new();
+    let mut split_files = Vec::new();
+    for (src, dst, size) in files {
+        if size < split_min {
+            whole.push(FolderCopyItem::File { src, dst, size });
+            continue;
+        }
+        let file = split_files.len();
+        let ranges = ((size + range_bytes - 1) / range_bytes) as usize;
+        for i in 0..ranges as u64 {
+            let offset = i * range_bytes;
+            items.push(FolderCopyItem::Range { file, offset, len: range_bytes.min(size - offset) });
+        }
+        split_files.push(SplitFile {
+            src,
+            dst,
+            size,
+            state: Mutex::new(SplitFileState::Pending),
+            ranges_left: AtomicUsize::new(ranges),
+        });
+    }
+    items.extend(whole);
+
+    Ok(FolderCopyPlan { items, split_files, total_bytes, total_files })
+}
+
+#[cfg(unix)]
+fn read_at(file: &File, buffer: &mut [u8], offset: u64) -> std::io::Result<usize> {
+    std::os::unix::fs::FileExt::read_at(file, buffer, offset)
+}
+
+#[cfg(unix)]
+fn write_all_at(file: &File, data: &[u8], offset: u64) -> std::io::Result<()> {
+    std::os::unix::fs::FileExt::write_all_at(file, data, offset)
+}
+
+#[cfg(windows)]
+fn read_at(file: &File, buffer: &mut [u8], offset: u64) -> std::io::Result<usize> {
+    std::os::windows::fs::FileExt::seek_read(file, buffer, offset)
+}
+
+#[cfg(windows)]
+fn write_all_at(file: &File, mut data: &[u8], mut offset: u64) -> std::io::Result<()> {
+    while !data.is_empty() {
+        let written = std::os::windows::fs::FileExt::seek_write(file, data, offset)?;
+        if written == 0 {
+            return Err(std::io::ErrorKind::WriteZero.into());
+        }
+        data = &data[written..];
+        offset += written as u64;
+    }
+    Ok(())
+}
+
+/// Copy one range of a split file through `buffer`
+fn copy_range_buffered(
+    file: &SplitHandles,
+    offset: u64,
+    len: u64,
+    buffer: &mut [u8],
+    cancel_flag: *const AtomicBool,
+    progress: &mut dyn FnMut(u64),
+) -> i32 {
+    let mut done = 0u64;
+    while done < len {
+        if unsafe { is_cancelled(cancel_flag) } {
+            return ERROR_CANCELLED;
+        }
+        let want = (len - done).min(buffer.len() as u64) as usize;
+        let read = match read_at(&file.source, &mut buffer[..want], offset + done) {
+            Ok(0) | Err(_) => return ERROR_IO_FAILED,
+            Ok(n) => n,
+        };
+        if write_all_at(&file.dest, &buffer[..read], offset + done).is_err() {
+            return ERROR_IO_FAILED;
+        }
+        done += read as u64;
+        progress(read as u64);
+    }
+    SUCCESS
+}
+
+/// Progress shared by the folder copy workers
+struct FolderCopyProgress {
+    callback: Option<CopyProgressCallback>,
+    user_data: *mut c_void,
+    throttler: ProgressThrottler,
+}
+unsafe impl Send for FolderCopyProgress {}
+
+/// Cancel flag shared with the workers (the caller keeps it alive for the call)
+#[derive(Clone, Copy)]
+struct SharedCancelFlag(*const AtomicBool);
+unsafe impl Send for SharedCancelFlag {}
+unsafe impl Sync for SharedCancelFlag {}
+
+impl SharedCancelFlag {
+    fn get(&self) -> *const AtomicBool {
+        self.0
+    }
+}
+
+/// Copy a whole folder tree on a native worker pool
+///
+/// Replaces the folder_copy_init / folder_copy_next_file loop with a single call: the
+/// destination directory tree is created up front, then up to `max_workers` threads copy
+/// the files. Files of 64MB and more are cloned whole where the filesystem supports it
+/// and otherwise split into 16MB ranges copied in parallel; every copy uses the OS copy
+/// offload when available. Large files copied only in part are removed on failure. `progress_callback` receives the
+/// aggregate progress (throttled, one call at a time, from worker threads) and a final
+/// update. Setting `cancel_flag` stops all workers after their current step.
+///
+/// # Arguments
+/// * `source_folder` - Source folder path
+/// * `dest_folder` - Destination folder path (created if missing)
+/// * `max_workers` - Maximum number of worker threads (0 = default of 8)
+/// * `progress_callback` - Optional progress callback
+/// * `cancel_flag` - Cancellation flag
+/// * `user_data` - User data for the callback
+///
+/// # Returns
+/// 0 on success, the first error code encountered on failure
+#[no_mangle]
+pub extern "C" fn folder_copy_parallel(
+    source_folder: *const c_char,
+    dest_folder: *const c_char,
+    max_workers: u32,
+    progress_callback: Option<CopyProgressCallback>,
+    cancel_flag: *const AtomicBool,
+    user_data: *mut c_void,
+) -> i32 {
+    if source_folder.is_null() || dest_folder.is_null() {
+        return ERROR_NULL_POINTER;
+    }
+
+    let src = match unsafe { c_str_to_path(source_folder) } {
+        Ok(p) => p,
+        Err(_) => return ERROR_INVALID_PATH,
+    };
+    let dst = match unsafe { c_str_to_path(dest_folder) } {
+        Ok(p) => p,
+        Err(_) => return ERROR_INVALID_PATH,
+    };
+    if !src.is_dir() {
+        return ERROR_INVALID_PATH;
+    }
+
+    copy_folder_parallel(&src, &dst, RANGE_SPLIT_MIN_BYTES, RANGE_BYTES, max_workers, progress_callback, cancel_flag, user_data)
+}
+
+fn copy_folder_parallel(
+    src: &Path,
+    dst: &Path,
+    split_min: u64,
+    range_bytes: u64,
+    max_workers: u32,
+    progress_callback: Option<CopyProgressCallback>,
+    cancel_flag: *const AtomicBool,
+    user_data: *mut c_void,
+) -> i32 {
+    let plan = match plan_folder_copy(src, dst, split_min, range_bytes) {
+        Ok(plan) => plan,
+        Err(code) => return code,
+    };
+
+    let workers = match max_workers {
+        0 => DEFAULT_FOLDER_COPY_WORKERS,
+        n => n.min(MAX_FOLDER_COPY_WORKERS),
+    } as usize;
+    let workers = workers.min(plan.items.len()).max(1);
+
+    let total_bytes = plan.total_bytes as usize;
+    let total_files = plan.total_files;
+    let bytes_copied = AtomicUsize::new(0);
+    let files_processed = AtomicUsize::new(0);
+    let next_item = AtomicUsize::new(0);
+    let first_error = AtomicI32::new(SUCCESS);
+    let cancel = SharedCancelFlag(cancel_flag);
+    let progress = Mutex::new(FolderCopyProgress {
+        callback: progress_callback,
+        user_data,
+        throttler: ProgressThrottler::new(500),
+    });
+
+    let report = |force: bool| {
+        if let Ok(mut progress) = progress.lock() {
+            let copied = bytes_copied.load(Ordering::Relaxed);
+            if let Some(cb) = progress.callback {
+                if force || progress.throttler.should_update(copied, total_bytes) {
+                    cb(copied, total_bytes, files_processed.load(Ordering::Relaxed), total_files, progress.user_data);
+                }
+            }
+        }
+    };
+
+    std::thread::scope(|scope| {
+        for _ in 0..workers {
+            scope.spawn(|| {
+                let cancel_flag = cancel.get();
+                let plan = &plan;
+                let mut buffer: Vec<u8> = Vec::new();
+                loop {
+                    if first_error.load(Ordering::Relaxed) != SUCCESS {
+                        return;
+                    }
+                    if unsafe { is_cancelled(cancel_flag) } {
+                        let _ = first_error.compare_exchange(SUCCESS, ERROR_CANCELLED, Ordering::Relaxed, Ordering::Relaxed);
+                        return;
+                    }
+                    let item = match plan.items.get(next_item.fetch_add(1, Ordering::Relaxed)) {
+                        Some(item) => item,
+                        None => return,
+                    };
+
+                    let result = match item {
+                        FolderCopyItem::File { src, dst, size } => {
+                            let mut offloaded = 0u64;
+                            let result = match offload_copy(src, dst, *size, cancel_flag, &mut |done| {
+                                bytes_copied.fetch_add((done - offloaded) as usize, Ordering::Relaxed);
+                                offloaded = done;
+                                report(false);
+                            }) {
+                                Ok(Offload::Copied) => SUCCESS,
+                                Ok(Offload::Unsupported) => match copy_single_file_buffered(src, dst) {
+                                    Ok(()) => SUCCESS,
+                                    Err(_) => ERROR_IO_FAILED,
+                                },
+                                Err(code) => code,
+                            };
+                            if result == SUCCESS {
+                                // Credit what the offload did not report (all of it for buffered copies)
+                                bytes_copied.fetch_add((*size - offloaded.min(*size)) as usize, Ordering::Relaxed);
+                                files_processed.fetch_add(1, Ordering::Relaxed);
+                            }
+                            result
+                        }
+                        FolderCopyItem::Range { file, offset, len } => {
+                            let split = &plan.split_files[*file];
+                            let handles = match split.claim() {
+                                Ok(SplitClaim::Copy(handles)) => Some(handles),
+                                Ok(SplitClaim::Cloned) => {
+                                    bytes_copied.fetch_add(split.size as usize, Ordering::Relaxed);
+                                    files_processed.fetch_add(1, Ordering::Relaxed);
+                                    None
+                                }
+                                Ok(SplitClaim::Skip) => None,
+                                Err(code) => {
+                                    let _ = first_error.compare_exchange(SUCCESS, code, Ordering::Relaxed, Ordering::Relaxed);
+                                    return;
+                                }
+                            };
+                            match handles {
+                                None => SUCCESS,
+                                Some(handles) => {
+                                    let mut on_bytes = |n: u64| {
+                                        bytes_copied.fetch_add(n as usize, Ordering::Relaxed);
+                                        report(false);
+                                    };
+                                    let result = match offload_copy_range(&handles.source, &handles.dest, *offset, *len, cancel_flag, &mut on_bytes) {
+                                        Ok(Offload::Copied) => SUCCESS,
+                                        Ok(Offload::Unsupported) => {
+                                            if buffer.is_empty() {
+                                                buffer = vec![0u8; FOLDER_COPY_BUFFER_BYTES];
+                                            }
+                                            copy_range_buffered(&handles, *offset, *len, &mut buffer, cancel_flag, &mut on_bytes)
+                                        }
+                                        Err(code) => code,
+                                    };
+                                    drop(handles);
+                                    if result == SUCCESS && split.ranges_left.fetch_sub(1, Ordering::AcqRel) == 1 {
+                                        split.finish();
+                                        files_processed.fetch_add(1, Ordering::Relaxed);
+                                    }
+                                    result
+                                }
+                            }
+                        }
+                    };
+
+                    if result != SUCCESS {
+                        let _ = first_error.compare_exchange(SUCCESS, result, Ordering::Relaxed, Ordering::Relaxed);
+                        return;
+                    }
+                    report(false);
+                }
+            });
+        }
+    });
+
+    let result = first_error.load(Ordering::Relaxed);
+    if result == SUCCESS {
+        report(true);
+    } else {
+        // Leave no preallocated, partly written large files behind
+        for split in &plan.split_files {
+            split.discard();
+        }
+    }
+    result
+}
+
 // ============================================================================
 // CHUNKED STREAMING COPY FOR CROSS-ACCOUNT TRANSFER
 // ============================================================================
@@ -696,6 +1203,54 @@ pub extern "C" fn chunked_copy_open_source(context: *mut ChunkedCopyContext) ->
     SUCCESS
 }
 
+/// Copy the whole file with the OS copy offload instead of chunk by chunk
+///
+/// Must be called before the first chunk is read or written. Progress is reported through
+/// `progress_callback` as the kernel copies, and the cancel flag is honoured.
+///
+/// # Arguments
+/// * `context` - Pointer to ChunkedCopyContext
+/// * `progress_callback` - Optional progress callback
+/// * `user_data` - User data for callback
+///
+/// # Returns
+/// 0 if the file was copied, 1 if the OS cannot copy it (continue with
+/// chunked_copy_read_chunk / chunked_copy_write_chunk), negative error code on failure
+#[no_mangle]
+pub extern "C" fn chunked_copy_offload(
+    context: *mut ChunkedCopyContext,
+    progress_callback: Option<CopyProgressCallback>,
+    user_data: *mut c_void,
+) -> i32 {
+    if context.is_null() {
+        return ERROR_NULL_POINTER;
+    }
+
+    let ctx = unsafe { &mut *context };
+    if ctx.bytes_copied > 0 || ctx.dest_file.is_some() {
+        return ERROR_IO_FAILED;
+    }
+
+    let total_bytes = ctx.total_bytes;
+    let throttler = &mut ctx.progress_throttler;
+    let result = offload_copy(&ctx.source_path, &ctx.dest_path, total_bytes as u64, ctx.cancel_flag, &mut |done| {
+        if let Some(cb) = progress_callback {
+            if throttler.should_update(done as usize, total_bytes) {
+                cb(done as usize, total_bytes, 1, 1, user_data);
+            }
+        }
+    });
+
+    match result {
+        Ok(Offload::Copied) => {
+            ctx.bytes_copied = total_bytes;
+            SUCCESS
+        }
+        Ok(Offload::Unsupported) => 1,
+        Err(code) => code,
+    }
+}
+
 /// Read next chunk from source file
 ///
 /// # Arguments
@@ -915,6 +1470,10 @@ pub extern "C" fn chunked_copy_get_progress(
 // CLOUD-TO-CLOUD STREAMING COPY (Rust-orchestrated)
 // ============================================================================
 
+/// Default and maximum number of chunk buffers in a cloud copy read-ahead ring
+const DEFAULT_CLOUD_PIPELINE_DEPTH: usize = 3;
+const MAX_CLOUD_PIPELINE_DEPTH: usize = 16;
+
 /// Context for cloud-to-cloud streaming copy
 #[repr(C)]
 pub struct CloudCopyContext {
@@ -923,6 +1482,10 @@ pub struct CloudCopyContext {
     total_bytes: usize,
     cancel_flag: *const AtomicBool,
     progress_throttler: ProgressThrottler,
+    /// Ring depth requested with cloud_copy_enable_pipeline (0 = alternate read and write)
+    pipeline_depth: usize,
+    /// Read-ahead stage, started by the first chunk once a depth is set
+    pipeline: Option<CloudCopyPipeline>,
 }
 
 impl CloudCopyContext {
@@ -933,7 +1496,103 @@ impl CloudCopyContext {
             total_bytes,
             cancel_flag,
             progress_throttler: ProgressThrottler::new(500),
+            pipeline_depth: 0,
+            pipeline: None,
+        }
+    }
+    
+    /// Stop the read-ahead thread (if any) before the context or user data go away
+    fn shutdown_pipeline(&mut self) {
+        if let Some(pipeline) = self.pipeline.take() {
+            pipeline.shutdown();
+        }
+    }
+}
+
+impl Drop for CloudCopyContext {
+    fn drop(&mut self) {
+        self.shutdown_pipeline();
+    }
+}
+
+/// Raw pointers handed to the read-ahead thread
+///
+/// Both outlive the thread: the cancel flag and user data are owned by the caller for the
+/// whole copy, and `CloudCopyPipeline::shutdown` joins the thread at finalize/free.
+#[derive(Clone, Copy)]
+struct CloudPipelineShared {
+    cancel_flag: *const AtomicBool,
+    user_data: *mut c_void,
+}
+
+unsafe impl Send for CloudPipelineShared {}
+
+/// Read-ahead stage running behind `cloud_copy_process_chunk`
+///
+/// A ring of chunk buffers circulates reader → caller (write) → reader, so the source is
+/// downloading chunk N+1 while the destination receives chunk N. The read callback is
+/// called from the stage's own thread (native callbacks only).
+struct CloudCopyPipeline {
+    ready_rx: mpsc::Receiver<Result<(Vec<u8>, usize), isize>>,
+    free_tx: mpsc::Sender<Vec<u8>>,
+    stop: Arc<AtomicBool>,
+    worker: JoinHandle<()>,
+}
+
+impl CloudCopyPipeline {
+    fn start(read_cb: CloudCopyReadCallback, buffer_size: usize, depth: usize, shared: CloudPipelineShared) -> Self {
+        let (free_tx, free_rx) = mpsc::channel::<Vec<u8>>();
+        let (ready_tx, ready_rx) = mpsc::channel::<Result<(Vec<u8>, usize), isize>>();
+        let stop = Arc::new(AtomicBool::new(false));
+        
+        for _ in 0..depth {
+            let _ = free_tx.send(vec![0u8; buffer_size]);
         }
+        
+        let reader_stop = stop.clone();
+        let worker = std::thread::spawn(move || {
+            let shared = shared;
+            loop {
+                // Blocks here once every buffer is waiting to be written
+                let mut buffer = match free_rx.recv() {
+                    Ok(buffer) => buffer,
+                    Err(_) => return,
+                };
+                if reader_stop.load(Ordering::SeqCst) {
+                    return;
+                }
+                if unsafe { is_cancelled(shared.cancel_flag) } {
+                    let _ = ready_tx.send(Err(ERROR_CANCELLED as isize));
+                    return;
+                }
+                
+                let bytes_read = read_cb(buffer.as_mut_ptr(), buffer.len(), shared.user_data);
+                if bytes_read <= 0 {
+                    // EOF ends the stage; errors are reported to the caller first
+                    if bytes_read < 0 {
+                        let _ = ready_tx.send(Err(bytes_read));
+                    }
+                    return;
+                }
+                
+                let len = (bytes_read as usize).min(buffer.len());
+                if ready_tx.send(Ok((buffer, len))).is_err() {
+                    return;
+                }
+            }
+        });
+        
+        CloudCopyPipeline { ready_rx, free_tx, stop, worker }
+    }
+    
+    /// Stop the stage and wait for it to exit
+    fn shutdown(self) {
+        let CloudCopyPipeline { ready_rx, free_tx, stop, worker } = self;
+        stop.store(true, Ordering::SeqCst);
+        // Dropping our channel ends unblocks the reader waiting on a send or a free buffer
+        drop(ready_rx);
+        drop(free_tx);
+        let _ = worker.join();
     }
 }
 
@@ -978,9 +1637,44 @@ pub type CloudCopyReadCallback = extern "C" fn(buffer: *mut u8, buffer_size: usi
 /// Write callback type for cloud copy
 pub type CloudCopyWriteCallback = extern "C" fn(data: *const u8, data_len: usize, user_data: *mut c_void) -> i32;
 
+/// Overlap reads and writes of a cloud copy
+///
+/// After this call, the first `cloud_copy_process_chunk` starts a background thread
+/// that keeps calling that call's read callback (with its buffer size and user data)
+/// into a ring of `depth` buffers. Each `cloud_copy_process_chunk` then writes the next
+/// chunk already read, while the following chunks download. Every later call must pass
+/// the same read callback and user data; the read callback runs on the background thread.
+/// It must therefore be a native function: a Dart callback may only run on its isolate's
+/// thread, so Dart callers copy without the pipeline.
+///
+/// # Arguments
+/// * `context` - Pointer to CloudCopyContext
+/// * `depth` - Number of chunk buffers in the ring (0 = default of 3, minimum 2, maximum 16)
+///
+/// # Returns
+/// 0 on success, error code on failure (e.g. chunks were already processed)
+#[no_mangle]
+pub extern "C" fn cloud_copy_enable_pipeline(context: *mut CloudCopyContext, depth: u32) -> i32 {
+    if context.is_null() {
+        return ERROR_NULL_POINTER;
+    }
+    
+    let ctx = unsafe { &mut *context };
+    if ctx.pipeline.is_some() || ctx.bytes_copied > 0 {
+        return ERROR_IO_FAILED;
+    }
+    
+    ctx.pipeline_depth = match depth {
+        0 => DEFAULT_CLOUD_PIPELINE_DEPTH,
+        n => (n as usize).max(2).min(MAX_CLOUD_PIPELINE_DEPTH),
+    };
+    SUCCESS
+}
+
 /// Execute one chunk of cloud-to-cloud copy
 ///
 /// Rust orchestrates: read from source → write to dest
+/// (with cloud_copy_enable_pipeline, the read has already happened in the background)
 ///
 /// # Arguments
 /// * `context` - Pointer to CloudCopyContext
@@ -1024,27 +1718,62 @@ pub extern "C" fn cloud_copy_process_chunk(
         None => return ERROR_NULL_POINTER as isize,
     };
     
-    // Read chunk from source
-    let bytes_read = read_cb(read_buffer, buffer_size, user_data);
-    
-    if bytes_read < 0 {
-        eprintln!("[RUST] ❌ cloud_copy_process_chunk: read error {}", bytes_read);
-        return bytes_read; // Error from read callback
-    }
-    
-    if bytes_read == 0 {
-        // EOF - return 0 to indicate done
-        eprintln!("[RUST] 📊 cloud_copy_process_chunk: EOF reached, bytes_copied={}", ctx.bytes_copied);
-        return 0;
+    // Pipelined mode: start the read-ahead stage with the first chunk
+    if ctx.pipeline_depth > 1 && ctx.pipeline.is_none() && ctx.bytes_copied == 0 {
+        ctx.pipeline = Some(CloudCopyPipeline::start(
+            read_cb,
+            buffer_size,
+            ctx.pipeline_depth,
+            CloudPipelineShared { cancel_flag: ctx.cancel_flag, user_data },
+        ));
     }
     
-    // Write chunk to destination
-    let write_result = write_cb(read_buffer, bytes_read as usize, user_data);
-    
-    if write_result < 0 {
-        eprintln!("[RUST] ❌ cloud_copy_process_chunk: write error {}", write_result);
-        return write_result as isize;
-    }
+    let bytes_read = if let Some(pipeline) = ctx.pipeline.as_ref() {
+        let (buffer, len) = match pipeline.ready_rx.recv() {
+            Ok(Ok(chunk)) => chunk,
+            Ok(Err(code)) => {
+                eprintln!("[RUST] ❌ cloud_copy_process_chunk: read error {}", code);
+                return code;
+            }
+            Err(_) => {
+                // Read stage finished: EOF
+                eprintln!("[RUST] 📊 cloud_copy_process_chunk: EOF reached, bytes_copied={}", ctx.bytes_copied);
+                return 0;
+            }
+        };
+        
+        // Write straight from the ring buffer, then hand it back for the next read
+        let write_result = write_cb(buffer.as_ptr(), len, user_data);
+        let _ = pipeline.free_tx.send(buffer);
+        if write_result < 0 {
+            eprintln!("[RUST] ❌ cloud_copy_process_chunk: write error {}", write_result);
+            return write_result as isize;
+        }
+        len as isize
+    } else {
+        // Read chunk from source
+        let bytes_read = read_cb(read_buffer, buffer_size, user_data);
+        
+        if bytes_read < 0 {
+            eprintln!("[RUST] ❌ cloud_copy_process_chunk: read error {}", bytes_read);
+            return bytes_read; // Error from read callback
+        }
+        
+        if bytes_read == 0 {
+            // EOF - return 0 to indicate done
+            eprintln!("[RUST] 📊 cloud_copy_process_chunk: EOF reached, bytes_copied={}", ctx.bytes_copied);
+            return 0;
+        }
+        
+        // Write chunk to destination
+        let write_result = write_cb(read_buffer, bytes_read as usize, user_data);
+        
+        if write_result < 0 {
+            eprintln!("[RUST] ❌ cloud_copy_process_chunk: write error {}", write_result);
+            return write_result as isize;
+        }
+        bytes_read
+    };
     
     ctx.bytes_copied += bytes_read as usize;
     
@@ -1073,6 +1802,7 @@ pub extern "C" fn cloud_copy_finalize(context: *mut CloudCopyContext) -> i32 {
     }
     
     let ctx = unsafe { &mut *context };
+    ctx.shutdown_pipeline();
     
     eprintln!("[RUST] ✅ cloud_copy_finalize: total bytes copied={}", ctx.bytes_copied);
     
@@ -1109,4 +1839,73 @@ pub extern "C" fn cloud_copy_get_progress(
     if !total_bytes.is_null() {
         unsafe { *total_bytes = ctx.total_bytes; }
     }
-}
\ No newline at end of file
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::sync::atomic::AtomicUsize;
+
+    static LAST_FILES_PROCESSED: AtomicUsize = AtomicUsize::new(0);
+
+    extern "C" fn record_progress(_bytes: usize, _total: usize, files: usize, _total_files: usize, _user_data: *mut c_void) {
+        LAST_FILES_PROCESSED.store(files, Ordering::Relaxed);
+    }
+
+    #[test]
+    fn test_folder_copy_parallel_tree() {
+        let root = std::env::temp_dir().join(format!("cn_folder_copy_{}", std::process::id()));
+        let src = root.join("src");
+        let dst = root.join("dst");
+        fs::create_dir_all(src.join("a/b")).unwrap();
+        fs::create_dir_all(src.join("empty")).unwrap();
+        let large: Vec<u8> = (0..300_000).map(|i| (i % 241) as u8).collect();
+        fs::write(src.join("large.bin"), &large).unwrap();
+        fs::write(src.join("a/one.txt"), b"one").unwrap();
+        fs::write(src.join("a/b/two.txt"), b"two").unwrap();
+        fs::write(src.join("a/b/zero.txt"), b"").unwrap();
+
+        // Split anything over 100KB into 64KB ranges to exercise the range workers
+        let result = copy_folder_parallel(&src, &dst, 100_000, 64 * 1024, 3, Some(record_progress), ptr::null(), ptr::null_mut());
+
+        assert_eq!(result, SUCCESS);
+        assert_eq!(fs::read(dst.join("large.bin")).unwrap(), large);
+        assert_eq!(fs::read(dst.join("a/one.txt")).unwrap(), b"one");
+        assert_eq!(fs::read(dst.join("a/b/two.txt")).unwrap(), b"two");
+        assert_eq!(fs::read(dst.join("a/b/zero.txt")).unwrap(), b"");
+        assert!(dst.join("empty").is_dir());
+        assert_eq!(LAST_FILES_PROCESSED.load(Ordering::Relaxed), 4);
+        fs::remove_dir_all(&root).ok();
+    }
+
+    /// Sets the cancel flag passed as user data on the first progress report
+    extern "C" fn cancel_on_progress(_bytes: usize, _total: usize, _files: usize, _total_files: usize, user_data: *mut c_void) {
+        unsafe { (*(user_data as *const AtomicBool)).store(true, Ordering::SeqCst) };
+    }
+
+    #[test]
+    fn test_folder_copy_parallel_cancel_removes_partial_ranges() {
+        let root = std::env::temp_dir().join(format!("cn_folder_copy_cancel_{}", std::process::id()));
+        let src = root.join("src");
+        let dst = root.join("dst");
+        fs::create_dir_all(&src).unwrap();
+        let large: Vec<u8> = (0..400_000).map(|i| (i % 239) as u8).collect();
+        for name in ["a.bin", "b.bin", "c.bin"] {
+            fs::write(src.join(name), &large).unwrap();
+        }
+
+        // One worker, 16KB ranges: the first report cancels long before every range is done
+        let cancel = AtomicBool::new(false);
+        let cancel_ptr = &cancel as *const AtomicBool;
+        let result = copy_folder_parallel(&src, &dst, 100_000, 16 * 1024, 1, Some(cancel_on_progress), cancel_ptr, cancel_ptr as *mut c_void);
+
+        assert_eq!(result, ERROR_CANCELLED);
+        for name in ["a.bin", "b.bin", "c.bin"] {
+            // Either cloned whole or not there at all, never a preallocated partial file
+            if let Ok(copied) = fs::read(dst.join(name)) {
+                assert_eq!(copied, large);
+            }
+        }
+        fs::remove_dir_all(&root).ok();
+    }
+}
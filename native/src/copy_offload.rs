@@ -0,0 +1,507 @@
+/// Kernel copy offload for local file copies
+///
+/// Lets the OS copy file data without bouncing it through user-space buffers:
+/// - Linux: FICLONE reflink (btrfs, XFS, bcachefs), then copy_file_range
+/// - Windows: CopyFileExW, unbuffered for large files; ReFS block cloning for offload_clone
+/// - macOS: clonefile (APFS copy-on-write)
+///
+/// Callers fall back to their buffered loop when the offload reports `Unsupported`.
+/// `offload_clone` is the copy-on-write part alone, for callers that would rather split a
+/// file across workers than have one worker stream it.
+use std::path::Path;
+use std::sync::atomic::AtomicBool;
+
+use crate::file_io::{ERROR_CANCELLED, is_cancelled};
+
+/// Result of an offload attempt
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub(crate) enum Offload {
+    /// The file was copied completely
+    Copied,
+    /// Nothing was copied; use the buffered copy instead
+    Unsupported,
+}
+
+/// Copy `src` to `dst` (created or truncated) with the platform's copy offload
+///
+/// `progress` receives the total bytes copied so far. The cancel flag is checked between
+/// kernel calls; a cancelled copy returns `Err(ERROR_CANCELLED)` and may leave a partial
+/// destination behind, like the buffered copy. Other errors after data was copied are
+/// returned as their FFI error code.
+pub(crate) fn offload_copy(
+    src: &Path,
+    dst: &Path,
+    total_bytes: u64,
+    cancel_flag: *const AtomicBool,
+    progress: &mut dyn FnMut(u64),
+) -> Result<Offload, i32> {
+    if unsafe { is_cancelled(cancel_flag) } {
+        return Err(ERROR_CANCELLED);
+    }
+    platform::offload_copy(src, dst, total_bytes, cancel_flag, progress)
+}
+
+/// Clone `src` to `dst` (created or truncated) if the filesystem can share extents
+///
+/// Constant time regardless of file size. Returns `Unsupported` without copying any
+/// data when the platform or filesystem has no clone (the destination may then be left
+/// empty); there is no streaming fallback, unlike `offload_copy`.
+pub(crate) fn offload_clone(src: &Path, dst: &Path) -> Result<Offload, i32> {
+    platform::offload_clone(src, dst)
+}
+
+/// Copy `len` bytes at `offset` between two open files with the platform's copy offload
+///
+/// Used for the ranges of a large file copied by several workers at once; the files are
+/// shared and positions are explicit, so ranges may run concurrently. `progress`
+/// receives the bytes of each completed slice. Returns `Unsupported` (before copying
+/// anything) when the ranges must be copied through buffers instead.
+pub(crate) fn offload_copy_range(
+    src: &std::fs::File,
+    dst: &std::fs::File,
+    offset: u64,
+    len: u64,
+    cancel_flag: *const AtomicBool,
+    progress: &mut dyn FnMut(u64),
+) -> Result<Offload, i32> {
+    platform::offload_copy_range(src, dst, offset, len, cancel_flag, progress)
+}
+
+// ============================================================================
+// Linux: FICLONE / copy_file_range
+// ============================================================================
+
+#[cfg(target_os = "linux")]
+mod platform {
+    use super::*;
+    use std::fs::File;
+    use std::io;
+    use std::os::unix::io::AsRawFd;
+
+    use crate::file_io::{ERROR_FILE_NOT_FOUND, ERROR_IO_FAILED, ERROR_PERMISSION_DENIED};
+
+    /// Bytes per copy_file_range call, bounding how long a cancel takes to be seen
+    const SLICE_BYTES: usize = 16 * 1024 * 1024;
+
+    pub(super) fn offload_copy(
+        src: &Path,
+        dst: &Path,
+        total_bytes: u64,
+        cancel_flag: *const AtomicBool,
+        progress: &mut dyn FnMut(u64),
+    ) -> Result<Offload, i32> {
+        let src_file = File::open(src).map_err(|_| ERROR_FILE_NOT_FOUND)?;
+        let dst_file = File::create(dst).map_err(|_| ERROR_PERMISSION_DENIED)?;
+
+        if reflink(&src_file, &dst_file) {
+            progress(total_bytes);
+            return Ok(Offload::Copied);
+        }
+
+        let mut copied = 0u64;
+        loop {
+            if unsafe { is_cancelled(cancel_flag) } {
+                return Err(ERROR_CANCELLED);
+            }
+
+            let result = unsafe {
+                libc::copy_file_range(
+                    src_file.as_raw_fd(),
+                    std::ptr::null_mut(),
+                    dst_file.as_raw_fd(),
+                    std::ptr::null_mut(),
+                    SLICE_BYTES,
+                    0,
+                )
+            };
+            if result < 0 {
+                let error = io::Error::last_os_error();
+                // Not offloadable here (old kernel, cross-device, special file): nothing
+                // was written yet, so the buffered copy can start over
+                if copied == 0 && is_unsupported(&error) {
+                    return Ok(Offload::Unsupported);
+                }
+                if error.kind() == io::ErrorKind::Interrupted {
+                    continue;
+                }
+                return Err(ERROR_IO_FAILED);
+            }
+            if result == 0 {
+                break;
+            }
+
+            copied += result as u64;
+            progress(copied);
+        }
+
+        // Files whose size is not known up front (e.g. /proc) read as empty here
+        if copied == 0 && total_bytes > 0 {
+            return Ok(Offload::Unsupported);
+        }
+        Ok(Offload::Copied)
+    }
+
+    pub(super) fn offload_clone(src: &Path, dst: &Path) -> Result<Offload, i32> {
+        let src_file = File::open(src).map_err(|_| ERROR_FILE_NOT_FOUND)?;
+        let dst_file = File::create(dst).map_err(|_| ERROR_PERMISSION_DENIED)?;
+        Ok(if reflink(&src_file, &dst_file) { Offload::Copied } else { Offload::Unsupported })
+    }
+
+    /// Reflink: shares the source extents, no data is copied at all
+    fn reflink(src: &File, dst: &File) -> bool {
+        unsafe { libc::ioctl(dst.as_raw_fd(), libc::FICLONE, src.as_raw_fd()) == 0 }
+    }
+
+    pub(super) fn offload_copy_range(
+        src: &File,
+        dst: &File,
+        offset: u64,
+        len: u64,
+        cancel_flag: *const AtomicBool,
+        progress: &mut dyn FnMut(u64),
+    ) -> Result<Offload, i32> {
+        let mut src_offset = offset as libc::loff_t;
+        let mut dst_offset = offset as libc::loff_t;
+        let mut remaining = len;
+        while remaining > 0 {
+            if unsafe { is_cancelled(cancel_flag) } {
+                return Err(ERROR_CANCELLED);
+            }
+
+            let request = remaining.min(SLICE_BYTES as u64) as usize;
+            let result = unsafe {
+                libc::copy_file_range(src.as_raw_fd(), &mut src_offset, dst.as_raw_fd(), &mut dst_offset, request, 0)
+            };
+            if result < 0 {
+                let error = io::Error::last_os_error();
+                if remaining == len && is_unsupported(&error) {
+                    return Ok(Offload::Unsupported);
+                }
+                if error.kind() == io::ErrorKind::Interrupted {
+                    continue;
+                }
+                return Err(ERROR_IO_FAILED);
+            }
+            if result == 0 {
+                // Source shrank while copying
+                return Err(ERROR_IO_FAILED);
+            }
+
+            remaining -= result as u64;
+            progress(result as u64);
+        }
+        Ok(Offload::Copied)
+    }
+
+    fn is_unsupported(error: &io::Error) -> bool {
+        matches!(
+            error.raw_os_error(),
+            Some(libc::ENOSYS) | Some(libc::EXDEV) | Some(libc::EINVAL) | Some(libc::EOPNOTSUPP)
+                | Some(libc::EPERM) | Some(libc::EBADF)
+        )
+    }
+}
+
+// ============================================================================
+// Windows: CopyFileExW / block cloning
+// ============================================================================
+
+#[cfg(target_os = "windows")]
+mod platform {
+    use super::*;
+    use std::ffi::c_void;
+    use std::os::windows::ffi::OsStrExt;
+    use std::os::windows::io::AsRawHandle;
+
+    use crate::file_io::{ERROR_FILE_NOT_FOUND, ERROR_PERMISSION_DENIED};
+
+    /// Files at least this large are copied unbuffered (no page-cache pollution)
+    const NO_BUFFERING_MIN_BYTES: u64 = 256 * 1024 * 1024;
+    const COPY_FILE_NO_BUFFERING: u32 = 0x0000_1000;
+    const PROGRESS_CONTINUE: u32 = 0;
+    const PROGRESS_CANCEL: u32 = 1;
+    const ERROR_REQUEST_ABORTED: u32 = 1235;
+    const FSCTL_DUPLICATE_EXTENTS_TO_FILE: u32 = 0x0009_8344;
+    /// Bytes per block-clone request: a multiple of every ReFS cluster size (4KB, 64KB),
+    /// below the 4GB limit of one request
+    const CLONE_SLICE_BYTES: u64 = 1024 * 1024 * 1024;
+    const CLONE_ALIGN: u64 = 64 * 1024;
+
+    #[repr(C)]
+    struct DuplicateExtentsData {
+        file_handle: *mut c_void,
+        source_file_offset: i64,
+        target_file_offset: i64,
+        byte_count: i64,
+    }
+
+    type ProgressRoutine = extern "system" fn(
+        total_file_size: i64,
+        total_bytes_transferred: i64,
+        stream_size: i64,
+        stream_bytes_transferred: i64,
+        stream_number: u32,
+        callback_reason: u32,
+        source_file: *mut c_void,
+        destination_file: *mut c_void,
+        data: *mut c_void,
+    ) -> u32;
+
+    extern "system" {
+        fn CopyFileExW(
+            existing_file_name: *const u16,
+            new_file_name: *const u16,
+            progress_routine: Option<ProgressRoutine>,
+            data: *mut c_void,
+            cancel: *mut i32,
+            copy_flags: u32,
+        ) -> i32;
+        fn GetLastError() -> u32;
+        fn DeviceIoControl(
+            device: *mut c_void,
+            io_control_code: u32,
+            in_buffer: *const c_void,
+            in_buffer_size: u32,
+            out_buffer: *mut c_void,
+            out_buffer_size: u32,
+            bytes_returned: *mut u32,
+            overlapped: *mut c_void,
+        ) -> i32;
+    }
+
+    /// State handed to the progress routine
+    struct CopyProgress<'a> {
+        cancel_flag: *const AtomicBool,
+        progress: &'a mut dyn FnMut(u64),
+    }
+
+    extern "system" fn progress_routine(
+        _total_file_size: i64,
+        total_bytes_transferred: i64,
+        _stream_size: i64,
+        _stream_bytes_transferred: i64,
+        _stream_number: u32,
+        _callback_reason: u32,
+        _source_file: *mut c_void,
+        _destination_file: *mut c_void,
+        data: *mut c_void,
+    ) -> u32 {
+        let state = unsafe { &mut *(data as *mut CopyProgress) };
+        if unsafe { is_cancelled(state.cancel_flag) } {
+            return PROGRESS_CANCEL;
+        }
+        (state.progress)(total_bytes_transferred as u64);
+        PROGRESS_CONTINUE
+    }
+
+    fn wide(path: &Path) -> Vec<u16> {
+        path.as_os_str().encode_wide().chain(std::iter::once(0)).collect()
+    }
+
+    pub(super) fn offload_copy(
+        src: &Path,
+        dst: &Path,
+        total_bytes: u64,
+        cancel_flag: *const AtomicBool,
+        progress: &mut dyn FnMut(u64),
+    ) -> Result<Offload, i32> {
+        let src_w = wide(src);
+        let dst_w = wide(dst);
+        let flags = if total_bytes >= NO_BUFFERING_MIN_BYTES { COPY_FILE_NO_BUFFERING } else { 0 };
+        let mut state = CopyProgress { cancel_flag, progress };
+
+        let ok = unsafe {
+            CopyFileExW(
+                src_w.as_ptr(),
+                dst_w.as_ptr(),
+                Some(progress_routine),
+                &mut state as *mut CopyProgress as *mut c_void,
+                std::ptr::null_mut(),
+                flags,
+            )
+        };
+        if ok != 0 {
+            (state.progress)(total_bytes);
+            return Ok(Offload::Copied);
+        }
+
+        // CopyFileExW removes the partial destination on failure
+        if unsafe { GetLastError() } == ERROR_REQUEST_ABORTED {
+            return Err(ERROR_CANCELLED);
+        }
+        Ok(Offload::Unsupported)
+    }
+
+    /// Block cloning (ReFS, Dev Drive): the destination shares the source clusters
+    ///
+    /// Fails on the first request on volumes without it. The last slice is rounded up to
+    /// the cluster size, which the destination's preset end of file allows.
+    pub(super) fn offload_clone(src: &Path, dst: &Path) -> Result<Offload, i32> {
+        let src_file = std::fs::File::open(src).map_err(|_| ERROR_FILE_NOT_FOUND)?;
+        let size = src_file.metadata().map_err(|_| ERROR_FILE_NOT_FOUND)?.len();
+        let dst_file = std::fs::File::create(dst).map_err(|_| ERROR_PERMISSION_DENIED)?;
+        if dst_file.set_len(size).is_err() {
+            return Ok(Offload::Unsupported);
+        }
+
+        let mut offset = 0u64;
+        while offset < size {
+            let len = (size - offset).min(CLONE_SLICE_BYTES);
+            let request = DuplicateExtentsData {
+                file_handle: src_file.as_raw_handle() as *mut c_void,
+                source_file_offset: offset as i64,
+                target_file_offset: offset as i64,
+                byte_count: ((len + CLONE_ALIGN - 1) / CLONE_ALIGN * CLONE_ALIGN) as i64,
+            };
+            let mut returned = 0u32;
+            let ok = unsafe {
+                DeviceIoControl(
+                    dst_file.as_raw_handle() as *mut c_void,
+                    FSCTL_DUPLICATE_EXTENTS_TO_FILE,
+                    &request as *const DuplicateExtentsData as *const c_void,
+                    std::mem::size_of::<DuplicateExtentsData>() as u32,
+                    std::ptr::null_mut(),
+                    0,
+                    &mut returned,
+                    std::ptr::null_mut(),
+                )
+            };
+            if ok == 0 {
+                // Callers copy the bytes instead, which overwrites anything cloned so far
+                return Ok(Offload::Unsupported);
+            }
+            offset += len;
+        }
+        Ok(Offload::Copied)
+    }
+
+    pub(super) fn offload_copy_range(
+        _src: &std::fs::File,
+        _dst: &std::fs::File,
+        _offset: u64,
+        _len: u64,
+        _cancel_flag: *const AtomicBool,
+        _progress: &mut dyn FnMut(u64),
+    ) -> Result<Offload, i32> {
+        Ok(Offload::Unsupported)
+    }
+}
+
+// ============================================================================
+// macOS: clonefile
+// ============================================================================
+
+#[cfg(target_os = "macos")]
+mod platform {
+    use super::*;
+    use std::ffi::CString;
+    use std::os::unix::ffi::OsStrExt;
+
+    pub(super) fn offload_copy(
+        src: &Path,
+        dst: &Path,
+        total_bytes: u64,
+        _cancel_flag: *const AtomicBool,
+        progress: &mut dyn FnMut(u64),
+    ) -> Result<Offload, i32> {
+        let outcome = offload_clone(src, dst)?;
+        if outcome == Offload::Copied {
+            progress(total_bytes);
+        }
+        Ok(outcome)
+    }
+
+    pub(super) fn offload_clone(src: &Path, dst: &Path) -> Result<Offload, i32> {
+        // clonefile never overwrites; existing destinations go through the buffered copy
+        if dst.exists() {
+            return Ok(Offload::Unsupported);
+        }
+
+        let (src_c, dst_c) = match (
+            CString::new(src.as_os_str().as_bytes()),
+            CString::new(dst.as_os_str().as_bytes()),
+        ) {
+            (Ok(src_c), Ok(dst_c)) => (src_c, dst_c),
+            _ => return Ok(Offload::Unsupported),
+        };
+
+        // Copy-on-write clone: constant time regardless of file size
+        if unsafe { libc::clonefile(src_c.as_ptr(), dst_c.as_ptr(), 0) } == 0 {
+            return Ok(Offload::Copied);
+        }
+        Ok(Offload::Unsupported)
+    }
+
+    pub(super) fn offload_copy_range(
+        _src: &std::fs::File,
+        _dst: &std::fs::File,
+        _offset: u64,
+        _len: u64,
+        _cancel_flag: *const AtomicBool,
+        _progress: &mut dyn FnMut(u64),
+    ) -> Result<Offload, i32> {
+        Ok(Offload::Unsupported)
+    }
+}
+
+#[cfg(not(any(target_os = "linux", target_os = "windows", target_os = "macos")))]
+mod platform {
+    use super::*;
+
+    pub(super) fn offload_copy(
+        _src: &Path,
+        _dst: &Path,
+        _total_bytes: u64,
+        _cancel_flag: *const AtomicBool,
+        _progress: &mut dyn FnMut(u64),
+    ) -> Result<Offload, i32> {
+        Ok(Offload::Unsupported)
+    }
+
+    pub(super) fn offload_clone(_src: &Path, _dst: &Path) -> Result<Offload, i32> {
+        Ok(Offload::Unsupported)
+    }
+
+    pub(super) fn offload_copy_range(
+        _src: &std::fs::File,
+        _dst: &std::fs::File,
+        _offset: u64,
+        _len: u64,
+        _cancel_flag: *const AtomicBool,
+        _progress: &mut dyn FnMut(u64),
+    ) -> Result<Offload, i32> {
+        Ok(Offload::Unsupported)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::fs;
+
+    #[test]
+    fn test_offload_copy_matches_source() {
+        let dir = std::env::temp_dir().join(format!("cn_offload_{}", std::process::id()));
+        fs::create_dir_all(&dir).unwrap();
+        let src = dir.join("source.bin");
+        let dst = dir.join("dest.bin");
+        let data: Vec<u8> = (0..3 * 1024 * 1024 + 17).map(|i| (i % 253) as u8).collect();
+        fs::write(&src, &data).unwrap();
+
+        let mut last_progress = 0;
+        let outcome = offload_copy(&src, &dst, data.len() as u64, std::ptr::null(), &mut |done| {
+            last_progress = done;
+        })
+        .unwrap();
+
+        if outcome == Offload::Copied {
+            assert_eq!(fs::read(&dst).unwrap(), data);
+            assert_eq!(last_progress, data.len() as u64);
+        }
+
+        // A set cancel flag stops before anything is copied
+        let cancel = AtomicBool::new(true);
+        assert_eq!(offload_copy(&src, &dst, data.len() as u64, &cancel, &mut |_| {}), Err(ERROR_CANCELLED));
+        fs::remove_dir_all(&dir).ok();
+    }
+}
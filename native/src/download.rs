@@ -1,9 +1,12 @@
 /// Download operations for CloudNexus
 /// Handles streaming file downloads with optional decryption and progress reporting
-use std::fs::File;
+use std::fs::{File, OpenOptions};
 use std::io::{Write, BufWriter};
+use std::collections::BTreeMap;
 use std::path::PathBuf;
-use std::sync::atomic::AtomicBool;
+use std::sync::atomic::{AtomicBool, AtomicI32, AtomicUsize, Ordering};
+use std::sync::{mpsc, Arc, Mutex};
+use std::thread::JoinHandle;
 use std::ffi::{c_char, c_void, CStr};
 use std::ptr;
 use std::slice;
@@ -11,7 +14,12 @@ use std::slice;
 use crate::file_io::{ProgressThrottler, ERROR_NULL_POINTER, ERROR_FILE_NOT_FOUND,
                      ERROR_PERMISSION_DENIED, ERROR_IO_FAILED, ERROR_CANCELLED,
                      ERROR_INVALID_PATH, ERROR_DISK_FULL, SUCCESS, c_str_to_path, is_cancelled};
-use crate::{DecryptionContext, decrypt_chunk, decrypt_file_init, decrypt_file_finalize};
+use crate::{DecryptionContext, SeekableDecryptContext, decrypt_chunk, decrypt_file_init, decrypt_file_finalize,
+            decrypt_chunk_in_place_impl, write_all_at, CHUNK_HEADER_SIZE, CHUNK_PREFIX_SIZE, MAC_SIZE};
+use crate::metrics::{Metrics, MetricsSnapshot, Stage};
+
+/// Default number of encrypted chunks queued for the decrypt workers
+const DEFAULT_PARALLEL_QUEUE_DEPTH: usize = 8;
 
 /// Progress callback for download operations
 pub type DownloadProgressCallback = extern "C" fn(bytes_written: usize, total_bytes: usize, user_data: *mut c_void);
@@ -30,6 +38,8 @@ pub struct DownloadContext {
     progress_throttler: ProgressThrottler,
     is_finalized: bool,
     header_written: bool,
+    parallel: Option<ParallelDownload>,
+    metrics: Arc<Metrics>,
 }
 
 impl DownloadContext {
@@ -47,7 +57,289 @@ impl DownloadContext {
             progress_throttler: ProgressThrottler::new(500),
             is_finalized: false,
             header_written: false,
+            parallel: None,
+            metrics: Arc::new(Metrics::new()),
+        }
+    }
+
+    /// Stop parallel workers (if any) and report the first error they hit
+    fn shutdown_parallel(&mut self) -> i32 {
+        match self.parallel.take() {
+            Some(parallel) => {
+                let result = parallel.shutdown();
+                self.bytes_written = result.1;
+                result.0
+            }
+            None => SUCCESS,
+        }
+    }
+}
+
+/// One encrypted chunk waiting for a decrypt worker
+struct DecryptJob {
+    chunk: Vec<u8>,
+    chunk_index: u64,
+}
+
+/// What a parallel download has received so far
+///
+/// A byte count alone cannot tell a range delivered twice from one that never arrived, so
+/// every chunk (or, without decryption, every byte range) is claimed exactly once.
+enum Received {
+    /// One bit per chunk index
+    Chunks { bits: Vec<u64>, count: u64, claimed: u64 },
+    /// Raw byte ranges, start -> end, merged when they touch
+    Ranges(BTreeMap<u64, u64>),
+}
+
+impl Received {
+    fn chunks(count: u64) -> Self {
+        Received::Chunks { bits: vec![0; ((count + 63) / 64) as usize], count, claimed: 0 }
+    }
+
+    /// Claim chunks `first..first + count`; claims nothing if any of them was already claimed
+    fn claim_chunks(&mut self, first: u64, count: u64) -> bool {
+        let Received::Chunks { bits, claimed, .. } = self else { return false };
+        let is_set = |bits: &[u64], i: u64| bits[(i / 64) as usize] & (1 << (i % 64)) != 0;
+        if (first..first + count).any(|i| is_set(bits, i)) {
+            return false;
+        }
+        for i in first..first + count {
+            bits[(i / 64) as usize] |= 1 << (i % 64);
+        }
+        *claimed += count;
+        true
+    }
+
+    /// Whether `start..end` overlaps a range already received
+    fn overlaps(&self, start: u64, end: u64) -> bool {
+        let Received::Ranges(ranges) = self else { return true };
+        ranges.range(..end).next_back().map_or(false, |(_, &prev_end)| prev_end > start)
+    }
+
+    /// Record `start..end` as received (call after `overlaps` returned false)
+    fn add_range(&mut self, mut start: u64, mut end: u64) {
+        let Received::Ranges(ranges) = self else { return };
+        if let Some((&prev_start, &prev_end)) = ranges.range(..=start).next_back() {
+            if prev_end == start {
+                ranges.remove(&prev_start);
+                start = prev_start;
+            }
+        }
+        if let Some(next_end) = ranges.remove(&end) {
+            end = next_end;
+        }
+        ranges.insert(start, end);
+    }
+
+    fn is_complete(&self, expected_bytes: usize) -> bool {
+        match self {
+            Received::Chunks { count, claimed, .. } => claimed == count,
+            Received::Ranges(ranges) => {
+                expected_bytes == 0 || (ranges.len() == 1 && ranges.get(&0) == Some(&(expected_bytes as u64)))
+            }
+        }
+    }
+}
+
+/// Out-of-order download state
+///
+/// The output file is preallocated to its final plaintext size. Every chunk's place in it
+/// follows from the chunk index, so workers decrypt chunks in whatever order they arrive and
+/// write each one with a positional write.
+struct ParallelDownload {
+    file: Arc<File>,
+    /// None when not decrypting: ranges are written straight through on the calling thread
+    layout: Option<Arc<SeekableDecryptContext>>,
+    job_tx: Option<mpsc::SyncSender<DecryptJob>>,
+    workers: Vec<JoinHandle<()>>,
+    error: Arc<AtomicI32>,
+    bytes_done: Arc<AtomicUsize>,
+    expected_bytes: usize,
+    received: Mutex<Received>,
+    metrics: Arc<Metrics>,
+}
+
+impl ParallelDownload {
+    fn start(file: File, layout: Option<SeekableDecryptContext>, expected_bytes: usize,
+             num_threads: usize, queue_depth: usize, metrics: Arc<Metrics>) -> Self {
+        let file = Arc::new(file);
+        let layout = layout.map(Arc::new);
+        let error = Arc::new(AtomicI32::new(SUCCESS));
+        let bytes_done = Arc::new(AtomicUsize::new(0));
+        let mut workers = Vec::new();
+        let mut job_tx = None;
+
+        if let Some(layout) = layout.as_ref() {
+            // Bounded queue: appends block once queue_depth chunks are waiting
+            let (tx, rx) = mpsc::sync_channel::<DecryptJob>(queue_depth);
+            let rx = Arc::new(Mutex::new(rx));
+            for _ in 0..num_threads {
+                let (rx, file, layout) = (rx.clone(), file.clone(), layout.clone());
+                let (error, bytes_done, metrics) = (error.clone(), bytes_done.clone(), metrics.clone());
+                workers.push(std::thread::spawn(move || loop {
+                    let job = match rx.lock() {
+                        Ok(rx) => rx.recv(),
+                        Err(_) => return,
+                    };
+                    let Ok(mut job) = job else { return };
+                    metrics.queue_pop();
+                    if error.load(Ordering::Relaxed) != SUCCESS {
+                        continue; // Drain without work after a failure
+                    }
+                    let offset = job.chunk_index * layout.chunk_plain_size();
+                    let decrypt_timer = metrics.time(Stage::Decrypt).with_bytes(job.chunk.len());
+                    let decrypted = decrypt_chunk_in_place_impl(&mut job.chunk, layout.fek());
+                    drop(decrypt_timer);
+                    let result = match decrypted {
+                        Some(len) => {
+                            let _timer = metrics.time(Stage::DiskWrite).with_bytes(len);
+                            write_all_at(&file, &job.chunk[CHUNK_PREFIX_SIZE..CHUNK_PREFIX_SIZE + len], offset)
+                                .map(|_| len)
+                                .map_err(|_| ERROR_IO_FAILED)
+                        }
+                        None => Err(ERROR_IO_FAILED),
+                    };
+                    match result {
+                        Ok(len) => {
+                            bytes_done.fetch_add(len, Ordering::Relaxed);
+                        }
+                        Err(code) => {
+                            let _ = error.compare_exchange(SUCCESS, code, Ordering::Relaxed, Ordering::Relaxed);
+                        }
+                    }
+                }));
+            }
+            job_tx = Some(tx);
+        }
+
+        let received = Mutex::new(match layout.as_ref() {
+            Some(layout) => Received::chunks(layout.chunk_count()),
+            None => Received::Ranges(BTreeMap::new()),
+        });
+        ParallelDownload { file, layout, job_tx, workers, error, bytes_done, expected_bytes, received, metrics }
+    }
+
+    /// Split an encrypted byte range into whole chunks and queue them
+    ///
+    /// A range overlapping one already appended is rejected with ERROR_INVALID_PATH.
+    fn append_range(&self, data: &[u8], encrypted_offset: u64) -> i32 {
+        let layout = match self.layout.as_ref() {
+            Some(layout) => layout,
+            None => {
+                // Raw download: the range lands at the same offset in the output
+                let end = encrypted_offset + data.len() as u64;
+                if end > self.expected_bytes as u64 {
+                    return ERROR_INVALID_PATH;
+                }
+                if data.is_empty() {
+                    return SUCCESS;
+                }
+                if self.received.lock().unwrap_or_else(|e| e.into_inner()).overlaps(encrypted_offset, end) {
+                    return ERROR_INVALID_PATH;
+                }
+                let _timer = self.metrics.time(Stage::DiskWrite).with_bytes(data.len());
+                return match write_all_at(&self.file, data, encrypted_offset) {
+                    Ok(()) => {
+                        // Recorded only once written, so a failed write can be retried
+                        self.received.lock().unwrap_or_else(|e| e.into_inner()).add_range(encrypted_offset, end);
+                        self.bytes_done.fetch_add(data.len(), Ordering::Relaxed);
+                        SUCCESS
+                    }
+                    Err(_) => ERROR_IO_FAILED,
+                };
+            }
+        };
+
+        // Ranges starting at 0 may include the file header and wrapped FEK: skip them
+        let mut position = encrypted_offset;
+        let mut local = 0usize;
+        if position < layout.data_offset() {
+            let skip = (layout.data_offset() - position) as usize;
+            if skip >= data.len() {
+                return SUCCESS;
+            }
+            local = skip;
+            position = layout.data_offset();
+        }
+
+        let stride = layout.chunk_plain_size() + CHUNK_HEADER_SIZE as u64;
+        if (position - layout.data_offset()) % stride != 0 {
+            return ERROR_INVALID_PATH; // Not on a chunk boundary
+        }
+
+        let job_tx = match self.job_tx.as_ref() {
+            Some(tx) => tx,
+            None => return ERROR_IO_FAILED,
+        };
+
+        // Check every chunk header before claiming or queueing any of them
+        let first_index = (position - layout.data_offset()) / stride;
+        let mut chunks = Vec::new();
+        while local < data.len() {
+            let chunk_index = first_index + chunks.len() as u64;
+            if chunk_index >= layout.chunk_count() {
+                return ERROR_INVALID_PATH;
+            }
+            let plain_len = layout.chunk_plain_len(chunk_index) as usize;
+            let chunk_len = plain_len + CHUNK_HEADER_SIZE;
+            if local + chunk_len > data.len() {
+                return ERROR_INVALID_PATH; // Range ends mid-chunk
+            }
+
+            // Chunk header must match the computed layout
+            let chunk = &data[local..local + chunk_len];
+            let stored_index = u32::from_le_bytes([chunk[0], chunk[1], chunk[2], chunk[3]]) as u64;
+            let stored_size = u32::from_le_bytes([chunk[4], chunk[5], chunk[6], chunk[7]]) as usize;
+            if stored_index != chunk_index || stored_size != plain_len + MAC_SIZE {
+                return ERROR_INVALID_PATH;
+            }
+            chunks.push(chunk);
+            local += chunk_len;
+        }
+
+        // A chunk delivered twice would otherwise hide one that never arrives
+        if !self.received.lock().unwrap_or_else(|e| e.into_inner()).claim_chunks(first_index, chunks.len() as u64) {
+            return ERROR_INVALID_PATH;
+        }
+
+        for (chunk_index, chunk) in (first_index..).zip(chunks) {
+            self.metrics.record_allocation(chunk.len());
+            let job = DecryptJob { chunk: chunk.to_vec(), chunk_index };
+            // Time blocked on a full queue shows the workers are the bottleneck
+            let wait_timer = self.metrics.time(Stage::QueueWait);
+            // Count the job before a worker can pop it, or the pop saturates at 0
+            self.metrics.queue_push();
+            if job_tx.send(job).is_err() {
+                self.metrics.queue_pop();
+                return ERROR_IO_FAILED;
+            }
+            drop(wait_timer);
+            self.metrics.add_chunk();
         }
+
+        self.error.load(Ordering::Relaxed)
+    }
+
+    /// Wait for queued chunks, then check that the whole file arrived
+    /// Returns (status, plaintext bytes written)
+    fn shutdown(self) -> (i32, usize) {
+        let ParallelDownload { file, job_tx, workers, error, bytes_done, expected_bytes, received, .. } = self;
+        drop(job_tx);
+        for worker in workers {
+            let _ = worker.join();
+        }
+
+        let written = bytes_done.load(Ordering::Relaxed);
+        let mut status = error.load(Ordering::Relaxed);
+        if status == SUCCESS && file.sync_data().is_err() {
+            status = ERROR_IO_FAILED;
+        }
+        let complete = received.lock().unwrap_or_else(|e| e.into_inner()).is_complete(expected_bytes);
+        if status == SUCCESS && (!complete || written != expected_bytes) {
+            status = ERROR_IO_FAILED; // Some ranges never arrived
+        }
+        (status, written)
     }
 }
 
@@ -231,6 +523,7 @@ pub extern "C" fn download_append_chunk(
         let data_start = 12 + fek_len;
         if data_len > data_start {
             let first_chunk = &encrypted_slice[data_start..];
+            let decrypt_timer = ctx.metrics.time(Stage::Decrypt).with_bytes(first_chunk.len());
             let decrypted = unsafe {
                 decrypt_chunk(
                     dec_ctx,
@@ -244,21 +537,27 @@ pub extern "C" fn download_append_chunk(
                 return ERROR_IO_FAILED;
             }
 
+            drop(decrypt_timer);
+
             let decrypted_size = unsafe { *(&data_len as *const usize as *const usize) };
             let writer = unsafe { &mut *ctx.output_file };
             let decrypted_data = unsafe { slice::from_raw_parts(decrypted, decrypted_size) };
+            let write_timer = ctx.metrics.time(Stage::DiskWrite).with_bytes(decrypted_size);
             if let Err(_) = writer.write_all(decrypted_data) {
                 unsafe { libc::free(decrypted as *mut c_void); }
                 return ERROR_IO_FAILED;
             }
     
+            drop(write_timer);
             unsafe { libc::free(decrypted as *mut c_void); }
             ctx.bytes_written += decrypted_size;
+            ctx.metrics.add_chunk();
         }
 
         // Progress callback
         if let Some(cb) = progress_callback {
             if ctx.progress_throttler.should_update(ctx.bytes_written, ctx.total_bytes) {
+                let _timer = ctx.metrics.time(Stage::CallbackWait);
                 cb(ctx.bytes_written, ctx.total_bytes, user_data);
             }
         }
@@ -271,6 +570,7 @@ pub extern "C" fn download_append_chunk(
         // Decrypt chunk
         let dec_ctx = ctx.decryption_context.unwrap();
         let output_len: usize = 0;
+        let decrypt_timer = ctx.metrics.time(Stage::Decrypt).with_bytes(data_len);
         let decrypted = unsafe {
             decrypt_chunk(
                 dec_ctx,
@@ -284,30 +584,37 @@ pub extern "C" fn download_append_chunk(
             return ERROR_IO_FAILED;
         }
 
+        drop(decrypt_timer);
+
         let decrypted_size = unsafe { *(&output_len as *const usize as *const usize) };
 
         // Write to file
         let writer = unsafe { &mut *ctx.output_file };
         let decrypted_slice = unsafe { std::slice::from_raw_parts(decrypted, decrypted_size) };
+        let write_timer = ctx.metrics.time(Stage::DiskWrite).with_bytes(decrypted_size);
         if let Err(_) = writer.write_all(decrypted_slice) {
             unsafe { libc::free(decrypted as *mut c_void); }
             return ERROR_IO_FAILED;
         }
 
+        drop(write_timer);
         unsafe { libc::free(decrypted as *mut c_void); }
         ctx.bytes_written += decrypted_size;
     } else {
         // No decryption - write raw data
         let writer = unsafe { &mut *ctx.output_file };
+        let _timer = ctx.metrics.time(Stage::DiskWrite).with_bytes(data_len);
         if let Err(_) = writer.write_all(encrypted_slice) {
             return ERROR_IO_FAILED;
         }
         ctx.bytes_written += data_len;
     }
+    ctx.metrics.add_chunk();
 
     // Progress callback
     if let Some(cb) = progress_callback {
         if ctx.progress_throttler.should_update(ctx.bytes_written, ctx.total_bytes) {
+            let _timer = ctx.metrics.time(Stage::CallbackWait);
             cb(ctx.bytes_written, ctx.total_bytes, user_data);
         }
     }
@@ -315,6 +622,151 @@ pub extern "C" fn download_append_chunk(
     SUCCESS
 }
 
+/// Switch a download to parallel, out-of-order mode
+///
+/// After this, ranges of the encrypted file are passed to `download_append_range` in any
+/// order (e.g. straight from several parallel HTTP range requests). Each range must cover
+/// whole chunks; they are decrypted on a worker pool and written at their final offset in
+/// the output file, which is preallocated to the plaintext size. Only files cut into
+/// fixed-size chunks are accepted (see `seekable_decrypt_init`).
+///
+/// The context must have been created with `download_init_with_size` (total bytes = size of
+/// the encrypted file) and no chunk may have been appended yet.
+///
+/// # Arguments
+/// * `context` - Pointer to DownloadContext
+/// * `file_prefix` - Leading bytes of the encrypted file (at least `seekable_decrypt_probe_size()`);
+///   may be null when not decrypting
+/// * `prefix_len` - Length of file_prefix
+/// * `num_threads` - Decrypt worker count (0 = one per available core)
+/// * `max_queued_chunks` - Chunks buffered ahead of the workers before appends block (0 = 8)
+///
+/// # Returns
+/// 0 on success, error code on failure
+#[no_mangle]
+pub extern "C" fn download_enable_parallel(
+    context: *mut DownloadContext,
+    file_prefix: *const u8,
+    prefix_len: usize,
+    num_threads: u32,
+    max_queued_chunks: u32,
+) -> i32 {
+    if context.is_null() {
+        return ERROR_NULL_POINTER;
+    }
+
+    let ctx = unsafe { &mut *context };
+
+    if ctx.parallel.is_some() {
+        return SUCCESS;
+    }
+
+    // Serial appends already started writing sequentially
+    if !ctx.output_file.is_null() || ctx.is_finalized || ctx.total_bytes == 0 {
+        return ERROR_IO_FAILED;
+    }
+
+    let decrypting = ctx.should_decrypt && !ctx.master_key.is_empty();
+    let layout = if decrypting {
+        if file_prefix.is_null() {
+            return ERROR_NULL_POINTER;
+        }
+        let prefix = unsafe { slice::from_raw_parts(file_prefix, prefix_len) };
+        match SeekableDecryptContext::from_prefix(prefix, ctx.total_bytes as u64, &ctx.master_key) {
+            Some(layout) => Some(layout),
+            None => return ERROR_INVALID_PATH,
+        }
+    } else {
+        None
+    };
+    let expected_bytes = match layout.as_ref() {
+        Some(layout) => layout.plaintext_size() as usize,
+        None => ctx.total_bytes,
+    };
+
+    // Preallocate the output so positional writes never extend the file
+    let file = match OpenOptions::new().write(true).create(true).truncate(true).open(&ctx.file_path) {
+        Ok(f) => f,
+        Err(_) => return ERROR_PERMISSION_DENIED,
+    };
+    if file.set_len(expected_bytes as u64).is_err() {
+        return ERROR_DISK_FULL;
+    }
+
+    let num_threads = match num_threads {
+        0 => std::thread::available_parallelism().map(|n| n.get()).unwrap_or(1),
+        n => n as usize,
+    };
+    let queue_depth = match max_queued_chunks {
+        0 => DEFAULT_PARALLEL_QUEUE_DEPTH,
+        n => n as usize,
+    };
+
+    ctx.parallel = Some(ParallelDownload::start(file, layout, expected_bytes, num_threads, queue_depth,
+                                                ctx.metrics.clone()));
+
+    SUCCESS
+}
+
+/// Append a range of the encrypted file in parallel mode
+///
+/// Ranges may arrive in any order. A range starting at offset 0 may include the file
+/// header and wrapped FEK, which are skipped. Every chunk must be appended exactly once: a
+/// range overlapping an earlier one is rejected, and `download_finalize` fails unless every
+/// chunk arrived. Returns once the range's chunks are queued; errors from the workers are
+/// reported by later calls and by `download_finalize`.
+///
+/// # Arguments
+/// * `context` - Pointer to DownloadContext (after `download_enable_parallel`)
+/// * `data` - Pointer to the range bytes
+/// * `data_len` - Length of the range (whole chunks, the last chunk may be the file's short tail)
+/// * `encrypted_offset` - Offset of the range within the encrypted file
+/// * `progress_callback` - Progress callback
+/// * `user_data` - User data
+///
+/// # Returns
+/// 0 on success, error code on failure
+#[no_mangle]
+pub extern "C" fn download_append_range(
+    context: *mut DownloadContext,
+    data: *const u8,
+    data_len: usize,
+    encrypted_offset: u64,
+    progress_callback: Option<DownloadProgressCallback>,
+    user_data: *mut c_void,
+) -> i32 {
+    if context.is_null() || data.is_null() {
+        return ERROR_NULL_POINTER;
+    }
+
+    let ctx = unsafe { &mut *context };
+
+    // Check cancellation
+    if unsafe { is_cancelled(ctx.cancel_flag) } {
+        return ERROR_CANCELLED;
+    }
+
+    let parallel = match ctx.parallel.as_ref() {
+        Some(parallel) => parallel,
+        None => return ERROR_IO_FAILED,
+    };
+
+    let data_slice = unsafe { slice::from_raw_parts(data, data_len) };
+    let result = parallel.append_range(data_slice, encrypted_offset);
+
+    ctx.bytes_written = parallel.bytes_done.load(Ordering::Relaxed);
+
+    // Progress callback
+    if let Some(cb) = progress_callback {
+        if ctx.progress_throttler.should_update(ctx.bytes_written, parallel.expected_bytes) {
+            let _timer = ctx.metrics.time(Stage::CallbackWait);
+            cb(ctx.bytes_written, parallel.expected_bytes, user_data);
+        }
+    }
+
+    result
+}
+
 /// Append decrypted data directly (bypasses decryption in Rust)
 /// Use this when decryption is handled elsewhere
 ///
@@ -359,15 +811,19 @@ pub extern "C" fn download_append_decrypted(
 
     // Write to file
     let writer = unsafe { &mut *ctx.output_file };
+    let write_timer = ctx.metrics.time(Stage::DiskWrite).with_bytes(data_len);
     if let Err(_) = writer.write_all(data_slice) {
         return ERROR_IO_FAILED;
     }
+    drop(write_timer);
+    ctx.metrics.add_chunk();
 
     ctx.bytes_written += data_len;
 
     // Progress callback
     if let Some(cb) = progress_callback {
         if ctx.progress_throttler.should_update(ctx.bytes_written, ctx.total_bytes) {
+            let _timer = ctx.metrics.time(Stage::CallbackWait);
             cb(ctx.bytes_written, ctx.total_bytes, user_data);
         }
     }
@@ -390,6 +846,9 @@ pub extern "C" fn download_finalize(context: *mut DownloadContext) -> i32 {
 
     let ctx = unsafe { &mut *context };
 
+    // Wait for parallel workers and surface their errors
+    let parallel_status = ctx.shutdown_parallel();
+
     // Finalize decryption context
     if let Some(dec_ctx) = ctx.decryption_context {
         unsafe { decrypt_file_finalize(dec_ctx); }
@@ -409,7 +868,7 @@ pub extern "C" fn download_finalize(context: *mut DownloadContext) -> i32 {
 
     ctx.is_finalized = true;
 
-    SUCCESS
+    parallel_status
 }
 
 /// Free download context
@@ -424,6 +883,7 @@ pub extern "C" fn download_free(context: *mut DownloadContext) {
             if !context.is_null() {
                 let ctx = &mut *context;
                 if !ctx.is_finalized {
+                    let _ = ctx.shutdown_parallel();
                     if let Some(dec_ctx) = ctx.decryption_context {
                         decrypt_file_finalize(dec_ctx);
                     }
@@ -479,4 +939,117 @@ pub extern "C" fn download_set_total_bytes(context: *mut DownloadContext, total_
     if !context.is_null() {
         unsafe { (&mut *context).total_bytes = total_bytes; }
     }
-}
\ No newline at end of file
+}
+/// Take a snapshot of one download's metrics
+///
+/// # Arguments
+/// * `context` - Pointer to DownloadContext
+/// * `out` - Receives the snapshot
+///
+/// # Returns
+/// 0 on success, error code on failure
+#[no_mangle]
+pub extern "C" fn download_get_metrics(context: *mut DownloadContext, out: *mut MetricsSnapshot) -> i32 {
+    if context.is_null() || out.is_null() {
+        return ERROR_NULL_POINTER;
+    }
+    unsafe { (&*context).metrics.snapshot(&mut *out) };
+    SUCCESS
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::{encrypt_file_streaming, free_buffer, seekable_decrypt_probe_size, CHUNK_HEADER_SIZE, DEFAULT_CHUNK_SIZE};
+    use std::ffi::CString;
+
+    #[test]
+    fn test_parallel_download_out_of_order() {
+        let path = std::env::temp_dir().join(format!("cn_download_parallel_{}.bin", std::process::id()));
+        let plaintext: Vec<u8> = (0..(3 * DEFAULT_CHUNK_SIZE + 4321)).map(|i| (i % 251) as u8).collect();
+        let master_key = [9u8; 32];
+
+        let mut encrypted_len = 0usize;
+        let encrypted_ptr = encrypt_file_streaming(plaintext.as_ptr(), plaintext.len(), master_key.as_ptr(), 32,
+                                                   &mut encrypted_len, None, ptr::null_mut());
+        assert!(!encrypted_ptr.is_null());
+        let encrypted = unsafe { slice::from_raw_parts(encrypted_ptr, encrypted_len) }.to_vec();
+        free_buffer(encrypted_ptr);
+
+        let c_path = CString::new(path.to_str().unwrap()).unwrap();
+        let ctx = download_init_with_size(c_path.as_ptr(), encrypted.len(), master_key.as_ptr(), 32, 1,
+                                          None, ptr::null(), ptr::null_mut());
+        assert!(!ctx.is_null());
+        let prefix_len = seekable_decrypt_probe_size();
+        assert_eq!(download_enable_parallel(ctx, encrypted.as_ptr(), prefix_len, 3, 2), SUCCESS);
+
+        // Ranges: [header + chunk 0], [chunks 1..2], [short tail chunk], appended in reverse
+        let stride = DEFAULT_CHUNK_SIZE + CHUNK_HEADER_SIZE;
+        let data_offset = encrypted.len() - 3 * stride - (4321 + CHUNK_HEADER_SIZE);
+        let ranges = [
+            (0, data_offset + stride),
+            (data_offset + stride, data_offset + 3 * stride),
+            (data_offset + 3 * stride, encrypted.len()),
+        ];
+        for &(start, end) in ranges.iter().rev() {
+            assert_eq!(download_append_range(ctx, encrypted[start..end].as_ptr(), end - start, start as u64,
+                                             None, ptr::null_mut()), SUCCESS);
+        }
+
+        // A range that starts mid-chunk is rejected
+        assert_eq!(download_append_range(ctx, encrypted[data_offset + 1..].as_ptr(), 64,
+                                         (data_offset + 1) as u64, None, ptr::null_mut()), ERROR_INVALID_PATH);
+
+        assert_eq!(download_finalize(ctx), SUCCESS);
+        download_free(ctx);
+
+        assert_eq!(std::fs::read(&path).unwrap(), plaintext);
+        let _ = std::fs::remove_file(&path);
+    }
+
+    #[test]
+    fn test_parallel_download_rejects_duplicate_and_missing_ranges() {
+        let path = std::env::temp_dir().join(format!("cn_download_duplicate_{}.bin", std::process::id()));
+        let c_path = CString::new(path.to_str().unwrap()).unwrap();
+        let plaintext: Vec<u8> = (0..(3 * DEFAULT_CHUNK_SIZE + 100)).map(|i| (i % 241) as u8).collect();
+        let master_key = [5u8; 32];
+
+        let mut encrypted_len = 0usize;
+        let encrypted_ptr = encrypt_file_streaming(plaintext.as_ptr(), plaintext.len(), master_key.as_ptr(), 32,
+                                                   &mut encrypted_len, None, ptr::null_mut());
+        let encrypted = unsafe { slice::from_raw_parts(encrypted_ptr, encrypted_len) }.to_vec();
+        free_buffer(encrypted_ptr);
+
+        let ctx = download_init_with_size(c_path.as_ptr(), encrypted.len(), master_key.as_ptr(), 32, 1,
+                                          None, ptr::null(), ptr::null_mut());
+        assert_eq!(download_enable_parallel(ctx, encrypted.as_ptr(), seekable_decrypt_probe_size(), 2, 2), SUCCESS);
+
+        // Chunk 1 is sent twice (the second time inside a larger range), chunk 3 never
+        let stride = DEFAULT_CHUNK_SIZE + CHUNK_HEADER_SIZE;
+        let data_offset = encrypted.len() - 3 * stride - (100 + CHUNK_HEADER_SIZE);
+        let chunk = |i: usize| data_offset + i * stride;
+        let mut append = |start: usize, end: usize| {
+            download_append_range(ctx, encrypted[start..end].as_ptr(), end - start, start as u64, None, ptr::null_mut())
+        };
+        assert_eq!(append(0, chunk(2)), SUCCESS);
+        assert_eq!(append(chunk(1), chunk(3)), ERROR_INVALID_PATH);
+        assert_eq!(append(chunk(2), chunk(3)), SUCCESS);
+        assert_eq!(download_finalize(ctx), ERROR_IO_FAILED);
+        download_free(ctx);
+
+        // Same checks on the byte ranges of a raw download
+        let ctx = download_init_with_size(c_path.as_ptr(), 300, ptr::null(), 0, 0, None, ptr::null(), ptr::null_mut());
+        assert_eq!(download_enable_parallel(ctx, ptr::null(), 0, 1, 1), SUCCESS);
+        let raw = [7u8; 300];
+        let mut append = |start: usize, end: usize| {
+            download_append_range(ctx, raw[start..end].as_ptr(), end - start, start as u64, None, ptr::null_mut())
+        };
+        assert_eq!(append(0, 100), SUCCESS);
+        assert_eq!(append(200, 300), SUCCESS);
+        assert_eq!(append(50, 150), ERROR_INVALID_PATH);
+        assert_eq!(download_finalize(ctx), ERROR_IO_FAILED);
+        download_free(ctx);
+
+        let _ = std::fs::remove_file(&path);
+    }
+}
@@ -100,74 +100,3 @@ pub fn parse_header(header: &[u8]) -> Result<(u32, u8, usize), ()> {
 
     Ok((magic, version, fek_length))
 }
-
-// ============================================================================
-// CHUNK ENCRYPTION/DECRYPTION
-// ============================================================================
-
-pub fn encrypt_chunk_impl(data: &[u8], fek: &[u8], chunk_index: u32) -> Option<Vec<u8>> {
-    // Generate nonce for this chunk
-    let mut nonce_bytes = [0u8; NONCE_SIZE];
-    OsRng.fill_bytes(&mut nonce_bytes);
-    let nonce = Nonce::from_slice(&nonce_bytes);
-
-    // Encrypt chunk
-    let cipher = Aes256Gcm::new_from_slice(fek).ok()?;
-    let ciphertext = cipher.encrypt(nonce, data).ok()?;
-
-    // Build chunk header: index (4) + size (4) + nonce (12)
-    // Total header: 20 bytes
-    let mut chunk = Vec::with_capacity(20 + ciphertext.len());
-
-    // Chunk index (incrementing for each chunk)
-    chunk.extend_from_slice(&chunk_index.to_le_bytes());
-    
-    // Chunk size (encrypted data INCLUDING MAC, as stored in encrypted_content)
-    chunk.extend_from_slice(&(ciphertext.len() as u32).to_le_bytes());
-    
-    // Nonce
-    chunk.extend_from_slice(&nonce_bytes);
-    
-    // Encrypted data (ciphertext which includes MAC tag)
-    chunk.extend_from_slice(&ciphertext);
-
-    Some(chunk)
-}
-
-pub fn decrypt_chunk_impl(encrypted_data: &[u8], fek: &[u8]) -> Option<(Vec<u8>, usize)> {
-    if encrypted_data.len() < 20 {
-        return None;
-    }
-
-    // Parse chunk header
-    let _chunk_index = u32::from_le_bytes([
-        encrypted_data[0], encrypted_data[1], encrypted_data[2], encrypted_data[3],
-    ]);
-    
-    let _chunk_size = u32::from_le_bytes([
-        encrypted_data[4], encrypted_data[5], encrypted_data[6], encrypted_data[7],
-    ]) as usize;
-    
-    let nonce_bytes = &encrypted_data[8..20];
-    
-    // Encrypted data starts at position 20
-    let encrypted_content = &encrypted_data[20..];
-    
-    // Validate chunk size
-    if encrypted_content.len() < MAC_SIZE {
-        return None;
-    }
-
-    // Extract nonce
-    let nonce = Nonce::from_slice(nonce_bytes);
-
-    // Decrypt
-    let cipher = Aes256Gcm::new_from_slice(fek).ok()?;
-    let plaintext = cipher.decrypt(nonce, encrypted_content.as_ref()).ok()?;
-
-    // Calculate total chunk length
-    let chunk_len = 20 + encrypted_content.len();
-
-    Some((plaintext, chunk_len))
-}
-
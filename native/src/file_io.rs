@@ -24,6 +24,13 @@ pub const ERROR_BUFFER_ALLOC_FAILED: i32 = -8;
 const DEFAULT_CHUNK_SIZE: usize = 1024 * 1024; // 1MB chunks
 const PROGRESS_UPDATE_INTERVAL_MS: u64 = 500; // 500ms = 2 updates/second
 
+/// Smallest and largest chunk sizes accepted by streaming transfers
+pub const MIN_CHUNK_SIZE: usize = 64 * 1024; // 64KB
+pub const MAX_CHUNK_SIZE: usize = 64 * 1024 * 1024; // 64MB
+
+/// Adaptive chunking aims for one chunk round-trip per second
+const ADAPTIVE_TARGET_CHUNK_MS: u128 = 1000;
+
 /// Progress throttler to limit callback frequency
 pub struct ProgressThrottler {
     last_update_time: Instant,
@@ -63,6 +70,93 @@ impl ProgressThrottler {
     }
 }
 
+/// Normalize a caller-requested chunk size (0 = 1MB default)
+pub fn clamp_chunk_size(chunk_size: usize) -> usize {
+    if chunk_size == 0 {
+        DEFAULT_CHUNK_SIZE
+    } else {
+        chunk_size.max(MIN_CHUNK_SIZE).min(MAX_CHUNK_SIZE)
+    }
+}
+
+/// Chunk size policy for streaming transfers
+///
+/// Keeps chunk sizes on a provider's upload granularity (e.g. multiples of 320 KiB for
+/// OneDrive) and, in adaptive mode, resizes chunks from measured throughput so each one
+/// takes about a second: fast links stop wasting round-trips on tiny chunks and slow links
+/// keep reporting progress.
+pub struct ChunkSizer {
+    current: usize,
+    min: usize,
+    max: usize,
+    alignment: usize,
+    adaptive: bool,
+    last_chunk: Option<(Instant, usize)>,
+}
+
+impl ChunkSizer {
+    pub fn new(chunk_size: usize) -> Self {
+        let chunk_size = clamp_chunk_size(chunk_size);
+        Self {
+            current: chunk_size,
+            min: chunk_size,
+            max: chunk_size,
+            alignment: 1,
+            adaptive: false,
+            last_chunk: None,
+        }
+    }
+
+    /// Set alignment and adaptive bounds (0 keeps the current setting / chunk size)
+    pub fn configure(&mut self, alignment: usize, adaptive: bool, min: usize, max: usize) {
+        self.alignment = alignment.max(1);
+        self.adaptive = adaptive;
+        if adaptive {
+            self.min = if min == 0 { MIN_CHUNK_SIZE } else { clamp_chunk_size(min) };
+            self.max = if max == 0 { MAX_CHUNK_SIZE } else { clamp_chunk_size(max) }.max(self.min);
+        } else {
+            self.min = self.current;
+            self.max = self.current;
+        }
+        self.current = self.align(self.current);
+        self.last_chunk = None;
+    }
+
+    /// Size to use for the next chunk
+    pub fn chunk_size(&self) -> usize {
+        self.current
+    }
+
+    /// Largest chunk this sizer can ever return
+    pub fn max_chunk_size(&self) -> usize {
+        self.align(self.max).max(self.current)
+    }
+
+    /// Record that a chunk of `bytes` is starting
+    ///
+    /// The time since the previous call covers the previous chunk's full cycle (read,
+    /// encrypt and hand-off), which is what the next size is tuned against.
+    pub fn record_chunk(&mut self, bytes: usize) {
+        let now = Instant::now();
+        if let Some((started, previous_bytes)) = self.last_chunk {
+            let elapsed_ms = now.duration_since(started).as_millis().max(1);
+            if self.adaptive && previous_bytes > 0 {
+                let ideal = (previous_bytes as u128 * ADAPTIVE_TARGET_CHUNK_MS / elapsed_ms) as usize;
+                // At most double or halve per step so one noisy sample cannot swing the size
+                let next = ideal.max(self.current / 2).min(self.current.saturating_mul(2));
+                self.current = self.align(next);
+            }
+        }
+        self.last_chunk = Some((now, bytes));
+    }
+
+    fn align(&self, size: usize) -> usize {
+        let size = size.max(self.min).min(self.max);
+        // Round down to the provider granularity, but never below one unit
+        ((size / self.alignment) * self.alignment).max(self.alignment)
+    }
+}
+
 /// Upload context for streaming uploads
 #[repr(C)]
 pub struct UploadContext {
@@ -180,4 +274,34 @@ pub unsafe fn string_to_c_char(s: &str) -> *mut c_char {
     ptr.add(len).write(0);
     
     ptr as *mut c_char
-}
\ No newline at end of file
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_chunk_sizer_alignment_and_bounds() {
+        let mut sizer = ChunkSizer::new(0);
+        assert_eq!(sizer.chunk_size(), DEFAULT_CHUNK_SIZE);
+
+        sizer.configure(320 * 1024, false, 0, 0);
+        assert_eq!(sizer.chunk_size(), 3 * 320 * 1024);
+        assert_eq!(sizer.max_chunk_size(), 3 * 320 * 1024);
+
+        // Requests outside the accepted range are clamped
+        assert_eq!(ChunkSizer::new(1).chunk_size(), MIN_CHUNK_SIZE);
+        assert_eq!(ChunkSizer::new(usize::MAX).chunk_size(), MAX_CHUNK_SIZE);
+
+        // Adaptive mode never leaves its bounds or the alignment grid
+        let mut sizer = ChunkSizer::new(0);
+        sizer.configure(320 * 1024, true, 0, 8 * 1024 * 1024);
+        assert_eq!(sizer.max_chunk_size(), 25 * 320 * 1024);
+        for _ in 0..4 {
+            sizer.record_chunk(sizer.chunk_size());
+        }
+        let size = sizer.chunk_size();
+        assert_eq!(size % (320 * 1024), 0);
+        assert!(size <= sizer.max_chunk_size());
+    }
+}
@@ -0,0 +1,583 @@
+/// Asynchronous job API for CloudNexus
+///
+/// Long-running operations (file copy and crypto, folder copy, folder scan) are submitted
+/// to one shared tokio runtime and return a job handle immediately instead of blocking the
+/// caller. Completion is reported through a callback, and the handle can be polled, waited
+/// on or cancelled. Every job of the process shares the runtime's bounded blocking pool, so
+/// many concurrent transfers are scheduled together instead of each bringing its own
+/// isolate or threads.
+///
+/// Callbacks (completion and progress) run on runtime threads, never on the submitting
+/// thread: from Dart, pass a `NativeCallable.listener`.
+use std::ffi::{c_char, c_void, CStr, CString};
+use std::sync::atomic::{AtomicBool, AtomicI64, AtomicU64, Ordering};
+use std::sync::{Arc, Condvar, Mutex, OnceLock};
+use std::time::Duration;
+
+use tokio::runtime::{Builder, Runtime};
+
+use crate::copy::{copy_file, folder_copy_parallel, CopyProgressCallback};
+use crate::scan::{scan_folder_free, scan_folder_on, scan_folder_sync, FolderScanContext};
+use crate::{decrypt_file_from_path, encrypt_file_from_path, ProgressCallback};
+
+/// Job states reported by `job_get_status`
+pub const JOB_STATUS_PENDING: i32 = 0;
+pub const JOB_STATUS_RUNNING: i32 = 1;
+pub const JOB_STATUS_SUCCEEDED: i32 = 2;
+pub const JOB_STATUS_FAILED: i32 = 3;
+pub const JOB_STATUS_CANCELLED: i32 = 4;
+
+/// Upper bound on jobs running at once; later submissions queue behind them
+const JOB_MAX_BLOCKING_THREADS: usize = 64;
+
+/// Completion callback: job id, final status (JOB_STATUS_*), operation result
+/// (>= 0 on success, the operation's error code otherwise), user data
+pub type JobCompletionCallback = extern "C" fn(job_id: u64, status: i32, result: i64, user_data: *mut c_void);
+
+/// Caller pointer carried to a runtime thread
+///
+/// The caller guarantees user data (and anything it points to) outlives the job.
+#[derive(Clone, Copy)]
+struct SendPtr(*mut c_void);
+
+unsafe impl Send for SendPtr {}
+
+impl SendPtr {
+    fn get(self) -> *mut c_void {
+        self.0
+    }
+}
+
+/// Result an operation leaves behind for the caller to collect
+enum JobOutput {
+    Scan(*mut FolderScanContext),
+}
+
+unsafe impl Send for JobOutput {}
+
+impl Drop for JobOutput {
+    fn drop(&mut self) {
+        match *self {
+            JobOutput::Scan(context) => scan_folder_free(context),
+        }
+    }
+}
+
+/// One submitted operation, shared by the caller's handle and the running task
+pub struct Job {
+    id: u64,
+    status: Mutex<i32>,
+    finished: Condvar,
+    result: AtomicI64,
+    /// Handed to operations as their cancel flag
+    cancel: AtomicBool,
+    output: Mutex<Option<JobOutput>>,
+}
+
+impl Job {
+    fn new() -> Self {
+        static NEXT_JOB_ID: AtomicU64 = AtomicU64::new(1);
+        Job {
+            id: NEXT_JOB_ID.fetch_add(1, Ordering::Relaxed),
+            status: Mutex::new(JOB_STATUS_PENDING),
+            finished: Condvar::new(),
+            result: AtomicI64::new(0),
+            cancel: AtomicBool::new(false),
+            output: Mutex::new(None),
+        }
+    }
+
+    fn status(&self) -> i32 {
+        *self.status.lock().unwrap_or_else(|e| e.into_inner())
+    }
+
+    fn set_status(&self, status: i32) {
+        *self.status.lock().unwrap_or_else(|e| e.into_inner()) = status;
+        self.finished.notify_all();
+    }
+
+    fn cancel_flag(&self) -> *const AtomicBool {
+        &self.cancel
+    }
+}
+
+/// The runtime every job runs on, sized to the machine on first use
+fn job_runtime() -> Option<&'static Runtime> {
+    static RUNTIME: OnceLock<Option<Runtime>> = OnceLock::new();
+    RUNTIME
+        .get_or_init(|| {
+            let workers = std::thread::available_parallelism().map(|n| n.get()).unwrap_or(1);
+            Builder::new_multi_thread()
+                .worker_threads(workers)
+                .max_blocking_threads(JOB_MAX_BLOCKING_THREADS)
+                .thread_name("cn-jobs")
+                .build()
+                .ok()
+        })
+        .as_ref()
+}
+
+/// Start the job runtime ahead of the first submission (see `cloud_nexus_preload_start`)
+pub(crate) fn warm_job_runtime() {
+    let _ = job_runtime();
+}
+
+/// Run `operation` as a job and hand its handle to the caller
+///
+/// The operation returns its result code (>= 0 on success). The job counts as cancelled
+/// when it fails after `job_cancel`, or when it is cancelled before it starts.
+fn submit<F>(operation: F, completion: Option<JobCompletionCallback>, user_data: *mut c_void) -> *mut Job
+where
+    F: FnOnce(&Job) -> i64 + Send + 'static,
+{
+    let runtime = match job_runtime() {
+        Some(runtime) => runtime,
+        None => return std::ptr::null_mut(),
+    };
+
+    let job = Arc::new(Job::new());
+    let task_job = job.clone();
+    let user_data = SendPtr(user_data);
+
+    // Blocking file I/O runs on the blocking pool, leaving the async workers free
+    runtime.spawn_blocking(move || {
+        let job = task_job;
+        let status = if job.cancel.load(Ordering::SeqCst) {
+            JOB_STATUS_CANCELLED
+        } else {
+            job.set_status(JOB_STATUS_RUNNING);
+            let result = operation(&job);
+            job.result.store(result, Ordering::SeqCst);
+            if result >= 0 {
+                JOB_STATUS_SUCCEEDED
+            } else if job.cancel.load(Ordering::SeqCst) {
+                JOB_STATUS_CANCELLED
+            } else {
+                JOB_STATUS_FAILED
+            }
+        };
+        job.set_status(status);
+
+        if let Some(cb) = completion {
+            cb(job.id, status, job.result.load(Ordering::SeqCst), user_data.get());
+        }
+    });
+
+    Arc::into_raw(job) as *mut Job
+}
+
+/// Copy a C string so the caller may free it as soon as the submit call returns
+unsafe fn owned_c_string(s: *const c_char) -> Option<CString> {
+    if s.is_null() {
+        None
+    } else {
+        Some(CStr::from_ptr(s).to_owned())
+    }
+}
+
+/// Submit a file copy (see `copy_file`)
+///
+/// # Arguments
+/// * `source_path` - Source file path
+/// * `dest_path` - Destination file path
+/// * `chunk_size` - Chunk size for the buffered fallback (0 = default)
+/// * `progress_callback` - Optional progress callback, invoked on a runtime thread
+/// * `completion_callback` - Optional completion callback, invoked on a runtime thread
+/// * `user_data` - User data passed to callbacks
+///
+/// # Returns
+/// Job handle (free with `job_free`), or null on error
+#[no_mangle]
+pub extern "C" fn job_submit_copy_file(
+    source_path: *const c_char,
+    dest_path: *const c_char,
+    chunk_size: usize,
+    progress_callback: Option<CopyProgressCallback>,
+    completion_callback: Option<JobCompletionCallback>,
+    user_data: *mut c_void,
+) -> *mut Job {
+    let (source, dest) = match unsafe { (owned_c_string(source_path), owned_c_string(dest_path)) } {
+        (Some(source), Some(dest)) => (source, dest),
+        _ => return std::ptr::null_mut(),
+    };
+    let callback_data = SendPtr(user_data);
+    submit(
+        move |job| {
+            copy_file(source.as_ptr(), dest.as_ptr(), chunk_size, progress_callback,
+                      job.cancel_flag(), callback_data.get()) as i64
+        },
+        completion_callback,
+        user_data,
+    )
+}
+
+/// Submit a parallel folder copy (see `folder_copy_parallel`)
+///
+/// # Arguments
+/// * `source_folder` - Folder to copy
+/// * `dest_folder` - Destination folder (created if missing)
+/// * `max_workers` - Concurrent copy workers (0 = default)
+/// * `progress_callback` - Optional progress callback, invoked on a runtime thread
+/// * `completion_callback` - Optional completion callback, invoked on a runtime thread
+/// * `user_data` - User data passed to callbacks
+///
+/// # Returns
+/// Job handle (free with `job_free`), or null on error
+#[no_mangle]
+pub extern "C" fn job_submit_folder_copy(
+    source_folder: *const c_char,
+    dest_folder: *const c_char,
+    max_workers: u32,
+    progress_callback: Option<CopyProgressCallback>,
+    completion_callback: Option<JobCompletionCallback>,
+    user_data: *mut c_void,
+) -> *mut Job {
+    let (source, dest) = match unsafe { (owned_c_string(source_folder), owned_c_string(dest_folder)) } {
+        (Some(source), Some(dest)) => (source, dest),
+        _ => return std::ptr::null_mut(),
+    };
+    let callback_data = SendPtr(user_data);
+    submit(
+        move |job| {
+            folder_copy_parallel(source.as_ptr(), dest.as_ptr(), max_workers, progress_callback,
+                                 job.cancel_flag(), callback_data.get()) as i64
+        },
+        completion_callback,
+        user_data,
+    )
+}
+
+/// Submit a path-to-path encryption (see `encrypt_file_from_path`)
+///
+/// The master key is copied. Cancelling only takes effect before the job starts.
+///
+/// # Arguments
+/// * `input_path` - Plaintext file
+/// * `output_path` - Encrypted file to create
+/// * `master_key` - Pointer to 32-byte master key
+/// * `master_key_len` - Length of master key (must be 32)
+/// * `chunk_size` - Plaintext bytes per chunk (0 = 1MB default)
+/// * `num_threads` - Worker thread count (0 = one per available core)
+/// * `progress_callback` - Optional progress callback, invoked on a runtime thread
+/// * `completion_callback` - Optional completion callback, invoked on a runtime thread
+/// * `user_data` - User data passed to callbacks
+///
+/// # Returns
+/// Job handle (free with `job_free`), or null on error
+#[no_mangle]
+pub extern "C" fn job_submit_encrypt_file(
+    input_path: *const c_char,
+    output_path: *const c_char,
+    master_key: *const u8,
+    master_key_len: usize,
+    chunk_size: usize,
+    num_threads: u32,
+    progress_callback: Option<ProgressCallback>,
+    completion_callback: Option<JobCompletionCallback>,
+    user_data: *mut c_void,
+) -> *mut Job {
+    let (input, output) = match unsafe { (owned_c_string(input_path), owned_c_string(output_path)) } {
+        (Some(input), Some(output)) => (input, output),
+        _ => return std::ptr::null_mut(),
+    };
+    if master_key.is_null() {
+        return std::ptr::null_mut();
+    }
+    let key = unsafe { std::slice::from_raw_parts(master_key, master_key_len) }.to_vec();
+    let callback_data = SendPtr(user_data);
+    submit(
+        move |_| {
+            encrypt_file_from_path(input.as_ptr(), output.as_ptr(), key.as_ptr(), key.len(),
+                                   chunk_size, num_threads, progress_callback, callback_data.get()) as i64
+        },
+        completion_callback,
+        user_data,
+    )
+}
+
+/// Submit a path-to-path decryption (see `decrypt_file_from_path`)
+///
+/// The master key is copied. Cancelling only takes effect before the job starts.
+///
+/// # Arguments
+/// * `input_path` - Encrypted file
+/// * `output_path` - Plaintext file to create
+/// * `master_key` - Pointer to 32-byte master key
+/// * `master_key_len` - Length of master key (must be 32)
+/// * `num_threads` - Worker thread count (0 = one per available core)
+/// * `progress_callback` - Optional progress callback, invoked on a runtime thread
+/// * `completion_callback` - Optional completion callback, invoked on a runtime thread
+/// * `user_data` - User data passed to callbacks
+///
+/// # Returns
+/// Job handle (free with `job_free`), or null on error
+#[no_mangle]
+pub extern "C" fn job_submit_decrypt_file(
+    input_path: *const c_char,
+    output_path: *const c_char,
+    master_key: *const u8,
+    master_key_len: usize,
+    num_threads: u32,
+    progress_callback: Option<ProgressCallback>,
+    completion_callback: Option<JobCompletionCallback>,
+    user_data: *mut c_void,
+) -> *mut Job {
+    let (input, output) = match unsafe { (owned_c_string(input_path), owned_c_string(output_path)) } {
+        (Some(input), Some(output)) => (input, output),
+        _ => return std::ptr::null_mut(),
+    };
+    if master_key.is_null() {
+        return std::ptr::null_mut();
+    }
+    let key = unsafe { std::slice::from_raw_parts(master_key, master_key_len) }.to_vec();
+    let callback_data = SendPtr(user_data);
+    submit(
+        move |_| {
+            decrypt_file_from_path(input.as_ptr(), output.as_ptr(), key.as_ptr(), key.len(),
+                                   num_threads, progress_callback, callback_data.get()) as i64
+        },
+        completion_callback,
+        user_data,
+    )
+}
+
+/// Submit a folder scan (same result as `scan_folder_init_parallel`)
+///
+/// On success the job result is the number of files found; collect the scan with
+/// `job_take_scan_context`. Directories are read by tasks on the shared job runtime rather
+/// than by scan workers started for this job.
+///
+/// # Arguments
+/// * `folder_path` - Folder to scan
+/// * `max_depth` - Maximum depth (0 = unlimited)
+/// * `num_threads` - 1 = read directories serially on the job's thread, anything else = on
+///   the shared runtime's workers
+/// * `completion_callback` - Optional completion callback, invoked on a runtime thread
+/// * `user_data` - User data passed to the callback
+///
+/// # Returns
+/// Job handle (free with `job_free`), or null on error
+#[no_mangle]
+pub extern "C" fn job_submit_scan_folder(
+    folder_path: *const c_char,
+    max_depth: u32,
+    num_threads: u32,
+    completion_callback: Option<JobCompletionCallback>,
+    user_data: *mut c_void,
+) -> *mut Job {
+    let path = match unsafe { owned_c_string(folder_path) } {
+        Some(path) => path,
+        None => return std::ptr::null_mut(),
+    };
+    submit(
+        move |job| {
+            let path = match path.to_str() {
+                Ok(path) => path,
+                Err(_) => return -1,
+            };
+            let max_depth = if max_depth == 0 { None } else { Some(max_depth as u64) };
+            // Runs on the blocking pool, so waiting for the runtime's workers is fine here
+            let result = match (num_threads, job_runtime()) {
+                (1, _) | (_, None) => scan_folder_sync(path, max_depth),
+                (_, Some(runtime)) => scan_folder_on(runtime.handle(), path, max_depth),
+            };
+
+            let mut context = Box::new(FolderScanContext::new());
+            let file_count = match result {
+                Ok(scan_result) => {
+                    let file_count = scan_result.file_count as i64;
+                    context.set_result(scan_result);
+                    file_count
+                }
+                Err(error) => {
+                    context.set_error(error);
+                    -1
+                }
+            };
+            // Failed scans are kept too: scan_folder_get_error explains them
+            *job.output.lock().unwrap_or_else(|e| e.into_inner()) = Some(JobOutput::Scan(Box::into_raw(context)));
+            file_count
+        },
+        completion_callback,
+        user_data,
+    )
+}
+
+/// Take the result of a finished scan job
+///
+/// # Arguments
+/// * `job` - Handle from `job_submit_scan_folder`
+///
+/// # Returns
+/// Scan context (caller frees with `scan_folder_free`), or null if the job has not
+/// finished, is not a scan, or the context was already taken
+#[no_mangle]
+pub extern "C" fn job_take_scan_context(job: *mut Job) -> *mut FolderScanContext {
+    if job.is_null() {
+        return std::ptr::null_mut();
+    }
+    let job = unsafe { &*job };
+    let taken = job.output.lock().unwrap_or_else(|e| e.into_inner()).take();
+    match taken {
+        Some(output) => {
+            let JobOutput::Scan(context) = output;
+            std::mem::forget(output);
+            context
+        }
+        None => std::ptr::null_mut(),
+    }
+}
+
+/// Get a job's id (the value passed to its completion callback)
+#[no_mangle]
+pub extern "C" fn job_get_id(job: *mut Job) -> u64 {
+    if job.is_null() {
+        return 0;
+    }
+    unsafe { (&*job).id }
+}
+
+/// Get a job's status (JOB_STATUS_*), or -1 for a null handle
+#[no_mangle]
+pub extern "C" fn job_get_status(job: *mut Job) -> i32 {
+    if job.is_null() {
+        return -1;
+    }
+    unsafe { (&*job).status() }
+}
+
+/// Get a finished job's result (>= 0 on success, the operation's error code otherwise)
+#[no_mangle]
+pub extern "C" fn job_get_result(job: *mut Job) -> i64 {
+    if job.is_null() {
+        return 0;
+    }
+    unsafe { (&*job).result.load(Ordering::SeqCst) }
+}
+
+/// Ask a job to stop
+///
+/// A pending job never starts; a running one stops at its next cancellation check.
+#[no_mangle]
+pub extern "C" fn job_cancel(job: *mut Job) {
+    if !job.is_null() {
+        unsafe { (&*job).cancel.store(true, Ordering::SeqCst) };
+    }
+}
+
+/// Block until a job finishes or the timeout passes
+///
+/// # Arguments
+/// * `job` - Job handle
+/// * `timeout_ms` - Maximum wait (0 = wait indefinitely)
+///
+/// # Returns
+/// The job's status after waiting, or -1 for a null handle
+#[no_mangle]
+pub extern "C" fn job_wait(job: *mut Job, timeout_ms: u64) -> i32 {
+    if job.is_null() {
+        return -1;
+    }
+    let job = unsafe { &*job };
+    let finished = |status: &mut i32| *status < JOB_STATUS_SUCCEEDED;
+    let status = job.status.lock().unwrap_or_else(|e| e.into_inner());
+    let status = if timeout_ms == 0 {
+        job.finished.wait_while(status, finished).unwrap_or_else(|e| e.into_inner())
+    } else {
+        job.finished
+            .wait_timeout_while(status, Duration::from_millis(timeout_ms), finished)
+            .unwrap_or_else(|e| e.into_inner())
+            .0
+    };
+    *status
+}
+
+/// Release a job handle
+///
+/// A running job keeps running (call `job_cancel` first to stop it) and still invokes its
+/// completion callback; an untaken scan result is freed with the job.
+#[no_mangle]
+pub extern "C" fn job_free(job: *mut Job) {
+    if !job.is_null() {
+        unsafe {
+            let _ = Arc::from_raw(job as *const Job);
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::sync::atomic::AtomicUsize;
+
+    static COMPLETIONS: AtomicUsize = AtomicUsize::new(0);
+
+    extern "C" fn on_complete(_job_id: u64, status: i32, _result: i64, _user_data: *mut c_void) {
+        if status == JOB_STATUS_SUCCEEDED {
+            COMPLETIONS.fetch_add(1, Ordering::SeqCst);
+        }
+    }
+
+    #[test]
+    fn test_jobs_copy_scan_and_cancel() {
+        let dir = std::env::temp_dir().join(format!("cn_jobs_{}", std::process::id()));
+        let _ = std::fs::remove_dir_all(&dir);
+        std::fs::create_dir_all(dir.join("tree/sub")).unwrap();
+        std::fs::write(dir.join("tree/a.bin"), vec![7u8; 300_000]).unwrap();
+        std::fs::write(dir.join("tree/sub/b.bin"), b"hello").unwrap();
+
+        let src = CString::new(dir.join("tree/a.bin").to_str().unwrap()).unwrap();
+        let dst = CString::new(dir.join("a_copy.bin").to_str().unwrap()).unwrap();
+        let copy_job = job_submit_copy_file(src.as_ptr(), dst.as_ptr(), 0, None, Some(on_complete),
+                                            std::ptr::null_mut());
+        assert!(!copy_job.is_null());
+
+        let tree = CString::new(dir.join("tree").to_str().unwrap()).unwrap();
+        let scan_job = job_submit_scan_folder(tree.as_ptr(), 0, 2, Some(on_complete), std::ptr::null_mut());
+        assert!(!scan_job.is_null());
+        assert_ne!(job_get_id(copy_job), job_get_id(scan_job));
+
+        assert_eq!(job_wait(copy_job, 0), JOB_STATUS_SUCCEEDED);
+        assert_eq!(std::fs::read(dir.join("a_copy.bin")).unwrap().len(), 300_000);
+
+        assert_eq!(job_wait(scan_job, 10_000), JOB_STATUS_SUCCEEDED);
+        assert_eq!(job_get_result(scan_job), 2);
+        let context = job_take_scan_context(scan_job);
+        assert!(!context.is_null());
+        assert!(job_take_scan_context(scan_job).is_null());
+        scan_folder_free(context);
+
+        // An operation that runs until its cancel flag is set
+        let cancelled = submit(
+            |job| {
+                while !unsafe { crate::file_io::is_cancelled(job.cancel_flag()) } {
+                    std::thread::sleep(Duration::from_millis(1));
+                }
+                -1
+            },
+            None,
+            std::ptr::null_mut(),
+        );
+        while job_get_status(cancelled) == JOB_STATUS_PENDING {
+            std::thread::sleep(Duration::from_millis(1));
+        }
+        assert_eq!(job_wait(cancelled, 20), JOB_STATUS_RUNNING);
+        job_cancel(cancelled);
+        assert_eq!(job_wait(cancelled, 0), JOB_STATUS_CANCELLED);
+        assert_eq!(job_get_result(cancelled), -1);
+
+        // Completion callbacks run just after the status flips, so give them a moment
+        for _ in 0..100 {
+            if COMPLETIONS.load(Ordering::SeqCst) >= 2 {
+                break;
+            }
+            std::thread::sleep(Duration::from_millis(10));
+        }
+        assert!(COMPLETIONS.load(Ordering::SeqCst) >= 2);
+
+        job_free(copy_job);
+        job_free(scan_job);
+        job_free(cancelled);
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+}
@@ -0,0 +1,306 @@
+/// Cache of unwrapped file encryption keys for CloudNexus
+///
+/// Thumbnails, previews and sync verification open the same encrypted object many times
+/// per session. Every `decrypt_file_init` unwraps the FEK with the master key and builds a
+/// fresh cipher; with a cache, re-opening a recently used file skips both.
+///
+/// The cache is an explicit, thread-safe handle so callers opt in per session:
+/// 1. `fek_cache_create` once (bounded by entry count and idle TTL)
+/// 2. `decrypt_file_init_cached` instead of `decrypt_file_init`
+/// 3. `fek_cache_free` when done (open decryption contexts stay valid)
+///
+/// Entries are keyed by SHA-256 over the master key and wrapped FEK, so a cached key is
+/// only handed out to a caller presenting the same master key. FEK bytes are zeroized when
+/// the last holder (cache entry or decryption context) drops them.
+use std::collections::HashMap;
+use std::ffi::c_int;
+use std::ptr;
+use std::slice;
+use std::sync::{Arc, Mutex};
+use std::time::{Duration, Instant};
+
+use aes_gcm::{aead::KeyInit, Aes256Gcm};
+use sha2::{Digest, Sha256};
+use zeroize::Zeroize;
+
+use crate::{new_decryption_context, unwrap_key, DecryptionContext, ERROR_NULL_POINTER, KEY_SIZE, SUCCESS};
+
+/// Default maximum number of cached keys
+const DEFAULT_MAX_ENTRIES: usize = 64;
+
+/// An unwrapped FEK together with its initialized cipher
+pub(crate) struct FileKey {
+    fek: [u8; KEY_SIZE],
+    cipher: Aes256Gcm,
+}
+
+impl FileKey {
+    pub(crate) fn new(fek: &[u8]) -> Option<Self> {
+        if fek.len() != KEY_SIZE {
+            return None;
+        }
+        let cipher = Aes256Gcm::new_from_slice(fek).ok()?;
+        let mut key = [0u8; KEY_SIZE];
+        key.copy_from_slice(fek);
+        Some(FileKey { fek: key, cipher })
+    }
+
+    #[cfg(test)]
+    pub(crate) fn fek(&self) -> &[u8] {
+        &self.fek
+    }
+
+    pub(crate) fn cipher(&self) -> &Aes256Gcm {
+        &self.cipher
+    }
+}
+
+impl Drop for FileKey {
+    fn drop(&mut self) {
+        // The cipher's AES and GHASH key schedules are wiped by its own Drop
+        // (aes and aes-gcm "zeroize" features)
+        self.fek.zeroize();
+    }
+}
+
+struct CacheEntry {
+    key: Arc<FileKey>,
+    last_used: Instant,
+}
+
+struct CacheState {
+    entries: HashMap<[u8; 32], CacheEntry>,
+    hits: u64,
+    misses: u64,
+}
+
+/// Thread-safe FEK cache (see module docs)
+pub struct FekCache {
+    state: Mutex<CacheState>,
+    max_entries: usize,
+    /// Entries idle for longer than this are evicted (None = no expiry)
+    ttl: Option<Duration>,
+}
+
+impl FekCache {
+    pub fn new(max_entries: usize, ttl: Option<Duration>) -> Self {
+        FekCache {
+            state: Mutex::new(CacheState {
+                entries: HashMap::new(),
+                hits: 0,
+                misses: 0,
+            }),
+            max_entries: if max_entries == 0 { DEFAULT_MAX_ENTRIES } else { max_entries },
+            ttl,
+        }
+    }
+
+    fn cache_key(wrapped_fek: &[u8], master_key: &[u8]) -> [u8; 32] {
+        let mut hasher = Sha256::new();
+        hasher.update(master_key);
+        hasher.update(wrapped_fek);
+        hasher.finalize().into()
+    }
+
+    /// Return the unwrapped key for `wrapped_fek`, unwrapping and caching it on a miss
+    pub(crate) fn get_or_unwrap(&self, wrapped_fek: &[u8], master_key: &[u8]) -> Option<Arc<FileKey>> {
+        let id = Self::cache_key(wrapped_fek, master_key);
+        let now = Instant::now();
+
+        {
+            let mut state = self.state.lock().ok()?;
+            self.evict_expired(&mut state, now);
+            if let Some(entry) = state.entries.get_mut(&id) {
+                entry.last_used = now;
+                let key = entry.key.clone();
+                state.hits += 1;
+                return Some(key);
+            }
+            state.misses += 1;
+        }
+
+        // Unwrap outside the lock so other files are not blocked
+        let fek = unwrap_key(wrapped_fek, master_key).ok()?;
+        let key = FileKey::new(&fek).map(Arc::new)?;
+
+        let mut state = self.state.lock().ok()?;
+        if state.entries.len() >= self.max_entries && !state.entries.contains_key(&id) {
+            // Evict the least recently used entry
+            let oldest = state.entries.iter().min_by_key(|(_, e)| e.last_used).map(|(id, _)| *id);
+            if let Some(oldest) = oldest {
+                state.entries.remove(&oldest);
+            }
+        }
+        state.entries.insert(id, CacheEntry { key: key.clone(), last_used: now });
+
+        Some(key)
+    }
+
+    fn evict_expired(&self, state: &mut CacheState, now: Instant) {
+        if let Some(ttl) = self.ttl {
+            state.entries.retain(|_, e| now.duration_since(e.last_used) <= ttl);
+        }
+    }
+
+    /// Drop every cached key
+    pub fn clear(&self) {
+        if let Ok(mut state) = self.state.lock() {
+            state.entries.clear();
+        }
+    }
+
+    /// (entries, hits, misses)
+    pub fn stats(&self) -> (usize, u64, u64) {
+        match self.state.lock() {
+            Ok(state) => (state.entries.len(), state.hits, state.misses),
+            Err(_) => (0, 0, 0),
+        }
+    }
+}
+
+/// Create a FEK cache
+///
+/// # Arguments
+/// * `max_entries` - Maximum number of cached keys (0 = 64); least recently used is evicted
+/// * `ttl_ms` - Evict keys unused for this many milliseconds (0 = no expiry)
+///
+/// # Returns
+/// Pointer to FekCache (caller must free with fek_cache_free)
+#[no_mangle]
+pub extern "C" fn fek_cache_create(max_entries: u32, ttl_ms: u64) -> *mut FekCache {
+    let ttl = if ttl_ms == 0 { None } else { Some(Duration::from_millis(ttl_ms)) };
+    let cache = Box::new(FekCache::new(max_entries as usize, ttl));
+    Box::leak(cache) as *mut FekCache
+}
+
+/// Initialize a decryption context, reusing a cached FEK and cipher when available
+///
+/// Same contract as `decrypt_file_init`; the cache may be shared between threads.
+///
+/// # Arguments
+/// * `cache` - Pointer to FekCache from fek_cache_create()
+/// * `encrypted_data` - Pointer to encrypted file data (must include header and wrapped FEK)
+/// * `encrypted_len` - Length of encrypted data
+/// * `master_key` - Pointer to 32-byte Master Key
+/// * `master_key_len` - Length of master key (must be 32)
+///
+/// # Returns
+/// Pointer to DecryptionContext (free with decrypt_file_finalize), or null on error
+#[no_mangle]
+pub extern "C" fn decrypt_file_init_cached(
+    cache: *const FekCache,
+    encrypted_data: *const u8,
+    encrypted_len: usize,
+    master_key: *const u8,
+    master_key_len: usize,
+) -> *mut DecryptionContext {
+    if cache.is_null() || encrypted_data.is_null() || master_key.is_null() || master_key_len != KEY_SIZE {
+        return ptr::null_mut();
+    }
+
+    let cache = unsafe { &*cache };
+    let encrypted_slice = unsafe { slice::from_raw_parts(encrypted_data, encrypted_len) };
+    let master_key_slice = unsafe { slice::from_raw_parts(master_key, master_key_len) };
+
+    new_decryption_context(encrypted_slice, |wrapped_fek| cache.get_or_unwrap(wrapped_fek, master_key_slice))
+}
+
+/// Evict (and zeroize) every cached key
+#[no_mangle]
+pub extern "C" fn fek_cache_clear(cache: *mut FekCache) {
+    if !cache.is_null() {
+        unsafe { (&*cache).clear() };
+    }
+}
+
+/// Get cache statistics
+///
+/// # Arguments
+/// * `cache` - Pointer to FekCache
+/// * `entries` - Pointer to store the number of cached keys (can be null)
+/// * `hits` - Pointer to store the hit count (can be null)
+/// * `misses` - Pointer to store the miss count (can be null)
+///
+/// # Returns
+/// 0 on success, error code on failure
+#[no_mangle]
+pub extern "C" fn fek_cache_get_stats(
+    cache: *mut FekCache,
+    entries: *mut usize,
+    hits: *mut u64,
+    misses: *mut u64,
+) -> c_int {
+    if cache.is_null() {
+        return ERROR_NULL_POINTER;
+    }
+
+    let (count, hit_count, miss_count) = unsafe { (&*cache).stats() };
+    unsafe {
+        if !entries.is_null() {
+            *entries = count;
+        }
+        if !hits.is_null() {
+            *hits = hit_count;
+        }
+        if !misses.is_null() {
+            *misses = miss_count;
+        }
+    }
+
+    SUCCESS
+}
+
+/// Free a FEK cache; decryption contexts created from it remain valid
+#[no_mangle]
+pub extern "C" fn fek_cache_free(cache: *mut FekCache) {
+    if !cache.is_null() {
+        unsafe {
+            let _ = Box::from_raw(cache);
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::{decrypt_chunk_into, decrypt_file_finalize, encrypt_file_streaming, free_buffer};
+
+    #[test]
+    fn test_cached_init_reuses_key() {
+        let plaintext: Vec<u8> = (0..5000).map(|i| (i % 97) as u8).collect();
+        let master_key = [3u8; 32];
+        let mut encrypted_len = 0usize;
+        let encrypted_ptr = encrypt_file_streaming(plaintext.as_ptr(), plaintext.len(), master_key.as_ptr(), 32,
+                                                   &mut encrypted_len, None, ptr::null_mut());
+        assert!(!encrypted_ptr.is_null());
+        let encrypted = unsafe { slice::from_raw_parts(encrypted_ptr, encrypted_len) }.to_vec();
+        free_buffer(encrypted_ptr);
+
+        let cache = fek_cache_create(2, 0);
+        for _ in 0..3 {
+            let ctx = decrypt_file_init_cached(cache, encrypted.as_ptr(), encrypted.len(), master_key.as_ptr(), 32);
+            assert!(!ctx.is_null());
+            let chunk = &encrypted[72..];
+            let mut output = vec![0u8; chunk.len()];
+            let mut output_len = 0usize;
+            assert_eq!(decrypt_chunk_into(ctx, chunk.as_ptr(), chunk.len(), output.as_mut_ptr(),
+                                          output.len(), &mut output_len), SUCCESS);
+            assert_eq!(&output[..output_len], &plaintext[..]);
+            decrypt_file_finalize(ctx);
+        }
+
+        // A different master key must not be served the cached FEK
+        let wrong_key = [4u8; 32];
+        let ctx = decrypt_file_init_cached(cache, encrypted.as_ptr(), encrypted.len(), wrong_key.as_ptr(), 32);
+        assert!(ctx.is_null());
+
+        let (mut entries, mut hits, mut misses) = (0usize, 0u64, 0u64);
+        assert_eq!(fek_cache_get_stats(cache, &mut entries, &mut hits, &mut misses), SUCCESS);
+        assert_eq!((entries, hits, misses), (1, 2, 2));
+
+        fek_cache_clear(cache);
+        assert_eq!(fek_cache_get_stats(cache, &mut entries, ptr::null_mut(), ptr::null_mut()), SUCCESS);
+        assert_eq!(entries, 0);
+        fek_cache_free(cache);
+    }
+}
@@ -1,14 +1,18 @@
 use aes_gcm::{
-    aead::{Aead, KeyInit, OsRng},
-    Aes256Gcm, Nonce,
+    aead::{Aead, AeadInPlace, KeyInit, OsRng},
+    Aes256Gcm, Nonce, Tag,
 };
 use pbkdf2::pbkdf2_hmac;
 use rand::RngCore;
 use sha2::Sha256;
+use zeroize::Zeroizing;
 use std::ffi::{c_char, c_void, CStr};
+use std::fs::File;
 use std::os::raw::c_int;
 use std::ptr;
 use std::slice;
+use std::sync::atomic::{AtomicBool, AtomicI32, Ordering};
+use std::sync::{mpsc, Arc, Mutex};
 
 // Include the encryption module (re-export for consistency)
 mod encryption;
@@ -18,6 +22,18 @@ pub use encryption::*;
 mod scan;
 pub use scan::*;
 
+// Include streaming (paged) folder scan results
+mod scan_stream;
+pub use scan_stream::*;
+
+// Include incremental rescan (persisted folder snapshots)
+mod scan_snapshot;
+pub use scan_snapshot::*;
+
+// Include filesystem change notifications (folder watcher)
+mod watcher;
+pub use watcher::*;
+
 // Include the search module (Phase 1)
 mod search;
 pub use search::*;
@@ -26,6 +42,10 @@ pub use search::*;
 mod file_io;
 pub use file_io::*;
 
+// Include instrumentation module (per-stage timers and counters)
+mod metrics;
+pub use metrics::*;
+
 // Include upload module
 mod upload;
 pub use upload::*;
@@ -34,14 +54,39 @@ pub use upload::*;
 mod download;
 pub use download::*;
 
+// Include content-defined chunking module (delta uploads)
+mod cdc;
+pub use cdc::*;
+
 // Include copy modules
 mod copy;
 pub use copy::*;
+mod copy_offload;
 
 // Include unified copy module (replaces individual copy modules)
 mod unified_copy;
 pub use unified_copy::*;
 
+// Include seekable (random-access) decryption module
+mod seekable;
+pub use seekable::*;
+
+// Include FEK cache module
+mod key_cache;
+pub use key_cache::*;
+
+// Include batch encryption module (many small files per call)
+mod batch_crypto;
+pub use batch_crypto::*;
+
+// Include async job module (shared runtime, completion callbacks)
+mod jobs;
+pub use jobs::*;
+
+// Include cold-start preload module (used by the desktop runners)
+mod preload;
+pub use preload::*;
+
 // Constants
 const MAGIC: u32 = 0x434E4552; // "CNER"
 const VERSION: u8 = 1;
@@ -50,6 +95,7 @@ const MAC_SIZE: usize = 16;
 const KEY_SIZE: usize = 32;
 const HEADER_SIZE: usize = 4 + 1 + 3 + 4; // magic + version + reserved + fek_length
 const CHUNK_HEADER_SIZE: usize = 4 + 4 + 12 + 16; // index + size + nonce + mac
+const CHUNK_PREFIX_SIZE: usize = 4 + 4 + 12; // index + size + nonce (precedes ciphertext)
 const DEFAULT_CHUNK_SIZE: usize = 1024 * 1024; // 1MB chunks
 
 // Error codes
@@ -60,6 +106,13 @@ const ERROR_ENCRYPTION_FAILED: c_int = -3;
 const ERROR_DECRYPTION_FAILED: c_int = -4;
 const ERROR_INVALID_FORMAT: c_int = -5;
 const ERROR_ALLOCATION_FAILED: c_int = -6;
+// File error codes from the public header's extended set; file_io's internal codes
+// reuse these names with other values, so they are prefixed to keep the two apart
+const FILE_ERROR_NOT_FOUND: c_int = -7;
+const FILE_ERROR_PERMISSION_DENIED: c_int = -8;
+const FILE_ERROR_IO_FAILED: c_int = -9;
+const FILE_ERROR_INVALID_PATH: c_int = -11;
+const ERROR_BUFFER_TOO_SMALL: c_int = -13;
 
 // ============================================================================
 // TRUE STREAMING ENCRYPTION CONTEXTS
@@ -76,10 +129,11 @@ pub struct EncryptionContext {
 }
 
 /// Decryption context for streaming decryption
-/// Holds the FEK for chunk-by-chunk decryption
+/// Holds the FEK and its cipher for chunk-by-chunk decryption (shared with a FekCache
+/// when created by decrypt_file_init_cached)
 #[repr(C)]
 pub struct DecryptionContext {
-    fek: Vec<u8>,
+    key: Arc<FileKey>,
     chunk_index: u32,
 }
 
@@ -459,10 +513,66 @@ pub extern "C" fn free_buffer(buffer: *mut u8) {
     }
 }
 
+// ============================================================================
+// CRYPTO BACKEND DETECTION
+// ============================================================================
+
+/// AES-GCM backend identifiers returned by crypto_get_backend()
+const CRYPTO_BACKEND_SOFTWARE: c_int = 0;
+const CRYPTO_BACKEND_AESNI_CLMUL: c_int = 1;
+const CRYPTO_BACKEND_ARMV8_CRYPTO: c_int = 2;
+
+/// Detect which AES-GCM backend is used on this CPU
+///
+/// The `aes` and `ghash`/`polyval` crates behind `aes-gcm` pick their implementation at
+/// runtime with a CPUID (or HWCAP) check, so the same portable build uses AES-NI + PCLMULQDQ
+/// where available and falls back to constant-time software otherwise. This performs the
+/// same detection so callers can log or assert which path their build really takes.
+///
+/// # Returns
+/// 0 = software, 1 = AES-NI + PCLMULQDQ, 2 = ARMv8 Crypto Extensions
+#[no_mangle]
+pub extern "C" fn crypto_get_backend() -> c_int {
+    #[cfg(any(target_arch = "x86", target_arch = "x86_64"))]
+    {
+        if std::is_x86_feature_detected!("aes") && std::is_x86_feature_detected!("pclmulqdq") {
+            return CRYPTO_BACKEND_AESNI_CLMUL;
+        }
+    }
+
+    #[cfg(target_arch = "aarch64")]
+    {
+        if std::arch::is_aarch64_feature_detected!("aes") && std::arch::is_aarch64_feature_detected!("pmull") {
+            return CRYPTO_BACKEND_ARMV8_CRYPTO;
+        }
+    }
+
+    CRYPTO_BACKEND_SOFTWARE
+}
+
+/// Get a human-readable name for the AES-GCM backend
+///
+/// # Returns
+/// Pointer to a static null-terminated string (must NOT be freed)
+#[no_mangle]
+pub extern "C" fn crypto_get_backend_name() -> *const c_char {
+    let name: &'static [u8] = match crypto_get_backend() {
+        CRYPTO_BACKEND_AESNI_CLMUL => b"aes-ni+pclmulqdq\0",
+        CRYPTO_BACKEND_ARMV8_CRYPTO => b"armv8-crypto\0",
+        _ => b"software\0",
+    };
+    name.as_ptr() as *const c_char
+}
+
 // Helper functions
 
 fn wrap_key(key: &[u8], master_key: &[u8]) -> Vec<u8> {
     let cipher = Aes256Gcm::new_from_slice(master_key).unwrap();
+    wrap_key_with(key, &cipher)
+}
+
+/// Wrap a key with an already initialized master-key cipher
+fn wrap_key_with(key: &[u8], cipher: &Aes256Gcm) -> Vec<u8> {
     let mut nonce_bytes = [0u8; NONCE_SIZE];
     OsRng.fill_bytes(&mut nonce_bytes);
     let nonce = Nonce::from_slice(&nonce_bytes);
@@ -478,7 +588,18 @@ fn wrap_key(key: &[u8], master_key: &[u8]) -> Vec<u8> {
     }
 }
 
-fn unwrap_key(wrapped_key: &[u8], master_key: &[u8]) -> Result<Vec<u8>, ()> {
+/// The unwrapped key is zeroized when dropped
+fn unwrap_key(wrapped_key: &[u8], master_key: &[u8]) -> Result<Zeroizing<Vec<u8>>, ()> {
+    if wrapped_key.len() < NONCE_SIZE + MAC_SIZE {
+        return Err(());
+    }
+
+    let cipher = Aes256Gcm::new_from_slice(master_key).unwrap();
+    unwrap_key_with(wrapped_key, &cipher)
+}
+
+/// Unwrap a key with an already initialized master-key cipher
+fn unwrap_key_with(wrapped_key: &[u8], cipher: &Aes256Gcm) -> Result<Zeroizing<Vec<u8>>, ()> {
     if wrapped_key.len() < NONCE_SIZE + MAC_SIZE {
         return Err(());
     }
@@ -486,8 +607,7 @@ fn unwrap_key(wrapped_key: &[u8], master_key: &[u8]) -> Result<Vec<u8>, ()> {
     let nonce = Nonce::from_slice(&wrapped_key[..NONCE_SIZE]);
     let ciphertext = &wrapped_key[NONCE_SIZE..];
 
-    let cipher = Aes256Gcm::new_from_slice(master_key).unwrap();
-    cipher.decrypt(nonce, ciphertext.as_ref()).map_err(|_| ())
+    cipher.decrypt(nonce, ciphertext.as_ref()).map(Zeroizing::new).map_err(|_| ())
 }
 
 fn build_header(fek_length: u32) -> [u8; HEADER_SIZE] {
@@ -569,6 +689,68 @@ pub extern "C" fn encrypt_file_streaming(
     output_len: *mut usize,
     progress_callback: Option<ProgressCallback>,
     user_data: *mut c_void,
+) -> *mut u8 {
+    encrypt_file_streaming_parallel(
+        file_data, file_len, master_key, master_key_len, 1, output_len, progress_callback, user_data,
+    )
+}
+
+/// Decrypt a file encrypted with streaming encryption (Option 2)
+///
+/// # Arguments
+/// * `encrypted_data` - Pointer to encrypted file data
+/// * `encrypted_len` - Length of encrypted data
+/// * `master_key` - Pointer to 32-byte Master Key
+/// * `master_key_len` - Length of master key (must be 32)
+/// * `output_len` - Pointer to store output length
+/// * `progress_callback` - Optional progress callback (can be null)
+/// * `user_data` - User data to pass to progress callback
+///
+/// # Returns
+/// Pointer to decrypted file data (caller must free with free_buffer)
+#[no_mangle]
+pub extern "C" fn decrypt_file_streaming(
+    encrypted_data: *const u8,
+    encrypted_len: usize,
+    master_key: *const u8,
+    master_key_len: usize,
+    output_len: *mut usize,
+    progress_callback: Option<ProgressCallback>,
+    user_data: *mut c_void,
+) -> *mut u8 {
+    decrypt_file_streaming_parallel(
+        encrypted_data, encrypted_len, master_key, master_key_len, 1, output_len, progress_callback, user_data,
+    )
+}
+
+/// Encrypt a file using streaming encryption, spreading chunks across worker threads
+///
+/// Produces exactly the same format as `encrypt_file_streaming`. Every chunk has its own
+/// index and nonce, so chunks are encrypted independently, each directly into its final
+/// position in the output buffer.
+///
+/// # Arguments
+/// * `file_data` - Pointer to file data to encrypt
+/// * `file_len` - Length of file data
+/// * `master_key` - Pointer to 32-byte Master Key
+/// * `master_key_len` - Length of master key (must be 32)
+/// * `num_threads` - Worker thread count (0 = one per available core, 1 = calling thread only)
+/// * `output_len` - Pointer to store output length
+/// * `progress_callback` - Optional progress callback (can be null), always invoked on the calling thread
+/// * `user_data` - User data to pass to progress callback
+///
+/// # Returns
+/// Pointer to encrypted file data (caller must free with free_buffer)
+#[no_mangle]
+pub extern "C" fn encrypt_file_streaming_parallel(
+    file_data: *const u8,
+    file_len: usize,
+    master_key: *const u8,
+    master_key_len: usize,
+    num_threads: u32,
+    output_len: *mut usize,
+    progress_callback: Option<ProgressCallback>,
+    user_data: *mut c_void,
 ) -> *mut u8 {
     if file_data.is_null() || master_key.is_null() || output_len.is_null() {
         return ptr::null_mut();
@@ -592,36 +774,10 @@ pub extern "C" fn encrypt_file_streaming(
     // Build main header
     let main_header = build_header(wrapped_fek.len() as u32);
 
-    // Encrypt file in chunks
-    let mut chunks: Vec<Vec<u8>> = Vec::new();
-    let mut total_encrypted_size = 0;
-    let mut chunk_index: u32 = 0;
-
-    let mut offset = 0;
-    while offset < file_len {
-        let chunk_end = std::cmp::min(offset + DEFAULT_CHUNK_SIZE, file_len);
-        let chunk_data = &file_slice[offset..chunk_end];
-
-        // Encrypt chunk with incrementing index
-        match encrypt_chunk_impl(chunk_data, &fek, chunk_index) {
-            Some(encrypted_chunk) => {
-                total_encrypted_size += encrypted_chunk.len();
-                chunks.push(encrypted_chunk);
-            }
-            None => return ptr::null_mut(),
-        }
-
-        // Call progress callback if provided
-        if let Some(callback) = progress_callback {
-            callback(chunk_end, file_len, user_data);
-        }
-
-        chunk_index += 1;
-        offset = chunk_end;
-    }
-
-    // Calculate total output size
-    let total_size = HEADER_SIZE + wrapped_fek.len() + total_encrypted_size;
+    // Output size is known up front: every chunk grows by exactly CHUNK_HEADER_SIZE
+    let chunk_count = (file_len + DEFAULT_CHUNK_SIZE - 1) / DEFAULT_CHUNK_SIZE;
+    let data_offset = HEADER_SIZE + wrapped_fek.len();
+    let total_size = data_offset + file_len + chunk_count * CHUNK_HEADER_SIZE;
 
     // Allocate output buffer
     let output = unsafe {
@@ -631,22 +787,37 @@ pub extern "C" fn encrypt_file_streaming(
         }
         ptr
     };
+    let output_slice = unsafe { slice::from_raw_parts_mut(output, total_size) };
+
+    // Copy main header and wrapped FEK
+    let (prefix, mut remaining) = output_slice.split_at_mut(data_offset);
+    prefix[..HEADER_SIZE].copy_from_slice(&main_header);
+    prefix[HEADER_SIZE..].copy_from_slice(&wrapped_fek);
+
+    // Carve the output into one disjoint slot per chunk
+    let mut jobs = Vec::with_capacity(chunk_count);
+    for (chunk_index, chunk_data) in file_slice.chunks(DEFAULT_CHUNK_SIZE).enumerate() {
+        let (slot, rest) = remaining.split_at_mut(encrypted_chunk_len(chunk_data.len()));
+        jobs.push((chunk_index as u32, chunk_data, slot));
+        remaining = rest;
+    }
 
-    // Copy main header
-    let mut write_offset = 0;
-    unsafe {
-        ptr::copy_nonoverlapping(main_header.as_ptr(), output.add(write_offset), HEADER_SIZE);
-        write_offset += HEADER_SIZE;
-
-        // Copy wrapped FEK
-        ptr::copy_nonoverlapping(wrapped_fek.as_ptr(), output.add(write_offset), wrapped_fek.len());
-        write_offset += wrapped_fek.len();
+    let ok = run_chunk_jobs(
+        jobs,
+        num_threads,
+        file_len,
+        |(chunk_index, chunk_data, slot)| {
+            slot[CHUNK_PREFIX_SIZE..CHUNK_PREFIX_SIZE + chunk_data.len()].copy_from_slice(chunk_data);
+            encrypt_chunk_in_place_impl(slot, chunk_data.len(), &fek, chunk_index)?;
+            Some(chunk_data.len())
+        },
+        progress_callback,
+        user_data,
+    );
 
-        // Copy all chunks
-        for chunk in &chunks {
-            ptr::copy_nonoverlapping(chunk.as_ptr(), output.add(write_offset), chunk.len());
-            write_offset += chunk.len();
-        }
+    if !ok {
+        unsafe { libc::free(output as *mut c_void) };
+        return ptr::null_mut();
     }
 
     unsafe {
@@ -656,25 +827,31 @@ pub extern "C" fn encrypt_file_streaming(
     output
 }
 
-/// Decrypt a file encrypted with streaming encryption (Option 2)
+/// Decrypt a file encrypted with streaming encryption, spreading chunks across worker threads
+///
+/// Accepts any file produced by `encrypt_file_streaming` or `encrypt_file_streaming_parallel`.
+/// Chunk boundaries are located first, then each chunk is decrypted directly into its
+/// final position in the output buffer.
 ///
 /// # Arguments
 /// * `encrypted_data` - Pointer to encrypted file data
 /// * `encrypted_len` - Length of encrypted data
 /// * `master_key` - Pointer to 32-byte Master Key
 /// * `master_key_len` - Length of master key (must be 32)
+/// * `num_threads` - Worker thread count (0 = one per available core, 1 = calling thread only)
 /// * `output_len` - Pointer to store output length
-/// * `progress_callback` - Optional progress callback (can be null)
+/// * `progress_callback` - Optional progress callback (can be null), always invoked on the calling thread
 /// * `user_data` - User data to pass to progress callback
 ///
 /// # Returns
 /// Pointer to decrypted file data (caller must free with free_buffer)
 #[no_mangle]
-pub extern "C" fn decrypt_file_streaming(
+pub extern "C" fn decrypt_file_streaming_parallel(
     encrypted_data: *const u8,
     encrypted_len: usize,
     master_key: *const u8,
     master_key_len: usize,
+    num_threads: u32,
     output_len: *mut usize,
     progress_callback: Option<ProgressCallback>,
     user_data: *mut c_void,
@@ -719,19 +896,18 @@ pub extern "C" fn decrypt_file_streaming(
         Err(_) => return ptr::null_mut(),
     };
 
-    // Decrypt chunks
-    let mut plaintext_chunks: Vec<Vec<u8>> = Vec::new();
+    // Locate chunk boundaries (cheap, header-only pass)
+    let mut chunks: Vec<&[u8]> = Vec::new();
     let mut total_plaintext_size = 0;
     let mut offset = HEADER_SIZE + fek_length;
-    let mut total_decrypted_bytes = 0;
 
     while offset < encrypted_len {
         // Check if we have enough data for chunk header
-        if offset + 20 > encrypted_len {
+        if offset + CHUNK_PREFIX_SIZE > encrypted_len {
             return ptr::null_mut();
         }
 
-        // Read chunk header to get chunk size
+        // Read chunk header to get chunk size (ciphertext + MAC)
         let chunk_size = u32::from_le_bytes([
             encrypted_slice[offset + 4],
             encrypted_slice[offset + 5],
@@ -740,45 +916,45 @@ pub extern "C" fn decrypt_file_streaming(
         ]) as usize;
 
         // Check if we have enough data for the entire chunk
-        if offset + 20 + chunk_size > encrypted_len {
+        if chunk_size < MAC_SIZE || offset + CHUNK_PREFIX_SIZE + chunk_size > encrypted_len {
             return ptr::null_mut();
         }
 
-        // Pass only this chunk to decrypt_chunk_impl
-        let chunk_data = &encrypted_slice[offset..offset + 20 + chunk_size];
-        match decrypt_chunk_impl(chunk_data, &fek) {
-            Some((plaintext, _chunk_len)) => {
-                let plaintext_len = plaintext.len();
-                total_plaintext_size += plaintext_len;
-                plaintext_chunks.push(plaintext);
-                offset += 20 + chunk_size;
-                
-                // Call progress callback if provided
-                if let Some(callback) = progress_callback {
-                    total_decrypted_bytes += plaintext_len;
-                    callback(total_decrypted_bytes, total_plaintext_size, user_data);
-                }
-            }
-            None => return ptr::null_mut(),
-        }
+        chunks.push(&encrypted_slice[offset..offset + CHUNK_PREFIX_SIZE + chunk_size]);
+        total_plaintext_size += chunk_size - MAC_SIZE;
+        offset += CHUNK_PREFIX_SIZE + chunk_size;
     }
 
     // Allocate output buffer
     let output = unsafe {
-        let ptr = libc::malloc(total_plaintext_size) as *mut u8;
+        let ptr = libc::malloc(total_plaintext_size.max(1)) as *mut u8;
         if ptr.is_null() {
             return ptr::null_mut();
         }
         ptr
     };
+    let mut remaining = unsafe { slice::from_raw_parts_mut(output, total_plaintext_size) };
+
+    // Carve the output into one disjoint slot per chunk
+    let mut jobs = Vec::with_capacity(chunks.len());
+    for chunk in chunks {
+        let (slot, rest) = remaining.split_at_mut(chunk.len() - CHUNK_HEADER_SIZE);
+        jobs.push((chunk, slot));
+        remaining = rest;
+    }
 
-    // Copy all plaintext chunks
-    let mut write_offset = 0;
-    for chunk in &plaintext_chunks {
-        unsafe {
-            ptr::copy_nonoverlapping(chunk.as_ptr(), output.add(write_offset), chunk.len());
-            write_offset += chunk.len();
-        }
+    let ok = run_chunk_jobs(
+        jobs,
+        num_threads,
+        total_plaintext_size,
+        |(chunk, slot)| decrypt_chunk_into_impl(chunk, slot, &fek),
+        progress_callback,
+        user_data,
+    );
+
+    if !ok {
+        unsafe { libc::free(output as *mut c_void) };
+        return ptr::null_mut();
     }
 
     unsafe {
@@ -788,74 +964,184 @@ pub extern "C" fn decrypt_file_streaming(
     output
 }
 
+/// Run independent chunk jobs on a pool of scoped worker threads
+///
+/// Workers pull jobs from a shared queue, so a slow chunk does not stall the others.
+/// `work` returns the number of plaintext bytes it handled (for progress) or `None` on
+/// failure, which stops the remaining jobs. Progress is reported on the calling thread
+/// only, since the callback may not be safe to invoke from arbitrary threads.
+///
+/// # Returns
+/// true if every job succeeded
+fn run_chunk_jobs<J, F>(
+    jobs: Vec<J>,
+    num_threads: u32,
+    total_bytes: usize,
+    work: F,
+    progress_callback: Option<ProgressCallback>,
+    user_data: *mut c_void,
+) -> bool
+where
+    J: Send,
+    F: Fn(J) -> Option<usize> + Sync,
+{
+    let threads = match num_threads {
+        0 => std::thread::available_parallelism().map(|n| n.get()).unwrap_or(1),
+        n => n as usize,
+    }
+    .min(jobs.len());
+
+    let mut bytes_done = 0;
+
+    if threads <= 1 {
+        for job in jobs {
+            match work(job) {
+                Some(n) => bytes_done += n,
+                None => return false,
+            }
+            if let Some(callback) = progress_callback {
+                callback(bytes_done, total_bytes, user_data);
+            }
+        }
+        return true;
+    }
+
+    let queue = Mutex::new(jobs.into_iter());
+    let failed = AtomicBool::new(false);
+    let (done_tx, done_rx) = mpsc::channel::<usize>();
+
+    std::thread::scope(|scope| {
+        for _ in 0..threads {
+            let done_tx = done_tx.clone();
+            let (queue, failed, work) = (&queue, &failed, &work);
+            scope.spawn(move || loop {
+                if failed.load(Ordering::Relaxed) {
+                    break;
+                }
+                let job = match queue.lock() {
+                    Ok(mut queue) => queue.next(),
+                    Err(_) => None,
+                };
+                let Some(job) = job else { break };
+                match work(job) {
+                    Some(n) => {
+                        let _ = done_tx.send(n);
+                    }
+                    None => failed.store(true, Ordering::Relaxed),
+                }
+            });
+        }
+        drop(done_tx);
+
+        // Receives until every worker has exited
+        for n in done_rx {
+            bytes_done += n;
+            if let Some(callback) = progress_callback {
+                callback(bytes_done, total_bytes, user_data);
+            }
+        }
+    });
+
+    !failed.load(Ordering::Relaxed)
+}
+
 // Helper functions for streaming encryption
 
-fn encrypt_chunk_impl(data: &[u8], fek: &[u8], chunk_index: u32) -> Option<Vec<u8>> {
+/// Size of an encrypted chunk (prefix + ciphertext + MAC) for a given plaintext length
+fn encrypted_chunk_len(plaintext_len: usize) -> usize {
+    CHUNK_PREFIX_SIZE + plaintext_len + MAC_SIZE
+}
+
+/// Encrypt a chunk in place
+///
+/// `buffer` must hold the plaintext at `CHUNK_PREFIX_SIZE..CHUNK_PREFIX_SIZE + plaintext_len`
+/// and have room for the trailing MAC. The chunk header is written in front of the
+/// ciphertext, so on success `buffer[..returned_len]` is a complete encrypted chunk in the
+/// same format the streaming encryptors write.
+fn encrypt_chunk_in_place_impl(buffer: &mut [u8], plaintext_len: usize, fek: &[u8], chunk_index: u32) -> Option<usize> {
+    let total_len = encrypted_chunk_len(plaintext_len);
+    if buffer.len() < total_len {
+        return None;
+    }
+
     // Generate nonce for this chunk
     let mut nonce_bytes = [0u8; NONCE_SIZE];
     OsRng.fill_bytes(&mut nonce_bytes);
     let nonce = Nonce::from_slice(&nonce_bytes);
 
-    // Encrypt chunk
+    // Encrypt plaintext where it sits, MAC goes right after the ciphertext
     let cipher = Aes256Gcm::new_from_slice(fek).ok()?;
-    let ciphertext = cipher.encrypt(nonce, data).ok()?;
+    let content_end = CHUNK_PREFIX_SIZE + plaintext_len;
+    let tag = cipher
+        .encrypt_in_place_detached(nonce, b"", &mut buffer[CHUNK_PREFIX_SIZE..content_end])
+        .ok()?;
+    buffer[content_end..total_len].copy_from_slice(&tag);
+
+    // Chunk header: index (4) + size (4, ciphertext INCLUDING MAC) + nonce (12)
+    buffer[0..4].copy_from_slice(&chunk_index.to_le_bytes());
+    buffer[4..8].copy_from_slice(&((plaintext_len + MAC_SIZE) as u32).to_le_bytes());
+    buffer[8..CHUNK_PREFIX_SIZE].copy_from_slice(&nonce_bytes);
+
+    Some(total_len)
+}
 
-    // Build chunk header: index (4) + size (4) + nonce (12)
-    // Total header: 20 bytes
-    let mut chunk = Vec::with_capacity(20 + ciphertext.len());
+/// Decrypt a chunk in place
+///
+/// `buffer` holds one complete encrypted chunk. On success the plaintext is left at
+/// `buffer[CHUNK_PREFIX_SIZE..CHUNK_PREFIX_SIZE + returned_len]`.
+fn decrypt_chunk_in_place_impl(buffer: &mut [u8], fek: &[u8]) -> Option<usize> {
+    let cipher = Aes256Gcm::new_from_slice(fek).ok()?;
+    decrypt_chunk_in_place_with(buffer, &cipher)
+}
 
-    // Chunk index (incrementing for each chunk)
-    chunk.extend_from_slice(&chunk_index.to_le_bytes());
-    
-    // Chunk size (encrypted data INCLUDING MAC, as stored in encrypted_content)
-    // encrypted_content is ciphertext + MAC tag from AES-GCM
-    chunk.extend_from_slice(&(ciphertext.len() as u32).to_le_bytes());
-    
-    // Nonce
-    chunk.extend_from_slice(&nonce_bytes);
-    
-    // Encrypted data (ciphertext which includes MAC tag)
-    chunk.extend_from_slice(&ciphertext);
+/// Decrypt a chunk in place with an already initialized cipher
+fn decrypt_chunk_in_place_with(buffer: &mut [u8], cipher: &Aes256Gcm) -> Option<usize> {
+    if buffer.len() < CHUNK_PREFIX_SIZE + MAC_SIZE {
+        return None;
+    }
 
-    Some(chunk)
+    let plaintext_len = buffer.len() - CHUNK_PREFIX_SIZE - MAC_SIZE;
+    let (prefix, content) = buffer.split_at_mut(CHUNK_PREFIX_SIZE);
+    let (ciphertext, tag) = content.split_at_mut(plaintext_len);
+
+    let nonce = Nonce::from_slice(&prefix[8..CHUNK_PREFIX_SIZE]);
+    cipher
+        .decrypt_in_place_detached(nonce, b"", ciphertext, Tag::from_slice(tag))
+        .ok()?;
+
+    Some(plaintext_len)
 }
 
-fn decrypt_chunk_impl(encrypted_data: &[u8], fek: &[u8]) -> Option<(Vec<u8>, usize)> {
-    if encrypted_data.len() < 20 {
+/// Decrypt a chunk from `encrypted_data` into a separate `output` buffer
+///
+/// Only the ciphertext is copied; the MAC and nonce are read from the source chunk.
+/// Returns the plaintext length.
+fn decrypt_chunk_into_impl(encrypted_data: &[u8], output: &mut [u8], fek: &[u8]) -> Option<usize> {
+    let cipher = Aes256Gcm::new_from_slice(fek).ok()?;
+    decrypt_chunk_into_with(encrypted_data, output, &cipher)
+}
+
+/// Decrypt a chunk into `output` with an already initialized cipher
+fn decrypt_chunk_into_with(encrypted_data: &[u8], output: &mut [u8], cipher: &Aes256Gcm) -> Option<usize> {
+    if encrypted_data.len() < CHUNK_PREFIX_SIZE + MAC_SIZE {
         return None;
     }
 
-    // Parse chunk header
-    let _chunk_index = u32::from_le_bytes([
-        encrypted_data[0], encrypted_data[1], encrypted_data[2], encrypted_data[3],
-    ]);
-    
-    let _chunk_size = u32::from_le_bytes([
-        encrypted_data[4], encrypted_data[5], encrypted_data[6], encrypted_data[7],
-    ]) as usize;
-    
-    let nonce_bytes = &encrypted_data[8..20];
-    
-    // Encrypted data starts at position 20
-    let encrypted_content = &encrypted_data[20..];
-    
-    // Validate chunk size
-    if encrypted_content.len() < MAC_SIZE {
+    let plaintext_len = encrypted_data.len() - CHUNK_PREFIX_SIZE - MAC_SIZE;
+    if output.len() < plaintext_len {
         return None;
     }
 
-    // Extract nonce
-    let nonce = Nonce::from_slice(nonce_bytes);
+    let nonce = Nonce::from_slice(&encrypted_data[8..CHUNK_PREFIX_SIZE]);
+    let ciphertext = &encrypted_data[CHUNK_PREFIX_SIZE..CHUNK_PREFIX_SIZE + plaintext_len];
+    let tag = Tag::from_slice(&encrypted_data[CHUNK_PREFIX_SIZE + plaintext_len..]);
 
-    // Decrypt
-    let cipher = Aes256Gcm::new_from_slice(fek).ok()?;
-    let plaintext = cipher.decrypt(nonce, encrypted_content.as_ref()).ok()?;
+    let out = &mut output[..plaintext_len];
+    out.copy_from_slice(ciphertext);
 
-    // Calculate total chunk length (header 20 + encrypted_content which includes MAC)
-    // This is the size of the chunk in the encrypted file
-    let chunk_len = 20 + encrypted_content.len();
+    cipher.decrypt_in_place_detached(nonce, b"", out, tag).ok()?;
 
-    Some((plaintext, chunk_len))
+    Some(plaintext_len)
 }
 
 /// Simple wrapper for encrypting a file (backward compatible name)
@@ -884,6 +1170,355 @@ pub extern "C" fn decrypt_file(
     decrypt_file_streaming(encrypted_data, encrypted_len, master_key, master_key_len, output_len, None, ptr::null_mut())
 }
 
+// ============================================================================
+// PATH-BASED STREAMING ENCRYPTION (file → file, bounded memory)
+// ============================================================================
+
+/// Encrypt a file on disk into the streaming format, without loading it into memory
+///
+/// Chunks are read with positional reads, encrypted in place and written with positional
+/// writes to offsets computed up front, so workers never wait on each other and peak memory
+/// is about one chunk per worker thread. The output is identical in format to
+/// `encrypt_file_streaming`.
+///
+/// # Arguments
+/// * `input_path` - Path to the plaintext file (null-terminated UTF-8)
+/// * `output_path` - Path of the encrypted file to create (overwritten if it exists; must not be the input file)
+/// * `master_key` - Pointer to 32-byte Master Key
+/// * `master_key_len` - Length of master key (must be 32)
+/// * `chunk_size` - Plaintext bytes per chunk (0 = 1MB default)
+/// * `num_threads` - Worker thread count (0 = one per available core, 1 = calling thread only)
+/// * `progress_callback` - Optional progress callback (can be null), invoked on the calling thread
+/// * `user_data` - User data to pass to progress callback
+///
+/// # Returns
+/// SUCCESS, or error code on failure (the partial output file is removed)
+#[no_mangle]
+pub extern "C" fn encrypt_file_from_path(
+    input_path: *const c_char,
+    output_path: *const c_char,
+    master_key: *const u8,
+    master_key_len: usize,
+    chunk_size: usize,
+    num_threads: u32,
+    progress_callback: Option<ProgressCallback>,
+    user_data: *mut c_void,
+) -> c_int {
+    if input_path.is_null() || output_path.is_null() || master_key.is_null() {
+        return ERROR_NULL_POINTER;
+    }
+
+    if master_key_len != KEY_SIZE {
+        return ERROR_INVALID_KEY_SIZE;
+    }
+
+    let (input_path, output_path) = match unsafe { (c_str_to_path(input_path), c_str_to_path(output_path)) } {
+        (Ok(input), Ok(output)) => (input, output),
+        _ => return FILE_ERROR_INVALID_PATH,
+    };
+    let master_key_slice = unsafe { slice::from_raw_parts(master_key, master_key_len) };
+
+    let input = match File::open(&input_path) {
+        Ok(f) => f,
+        Err(e) => return io_error_code(&e),
+    };
+    let file_len = match input.metadata() {
+        Ok(m) => m.len() as usize,
+        Err(e) => return io_error_code(&e),
+    };
+    // Creating the output would truncate the input we are about to read
+    if is_same_file(&input, &input_path, &output_path) {
+        return FILE_ERROR_INVALID_PATH;
+    }
+
+    // Generate and wrap File Encryption Key (FEK); zeroized on every return
+    let mut fek = Zeroizing::new([0u8; KEY_SIZE]);
+    OsRng.fill_bytes(&mut *fek);
+    let wrapped_fek = wrap_key(&*fek, master_key_slice);
+    if wrapped_fek.is_empty() {
+        return ERROR_ENCRYPTION_FAILED;
+    }
+
+    let output = match File::create(&output_path) {
+        Ok(f) => f,
+        Err(e) => return io_error_code(&e),
+    };
+
+    let chunk_size = clamp_chunk_size(chunk_size);
+    let chunk_count = (file_len + chunk_size - 1) / chunk_size;
+    let data_offset = HEADER_SIZE + wrapped_fek.len();
+    let total_size = data_offset + file_len + chunk_count * CHUNK_HEADER_SIZE;
+
+    let mut prefix = build_header(wrapped_fek.len() as u32).to_vec();
+    prefix.extend_from_slice(&wrapped_fek);
+    let result = output
+        .set_len(total_size as u64)
+        .and_then(|_| write_all_at(&output, &prefix, 0));
+    if let Err(e) = result {
+        drop(output);
+        let _ = std::fs::remove_file(&output_path);
+        return io_error_code(&e);
+    }
+
+    // Every chunk but the last is full-size, so both offsets follow from the index
+    let error = AtomicI32::new(SUCCESS);
+    let jobs: Vec<usize> = (0..chunk_count).collect();
+    let ok = run_chunk_jobs(
+        jobs,
+        num_threads,
+        file_len,
+        |index| {
+            let read_offset = index * chunk_size;
+            let plaintext_len = chunk_size.min(file_len - read_offset);
+            let write_offset = data_offset + index * (chunk_size + CHUNK_HEADER_SIZE);
+
+            let mut buffer = vec![0u8; encrypted_chunk_len(plaintext_len)];
+            let region = &mut buffer[CHUNK_PREFIX_SIZE..CHUNK_PREFIX_SIZE + plaintext_len];
+            let status = match read_exact_at(&input, region, read_offset as u64) {
+                Ok(n) if n == plaintext_len => {
+                    match encrypt_chunk_in_place_impl(&mut buffer, plaintext_len, &*fek, index as u32) {
+                        Some(_) => write_all_at(&output, &buffer, write_offset as u64).map_err(|e| io_error_code(&e)),
+                        None => Err(ERROR_ENCRYPTION_FAILED),
+                    }
+                }
+                // File shrank while we were reading it
+                Ok(_) => Err(FILE_ERROR_IO_FAILED),
+                Err(e) => Err(io_error_code(&e)),
+            };
+            match status {
+                Ok(()) => Some(plaintext_len),
+                Err(code) => {
+                    let _ = error.compare_exchange(SUCCESS, code, Ordering::Relaxed, Ordering::Relaxed);
+                    None
+                }
+            }
+        },
+        progress_callback,
+        user_data,
+    );
+
+    if !ok {
+        drop(output);
+        let _ = std::fs::remove_file(&output_path);
+        return error.load(Ordering::Relaxed);
+    }
+
+    SUCCESS
+}
+
+/// Decrypt a streaming-format file on disk, without loading it into memory
+///
+/// Chunk headers are scanned first to compute every chunk's input and output offset; the
+/// output is preallocated and chunks are then decrypted independently with positional I/O.
+///
+/// # Arguments
+/// * `input_path` - Path to the encrypted file (null-terminated UTF-8)
+/// * `output_path` - Path of the plaintext file to create (overwritten if it exists; must not be the input file)
+/// * `master_key` - Pointer to 32-byte Master Key
+/// * `master_key_len` - Length of master key (must be 32)
+/// * `num_threads` - Worker thread count (0 = one per available core, 1 = calling thread only)
+/// * `progress_callback` - Optional progress callback (can be null), invoked on the calling thread
+/// * `user_data` - User data to pass to progress callback
+///
+/// # Returns
+/// SUCCESS, or error code on failure (the partial output file is removed)
+#[no_mangle]
+pub extern "C" fn decrypt_file_from_path(
+    input_path: *const c_char,
+    output_path: *const c_char,
+    master_key: *const u8,
+    master_key_len: usize,
+    num_threads: u32,
+    progress_callback: Option<ProgressCallback>,
+    user_data: *mut c_void,
+) -> c_int {
+    if input_path.is_null() || output_path.is_null() || master_key.is_null() {
+        return ERROR_NULL_POINTER;
+    }
+
+    if master_key_len != KEY_SIZE {
+        return ERROR_INVALID_KEY_SIZE;
+    }
+
+    let (input_path, output_path) = match unsafe { (c_str_to_path(input_path), c_str_to_path(output_path)) } {
+        (Ok(input), Ok(output)) => (input, output),
+        _ => return FILE_ERROR_INVALID_PATH,
+    };
+    let master_key_slice = unsafe { slice::from_raw_parts(master_key, master_key_len) };
+
+    let input = match File::open(&input_path) {
+        Ok(f) => f,
+        Err(e) => return io_error_code(&e),
+    };
+    let encrypted_len = match input.metadata() {
+        Ok(m) => m.len() as usize,
+        Err(e) => return io_error_code(&e),
+    };
+    if is_same_file(&input, &input_path, &output_path) {
+        return FILE_ERROR_INVALID_PATH;
+    }
+
+    // Parse main header and unwrap FEK
+    let mut header = [0u8; HEADER_SIZE];
+    match read_exact_at(&input, &mut header, 0) {
+        Ok(HEADER_SIZE) => {}
+        Ok(_) => return ERROR_INVALID_FORMAT,
+        Err(e) => return io_error_code(&e),
+    }
+    let fek_length = match parse_header(&header) {
+        Ok((MAGIC, VERSION, fek_length)) => fek_length,
+        _ => return ERROR_INVALID_FORMAT,
+    };
+    if encrypted_len < HEADER_SIZE + fek_length {
+        return ERROR_INVALID_FORMAT;
+    }
+    let mut wrapped_fek = vec![0u8; fek_length];
+    if let Err(e) = read_exact_at(&input, &mut wrapped_fek, HEADER_SIZE as u64) {
+        return io_error_code(&e);
+    }
+    let fek = match unwrap_key(&wrapped_fek, master_key_slice) {
+        Ok(key) => key,
+        Err(_) => return ERROR_DECRYPTION_FAILED,
+    };
+
+    // Locate chunks: (input offset, encrypted chunk length, output offset)
+    let mut jobs: Vec<(usize, usize, usize)> = Vec::new();
+    let mut offset = HEADER_SIZE + fek_length;
+    let mut total_plaintext_size = 0;
+    while offset < encrypted_len {
+        let mut prefix = [0u8; CHUNK_PREFIX_SIZE];
+        match read_exact_at(&input, &mut prefix, offset as u64) {
+            Ok(CHUNK_PREFIX_SIZE) => {}
+            Ok(_) => return ERROR_INVALID_FORMAT,
+            Err(e) => return io_error_code(&e),
+        }
+        let chunk_size = u32::from_le_bytes([prefix[4], prefix[5], prefix[6], prefix[7]]) as usize;
+        if chunk_size < MAC_SIZE || offset + CHUNK_PREFIX_SIZE + chunk_size > encrypted_len {
+            return ERROR_INVALID_FORMAT;
+        }
+        jobs.push((offset, CHUNK_PREFIX_SIZE + chunk_size, total_plaintext_size));
+        total_plaintext_size += chunk_size - MAC_SIZE;
+        offset += CHUNK_PREFIX_SIZE + chunk_size;
+    }
+
+    let output = match File::create(&output_path) {
+        Ok(f) => f,
+        Err(e) => return io_error_code(&e),
+    };
+    if let Err(e) = output.set_len(total_plaintext_size as u64) {
+        drop(output);
+        let _ = std::fs::remove_file(&output_path);
+        return io_error_code(&e);
+    }
+
+    let error = AtomicI32::new(SUCCESS);
+    let ok = run_chunk_jobs(
+        jobs,
+        num_threads,
+        total_plaintext_size,
+        |(read_offset, chunk_len, write_offset)| {
+            let mut buffer = vec![0u8; chunk_len];
+            let status = match read_exact_at(&input, &mut buffer, read_offset as u64) {
+                Ok(n) if n == chunk_len => match decrypt_chunk_in_place_impl(&mut buffer, &fek) {
+                    Some(plaintext_len) => {
+                        let plaintext = &buffer[CHUNK_PREFIX_SIZE..CHUNK_PREFIX_SIZE + plaintext_len];
+                        write_all_at(&output, plaintext, write_offset as u64)
+                            .map(|_| plaintext_len)
+                            .map_err(|e| io_error_code(&e))
+                    }
+                    None => Err(ERROR_DECRYPTION_FAILED),
+                },
+                Ok(_) => Err(ERROR_INVALID_FORMAT),
+                Err(e) => Err(io_error_code(&e)),
+            };
+            match status {
+                Ok(plaintext_len) => Some(plaintext_len),
+                Err(code) => {
+                    let _ = error.compare_exchange(SUCCESS, code, Ordering::Relaxed, Ordering::Relaxed);
+                    None
+                }
+            }
+        },
+        progress_callback,
+        user_data,
+    );
+
+    if !ok {
+        drop(output);
+        let _ = std::fs::remove_file(&output_path);
+        return error.load(Ordering::Relaxed);
+    }
+
+    SUCCESS
+}
+
+/// Whether `output_path` names the already opened `input` file (also through links)
+///
+/// A missing output is never the same file.
+fn is_same_file(input: &File, input_path: &std::path::Path, output_path: &std::path::Path) -> bool {
+    #[cfg(unix)]
+    {
+        use std::os::unix::fs::MetadataExt;
+        let _ = input_path;
+        match (input.metadata(), std::fs::metadata(output_path)) {
+            (Ok(a), Ok(b)) => a.dev() == b.dev() && a.ino() == b.ino(),
+            _ => false,
+        }
+    }
+    #[cfg(not(unix))]
+    {
+        let _ = input;
+        matches!((input_path.canonicalize(), output_path.canonicalize()), (Ok(a), Ok(b)) if a == b)
+    }
+}
+
+/// Map an I/O error onto the file error codes in the public header
+fn io_error_code(error: &std::io::Error) -> c_int {
+    match error.kind() {
+        std::io::ErrorKind::NotFound => FILE_ERROR_NOT_FOUND,
+        std::io::ErrorKind::PermissionDenied => FILE_ERROR_PERMISSION_DENIED,
+        _ => FILE_ERROR_IO_FAILED,
+    }
+}
+
+/// Positional read that fills `buf` unless EOF is reached first; returns bytes read
+///
+/// Does not move a shared file cursor, so several threads can read one `File` at once.
+fn read_exact_at(file: &File, buf: &mut [u8], offset: u64) -> std::io::Result<usize> {
+    let mut filled = 0;
+    while filled < buf.len() {
+        #[cfg(unix)]
+        let result = std::os::unix::fs::FileExt::read_at(file, &mut buf[filled..], offset + filled as u64);
+        #[cfg(windows)]
+        let result = std::os::windows::fs::FileExt::seek_read(file, &mut buf[filled..], offset + filled as u64);
+        match result {
+            Ok(0) => break,
+            Ok(n) => filled += n,
+            Err(ref e) if e.kind() == std::io::ErrorKind::Interrupted => {}
+            Err(e) => return Err(e),
+        }
+    }
+    Ok(filled)
+}
+
+/// Positional write of all of `buf` at `offset`
+fn write_all_at(file: &File, buf: &[u8], offset: u64) -> std::io::Result<()> {
+    let mut written = 0;
+    while written < buf.len() {
+        #[cfg(unix)]
+        let result = std::os::unix::fs::FileExt::write_at(file, &buf[written..], offset + written as u64);
+        #[cfg(windows)]
+        let result = std::os::windows::fs::FileExt::seek_write(file, &buf[written..], offset + written as u64);
+        match result {
+            Ok(0) => return Err(std::io::ErrorKind::WriteZero.into()),
+            Ok(n) => written += n,
+            Err(ref e) if e.kind() == std::io::ErrorKind::Interrupted => {}
+            Err(e) => return Err(e),
+        }
+    }
+    Ok(())
+}
+
 // ============================================================================
 // TRUE STREAMING ENCRYPTION API (for low-memory chunk-by-chunk processing)
 // ============================================================================
@@ -953,6 +1588,34 @@ pub extern "C" fn encrypt_file_init(
     Box::leak(context) as *mut EncryptionContext
 }
 
+/// Create an encryption context that keeps the FEK of an existing encrypted file
+///
+/// Used by delta uploads: with the same wrapped FEK the header is byte-identical and
+/// chunks of the previous version stay valid, so unchanged chunks need not be resent.
+/// New chunks still get fresh random nonces. Caller frees with encrypt_file_finalize.
+pub(crate) fn encryption_context_from_wrapped_fek(
+    master_key: &[u8],
+    wrapped_fek: &[u8],
+) -> Option<*mut EncryptionContext> {
+    if master_key.len() != KEY_SIZE {
+        return None;
+    }
+    let fek_vec = unwrap_key(wrapped_fek, master_key).ok()?;
+    if fek_vec.len() != KEY_SIZE {
+        return None;
+    }
+
+    let mut fek = [0u8; KEY_SIZE];
+    fek.copy_from_slice(&fek_vec);
+    let context = Box::new(EncryptionContext {
+        fek,
+        wrapped_fek: wrapped_fek.to_vec(),
+        header: build_header(wrapped_fek.len() as u32),
+        chunk_index: 0,
+    });
+    Some(Box::leak(context) as *mut EncryptionContext)
+}
+
 /// Encrypt a single chunk of data using the encryption context
 ///
 /// This function encrypts one chunk at a time, allowing true streaming encryption
@@ -989,13 +1652,7 @@ pub extern "C" fn encrypt_chunk(
     // Update chunk index in context
     ctx.chunk_index = chunk_index;
 
-    // Encrypt chunk
-    let encrypted = match encrypt_chunk_impl(chunk_slice, &ctx.fek, chunk_index) {
-        Some(data) => data,
-        None => return ptr::null_mut(),
-    };
-
-    let output_size = encrypted.len();
+    let output_size = encrypted_chunk_len(chunk_len);
 
     // Allocate output buffer
     let output = unsafe {
@@ -1006,15 +1663,153 @@ pub extern "C" fn encrypt_chunk(
         ptr
     };
 
-    // Copy encrypted data
+    // Place plaintext after the chunk header and encrypt it there (single allocation)
+    let output_slice = unsafe {
+        ptr::copy_nonoverlapping(chunk_slice.as_ptr(), output.add(CHUNK_PREFIX_SIZE), chunk_len);
+        slice::from_raw_parts_mut(output, output_size)
+    };
+
+    if encrypt_chunk_in_place_impl(output_slice, chunk_len, &ctx.fek, chunk_index).is_none() {
+        unsafe { libc::free(output as *mut c_void); }
+        return ptr::null_mut();
+    }
+
     unsafe {
-        ptr::copy_nonoverlapping(encrypted.as_ptr(), output, output_size);
         *output_len = output_size;
     }
 
     output
 }
 
+/// Get the size of an encrypted chunk for a given plaintext length
+///
+/// Use this to size a reusable buffer for encrypt_chunk_into() / encrypt_chunk_in_place().
+///
+/// # Arguments
+/// * `plaintext_len` - Length of the plaintext chunk
+///
+/// # Returns
+/// Required output size in bytes (chunk header + ciphertext + MAC)
+#[no_mangle]
+pub extern "C" fn encrypt_chunk_output_size(plaintext_len: usize) -> usize {
+    encrypted_chunk_len(plaintext_len)
+}
+
+/// Get the size of the plaintext contained in an encrypted chunk
+///
+/// # Arguments
+/// * `chunk_len` - Length of the encrypted chunk (including chunk header)
+///
+/// # Returns
+/// Plaintext size in bytes, or 0 if the chunk is too short to be valid
+#[no_mangle]
+pub extern "C" fn decrypt_chunk_output_size(chunk_len: usize) -> usize {
+    chunk_len.saturating_sub(CHUNK_PREFIX_SIZE + MAC_SIZE)
+}
+
+/// Encrypt a single chunk into a caller-provided buffer
+///
+/// Same output format as encrypt_chunk(), but nothing is allocated. The input and
+/// output may overlap (e.g. plaintext already placed at `output + 20`).
+///
+/// # Arguments
+/// * `context` - Pointer to EncryptionContext from encrypt_file_init()
+/// * `chunk_data` - Pointer to chunk data to encrypt
+/// * `chunk_len` - Length of chunk data
+/// * `chunk_index` - Index of this chunk (must increment for each chunk)
+/// * `output` - Buffer to receive the encrypted chunk
+/// * `output_capacity` - Size of output buffer (at least encrypt_chunk_output_size(chunk_len))
+/// * `output_len` - Pointer to store output length
+///
+/// # Returns
+/// 0 on success, error code on failure
+#[no_mangle]
+pub extern "C" fn encrypt_chunk_into(
+    context: *mut EncryptionContext,
+    chunk_data: *const u8,
+    chunk_len: usize,
+    chunk_index: u32,
+    output: *mut u8,
+    output_capacity: usize,
+    output_len: *mut usize,
+) -> c_int {
+    if context.is_null() || chunk_data.is_null() || output.is_null() || output_len.is_null() {
+        return ERROR_NULL_POINTER;
+    }
+
+    let required = encrypted_chunk_len(chunk_len);
+    if output_capacity < required {
+        return ERROR_BUFFER_TOO_SMALL;
+    }
+
+    let ctx = unsafe { &mut *context };
+    ctx.chunk_index = chunk_index;
+
+    // Move plaintext behind the chunk header (no-op when the caller already put it there)
+    unsafe {
+        let dest = output.add(CHUNK_PREFIX_SIZE);
+        if dest as *const u8 != chunk_data {
+            ptr::copy(chunk_data, dest, chunk_len);
+        }
+    }
+
+    let output_slice = unsafe { slice::from_raw_parts_mut(output, required) };
+    match encrypt_chunk_in_place_impl(output_slice, chunk_len, &ctx.fek, chunk_index) {
+        Some(written) => {
+            unsafe { *output_len = written; }
+            SUCCESS
+        }
+        None => ERROR_ENCRYPTION_FAILED,
+    }
+}
+
+/// Encrypt a single chunk in place
+///
+/// The plaintext must already be at `buffer + 20` (after the chunk header slot), which
+/// lets callers read file data straight into a reusable buffer with no extra copy.
+/// On success `buffer[0..*output_len]` holds the encrypted chunk.
+///
+/// # Arguments
+/// * `context` - Pointer to EncryptionContext from encrypt_file_init()
+/// * `buffer` - Buffer holding the plaintext at offset 20
+/// * `buffer_capacity` - Size of buffer (at least encrypt_chunk_output_size(plaintext_len))
+/// * `plaintext_len` - Length of plaintext at `buffer + 20`
+/// * `chunk_index` - Index of this chunk (must increment for each chunk)
+/// * `output_len` - Pointer to store output length
+///
+/// # Returns
+/// 0 on success, error code on failure
+#[no_mangle]
+pub extern "C" fn encrypt_chunk_in_place(
+    context: *mut EncryptionContext,
+    buffer: *mut u8,
+    buffer_capacity: usize,
+    plaintext_len: usize,
+    chunk_index: u32,
+    output_len: *mut usize,
+) -> c_int {
+    if context.is_null() || buffer.is_null() || output_len.is_null() {
+        return ERROR_NULL_POINTER;
+    }
+
+    let required = encrypted_chunk_len(plaintext_len);
+    if buffer_capacity < required {
+        return ERROR_BUFFER_TOO_SMALL;
+    }
+
+    let ctx = unsafe { &mut *context };
+    ctx.chunk_index = chunk_index;
+
+    let buffer_slice = unsafe { slice::from_raw_parts_mut(buffer, required) };
+    match encrypt_chunk_in_place_impl(buffer_slice, plaintext_len, &ctx.fek, chunk_index) {
+        Some(written) => {
+            unsafe { *output_len = written; }
+            SUCCESS
+        }
+        None => ERROR_ENCRYPTION_FAILED,
+    }
+}
+
 /// Get the wrapped FEK bytes from the encryption context
 ///
 /// This function retrieves the wrapped FEK that was generated during encrypt_file_init().
@@ -1102,13 +1897,25 @@ pub extern "C" fn decrypt_file_init(
         return ptr::null_mut();
     }
 
-    if encrypted_len < HEADER_SIZE {
-        return ptr::null_mut();
-    }
-
     let encrypted_slice = unsafe { slice::from_raw_parts(encrypted_data, encrypted_len) };
     let master_key_slice = unsafe { slice::from_raw_parts(master_key, master_key_len) };
 
+    new_decryption_context(encrypted_slice, |wrapped_fek| {
+        let fek = unwrap_key(wrapped_fek, master_key_slice).ok()?;
+        FileKey::new(&fek).map(Arc::new)
+    })
+}
+
+/// Parse the header of `encrypted_slice` and build a DecryptionContext around the key
+/// returned by `get_key` for the wrapped FEK
+fn new_decryption_context<F>(encrypted_slice: &[u8], get_key: F) -> *mut DecryptionContext
+where
+    F: FnOnce(&[u8]) -> Option<Arc<FileKey>>,
+{
+    if encrypted_slice.len() < HEADER_SIZE {
+        return ptr::null_mut();
+    }
+
     // Parse header
     let (magic, version, fek_length) = match parse_header(&encrypted_slice[..HEADER_SIZE]) {
         Ok(result) => result,
@@ -1121,22 +1928,20 @@ pub extern "C" fn decrypt_file_init(
     }
 
     // Validate total size
-    if encrypted_len < HEADER_SIZE + fek_length {
+    if encrypted_slice.len() < HEADER_SIZE + fek_length {
         return ptr::null_mut();
     }
 
-    // Extract wrapped FEK
+    // Extract wrapped FEK and unwrap (or look up) the key
     let wrapped_fek = &encrypted_slice[HEADER_SIZE..HEADER_SIZE + fek_length];
-
-    // Unwrap FEK
-    let fek = match unwrap_key(wrapped_fek, master_key_slice) {
-        Ok(key) => key,
-        Err(_) => return ptr::null_mut(),
+    let key = match get_key(wrapped_fek) {
+        Some(key) => key,
+        None => return ptr::null_mut(),
     };
 
     // Create decryption context
     let context = Box::new(DecryptionContext {
-        fek,
+        key,
         chunk_index: 0,
     });
 
@@ -1171,32 +1976,118 @@ pub extern "C" fn decrypt_chunk(
     let ctx = unsafe { &mut *context };
     let encrypted_slice = unsafe { slice::from_raw_parts(encrypted_chunk, chunk_len) };
 
-    // Decrypt chunk
-    let (plaintext, _chunk_len) = match decrypt_chunk_impl(encrypted_slice, &ctx.fek) {
-        Some(result) => result,
-        None => return ptr::null_mut(),
-    };
+    if chunk_len < CHUNK_PREFIX_SIZE + MAC_SIZE {
+        return ptr::null_mut();
+    }
 
-    let output_size = plaintext.len();
+    let output_size = decrypt_chunk_output_size(chunk_len);
 
-    // Allocate output buffer
+    // Allocate output buffer (at least 1 byte so an empty chunk still yields a valid pointer)
     let output = unsafe {
-        let ptr = libc::malloc(output_size) as *mut u8;
+        let ptr = libc::malloc(output_size.max(1)) as *mut u8;
         if ptr.is_null() {
             return ptr::null_mut();
         }
         ptr
     };
 
-    // Copy plaintext data
+    // Decrypt straight into the output buffer
+    let output_slice = unsafe { slice::from_raw_parts_mut(output, output_size) };
+    if decrypt_chunk_into_with(encrypted_slice, output_slice, ctx.key.cipher()).is_none() {
+        unsafe { libc::free(output as *mut c_void); }
+        return ptr::null_mut();
+    }
+
     unsafe {
-        ptr::copy_nonoverlapping(plaintext.as_ptr(), output, output_size);
         *output_len = output_size;
     }
 
     output
 }
 
+/// Decrypt a single chunk into a caller-provided buffer
+///
+/// # Arguments
+/// * `context` - Pointer to DecryptionContext from decrypt_file_init()
+/// * `encrypted_chunk` - Pointer to encrypted chunk data (must include chunk header)
+/// * `chunk_len` - Length of encrypted chunk data
+/// * `output` - Buffer to receive the plaintext (must not overlap the input)
+/// * `output_capacity` - Size of output buffer (at least decrypt_chunk_output_size(chunk_len))
+/// * `output_len` - Pointer to store plaintext length
+///
+/// # Returns
+/// 0 on success, error code on failure
+#[no_mangle]
+pub extern "C" fn decrypt_chunk_into(
+    context: *mut DecryptionContext,
+    encrypted_chunk: *const u8,
+    chunk_len: usize,
+    output: *mut u8,
+    output_capacity: usize,
+    output_len: *mut usize,
+) -> c_int {
+    if context.is_null() || encrypted_chunk.is_null() || output.is_null() || output_len.is_null() {
+        return ERROR_NULL_POINTER;
+    }
+
+    if chunk_len < CHUNK_PREFIX_SIZE + MAC_SIZE {
+        return ERROR_INVALID_FORMAT;
+    }
+
+    if output_capacity < decrypt_chunk_output_size(chunk_len) {
+        return ERROR_BUFFER_TOO_SMALL;
+    }
+
+    let ctx = unsafe { &mut *context };
+    let encrypted_slice = unsafe { slice::from_raw_parts(encrypted_chunk, chunk_len) };
+    let output_slice = unsafe { slice::from_raw_parts_mut(output, output_capacity) };
+
+    match decrypt_chunk_into_with(encrypted_slice, output_slice, ctx.key.cipher()) {
+        Some(plaintext_len) => {
+            unsafe { *output_len = plaintext_len; }
+            SUCCESS
+        }
+        None => ERROR_DECRYPTION_FAILED,
+    }
+}
+
+/// Decrypt a single chunk in place
+///
+/// The ciphertext is decrypted where it sits; no memory is allocated or copied.
+///
+/// # Arguments
+/// * `context` - Pointer to DecryptionContext from decrypt_file_init()
+/// * `buffer` - Buffer holding one encrypted chunk (including chunk header)
+/// * `chunk_len` - Length of the encrypted chunk
+/// * `output_len` - Pointer to store plaintext length
+///
+/// # Returns
+/// Pointer to the plaintext inside `buffer` (always `buffer + 20`), or null on error
+#[no_mangle]
+pub extern "C" fn decrypt_chunk_in_place(
+    context: *mut DecryptionContext,
+    buffer: *mut u8,
+    chunk_len: usize,
+    output_len: *mut usize,
+) -> *mut u8 {
+    if context.is_null() || buffer.is_null() || output_len.is_null() {
+        return ptr::null_mut();
+    }
+
+    let ctx = unsafe { &mut *context };
+    let buffer_slice = unsafe { slice::from_raw_parts_mut(buffer, chunk_len) };
+
+    match decrypt_chunk_in_place_with(buffer_slice, ctx.key.cipher()) {
+        Some(plaintext_len) => {
+            unsafe {
+                *output_len = plaintext_len;
+                buffer.add(CHUNK_PREFIX_SIZE)
+            }
+        }
+        None => ptr::null_mut(),
+    }
+}
+
 /// Finalize decryption context and free memory
 ///
 /// # Arguments
@@ -1217,3 +2108,207 @@ pub extern "C" fn decrypt_file_finalize(context: *mut DecryptionContext) {
 
 // Re-export all folder scanning FFI functions
 // These are defined in scan.rs and made available for FFI calls
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn test_contexts() -> (*mut EncryptionContext, *mut DecryptionContext) {
+        let master_key = [7u8; KEY_SIZE];
+        let mut header_len = 0usize;
+        let enc_ctx = encrypt_file_init(master_key.as_ptr(), KEY_SIZE, &mut header_len);
+        assert!(!enc_ctx.is_null());
+
+        // Build header + wrapped FEK so the decrypt side unwraps the same FEK
+        let ctx = unsafe { &*enc_ctx };
+        let mut file_header = ctx.header.to_vec();
+        file_header.extend_from_slice(&ctx.wrapped_fek);
+        assert_eq!(file_header.len(), header_len);
+
+        let dec_ctx = decrypt_file_init(file_header.as_ptr(), file_header.len(), master_key.as_ptr(), KEY_SIZE);
+        assert!(!dec_ctx.is_null());
+        (enc_ctx, dec_ctx)
+    }
+
+    #[test]
+    fn test_chunk_into_roundtrip() {
+        let (enc_ctx, dec_ctx) = test_contexts();
+        let plaintext: Vec<u8> = (0..5000u32).map(|i| (i % 251) as u8).collect();
+
+        let mut encrypted = vec![0u8; encrypt_chunk_output_size(plaintext.len())];
+        let mut encrypted_len = 0usize;
+        let rc = encrypt_chunk_into(enc_ctx, plaintext.as_ptr(), plaintext.len(), 3,
+                                    encrypted.as_mut_ptr(), encrypted.len(), &mut encrypted_len);
+        assert_eq!(rc, SUCCESS);
+        assert_eq!(encrypted_len, plaintext.len() + CHUNK_HEADER_SIZE);
+        assert_eq!(&encrypted[0..4], &3u32.to_le_bytes());
+
+        // Readable by the in-place decryptor
+        let fek = unsafe { (*dec_ctx).key.fek().to_vec() };
+        let mut in_place = encrypted[..encrypted_len].to_vec();
+        let decoded_len = decrypt_chunk_in_place_impl(&mut in_place, &fek).unwrap();
+        assert_eq!(&in_place[CHUNK_PREFIX_SIZE..CHUNK_PREFIX_SIZE + decoded_len], &plaintext[..]);
+
+        let mut output = vec![0u8; decrypt_chunk_output_size(encrypted_len)];
+        let mut output_len = 0usize;
+        let rc = decrypt_chunk_into(dec_ctx, encrypted.as_ptr(), encrypted_len,
+                                    output.as_mut_ptr(), output.len(), &mut output_len);
+        assert_eq!(rc, SUCCESS);
+        assert_eq!(&output[..output_len], &plaintext[..]);
+
+        // Too-small buffers are rejected without touching the cipher
+        let rc = decrypt_chunk_into(dec_ctx, encrypted.as_ptr(), encrypted_len,
+                                    output.as_mut_ptr(), output.len() - 1, &mut output_len);
+        assert_eq!(rc, ERROR_BUFFER_TOO_SMALL);
+
+        encrypt_file_finalize(enc_ctx);
+        decrypt_file_finalize(dec_ctx);
+    }
+
+    #[test]
+    fn test_chunk_in_place_roundtrip() {
+        let (enc_ctx, dec_ctx) = test_contexts();
+        let plaintext = b"in place chunk payload".to_vec();
+
+        let mut buffer = vec![0u8; encrypt_chunk_output_size(plaintext.len())];
+        buffer[CHUNK_PREFIX_SIZE..CHUNK_PREFIX_SIZE + plaintext.len()].copy_from_slice(&plaintext);
+
+        let mut encrypted_len = 0usize;
+        let rc = encrypt_chunk_in_place(enc_ctx, buffer.as_mut_ptr(), buffer.len(), plaintext.len(), 0, &mut encrypted_len);
+        assert_eq!(rc, SUCCESS);
+
+        // Readable by the allocating decrypt_chunk
+        let mut alloc_len = 0usize;
+        let decrypted = decrypt_chunk(dec_ctx, buffer.as_ptr(), encrypted_len, &mut alloc_len);
+        assert!(!decrypted.is_null());
+        assert_eq!(unsafe { slice::from_raw_parts(decrypted, alloc_len) }, &plaintext[..]);
+        free_buffer(decrypted);
+
+        let mut plaintext_len = 0usize;
+        let out = decrypt_chunk_in_place(dec_ctx, buffer.as_mut_ptr(), encrypted_len, &mut plaintext_len);
+        assert!(!out.is_null());
+        assert_eq!(unsafe { slice::from_raw_parts(out, plaintext_len) }, &plaintext[..]);
+
+        encrypt_file_finalize(enc_ctx);
+        decrypt_file_finalize(dec_ctx);
+    }
+
+    #[test]
+    fn test_chunk_tamper_detected() {
+        let (enc_ctx, dec_ctx) = test_contexts();
+        let plaintext = vec![42u8; 128];
+
+        let mut encrypted_len = 0usize;
+        let encrypted = encrypt_chunk(enc_ctx, plaintext.as_ptr(), plaintext.len(), 0, &mut encrypted_len);
+        assert!(!encrypted.is_null());
+        let mut chunk = unsafe { slice::from_raw_parts(encrypted, encrypted_len) }.to_vec();
+        free_buffer(encrypted);
+
+        chunk[CHUNK_PREFIX_SIZE] ^= 0x01;
+        let mut plaintext_len = 0usize;
+        let out = decrypt_chunk_in_place(dec_ctx, chunk.as_mut_ptr(), chunk.len(), &mut plaintext_len);
+        assert!(out.is_null());
+
+        encrypt_file_finalize(enc_ctx);
+        decrypt_file_finalize(dec_ctx);
+    }
+
+    #[test]
+    fn test_parallel_streaming_matches_sequential_format() {
+        let master_key = [9u8; KEY_SIZE];
+        // Three full chunks plus a short tail
+        let plaintext: Vec<u8> = (0..(3 * DEFAULT_CHUNK_SIZE + 1234)).map(|i| (i % 241) as u8).collect();
+
+        let mut encrypted_len = 0usize;
+        let encrypted = encrypt_file_streaming_parallel(plaintext.as_ptr(), plaintext.len(),
+                                                        master_key.as_ptr(), KEY_SIZE, 4,
+                                                        &mut encrypted_len, None, ptr::null_mut());
+        assert!(!encrypted.is_null());
+        assert_eq!(encrypted_len, HEADER_SIZE + 60 + plaintext.len() + 4 * CHUNK_HEADER_SIZE);
+
+        // Chunks are laid out in order and readable by the single-chunk decryptor
+        let encrypted_slice = unsafe { slice::from_raw_parts(encrypted, encrypted_len) };
+        let first_chunk = &encrypted_slice[HEADER_SIZE + 60..];
+        assert_eq!(&first_chunk[0..4], &0u32.to_le_bytes());
+        let second_chunk = &first_chunk[DEFAULT_CHUNK_SIZE + CHUNK_HEADER_SIZE..];
+        assert_eq!(&second_chunk[0..4], &1u32.to_le_bytes());
+
+        // Sequential decrypt reads parallel output
+        let mut decrypted_len = 0usize;
+        let decrypted = decrypt_file_streaming(encrypted, encrypted_len, master_key.as_ptr(), KEY_SIZE,
+                                               &mut decrypted_len, None, ptr::null_mut());
+        assert!(!decrypted.is_null());
+        assert_eq!(unsafe { slice::from_raw_parts(decrypted, decrypted_len) }, &plaintext[..]);
+        free_buffer(decrypted);
+
+        // Parallel decrypt with an automatic thread count
+        let decrypted = decrypt_file_streaming_parallel(encrypted, encrypted_len, master_key.as_ptr(), KEY_SIZE, 0,
+                                                        &mut decrypted_len, None, ptr::null_mut());
+        assert!(!decrypted.is_null());
+        assert_eq!(unsafe { slice::from_raw_parts(decrypted, decrypted_len) }, &plaintext[..]);
+        free_buffer(decrypted);
+
+        // A corrupted chunk fails the whole file
+        unsafe { *encrypted.add(encrypted_len - 1) ^= 0x01 };
+        let decrypted = decrypt_file_streaming_parallel(encrypted, encrypted_len, master_key.as_ptr(), KEY_SIZE, 4,
+                                                        &mut decrypted_len, None, ptr::null_mut());
+        assert!(decrypted.is_null());
+        free_buffer(encrypted);
+    }
+
+    #[test]
+    fn test_path_based_roundtrip() {
+        let master_key = [3u8; KEY_SIZE];
+        let dir = std::env::temp_dir();
+        let pid = std::process::id();
+        let plain_path = dir.join(format!("cn_path_plain_{}.bin", pid));
+        let enc_path = dir.join(format!("cn_path_enc_{}.bin", pid));
+        let out_path = dir.join(format!("cn_path_out_{}.bin", pid));
+        let plaintext: Vec<u8> = (0..(2 * DEFAULT_CHUNK_SIZE + 4321)).map(|i| (i % 233) as u8).collect();
+        std::fs::write(&plain_path, &plaintext).unwrap();
+
+        let c_path = |p: &std::path::Path| std::ffi::CString::new(p.to_str().unwrap()).unwrap();
+        let (plain_c, enc_c, out_c) = (c_path(&plain_path), c_path(&enc_path), c_path(&out_path));
+
+        let rc = encrypt_file_from_path(plain_c.as_ptr(), enc_c.as_ptr(), master_key.as_ptr(), KEY_SIZE,
+                                        0, 3, None, ptr::null_mut());
+        assert_eq!(rc, SUCCESS);
+
+        // Same format as the in-memory streaming encryptor
+        let encrypted = std::fs::read(&enc_path).unwrap();
+        let mut decrypted_len = 0usize;
+        let decrypted = decrypt_file_streaming(encrypted.as_ptr(), encrypted.len(), master_key.as_ptr(), KEY_SIZE,
+                                               &mut decrypted_len, None, ptr::null_mut());
+        assert!(!decrypted.is_null());
+        assert_eq!(unsafe { slice::from_raw_parts(decrypted, decrypted_len) }, &plaintext[..]);
+        free_buffer(decrypted);
+
+        let rc = decrypt_file_from_path(enc_c.as_ptr(), out_c.as_ptr(), master_key.as_ptr(), KEY_SIZE,
+                                        2, None, ptr::null_mut());
+        assert_eq!(rc, SUCCESS);
+        assert_eq!(std::fs::read(&out_path).unwrap(), plaintext);
+
+        // Wrong key fails and leaves no partial output behind
+        let wrong_key = [4u8; KEY_SIZE];
+        let _ = std::fs::remove_file(&out_path);
+        let rc = decrypt_file_from_path(enc_c.as_ptr(), out_c.as_ptr(), wrong_key.as_ptr(), KEY_SIZE,
+                                        2, None, ptr::null_mut());
+        assert_eq!(rc, ERROR_DECRYPTION_FAILED);
+        assert!(!out_path.exists());
+
+        // Writing over the input is refused and leaves the input untouched
+        let rc = encrypt_file_from_path(plain_c.as_ptr(), plain_c.as_ptr(), master_key.as_ptr(), KEY_SIZE,
+                                        0, 3, None, ptr::null_mut());
+        assert_eq!(rc, FILE_ERROR_INVALID_PATH);
+        assert_eq!(std::fs::read(&plain_path).unwrap(), plaintext);
+        let encrypted_before = std::fs::read(&enc_path).unwrap();
+        let rc = decrypt_file_from_path(enc_c.as_ptr(), enc_c.as_ptr(), master_key.as_ptr(), KEY_SIZE,
+                                        2, None, ptr::null_mut());
+        assert_eq!(rc, FILE_ERROR_INVALID_PATH);
+        assert_eq!(std::fs::read(&enc_path).unwrap(), encrypted_before);
+
+        for path in [&plain_path, &enc_path] {
+            let _ = std::fs::remove_file(path);
+        }
+    }
+}
@@ -0,0 +1,352 @@
+/// Native instrumentation for CloudNexus
+///
+/// Per-stage latency histograms and byte, chunk, allocation and queue-depth counters.
+/// Every transfer context owns a `Metrics` and each recording is mirrored into a
+/// process-wide registry, so both a single transfer and the whole library can be
+/// inspected. Recording is a handful of relaxed atomic adds; `metrics_set_enabled(0)`
+/// also skips the clock reads.
+use std::sync::atomic::{AtomicBool, AtomicU64, Ordering};
+use std::time::{Duration, Instant};
+
+use crate::file_io::{ERROR_NULL_POINTER, SUCCESS};
+
+/// Number of instrumented stages
+pub const METRICS_STAGE_COUNT: usize = 6;
+
+/// Latency histogram buckets: bucket i counts samples below 2^i microseconds,
+/// the last bucket everything slower
+pub const METRICS_HISTOGRAM_BUCKETS: usize = 24;
+
+/// Where a transfer spends its time
+#[repr(u32)]
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum Stage {
+    /// Reading plaintext or source bytes from disk
+    DiskRead = 0,
+    /// Encrypting chunks
+    Encrypt = 1,
+    /// Decrypting chunks
+    Decrypt = 2,
+    /// Writing to disk
+    DiskWrite = 3,
+    /// Time spent inside progress callbacks (i.e. in Dart)
+    CallbackWait = 4,
+    /// Time the caller waited for the next chunk from a background pipeline
+    QueueWait = 5,
+}
+
+#[allow(clippy::declare_interior_mutable_const)]
+const ZERO: AtomicU64 = AtomicU64::new(0);
+
+/// Whether timers read the clock at all
+static METRICS_ENABLED: AtomicBool = AtomicBool::new(true);
+
+/// Process-wide registry every context mirrors into
+pub static GLOBAL_METRICS: Metrics = Metrics::new();
+
+/// Counters of one stage
+pub struct StageMetrics {
+    count: AtomicU64,
+    bytes: AtomicU64,
+    total_ns: AtomicU64,
+    max_ns: AtomicU64,
+    histogram: [AtomicU64; METRICS_HISTOGRAM_BUCKETS],
+}
+
+impl StageMetrics {
+    const fn new() -> Self {
+        Self {
+            count: ZERO,
+            bytes: ZERO,
+            total_ns: ZERO,
+            max_ns: ZERO,
+            histogram: [ZERO; METRICS_HISTOGRAM_BUCKETS],
+        }
+    }
+
+    fn record(&self, elapsed_ns: u64, bytes: u64) {
+        self.count.fetch_add(1, Ordering::Relaxed);
+        self.bytes.fetch_add(bytes, Ordering::Relaxed);
+        self.total_ns.fetch_add(elapsed_ns, Ordering::Relaxed);
+        self.max_ns.fetch_max(elapsed_ns, Ordering::Relaxed);
+        self.histogram[histogram_bucket(elapsed_ns)].fetch_add(1, Ordering::Relaxed);
+    }
+}
+
+/// Metrics of one transfer context (or of the whole process, see `GLOBAL_METRICS`)
+pub struct Metrics {
+    stages: [StageMetrics; METRICS_STAGE_COUNT],
+    chunks: AtomicU64,
+    allocations: AtomicU64,
+    allocated_bytes: AtomicU64,
+    queue_depth: AtomicU64,
+    queue_depth_max: AtomicU64,
+}
+
+impl Metrics {
+    pub const fn new() -> Self {
+        Self {
+            stages: [
+                StageMetrics::new(),
+                StageMetrics::new(),
+                StageMetrics::new(),
+                StageMetrics::new(),
+                StageMetrics::new(),
+                StageMetrics::new(),
+            ],
+            chunks: ZERO,
+            allocations: ZERO,
+            allocated_bytes: ZERO,
+            queue_depth: ZERO,
+            queue_depth_max: ZERO,
+        }
+    }
+
+    /// Apply a recording to this context and to the global registry
+    fn each(&self, f: impl Fn(&Metrics)) {
+        f(self);
+        if !std::ptr::eq(self, &GLOBAL_METRICS) {
+            f(&GLOBAL_METRICS);
+        }
+    }
+
+    /// Start timing a stage; the sample is recorded when the timer is dropped or finished
+    pub fn time(&self, stage: Stage) -> StageTimer<'_> {
+        let start = if METRICS_ENABLED.load(Ordering::Relaxed) {
+            Some(Instant::now())
+        } else {
+            None
+        };
+        StageTimer { metrics: self, stage, start, bytes: 0 }
+    }
+
+    /// Record a stage sample measured elsewhere
+    pub fn record_stage(&self, stage: Stage, elapsed: Duration, bytes: usize) {
+        let elapsed_ns = elapsed.as_nanos().min(u64::MAX as u128) as u64;
+        self.each(|m| m.stages[stage as usize].record(elapsed_ns, bytes as u64));
+    }
+
+    /// Count a chunk handed to (or received from) the caller
+    pub fn add_chunk(&self) {
+        self.each(|m| {
+            m.chunks.fetch_add(1, Ordering::Relaxed);
+        });
+    }
+
+    /// Count a buffer allocation
+    pub fn record_allocation(&self, bytes: usize) {
+        self.each(|m| {
+            m.allocations.fetch_add(1, Ordering::Relaxed);
+            m.allocated_bytes.fetch_add(bytes as u64, Ordering::Relaxed);
+        });
+    }
+
+    /// An item entered a background queue
+    pub fn queue_push(&self) {
+        self.each(|m| {
+            let depth = m.queue_depth.fetch_add(1, Ordering::Relaxed) + 1;
+            m.queue_depth_max.fetch_max(depth, Ordering::Relaxed);
+        });
+    }
+
+    /// An item left a background queue
+    pub fn queue_pop(&self) {
+        self.each(|m| {
+            let _ = m.queue_depth.fetch_update(Ordering::Relaxed, Ordering::Relaxed, |d| d.checked_sub(1));
+        });
+    }
+
+    /// Copy the current values into a C snapshot
+    pub fn snapshot(&self, out: &mut MetricsSnapshot) {
+        for (stage, snap) in self.stages.iter().zip(out.stages.iter_mut()) {
+            snap.count = stage.count.load(Ordering::Relaxed);
+            snap.bytes = stage.bytes.load(Ordering::Relaxed);
+            snap.total_ns = stage.total_ns.load(Ordering::Relaxed);
+            snap.max_ns = stage.max_ns.load(Ordering::Relaxed);
+            for (bucket, value) in stage.histogram.iter().zip(snap.histogram.iter_mut()) {
+                *value = bucket.load(Ordering::Relaxed);
+            }
+        }
+        out.chunks = self.chunks.load(Ordering::Relaxed);
+        out.allocations = self.allocations.load(Ordering::Relaxed);
+        out.allocated_bytes = self.allocated_bytes.load(Ordering::Relaxed);
+        out.queue_depth = self.queue_depth.load(Ordering::Relaxed);
+        out.queue_depth_max = self.queue_depth_max.load(Ordering::Relaxed);
+    }
+
+    /// Zero every counter (the current queue depth is kept)
+    pub fn reset(&self) {
+        for stage in &self.stages {
+            stage.count.store(0, Ordering::Relaxed);
+            stage.bytes.store(0, Ordering::Relaxed);
+            stage.total_ns.store(0, Ordering::Relaxed);
+            stage.max_ns.store(0, Ordering::Relaxed);
+            for bucket in &stage.histogram {
+                bucket.store(0, Ordering::Relaxed);
+            }
+        }
+        self.chunks.store(0, Ordering::Relaxed);
+        self.allocations.store(0, Ordering::Relaxed);
+        self.allocated_bytes.store(0, Ordering::Relaxed);
+        self.queue_depth_max.store(self.queue_depth.load(Ordering::Relaxed), Ordering::Relaxed);
+    }
+}
+
+impl Default for Metrics {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+/// Times one stage sample (see `Metrics::time`)
+pub struct StageTimer<'a> {
+    metrics: &'a Metrics,
+    stage: Stage,
+    start: Option<Instant>,
+    bytes: usize,
+}
+
+impl StageTimer<'_> {
+    /// Builder form of `set_bytes`
+    pub fn with_bytes(mut self, bytes: usize) -> Self {
+        self.bytes = bytes;
+        self
+    }
+
+    /// Attribute bytes to the sample (for per-stage throughput)
+    pub fn set_bytes(&mut self, bytes: usize) {
+        self.bytes = bytes;
+    }
+
+    /// Record the sample now
+    pub fn finish(self, bytes: usize) {
+        let mut timer = self;
+        timer.bytes = bytes;
+    }
+}
+
+impl Drop for StageTimer<'_> {
+    fn drop(&mut self) {
+        if let Some(start) = self.start {
+            self.metrics.record_stage(self.stage, start.elapsed(), self.bytes);
+        }
+    }
+}
+
+fn histogram_bucket(elapsed_ns: u64) -> usize {
+    let micros = elapsed_ns / 1000;
+    // Bucket i holds [2^(i-1), 2^i) microseconds, bucket 0 anything under 1µs
+    let bucket = (u64::BITS - micros.leading_zeros()) as usize;
+    bucket.min(METRICS_HISTOGRAM_BUCKETS - 1)
+}
+
+/// Snapshot of one stage
+#[repr(C)]
+#[derive(Clone, Copy, Debug, Default)]
+pub struct MetricsStageSnapshot {
+    /// Samples recorded
+    pub count: u64,
+    /// Bytes processed by the stage
+    pub bytes: u64,
+    /// Total time spent in the stage
+    pub total_ns: u64,
+    /// Slowest sample
+    pub max_ns: u64,
+    /// Latency histogram (see `METRICS_HISTOGRAM_BUCKETS`)
+    pub histogram: [u64; METRICS_HISTOGRAM_BUCKETS],
+}
+
+/// Snapshot of a metrics registry, indexed by `Stage`
+#[repr(C)]
+#[derive(Clone, Copy, Debug, Default)]
+pub struct MetricsSnapshot {
+    pub stages: [MetricsStageSnapshot; METRICS_STAGE_COUNT],
+    /// Chunks handed to or received from the caller
+    pub chunks: u64,
+    /// Buffer allocations
+    pub allocations: u64,
+    /// Bytes allocated for buffers
+    pub allocated_bytes: u64,
+    /// Items currently waiting in background queues
+    pub queue_depth: u64,
+    /// Highest queue depth seen
+    pub queue_depth_max: u64,
+}
+
+/// Take a snapshot of the process-wide metrics registry
+///
+/// Per-stage throughput is `bytes / total_ns`; taking two snapshots a second apart and
+/// diffing them gives live rates.
+///
+/// # Arguments
+/// * `out` - Receives the snapshot
+///
+/// # Returns
+/// 0 on success, error code on failure
+#[no_mangle]
+pub extern "C" fn metrics_snapshot(out: *mut MetricsSnapshot) -> i32 {
+    if out.is_null() {
+        return ERROR_NULL_POINTER;
+    }
+    GLOBAL_METRICS.snapshot(unsafe { &mut *out });
+    SUCCESS
+}
+
+/// Reset the process-wide metrics registry
+#[no_mangle]
+pub extern "C" fn metrics_reset() {
+    GLOBAL_METRICS.reset();
+}
+
+/// Turn stage timers on or off (counters keep counting)
+///
+/// # Arguments
+/// * `enabled` - 1 to time stages, 0 to skip the clock reads
+#[no_mangle]
+pub extern "C" fn metrics_set_enabled(enabled: i32) {
+    METRICS_ENABLED.store(enabled != 0, Ordering::Relaxed);
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_metrics_record_and_snapshot() {
+        let metrics = Metrics::new();
+        metrics.record_stage(Stage::Encrypt, Duration::from_micros(3), 1024);
+        metrics.record_stage(Stage::Encrypt, Duration::from_millis(2), 2048);
+        {
+            let mut timer = metrics.time(Stage::DiskRead);
+            timer.set_bytes(10);
+        }
+        metrics.add_chunk();
+        metrics.record_allocation(4096);
+        metrics.queue_push();
+        metrics.queue_push();
+        metrics.queue_pop();
+
+        let mut snap = MetricsSnapshot::default();
+        metrics.snapshot(&mut snap);
+        let encrypt = &snap.stages[Stage::Encrypt as usize];
+        assert_eq!(encrypt.count, 2);
+        assert_eq!(encrypt.bytes, 3072);
+        assert_eq!(encrypt.max_ns, 2_000_000);
+        // 3µs in [2,4), 2000µs in [1024,2048)
+        assert_eq!(encrypt.histogram[2], 1);
+        assert_eq!(encrypt.histogram[11], 1);
+        assert_eq!(snap.stages[Stage::DiskRead as usize].bytes, 10);
+        assert_eq!((snap.chunks, snap.allocations, snap.allocated_bytes), (1, 1, 4096));
+        assert_eq!((snap.queue_depth, snap.queue_depth_max), (1, 2));
+
+        // Mirrored into the global registry
+        let mut global = MetricsSnapshot::default();
+        assert_eq!(metrics_snapshot(&mut global), SUCCESS);
+        assert!(global.stages[Stage::Encrypt as usize].count >= 2);
+
+        metrics.reset();
+        metrics.snapshot(&mut snap);
+        assert_eq!(snap.stages[Stage::Encrypt as usize].count, 0);
+        assert_eq!(snap.queue_depth_max, 1);
+    }
+}
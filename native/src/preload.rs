@@ -0,0 +1,69 @@
+/// Cold-start preload for CloudNexus
+///
+/// The desktop runners load this library on a background thread right after launch and
+/// call `cloud_nexus_preload_start` while the Flutter engine is still starting. It
+/// pre-warms the crypto backend and the shared job runtime, so the first Dart calls find
+/// them ready.
+use std::sync::atomic::{AtomicBool, Ordering};
+
+use crate::file_io::{ERROR_IO_FAILED, SUCCESS};
+use crate::jobs::warm_job_runtime;
+use crate::{crypto_get_backend_name, encrypt_chunk_into, encrypt_chunk_output_size,
+            encrypt_file_finalize, encrypt_file_init};
+
+static PRELOAD_STARTED: AtomicBool = AtomicBool::new(false);
+
+/// Run the crypto hot path once: backend detection, key schedule, chunk encryption
+fn warm_crypto() {
+    let _ = crypto_get_backend_name();
+    let key = [0u8; 32];
+    let mut header_len = 0usize;
+    let context = encrypt_file_init(key.as_ptr(), key.len(), &mut header_len);
+    if context.is_null() {
+        return;
+    }
+    let plaintext = [0u8; 4096];
+    let mut encrypted = vec![0u8; encrypt_chunk_output_size(plaintext.len())];
+    let mut encrypted_len = 0usize;
+    encrypt_chunk_into(context, plaintext.as_ptr(), plaintext.len(), 0,
+                       encrypted.as_mut_ptr(), encrypted.len(), &mut encrypted_len);
+    encrypt_file_finalize(context);
+}
+
+/// Start warming up the library on a background thread
+///
+/// Safe to call more than once; only the first call does anything. Returns immediately.
+///
+/// # Returns
+/// 0 on success, error code on failure
+#[no_mangle]
+pub extern "C" fn cloud_nexus_preload_start() -> i32 {
+    if PRELOAD_STARTED.swap(true, Ordering::SeqCst) {
+        return SUCCESS;
+    }
+
+    let spawned = std::thread::Builder::new()
+        .name("cn-preload".into())
+        .spawn(|| {
+            warm_crypto();
+            warm_job_runtime();
+        });
+
+    match spawned {
+        Ok(_) => SUCCESS,
+        Err(_) => ERROR_IO_FAILED,
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_preload_start_runs_once() {
+        assert_eq!(cloud_nexus_preload_start(), SUCCESS);
+        assert!(PRELOAD_STARTED.load(Ordering::SeqCst));
+        // Second call is a no-op
+        assert_eq!(cloud_nexus_preload_start(), SUCCESS);
+    }
+}
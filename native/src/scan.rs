@@ -1,6 +1,8 @@
 use serde::{Deserialize, Serialize};
 use std::fs;
 use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::Arc;
 use std::time::Instant;
 
 // ============================================================================
@@ -70,124 +72,324 @@ pub struct FolderScanError {
 pub fn scan_folder_sync(
     root_path: &str,
     max_depth: Option<u64>,
+) -> Result<FolderScanResult, String> {
+    collect_scan(root_path, max_depth, 1, None)
+}
+
+/// Run a walk and gather every listing into one FolderScanResult
+///
+/// With `runtime` the directories are read by tasks on that runtime (see `walk_tree_on`)
+/// and `num_threads` is ignored.
+fn collect_scan(
+    root_path: &str,
+    max_depth: Option<u64>,
+    num_threads: usize,
+    runtime: Option<&tokio::runtime::Handle>,
 ) -> Result<FolderScanResult, String> {
     let start_time = Instant::now();
     
-    let root = Path::new(root_path);
-    
-    // Validate root path exists and is a directory
-    if !root.exists() {
-        return Err(format!("Path does not exist: {}", root_path));
-    }
-    
-    if !root.is_dir() {
-        return Err(format!("Path is not a directory: {}", root_path));
-    }
-    
     let mut items = Vec::new();
     let mut total_size: u64 = 0;
     let mut file_count: u64 = 0;
     let mut folder_count: u64 = 0;
     
+    let emit = |listing: DirectoryListing| {
+        total_size += listing.total_size;
+        file_count += listing.file_count;
+        folder_count += listing.subfolders.len() as u64;
+        items.extend(listing.items);
+        true
+    };
+    match runtime {
+        Some(runtime) => walk_tree_on(runtime, Path::new(root_path), max_depth, emit)?,
+        None => walk_tree(Path::new(root_path), max_depth, num_threads, emit)?,
+    }
+    
+    Ok(FolderScanResult {
+        root_path: root_path.to_string(),
+        items,
+        total_size,
+        file_count,
+        folder_count,
+        scan_duration_ms: start_time.elapsed().as_millis() as u64,
+    })
+}
+
+/// Walk the tree below `root`, handing one listing per directory to `emit`
+///
+/// `emit` always runs on the calling thread, whatever the worker count; returning false
+/// stops the walk early. With `num_threads == 1` the walk is a depth-first traversal on
+/// the calling thread, otherwise see `scan_folder_parallel`.
+pub(crate) fn walk_tree<F>(
+    root: &Path,
+    max_depth: Option<u64>,
+    num_threads: usize,
+    mut emit: F,
+) -> Result<(), String>
+where
+    F: FnMut(DirectoryListing) -> bool,
+{
+    check_scan_root(root)?;
+    
     let max_depth = max_depth.unwrap_or(u64::MAX);
+    let num_threads = match num_threads {
+        0 => std::thread::available_parallelism().map(|n| n.get()).unwrap_or(1),
+        n => n,
+    };
     
-    // Use a stack for iterative depth-first traversal
-    // This avoids stack overflow on deep folder structures
-    let mut stack = vec![(PathBuf::from(root_path), 0u64)];
+    if num_threads == 1 {
+        // Use a stack for iterative depth-first traversal
+        // This avoids stack overflow on deep folder structures
+        let mut stack = vec![(root.to_path_buf(), 0u64)];
+        
+        while let Some((current_path, current_depth)) = stack.pop() {
+            if current_depth > max_depth {
+                continue;
+            }
+            
+            let listing = match scan_directory(root, &current_path) {
+                Ok(listing) => listing,
+                Err(e) => {
+                    eprintln!("Failed to read directory {}: {}", current_path.display(), e);
+                    continue;
+                }
+            };
+            
+            // Add subfolders to stack for deeper traversal
+            for subfolder in &listing.subfolders {
+                stack.push((subfolder.clone(), current_depth + 1));
+            }
+            
+            if !emit(listing) {
+                break;
+            }
+        }
+        
+        return Ok(());
+    }
+    
+    let runtime = tokio::runtime::Builder::new_multi_thread()
+        .worker_threads(num_threads)
+        .thread_name("cn-folder-scan")
+        .build()
+        .map_err(|e| format!("Failed to start scan workers: {}", e))?;
+    
+    walk_parallel(runtime.handle(), root, max_depth, num_threads, emit);
+    Ok(())
+}
+
+/// Walk the tree below `root` with tasks on an existing runtime
+///
+/// Like `walk_tree`, but the directories are read by `runtime`'s workers instead of a
+/// runtime started for this walk, so concurrent walks (e.g. scan jobs) share one pool.
+/// `emit` runs on the calling thread, which must not be one of `runtime`'s async workers:
+/// it blocks until the walk is done.
+pub(crate) fn walk_tree_on<F>(
+    runtime: &tokio::runtime::Handle,
+    root: &Path,
+    max_depth: Option<u64>,
+    emit: F,
+) -> Result<(), String>
+where
+    F: FnMut(DirectoryListing) -> bool,
+{
+    check_scan_root(root)?;
+    
+    let workers = std::thread::available_parallelism().map(|n| n.get()).unwrap_or(1);
+    walk_parallel(runtime, root, max_depth.unwrap_or(u64::MAX), workers, emit);
+    Ok(())
+}
+
+fn check_scan_root(root: &Path) -> Result<(), String> {
+    // Validate root path exists and is a directory
+    if !root.exists() {
+        return Err(format!("Path does not exist: {}", root.display()));
+    }
+    
+    if !root.is_dir() {
+        return Err(format!("Path is not a directory: {}", root.display()));
+    }
     
-    while let Some((current_path, current_depth)) = stack.pop() {
-        if current_depth > max_depth {
-            continue;
+    Ok(())
+}
+
+/// Fan the walk out as one task per directory on `handle`, emitting on the calling thread
+fn walk_parallel<F>(
+    handle: &tokio::runtime::Handle,
+    root: &Path,
+    max_depth: u64,
+    workers: usize,
+    mut emit: F,
+) where
+    F: FnMut(DirectoryListing) -> bool,
+{
+    // Every task holds a sender; the channel closes once the last directory is done. It is
+    // bounded so a slow `emit` holds the workers back instead of queueing the whole tree.
+    let (tx, rx) = std::sync::mpsc::sync_channel::<DirectoryListing>(workers * 4);
+    let stop = Arc::new(AtomicBool::new(false));
+    
+    spawn_directory_scan(
+        handle,
+        Arc::new(root.to_path_buf()),
+        root.to_path_buf(),
+        0,
+        max_depth,
+        stop.clone(),
+        tx,
+    );
+    
+    for listing in rx {
+        if !emit(listing) {
+            // Tasks already queued see the flag and exit without reading
+            stop.store(true, Ordering::Relaxed);
+            break;
         }
+    }
+}
+
+/// Entries of a single directory
+pub(crate) struct DirectoryListing {
+    pub(crate) items: Vec<FolderScanItem>,
+    /// Subfolders to descend into (in listing order)
+    pub(crate) subfolders: Vec<PathBuf>,
+    pub(crate) total_size: u64,
+    pub(crate) file_count: u64,
+}
+
+/// Read one directory: folders first, then files, both alphabetically
+///
+/// The entry type comes from the directory listing itself (`DirEntry::file_type`), so
+/// sorting and classification do not stat every entry again. Only files are stat'ed, for
+/// their size. Symlinks are skipped to avoid infinite loops.
+fn scan_directory(root: &Path, dir: &Path) -> std::io::Result<DirectoryListing> {
+    let mut entries: Vec<(fs::DirEntry, fs::FileType)> = fs::read_dir(dir)?
+        .filter_map(|e| e.ok())
+        .filter_map(|e| e.file_type().ok().map(|t| (e, t)))
+        .filter(|(_, t)| !t.is_symlink())
+        .collect();
+    
+    entries.sort_by(|(a, a_type), (b, b_type)| {
+        b_type.is_dir().cmp(&a_type.is_dir()).then_with(|| a.file_name().cmp(&b.file_name()))
+    });
+    
+    let mut listing = DirectoryListing {
+        items: Vec::with_capacity(entries.len()),
+        subfolders: Vec::new(),
+        total_size: 0,
+        file_count: 0,
+    };
+    
+    for (entry, file_type) in entries {
+        let entry_path = entry.path();
         
-        // Read directory entries
-        let dir_entries = match fs::read_dir(&current_path) {
-            Ok(entries) => entries,
-            Err(e) => {
-                eprintln!("Failed to read directory {}: {}", current_path.display(), e);
-                continue;
+        let size = if file_type.is_dir() {
+            0
+        } else {
+            match entry.metadata() {
+                Ok(m) => m.len(),
+                Err(_) => continue,
             }
         };
         
-        // Collect entries first to sort them
-        let mut entries: Vec<_> = dir_entries
-            .filter_map(|e| e.ok())
-            .collect();
+        let relative_path = entry_path
+            .strip_prefix(root)
+            .map(|p| p.to_string_lossy().replace('\\', "/"))
+            .unwrap_or_else(|_| entry_path.to_string_lossy().to_string());
         
-        // Sort entries: folders first, then files, both alphabetically
-        entries.sort_by(|a, b| {
-            let a_is_dir = a.path().is_dir();
-            let b_is_dir = b.path().is_dir();
-            
-            match (a_is_dir, b_is_dir) {
-                (true, false) => std::cmp::Ordering::Less,
-                (false, true) => std::cmp::Ordering::Greater,
-                _ => a.file_name().cmp(&b.file_name()),
-            }
+        listing.items.push(FolderScanItem {
+            name: entry.file_name().to_string_lossy().to_string(),
+            relative_path,
+            is_folder: file_type.is_dir(),
+            size,
+            absolute_path: entry_path.to_string_lossy().to_string(),
         });
         
-        for entry in entries {
-            let entry_path = entry.path();
-            
-            // Skip symlinks to avoid infinite loops
-            if entry_path.is_symlink() {
-                continue;
-            }
-            
-            if entry_path.is_dir() {
-                // It's a subfolder
-                folder_count += 1;
-                
-                let relative_path = entry_path
-                    .strip_prefix(root)
-                    .map(|p| p.to_string_lossy().replace('\\', "/"))
-                    .unwrap_or_else(|_| entry_path.to_string_lossy().to_string());
-                
-                items.push(FolderScanItem {
-                    name: entry.file_name().to_string_lossy().to_string(),
-                    relative_path: relative_path.clone(),
-                    is_folder: true,
-                    size: 0,
-                    absolute_path: entry_path.to_string_lossy().to_string(),
-                });
-                
-                // Add to stack for deeper traversal
-                stack.push((entry_path, current_depth + 1));
-            } else {
-                // It's a file
-                let metadata = match entry.metadata() {
-                    Ok(m) => m,
-                    Err(_) => continue,
-                };
-                
-                let size = metadata.len();
-                total_size += size;
-                file_count += 1;
-                
-                let relative_path = entry_path
-                    .strip_prefix(root)
-                    .map(|p| p.to_string_lossy().replace('\\', "/"))
-                    .unwrap_or_else(|_| entry_path.to_string_lossy().to_string());
-                
-                items.push(FolderScanItem {
-                    name: entry.file_name().to_string_lossy().to_string(),
-                    relative_path: relative_path.clone(),
-                    is_folder: false,
-                    size,
-                    absolute_path: entry_path.to_string_lossy().to_string(),
-                });
-            }
+        if file_type.is_dir() {
+            listing.subfolders.push(entry_path);
+        } else {
+            listing.total_size += size;
+            listing.file_count += 1;
         }
     }
     
-    Ok(FolderScanResult {
-        root_path: root_path.to_string(),
-        items,
-        total_size,
-        file_count,
-        folder_count,
-        scan_duration_ms: start_time.elapsed().as_millis() as u64,
-    })
+    Ok(listing)
+}
+
+// ============================================================================
+// PARALLEL FOLDER SCANNING
+// ============================================================================
+
+/// Scan folder with directory reads spread over a pool of worker threads
+///
+/// Every directory becomes a task on a dedicated multi-threaded tokio runtime, whose
+/// work-stealing scheduler keeps all workers busy on wide or unbalanced trees. Each task
+/// lists its directory and spawns one task per subfolder. The runtime is private to the
+/// scan, so the blocking `std::fs` calls inside tasks cannot starve unrelated async work.
+///
+/// Items within a directory are ordered as in `scan_folder_sync`; the order in which
+/// directories appear in the result is not deterministic.
+///
+/// # Arguments
+/// * `root_path` - Absolute path to the folder to scan
+/// * `max_depth` - Optional maximum depth to scan (None for unlimited)
+/// * `num_threads` - Worker threads (0 = one per available core)
+///
+/// # Returns
+/// Result containing FolderScanResult or error string
+pub fn scan_folder_parallel(
+    root_path: &str,
+    max_depth: Option<u64>,
+    num_threads: usize,
+) -> Result<FolderScanResult, String> {
+    collect_scan(root_path, max_depth, num_threads, None)
+}
+
+/// Scan a folder with tasks on an existing runtime instead of starting scan workers
+///
+/// See `walk_tree_on`; must not be called from one of `runtime`'s async workers.
+pub(crate) fn scan_folder_on(
+    runtime: &tokio::runtime::Handle,
+    root_path: &str,
+    max_depth: Option<u64>,
+) -> Result<FolderScanResult, String> {
+    collect_scan(root_path, max_depth, 0, Some(runtime))
+}
+
+/// Spawn a task that lists one directory and fans its subfolders out as new tasks
+fn spawn_directory_scan(
+    handle: &tokio::runtime::Handle,
+    root: Arc<PathBuf>,
+    dir: PathBuf,
+    depth: u64,
+    max_depth: u64,
+    stop: Arc<AtomicBool>,
+    tx: std::sync::mpsc::SyncSender<DirectoryListing>,
+) {
+    if depth > max_depth {
+        return;
+    }
+    
+    let task_handle = handle.clone();
+    handle.spawn(async move {
+        if stop.load(Ordering::Relaxed) {
+            return;
+        }
+        
+        let listing = match scan_directory(&root, &dir) {
+            Ok(listing) => listing,
+            Err(e) => {
+                eprintln!("Failed to read directory {}: {}", dir.display(), e);
+                return;
+            }
+        };
+        
+        for subfolder in &listing.subfolders {
+            spawn_directory_scan(&task_handle, root.clone(), subfolder.clone(), depth + 1, max_depth,
+                                 stop.clone(), tx.clone());
+        }
+        
+        let _ = tx.send(listing);
+    });
 }
 
 // ============================================================================
@@ -237,6 +439,27 @@ impl FolderScanContext {
 pub extern "C" fn scan_folder_init(
     folder_path: *const std::os::raw::c_char,
     max_depth: u32,
+) -> *mut FolderScanContext {
+    scan_folder_init_parallel(folder_path, max_depth, 1)
+}
+
+/// Initialize a folder scan operation, reading directories on several threads
+///
+/// See `scan_folder_parallel`. Items within a directory keep the serial ordering, but
+/// directories may appear in any order.
+///
+/// # Arguments
+/// * `folder_path` - Path to the folder to scan
+/// * `max_depth` - Maximum scan depth (0 for unlimited)
+/// * `num_threads` - Worker threads (0 = one per available core, 1 = serial scan)
+///
+/// # Returns
+/// Pointer to FolderScanContext, or null on error
+#[no_mangle]
+pub extern "C" fn scan_folder_init_parallel(
+    folder_path: *const std::os::raw::c_char,
+    max_depth: u32,
+    num_threads: u32,
 ) -> *mut FolderScanContext {
     if folder_path.is_null() {
         return std::ptr::null_mut();
@@ -256,7 +479,11 @@ pub extern "C" fn scan_folder_init(
     
     // Perform the scan
     let max_depth = if max_depth == 0 { None } else { Some(max_depth as u64) };
-    let result = scan_folder_sync(&path_str, max_depth);
+    let result = if num_threads == 1 {
+        scan_folder_sync(&path_str, max_depth)
+    } else {
+        scan_folder_parallel(&path_str, max_depth, num_threads as usize)
+    };
     
     // Create context
     let mut context = Box::new(FolderScanContext::new());
@@ -488,9 +715,29 @@ pub extern "C" fn scan_folder_quick(
     folder_path: *const std::os::raw::c_char,
     max_depth: u32,
     output_len: *mut usize,
+) -> *mut std::os::raw::c_char {
+    scan_folder_quick_parallel(folder_path, max_depth, 1, output_len)
+}
+
+/// Quick scan with directory reads spread over several threads
+///
+/// # Arguments
+/// * `folder_path` - Path to the folder to scan
+/// * `max_depth` - Maximum scan depth (0 for unlimited)
+/// * `num_threads` - Worker threads (0 = one per available core, 1 = serial scan)
+/// * `output_len` - Pointer to store output length
+///
+/// # Returns
+/// Pointer to JSON string (caller must free with scan_folder_free_string), or null on error
+#[no_mangle]
+pub extern "C" fn scan_folder_quick_parallel(
+    folder_path: *const std::os::raw::c_char,
+    max_depth: u32,
+    num_threads: u32,
+    output_len: *mut usize,
 ) -> *mut std::os::raw::c_char {
     // Initialize scan
-    let context = scan_folder_init(folder_path, max_depth);
+    let context = scan_folder_init_parallel(folder_path, max_depth, num_threads);
     
     if context.is_null() {
         return std::ptr::null_mut();
@@ -503,4 +750,52 @@ pub extern "C" fn scan_folder_quick(
     scan_folder_free(context);
     
     json_ptr
-}
\ No newline at end of file
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_parallel_scan_matches_serial() {
+        let root = std::env::temp_dir().join(format!("cn_scan_parallel_{}", std::process::id()));
+        let _ = fs::remove_dir_all(&root);
+        for a in 0..4 {
+            for b in 0..3 {
+                let dir = root.join(format!("dir{}", a)).join(format!("sub{}", b));
+                fs::create_dir_all(&dir).unwrap();
+                for f in 0..5 {
+                    fs::write(dir.join(format!("file{}.txt", f)), vec![0u8; a * 100 + b * 10 + f]).unwrap();
+                }
+            }
+        }
+        fs::write(root.join("top.bin"), b"top").unwrap();
+
+        let root_str = root.to_str().unwrap();
+        let serial = scan_folder_sync(root_str, None).unwrap();
+        let parallel = scan_folder_parallel(root_str, None, 4).unwrap();
+
+        assert_eq!(serial.file_count, 61);
+        assert_eq!(serial.folder_count, 16);
+        assert_eq!(parallel.file_count, serial.file_count);
+        assert_eq!(parallel.folder_count, serial.folder_count);
+        assert_eq!(parallel.total_size, serial.total_size);
+
+        // Folders sort before files within a directory
+        assert!(serial.items[0].is_folder);
+        assert_eq!(serial.items.last().map(|i| i.name.as_str()), Some("file4.txt"));
+
+        let mut serial_paths: Vec<_> = serial.items.iter().map(|i| (i.relative_path.clone(), i.size)).collect();
+        let mut parallel_paths: Vec<_> = parallel.items.iter().map(|i| (i.relative_path.clone(), i.size)).collect();
+        serial_paths.sort();
+        parallel_paths.sort();
+        assert_eq!(serial_paths, parallel_paths);
+
+        // Depth limit: root listing plus one level
+        let shallow = scan_folder_parallel(root_str, Some(1), 2).unwrap();
+        assert_eq!(shallow.folder_count, 16);
+        assert_eq!(shallow.file_count, 1);
+
+        let _ = fs::remove_dir_all(&root);
+    }
+}
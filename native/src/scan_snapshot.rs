@@ -0,0 +1,620 @@
+/// Incremental folder rescans against a persisted snapshot
+///
+/// A full `scan_folder_init` re-enumerates every directory even when nothing changed. A
+/// snapshot records, per directory, its mtime plus the names of its subfolders and the
+/// size and mtime of its files. On the next rescan:
+///
+/// - A directory whose mtime is unchanged has the same entries as before (adding, removing
+///   or renaming an entry updates the directory mtime), so it is not re-listed. That only
+///   holds if the mtime was already older than the previous scan by more than a timestamp
+///   tick: a change in the same tick as the listing leaves the mtime as it was. Such
+///   "racy" directories are listed again on every rescan until they settle.
+/// - Only directories whose mtime changed are read again and diffed against the snapshot.
+/// - Editing a file in place does not touch its directory's mtime. With `verify_files`
+///   the known files of unchanged directories are stat'ed (no directory listing needed);
+///   without it, such in-place edits go unnoticed until the directory changes.
+///
+/// Every directory is still stat'ed once, since a change deep in the tree is not reflected
+/// in the mtimes of its ancestors.
+///
+/// Snapshot file layout (all integers little-endian, strings are u32 length + UTF-8):
+///
+/// ```text
+/// magic u32 "CNSS" | version u8 | scan_start_ns i64 (version 2+) | dir_count u32
+/// per dir: rel_path str | mtime_ns i64 | subdir_count u32 | name str ...
+///          | file_count u32 | (name str | size u64 | mtime_ns i64) ...
+/// ```
+use serde::{Deserialize, Serialize};
+use std::collections::HashMap;
+use std::ffi::{c_char, CStr, CString};
+use std::fs;
+use std::io::{self, Read, Write};
+use std::path::{Path, PathBuf};
+use std::ptr;
+use std::time::{Instant, SystemTime, UNIX_EPOCH};
+
+use crate::FolderScanItem;
+
+const SNAPSHOT_MAGIC: u32 = 0x53534E43; // "CNSS"
+const SNAPSHOT_VERSION: u8 = 2;
+
+/// Coarsest directory timestamp granularity we expect (FAT/exFAT and SMB use 1-2 s ticks;
+/// Linux filesystems stamp from the coarse jiffy clock)
+const RACY_MTIME_WINDOW_NS: i64 = 2_000_000_000;
+
+/// Snapshot entry for one file
+#[derive(Debug, Clone, PartialEq)]
+struct FileState {
+    name: String,
+    size: u64,
+    mtime_ns: i64,
+}
+
+/// Snapshot entry for one directory
+#[derive(Debug, Clone, Default)]
+struct DirState {
+    mtime_ns: i64,
+    subdirs: Vec<String>,
+    files: Vec<FileState>,
+}
+
+/// Per-directory state of a scanned tree, keyed by relative path ("" = root)
+#[derive(Debug, Clone, Default)]
+pub struct FolderSnapshot {
+    /// Wall-clock time the scan that produced this snapshot started (0 = unknown)
+    scan_start_ns: i64,
+    dirs: HashMap<String, DirState>,
+}
+
+/// Changes found by a rescan
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct FolderScanDiff {
+    pub root_path: String,
+    /// New files and folders
+    pub added: Vec<FolderScanItem>,
+    /// Files whose size or mtime changed
+    pub modified: Vec<FolderScanItem>,
+    /// Relative paths of files and folders that no longer exist
+    pub removed: Vec<String>,
+    /// Directories that had to be listed again
+    pub directories_read: u64,
+    /// Directories whose listing was reused from the snapshot
+    pub directories_skipped: u64,
+    /// Directories that could not be read; their previous entries were kept
+    pub directories_failed: u64,
+    pub scan_duration_ms: u64,
+}
+
+fn mtime_ns(metadata: &fs::Metadata) -> i64 {
+    metadata
+        .modified()
+        .ok()
+        .and_then(|t| t.duration_since(UNIX_EPOCH).ok())
+        .map(|d| d.as_nanos() as i64)
+        .unwrap_or(0)
+}
+
+fn now_ns() -> i64 {
+    SystemTime::now()
+        .duration_since(UNIX_EPOCH)
+        .map(|d| d.as_nanos() as i64)
+        .unwrap_or(0)
+}
+
+fn join_relative(parent: &str, name: &str) -> String {
+    if parent.is_empty() {
+        name.to_string()
+    } else {
+        format!("{}/{}", parent, name)
+    }
+}
+
+fn scan_item(root: &Path, relative_path: &str, name: &str, is_folder: bool, size: u64) -> FolderScanItem {
+    FolderScanItem {
+        relative_path: relative_path.to_string(),
+        name: name.to_string(),
+        is_folder,
+        size,
+        absolute_path: root.join(relative_path).to_string_lossy().to_string(),
+    }
+}
+
+/// List one directory: subfolder names and file states (symlinks skipped)
+fn read_dir_state(dir: &Path, dir_mtime_ns: i64) -> io::Result<DirState> {
+    let mut state = DirState { mtime_ns: dir_mtime_ns, ..DirState::default() };
+
+    for entry in fs::read_dir(dir)?.filter_map(|e| e.ok()) {
+        let file_type = match entry.file_type() {
+            Ok(t) if !t.is_symlink() => t,
+            _ => continue,
+        };
+        let name = entry.file_name().to_string_lossy().to_string();
+
+        if file_type.is_dir() {
+            state.subdirs.push(name);
+        } else if let Ok(metadata) = entry.metadata() {
+            state.files.push(FileState { name, size: metadata.len(), mtime_ns: mtime_ns(&metadata) });
+        }
+    }
+
+    state.subdirs.sort();
+    state.files.sort_by(|a, b| a.name.cmp(&b.name));
+    Ok(state)
+}
+
+impl FolderSnapshot {
+    /// Whether a directory listed by this snapshot's scan can be reused at `mtime_ns`
+    ///
+    /// The mtime must match and be strictly older than the scan start minus one tick;
+    /// otherwise an entry may have changed within the same tick, after the listing.
+    fn listing_still_valid(&self, old: &DirState, mtime_ns: i64) -> bool {
+        old.mtime_ns == mtime_ns
+            && mtime_ns != 0
+            && mtime_ns < self.scan_start_ns.saturating_sub(RACY_MTIME_WINDOW_NS)
+    }
+
+    /// Record everything below a removed directory as removed
+    fn collect_removed(&self, relative_path: &str, removed: &mut Vec<String>) {
+        if let Some(dir) = self.dirs.get(relative_path) {
+            for file in &dir.files {
+                removed.push(join_relative(relative_path, &file.name));
+            }
+            for subdir in &dir.subdirs {
+                let child = join_relative(relative_path, subdir);
+                self.collect_removed(&child, removed);
+                removed.push(child);
+            }
+        }
+    }
+
+    /// Serialize the snapshot into its binary file layout
+    pub fn to_bytes(&self) -> Vec<u8> {
+        fn put_str(out: &mut Vec<u8>, s: &str) {
+            out.extend_from_slice(&(s.len() as u32).to_le_bytes());
+            out.extend_from_slice(s.as_bytes());
+        }
+
+        let mut out = Vec::new();
+        out.extend_from_slice(&SNAPSHOT_MAGIC.to_le_bytes());
+        out.push(SNAPSHOT_VERSION);
+        out.extend_from_slice(&self.scan_start_ns.to_le_bytes());
+        out.extend_from_slice(&(self.dirs.len() as u32).to_le_bytes());
+
+        for (path, dir) in &self.dirs {
+            put_str(&mut out, path);
+            out.extend_from_slice(&dir.mtime_ns.to_le_bytes());
+            out.extend_from_slice(&(dir.subdirs.len() as u32).to_le_bytes());
+            for subdir in &dir.subdirs {
+                put_str(&mut out, subdir);
+            }
+            out.extend_from_slice(&(dir.files.len() as u32).to_le_bytes());
+            for file in &dir.files {
+                put_str(&mut out, &file.name);
+                out.extend_from_slice(&file.size.to_le_bytes());
+                out.extend_from_slice(&file.mtime_ns.to_le_bytes());
+            }
+        }
+
+        out
+    }
+
+    /// Parse a snapshot; returns None if the data is truncated or not a snapshot
+    ///
+    /// Version 1 snapshots have no scan start, so none of their listings is trusted and
+    /// the first rescan lists every directory again (without reporting spurious changes).
+    pub fn from_bytes(data: &[u8]) -> Option<Self> {
+        struct Reader<'a> {
+            data: &'a [u8],
+        }
+        impl<'a> Reader<'a> {
+            fn take(&mut self, n: usize) -> Option<&'a [u8]> {
+                if self.data.len() < n {
+                    return None;
+                }
+                let (head, tail) = self.data.split_at(n);
+                self.data = tail;
+                Some(head)
+            }
+            fn u32(&mut self) -> Option<u32> {
+                self.take(4).map(|b| u32::from_le_bytes([b[0], b[1], b[2], b[3]]))
+            }
+            fn u64(&mut self) -> Option<u64> {
+                let mut buf = [0u8; 8];
+                buf.copy_from_slice(self.take(8)?);
+                Some(u64::from_le_bytes(buf))
+            }
+            fn str(&mut self) -> Option<String> {
+                let len = self.u32()? as usize;
+                String::from_utf8(self.take(len)?.to_vec()).ok()
+            }
+        }
+
+        let mut reader = Reader { data };
+        if reader.u32()? != SNAPSHOT_MAGIC {
+            return None;
+        }
+        let scan_start_ns = match reader.take(1)?[0] {
+            1 => 0,
+            SNAPSHOT_VERSION => reader.u64()? as i64,
+            _ => return None,
+        };
+
+        let dir_count = reader.u32()?;
+        let mut dirs = HashMap::new();
+        for _ in 0..dir_count {
+            let path = reader.str()?;
+            let mtime_ns = reader.u64()? as i64;
+            let mut dir = DirState { mtime_ns, ..DirState::default() };
+            for _ in 0..reader.u32()? {
+                dir.subdirs.push(reader.str()?);
+            }
+            for _ in 0..reader.u32()? {
+                let name = reader.str()?;
+                let size = reader.u64()?;
+                let mtime_ns = reader.u64()? as i64;
+                dir.files.push(FileState { name, size, mtime_ns });
+            }
+            dirs.insert(path, dir);
+        }
+
+        Some(FolderSnapshot { scan_start_ns, dirs })
+    }
+
+    /// Load a snapshot file (None if missing or unreadable)
+    pub fn load(path: &Path) -> Option<Self> {
+        let mut data = Vec::new();
+        fs::File::open(path).ok()?.read_to_end(&mut data).ok()?;
+        Self::from_bytes(&data)
+    }
+
+    /// Write the snapshot atomically (temporary file + rename)
+    pub fn save(&self, path: &Path) -> io::Result<()> {
+        if let Some(parent) = path.parent() {
+            fs::create_dir_all(parent)?;
+        }
+        let tmp_path = path.with_extension("tmp");
+        {
+            let mut file = fs::File::create(&tmp_path)?;
+            file.write_all(&self.to_bytes())?;
+            file.sync_all()?;
+        }
+        fs::rename(&tmp_path, path)
+    }
+}
+
+/// Keep the previous state of a directory that could not be read this time
+///
+/// Dropping it instead would report nothing as removed now and everything below it as
+/// added on the next successful scan. Its known subdirectories are still visited. The kept
+/// listing is older than the new snapshot's scan start, so its mtime is cleared to make
+/// the next rescan list it again.
+fn carry_forward(
+    previous: &FolderSnapshot,
+    relative: String,
+    absolute: &Path,
+    stack: &mut Vec<(String, PathBuf)>,
+    snapshot: &mut FolderSnapshot,
+) {
+    if let Some(old) = previous.dirs.get(&relative) {
+        for subdir in &old.subdirs {
+            stack.push((join_relative(&relative, subdir), absolute.join(subdir)));
+        }
+        snapshot.dirs.insert(relative, DirState { mtime_ns: 0, ..old.clone() });
+    }
+}
+
+/// Rescan a folder against an optional previous snapshot
+///
+/// # Arguments
+/// * `root_path` - Absolute path to the folder to scan
+/// * `previous` - Snapshot of the previous scan (None = report everything as added)
+/// * `verify_files` - Stat known files in unchanged directories to catch in-place edits
+///
+/// # Returns
+/// The diff and the new snapshot, or an error string
+pub fn rescan_folder(
+    root_path: &str,
+    previous: Option<&FolderSnapshot>,
+    verify_files: bool,
+) -> Result<(FolderScanDiff, FolderSnapshot), String> {
+    let start_time = Instant::now();
+    let root = Path::new(root_path);
+    // Taken before any directory is stat'ed, so every listing below is at least this new
+    let scan_start_ns = now_ns();
+
+    if !root.is_dir() {
+        return Err(format!("Path is not a directory: {}", root_path));
+    }
+
+    let empty = FolderSnapshot::default();
+    let previous = previous.unwrap_or(&empty);
+    let mut snapshot = FolderSnapshot { scan_start_ns, dirs: HashMap::new() };
+    let mut diff = FolderScanDiff {
+        root_path: root_path.to_string(),
+        added: Vec::new(),
+        modified: Vec::new(),
+        removed: Vec::new(),
+        directories_read: 0,
+        directories_skipped: 0,
+        directories_failed: 0,
+        scan_duration_ms: 0,
+    };
+
+    let mut stack: Vec<(String, PathBuf)> = vec![(String::new(), root.to_path_buf())];
+    while let Some((relative, absolute)) = stack.pop() {
+        let dir_mtime = match fs::metadata(&absolute) {
+            Ok(metadata) => mtime_ns(&metadata),
+            Err(e) => {
+                eprintln!("Failed to stat directory {}: {}", absolute.display(), e);
+                diff.directories_failed += 1;
+                carry_forward(previous, relative, &absolute, &mut stack, &mut snapshot);
+                continue;
+            }
+        };
+        let old = previous.dirs.get(&relative);
+
+        let state = match old {
+            Some(old) if previous.listing_still_valid(old, dir_mtime) => {
+                // Same entries as last time; only file contents may have changed
+                diff.directories_skipped += 1;
+                let mut state = old.clone();
+                if verify_files {
+                    let mut still_present = Vec::with_capacity(state.files.len());
+                    for mut file in state.files {
+                        let file_relative = join_relative(&relative, &file.name);
+                        match fs::metadata(absolute.join(&file.name)) {
+                            Ok(metadata) => {
+                                let (size, mtime) = (metadata.len(), mtime_ns(&metadata));
+                                if size != file.size || mtime != file.mtime_ns {
+                                    diff.modified.push(scan_item(root, &file_relative, &file.name, false, size));
+                                    file.size = size;
+                                    file.mtime_ns = mtime;
+                                }
+                                still_present.push(file);
+                            }
+                            Err(_) => diff.removed.push(file_relative),
+                        }
+                    }
+                    state.files = still_present;
+                }
+                state
+            }
+            _ => {
+                diff.directories_read += 1;
+                let state = match read_dir_state(&absolute, dir_mtime) {
+                    Ok(state) => state,
+                    Err(e) => {
+                        eprintln!("Failed to read directory {}: {}", absolute.display(), e);
+                        diff.directories_failed += 1;
+                        carry_forward(previous, relative, &absolute, &mut stack, &mut snapshot);
+                        continue;
+                    }
+                };
+
+                let old_files: HashMap<&str, &FileState> = old
+                    .map(|o| o.files.iter().map(|f| (f.name.as_str(), f)).collect())
+                    .unwrap_or_default();
+                for file in &state.files {
+                    let file_relative = join_relative(&relative, &file.name);
+                    match old_files.get(file.name.as_str()) {
+                        None => diff.added.push(scan_item(root, &file_relative, &file.name, false, file.size)),
+                        Some(old_file) if old_file.size != file.size || old_file.mtime_ns != file.mtime_ns => {
+                            diff.modified.push(scan_item(root, &file_relative, &file.name, false, file.size))
+                        }
+                        Some(_) => {}
+                    }
+                }
+
+                if let Some(old) = old {
+                    for old_file in &old.files {
+                        if state.files.binary_search_by(|f| f.name.cmp(&old_file.name)).is_err() {
+                            diff.removed.push(join_relative(&relative, &old_file.name));
+                        }
+                    }
+                    for old_subdir in &old.subdirs {
+                        if state.subdirs.binary_search(old_subdir).is_err() {
+                            let child = join_relative(&relative, old_subdir);
+                            previous.collect_removed(&child, &mut diff.removed);
+                            diff.removed.push(child);
+                        }
+                    }
+                }
+
+                for subdir in &state.subdirs {
+                    let known = old.map_or(false, |o| o.subdirs.contains(subdir));
+                    if !known {
+                        let child = join_relative(&relative, subdir);
+                        diff.added.push(scan_item(root, &child, subdir, true, 0));
+                    }
+                }
+
+                state
+            }
+        };
+
+        for subdir in &state.subdirs {
+            stack.push((join_relative(&relative, subdir), absolute.join(subdir)));
+        }
+        snapshot.dirs.insert(relative, state);
+    }
+
+    diff.scan_duration_ms = start_time.elapsed().as_millis() as u64;
+    Ok((diff, snapshot))
+}
+
+/// Rescan a folder against the snapshot stored at `snapshot_path` and update it
+///
+/// If the snapshot does not exist (or is unreadable) every item is reported as added.
+/// The new snapshot replaces the old one only after the scan succeeded.
+///
+/// # Arguments
+/// * `folder_path` - Path to the folder to scan (null-terminated)
+/// * `snapshot_path` - Path of the snapshot file (null-terminated)
+/// * `verify_files` - Non-zero to stat files in unchanged directories (detects in-place edits)
+/// * `output_len` - Pointer to store output length
+///
+/// # Returns
+/// Pointer to the diff as a JSON string (caller must free with scan_folder_free_string),
+/// or null on error
+#[no_mangle]
+pub extern "C" fn scan_folder_rescan(
+    folder_path: *const c_char,
+    snapshot_path: *const c_char,
+    verify_files: i32,
+    output_len: *mut usize,
+) -> *mut c_char {
+    if folder_path.is_null() || snapshot_path.is_null() || output_len.is_null() {
+        return ptr::null_mut();
+    }
+
+    let (folder, snapshot_file) = unsafe {
+        match (CStr::from_ptr(folder_path).to_str(), CStr::from_ptr(snapshot_path).to_str()) {
+            (Ok(f), Ok(s)) => (f.to_string(), PathBuf::from(s)),
+            _ => return ptr::null_mut(),
+        }
+    };
+
+    let previous = FolderSnapshot::load(&snapshot_file);
+    let (diff, snapshot) = match rescan_folder(&folder, previous.as_ref(), verify_files != 0) {
+        Ok(result) => result,
+        Err(_) => return ptr::null_mut(),
+    };
+
+    if snapshot.save(&snapshot_file).is_err() {
+        return ptr::null_mut();
+    }
+
+    let json_str = serde_json::to_string(&diff).unwrap_or_else(|_| "{}".to_string());
+    let c_str = CString::new(json_str).unwrap_or_else(|_| CString::new("{}").unwrap());
+
+    unsafe {
+        *output_len = c_str.as_bytes_with_nul().len();
+    }
+
+    c_str.into_raw()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    /// Backdate a directory so its listing is outside the racy-mtime window
+    fn backdate(dir: &Path, seconds: u64) -> SystemTime {
+        let mtime = SystemTime::now() - std::time::Duration::from_secs(seconds);
+        fs::File::open(dir).unwrap().set_modified(mtime).unwrap();
+        mtime
+    }
+
+    #[test]
+    fn test_rescan_reports_changes() {
+        let root = std::env::temp_dir().join(format!("cn_rescan_{}", std::process::id()));
+        let _ = fs::remove_dir_all(&root);
+        fs::create_dir_all(root.join("a/deep")).unwrap();
+        fs::create_dir_all(root.join("b")).unwrap();
+        fs::write(root.join("a/one.txt"), b"1").unwrap();
+        fs::write(root.join("a/deep/two.txt"), b"22").unwrap();
+        fs::write(root.join("b/three.txt"), b"333").unwrap();
+        for dir in ["", "a", "a/deep", "b"] {
+            backdate(&root.join(dir), 3600);
+        }
+        let root_str = root.to_str().unwrap();
+
+        let (first, snapshot) = rescan_folder(root_str, None, true).unwrap();
+        assert_eq!(first.added.len(), 6);
+        assert!(first.removed.is_empty());
+
+        // Round-trip through the on-disk format
+        let snapshot = FolderSnapshot::from_bytes(&snapshot.to_bytes()).unwrap();
+
+        // Nothing changed: no directory is listed again
+        let (unchanged, snapshot) = rescan_folder(root_str, Some(&snapshot), true).unwrap();
+        assert!(unchanged.added.is_empty() && unchanged.modified.is_empty() && unchanged.removed.is_empty());
+        assert_eq!(unchanged.directories_read, 0);
+        assert_eq!(unchanged.directories_skipped, 4);
+
+        fs::write(root.join("a/deep/two.txt"), b"changed").unwrap();
+        fs::write(root.join("a/deep/new.txt"), b"n").unwrap();
+        fs::remove_dir_all(root.join("b")).unwrap();
+
+        let (diff, _) = rescan_folder(root_str, Some(&snapshot), true).unwrap();
+        let added: Vec<_> = diff.added.iter().map(|i| i.relative_path.as_str()).collect();
+        let modified: Vec<_> = diff.modified.iter().map(|i| i.relative_path.as_str()).collect();
+        let mut removed = diff.removed.clone();
+        removed.sort();
+        assert_eq!(added, vec!["a/deep/new.txt"]);
+        assert_eq!(modified, vec!["a/deep/two.txt"]);
+        assert_eq!(removed, vec!["b".to_string(), "b/three.txt".to_string()]);
+
+        let _ = fs::remove_dir_all(&root);
+    }
+
+    #[cfg(unix)]
+    #[test]
+    fn test_unreadable_directory_keeps_previous_entries() {
+        use std::os::unix::fs::PermissionsExt;
+
+        let root = std::env::temp_dir().join(format!("cn_rescan_unreadable_{}", std::process::id()));
+        let _ = fs::remove_dir_all(&root);
+        fs::create_dir_all(root.join("locked/inner")).unwrap();
+        fs::write(root.join("locked/one.txt"), b"1").unwrap();
+        fs::write(root.join("locked/inner/two.txt"), b"2").unwrap();
+        let root_str = root.to_str().unwrap();
+        let (_, snapshot) = rescan_folder(root_str, None, false).unwrap();
+
+        // Touch the directory so its listing is not reused, then make it unreadable
+        fs::write(root.join("locked/new.txt"), b"n").unwrap();
+        fs::set_permissions(root.join("locked"), fs::Permissions::from_mode(0o000)).unwrap();
+        let readable = fs::read_dir(root.join("locked")).is_ok(); // e.g. running as root
+        let result = rescan_folder(root_str, Some(&snapshot), false);
+        fs::set_permissions(root.join("locked"), fs::Permissions::from_mode(0o755)).unwrap();
+        if readable {
+            let _ = fs::remove_dir_all(&root);
+            return;
+        }
+
+        let (diff, after) = result.unwrap();
+        // "locked" cannot be listed and "locked/inner" cannot be reached through it
+        assert_eq!(diff.directories_failed, 2);
+        assert!(diff.removed.is_empty());
+        assert!(diff.added.is_empty());
+
+        // Once readable again only the real change shows up
+        let (diff, _) = rescan_folder(root_str, Some(&after), false).unwrap();
+        let added: Vec<_> = diff.added.iter().map(|i| i.relative_path.as_str()).collect();
+        assert_eq!(added, vec!["locked/new.txt"]);
+        assert!(diff.removed.is_empty());
+
+        let _ = fs::remove_dir_all(&root);
+    }
+
+    #[test]
+    fn test_rescan_relists_directory_changed_in_same_tick() {
+        let root = std::env::temp_dir().join(format!("cn_rescan_racy_{}", std::process::id()));
+        let _ = fs::remove_dir_all(&root);
+        fs::create_dir_all(root.join("dir")).unwrap();
+        fs::write(root.join("dir/one.txt"), b"1").unwrap();
+        let root_str = root.to_str().unwrap();
+        let (_, snapshot) = rescan_folder(root_str, None, false).unwrap();
+
+        // A change the directory's timestamp cannot show: same mtime as when it was listed
+        let listed_mtime = fs::metadata(root.join("dir")).unwrap().modified().unwrap();
+        fs::write(root.join("dir/two.txt"), b"2").unwrap();
+        fs::File::open(root.join("dir")).unwrap().set_modified(listed_mtime).unwrap();
+
+        let (diff, snapshot) = rescan_folder(root_str, Some(&snapshot), false).unwrap();
+        let added: Vec<_> = diff.added.iter().map(|i| i.relative_path.as_str()).collect();
+        assert_eq!(added, vec!["dir/two.txt"]);
+        assert_eq!(diff.directories_skipped, 0);
+
+        // Settled well before a scan: trusted again, also across the on-disk format
+        backdate(&root, 3600);
+        backdate(&root.join("dir"), 3600);
+        let (_, snapshot) = rescan_folder(root_str, Some(&snapshot), false).unwrap();
+        let snapshot = FolderSnapshot::from_bytes(&snapshot.to_bytes()).unwrap();
+        let (diff, _) = rescan_folder(root_str, Some(&snapshot), false).unwrap();
+        assert_eq!(diff.directories_read, 0);
+        assert_eq!(diff.directories_skipped, 2);
+
+        let _ = fs::remove_dir_all(&root);
+    }
+}
@@ -0,0 +1,401 @@
+/// Streaming (paged) folder scan results for CloudNexus
+///
+/// `scan_folder_get_json` hands back the whole tree as one JSON string, which for a
+/// million-file folder means hundreds of MB of transient memory and a long parse in Dart.
+/// A scan stream runs the walk on a background thread and lets the caller poll results
+/// in batches while the scan is still running, so uploads can start on the first batch.
+///
+/// Each batch is a compact binary layout readable through FFI without parsing:
+///
+/// ```text
+/// ScanBatch { records: ScanRecord[count], strings: u8[strings_len] }
+/// ScanRecord.path_offset/path_len  -> relative path (UTF-8, '/' separated) in `strings`
+/// ScanRecord.name_offset           -> start of the name within that path
+/// ```
+///
+/// Absolute paths are not repeated per item: they are the scan root joined with the
+/// relative path.
+use std::collections::VecDeque;
+use std::ffi::{c_char, CStr};
+use std::path::PathBuf;
+use std::ptr;
+use std::sync::atomic::{AtomicBool, AtomicU64, Ordering};
+use std::sync::mpsc::{self, Receiver, RecvTimeoutError};
+use std::sync::Arc;
+use std::thread::JoinHandle;
+use std::time::Duration;
+
+use crate::file_io::ERROR_NULL_POINTER;
+use crate::scan::{walk_tree, DirectoryListing};
+use crate::FolderScanItem;
+
+/// Status codes returned by scan_folder_stream_next
+pub const SCAN_STREAM_DONE: i32 = 0;
+pub const SCAN_STREAM_BATCH: i32 = 1;
+pub const SCAN_STREAM_PENDING: i32 = 2;
+
+/// Default maximum number of records per batch
+const DEFAULT_BATCH_SIZE: usize = 4096;
+
+/// Directory listings buffered ahead of the caller before the walk blocks
+const MAX_QUEUED_LISTINGS: usize = 64;
+
+/// One scanned item in a ScanBatch
+#[repr(C)]
+pub struct ScanRecord {
+    /// File size in bytes (0 for folders)
+    pub size: u64,
+    /// Offset of the relative path in the batch string pool
+    pub path_offset: u32,
+    /// Length of the relative path in bytes
+    pub path_len: u32,
+    /// Offset of the name within the relative path
+    pub name_offset: u32,
+    /// 1 if the item is a folder
+    pub is_folder: u8,
+    pub reserved: [u8; 3],
+}
+
+/// A batch of scan results (records plus string pool)
+#[repr(C)]
+pub struct ScanBatch {
+    pub records: *const ScanRecord,
+    pub count: usize,
+    pub strings: *const u8,
+    pub strings_len: usize,
+}
+
+/// Owner of a batch's memory; `header` must stay the first field
+#[repr(C)]
+struct OwnedScanBatch {
+    header: ScanBatch,
+    records: Vec<ScanRecord>,
+    strings: Vec<u8>,
+}
+
+impl OwnedScanBatch {
+    fn from_items(items: &mut VecDeque<FolderScanItem>, max_items: usize) -> Box<Self> {
+        let count = items.len().min(max_items);
+        let mut records = Vec::with_capacity(count);
+        let mut strings = Vec::new();
+
+        for item in items.drain(..count) {
+            let path = item.relative_path.as_bytes();
+            records.push(ScanRecord {
+                size: item.size,
+                path_offset: strings.len() as u32,
+                path_len: path.len() as u32,
+                name_offset: path.len().saturating_sub(item.name.len()) as u32,
+                is_folder: item.is_folder as u8,
+                reserved: [0; 3],
+            });
+            strings.extend_from_slice(path);
+        }
+
+        let mut batch = Box::new(OwnedScanBatch {
+            header: ScanBatch { records: ptr::null(), count, strings: ptr::null(), strings_len: strings.len() },
+            records,
+            strings,
+        });
+        batch.header.records = batch.records.as_ptr();
+        batch.header.strings = batch.strings.as_ptr();
+        batch
+    }
+}
+
+/// Counters updated by the scan thread
+#[derive(Default)]
+struct ScanCounters {
+    files: AtomicU64,
+    folders: AtomicU64,
+    bytes: AtomicU64,
+}
+
+/// Handle for a scan running in the background
+pub struct FolderScanStream {
+    receiver: Receiver<DirectoryListing>,
+    /// Items received from the scan thread but not yet handed out
+    pending: VecDeque<FolderScanItem>,
+    finished: bool,
+    stop: Arc<AtomicBool>,
+    counters: Arc<ScanCounters>,
+    worker: Option<JoinHandle<()>>,
+}
+
+impl FolderScanStream {
+    fn shutdown(&mut self) {
+        self.stop.store(true, Ordering::Relaxed);
+        // Drop the receiver first so a walk blocked on a full queue wakes up and exits
+        let (_, closed) = mpsc::sync_channel(0);
+        drop(std::mem::replace(&mut self.receiver, closed));
+        if let Some(worker) = self.worker.take() {
+            let _ = worker.join();
+        }
+    }
+}
+
+impl Drop for FolderScanStream {
+    fn drop(&mut self) {
+        self.shutdown();
+    }
+}
+
+/// Start a folder scan in the background and return a stream handle
+///
+/// The walk runs ahead of the caller by at most `MAX_QUEUED_LISTINGS` directories, then
+/// waits for `scan_folder_stream_next` to catch up.
+///
+/// # Arguments
+/// * `folder_path` - Path to the folder to scan (null-terminated)
+/// * `max_depth` - Maximum scan depth (0 for unlimited)
+/// * `num_threads` - Worker threads (0 = one per available core, 1 = serial scan)
+///
+/// # Returns
+/// Pointer to FolderScanStream (free with scan_folder_stream_free), or null if the
+/// path is invalid or not a directory
+#[no_mangle]
+pub extern "C" fn scan_folder_stream_start(
+    folder_path: *const c_char,
+    max_depth: u32,
+    num_threads: u32,
+) -> *mut FolderScanStream {
+    if folder_path.is_null() {
+        return ptr::null_mut();
+    }
+
+    let root = match unsafe { CStr::from_ptr(folder_path) }.to_str() {
+        Ok(s) => PathBuf::from(s),
+        Err(_) => return ptr::null_mut(),
+    };
+
+    if !root.is_dir() {
+        return ptr::null_mut();
+    }
+
+    let max_depth = if max_depth == 0 { None } else { Some(max_depth as u64) };
+    // Bounded, so a caller that polls slowly pauses the walk instead of buffering the tree
+    let (tx, rx) = mpsc::sync_channel(MAX_QUEUED_LISTINGS);
+    let stop = Arc::new(AtomicBool::new(false));
+    let counters = Arc::new(ScanCounters::default());
+
+    let worker = {
+        let (stop, counters) = (stop.clone(), counters.clone());
+        std::thread::spawn(move || {
+            let _ = walk_tree(&root, max_depth, num_threads as usize, |listing| {
+                if stop.load(Ordering::Relaxed) {
+                    return false;
+                }
+                counters.files.fetch_add(listing.file_count, Ordering::Relaxed);
+                counters.folders.fetch_add(listing.subfolders.len() as u64, Ordering::Relaxed);
+                counters.bytes.fetch_add(listing.total_size, Ordering::Relaxed);
+                tx.send(listing).is_ok()
+            });
+        })
+    };
+
+    let stream = Box::new(FolderScanStream {
+        receiver: rx,
+        pending: VecDeque::new(),
+        finished: false,
+        stop,
+        counters,
+        worker: Some(worker),
+    });
+
+    Box::leak(stream) as *mut FolderScanStream
+}
+
+/// Poll the next batch of scan results
+///
+/// Waits up to `timeout_ms` for results. A batch is returned as soon as any items are
+/// available, so early batches may be smaller than `max_items`.
+///
+/// # Arguments
+/// * `stream` - Pointer to FolderScanStream
+/// * `max_items` - Maximum records per batch (0 = 4096)
+/// * `timeout_ms` - Maximum time to wait for new results (0 = don't wait)
+/// * `batch_out` - Receives the batch when SCAN_STREAM_BATCH is returned
+///   (free with scan_batch_free)
+///
+/// # Returns
+/// SCAN_STREAM_BATCH (1) with a batch, SCAN_STREAM_PENDING (2) if nothing arrived within
+/// the timeout, SCAN_STREAM_DONE (0) once the scan is complete and every item was returned,
+/// or a negative error code
+#[no_mangle]
+pub extern "C" fn scan_folder_stream_next(
+    stream: *mut FolderScanStream,
+    max_items: u32,
+    timeout_ms: u32,
+    batch_out: *mut *mut ScanBatch,
+) -> i32 {
+    if stream.is_null() || batch_out.is_null() {
+        return ERROR_NULL_POINTER;
+    }
+
+    let stream = unsafe { &mut *stream };
+    let max_items = if max_items == 0 { DEFAULT_BATCH_SIZE } else { max_items as usize };
+
+    // Take whatever is ready, waiting only if there is nothing at all
+    if stream.pending.is_empty() && !stream.finished {
+        match stream.receiver.recv_timeout(Duration::from_millis(timeout_ms as u64)) {
+            Ok(listing) => stream.pending.extend(listing.items),
+            Err(RecvTimeoutError::Timeout) => {}
+            Err(RecvTimeoutError::Disconnected) => stream.finished = true,
+        }
+    }
+    while stream.pending.len() < max_items && !stream.finished {
+        match stream.receiver.try_recv() {
+            Ok(listing) => stream.pending.extend(listing.items),
+            Err(mpsc::TryRecvError::Empty) => break,
+            Err(mpsc::TryRecvError::Disconnected) => stream.finished = true,
+        }
+    }
+
+    if stream.pending.is_empty() {
+        return if stream.finished { SCAN_STREAM_DONE } else { SCAN_STREAM_PENDING };
+    }
+
+    let batch = OwnedScanBatch::from_items(&mut stream.pending, max_items);
+    unsafe { *batch_out = Box::into_raw(batch) as *mut ScanBatch; }
+    SCAN_STREAM_BATCH
+}
+
+/// Get running totals of the scan (items found so far, including ones not yet polled)
+///
+/// # Arguments
+/// * `stream` - Pointer to FolderScanStream
+/// * `file_count` - Pointer to store the number of files (can be null)
+/// * `folder_count` - Pointer to store the number of folders (can be null)
+/// * `total_size` - Pointer to store the total file size in bytes (can be null)
+#[no_mangle]
+pub extern "C" fn scan_folder_stream_get_progress(
+    stream: *mut FolderScanStream,
+    file_count: *mut u64,
+    folder_count: *mut u64,
+    total_size: *mut u64,
+) {
+    if stream.is_null() {
+        return;
+    }
+
+    let counters = unsafe { &(*stream).counters };
+    unsafe {
+        if !file_count.is_null() {
+            *file_count = counters.files.load(Ordering::Relaxed);
+        }
+        if !folder_count.is_null() {
+            *folder_count = counters.folders.load(Ordering::Relaxed);
+        }
+        if !total_size.is_null() {
+            *total_size = counters.bytes.load(Ordering::Relaxed);
+        }
+    }
+}
+
+/// Free a batch returned by scan_folder_stream_next
+#[no_mangle]
+pub extern "C" fn scan_batch_free(batch: *mut ScanBatch) {
+    if !batch.is_null() {
+        unsafe {
+            let _ = Box::from_raw(batch as *mut OwnedScanBatch);
+        }
+    }
+}
+
+/// Stop the scan (if still running) and free the stream
+///
+/// Batches already returned stay valid until freed with scan_batch_free.
+#[no_mangle]
+pub extern "C" fn scan_folder_stream_free(stream: *mut FolderScanStream) {
+    if !stream.is_null() {
+        unsafe {
+            let _ = Box::from_raw(stream);
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::ffi::CString;
+    use std::fs;
+
+    #[test]
+    fn test_stream_batches_cover_tree() {
+        let root = std::env::temp_dir().join(format!("cn_scan_stream_{}", std::process::id()));
+        let _ = fs::remove_dir_all(&root);
+        for d in 0..5 {
+            let dir = root.join(format!("d{}", d));
+            fs::create_dir_all(&dir).unwrap();
+            for f in 0..20 {
+                fs::write(dir.join(format!("f{:02}.dat", f)), vec![1u8; f]).unwrap();
+            }
+        }
+
+        let c_root = CString::new(root.to_str().unwrap()).unwrap();
+        let stream = scan_folder_stream_start(c_root.as_ptr(), 0, 2);
+        assert!(!stream.is_null());
+
+        let mut seen = Vec::new();
+        loop {
+            let mut batch: *mut ScanBatch = ptr::null_mut();
+            match scan_folder_stream_next(stream, 7, 1000, &mut batch) {
+                SCAN_STREAM_BATCH => {
+                    let b = unsafe { &*batch };
+                    assert!(b.count >= 1 && b.count <= 7);
+                    let records = unsafe { std::slice::from_raw_parts(b.records, b.count) };
+                    let strings = unsafe { std::slice::from_raw_parts(b.strings, b.strings_len) };
+                    for r in records {
+                        let start = r.path_offset as usize;
+                        let path = std::str::from_utf8(&strings[start..start + r.path_len as usize]).unwrap();
+                        let name = &path[r.name_offset as usize..];
+                        assert!(path.ends_with(name) && !name.contains('/'));
+                        seen.push((path.to_string(), r.size, r.is_folder));
+                    }
+                    scan_batch_free(batch);
+                }
+                SCAN_STREAM_PENDING => continue,
+                status => {
+                    assert_eq!(status, SCAN_STREAM_DONE);
+                    break;
+                }
+            }
+        }
+
+        let (mut files, mut folders, mut bytes) = (0u64, 0u64, 0u64);
+        scan_folder_stream_get_progress(stream, &mut files, &mut folders, &mut bytes);
+        assert_eq!((files, folders, bytes), (100, 5, 5 * 190));
+        scan_folder_stream_free(stream);
+
+        assert_eq!(seen.len(), 105);
+        assert!(seen.iter().any(|(p, size, folder)| p == "d3/f07.dat" && *size == 7 && *folder == 0));
+
+        let _ = fs::remove_dir_all(&root);
+    }
+
+    #[test]
+    fn test_unpolled_stream_pauses_walk() {
+        let root = std::env::temp_dir().join(format!("cn_scan_stream_paused_{}", std::process::id()));
+        let _ = fs::remove_dir_all(&root);
+        let dirs = MAX_QUEUED_LISTINGS * 3;
+        for d in 0..dirs {
+            let dir = root.join(format!("d{:03}", d));
+            fs::create_dir_all(&dir).unwrap();
+            fs::write(dir.join("f.dat"), b"x").unwrap();
+        }
+
+        let c_root = CString::new(root.to_str().unwrap()).unwrap();
+        let stream = scan_folder_stream_start(c_root.as_ptr(), 0, 1);
+        assert!(!stream.is_null());
+        std::thread::sleep(Duration::from_millis(200));
+
+        // Nothing was polled: the walk stops once the queue is full
+        let mut files = 0u64;
+        scan_folder_stream_get_progress(stream, &mut files, ptr::null_mut(), ptr::null_mut());
+        assert!(files <= MAX_QUEUED_LISTINGS as u64 + 1, "walk ran ahead: {} files", files);
+
+        // Freeing a blocked stream must not hang
+        scan_folder_stream_free(stream);
+        let _ = fs::remove_dir_all(&root);
+    }
+}
@@ -1,7 +1,149 @@
 // Batch indexing module for CloudNexus
 // Phase 2: Efficient bulk document addition
+//
+// Bulk builds split the new document ids into contiguous chunks, one per worker thread.
+// Each worker tokenizes its names and buckets the postings by key hash into one map
+// per shard; a second parallel pass merges each shard's buckets from all workers, so
+// every posting key is owned by exactly one merging thread.
+
+use std::collections::HashMap;
+use std::panic::resume_unwind;
 
 use super::index::{SearchDocument, SearchIndex};
+use super::query::{trigrams, Trigram};
+use super::store::{DocId, DocumentStore};
+
+/// Batches below this size are indexed on the calling thread
+const PARALLEL_MIN_DOCS: usize = 4096;
+/// Documents per worker thread, at least
+const DOCS_PER_THREAD: usize = 2048;
+/// Upper bound on worker threads for one bulk build
+const MAX_BATCH_THREADS: usize = 8;
+
+/// Number of threads to use for a bulk build of `doc_count` documents
+pub(crate) fn batch_threads(doc_count: usize) -> usize {
+    if doc_count < PARALLEL_MIN_DOCS {
+        return 1;
+    }
+    let cores = std::thread::available_parallelism().map(|n| n.get()).unwrap_or(1);
+    cores.min(MAX_BATCH_THREADS).min(doc_count / DOCS_PER_THREAD).max(1)
+}
+
+/// Posting lists for one shard of the key space (lists sorted, keys unique)
+pub(crate) struct ShardPostings<'a> {
+    pub(crate) words: HashMap<&'a str, Vec<DocId>>,
+    pub(crate) trigrams: HashMap<Trigram, Vec<DocId>>,
+    pub(crate) accounts: HashMap<u32, Vec<DocId>>,
+}
+
+impl<'a> ShardPostings<'a> {
+    fn new() -> Self {
+        ShardPostings {
+            words: HashMap::new(),
+            trigrams: HashMap::new(),
+            accounts: HashMap::new(),
+        }
+    }
+    
+    /// Append another shard built from later (higher) ids
+    fn append(&mut self, other: ShardPostings<'a>) {
+        for (word, ids) in other.words {
+            self.words.entry(word).or_insert_with(Vec::new).extend(ids);
+        }
+        for (gram, ids) in other.trigrams {
+            self.trigrams.entry(gram).or_insert_with(Vec::new).extend(ids);
+        }
+        for (account, ids) in other.accounts {
+            self.accounts.entry(account).or_insert_with(Vec::new).extend(ids);
+        }
+    }
+}
+
+fn word_shard(word: &str, shards: usize) -> usize {
+    // FNV-1a; only needs to spread words evenly
+    let hash = word.bytes().fold(0xcbf29ce484222325u64, |h, b| (h ^ b as u64).wrapping_mul(0x100000001b3));
+    (hash % shards as u64) as usize
+}
+
+fn trigram_shard(gram: Trigram, shards: usize) -> usize {
+    ((gram.wrapping_mul(0x9E3779B97F4A7C15) >> 32) % shards as u64) as usize
+}
+
+/// Tokenize one chunk of documents into per-shard postings
+fn tokenize_chunk<'a>(store: &'a DocumentStore, ids: &[DocId], shards: usize) -> Vec<ShardPostings<'a>> {
+    let mut out: Vec<ShardPostings<'a>> = (0..shards).map(|_| ShardPostings::new()).collect();
+    
+    for &id in ids {
+        let doc = match store.get(id) {
+            Some(doc) => doc,
+            None => continue,
+        };
+        let name_lower = doc.name_lower();
+        
+        for word in name_lower.split_whitespace() {
+            let list = out[word_shard(word, shards)].words.entry(word).or_insert_with(Vec::new);
+            // A word repeated within one name is posted once
+            if list.last() != Some(&id) {
+                list.push(id);
+            }
+        }
+        for gram in trigrams(name_lower) {
+            out[trigram_shard(gram, shards)].trigrams.entry(gram).or_insert_with(Vec::new).push(id);
+        }
+        if let Some(account) = store.account_of(id) {
+            out[account as usize % shards].accounts.entry(account).or_insert_with(Vec::new).push(id);
+        }
+    }
+    
+    out
+}
+
+/// Build the posting lists of `ids` (sorted) across `threads` threads
+///
+/// Returns one ShardPostings per shard; shards have disjoint keys and every list is
+/// sorted, ready to merge into the index. A panicking worker is re-raised on the caller:
+/// skipping its postings would leave documents in the store that no query can find.
+pub(crate) fn build_postings<'a>(store: &'a DocumentStore, ids: &[DocId], threads: usize) -> Vec<ShardPostings<'a>> {
+    let threads = threads.max(1);
+    let chunk_size = ((ids.len() + threads - 1) / threads).max(1);
+    
+    // Phase 1: tokenize contiguous id ranges in parallel
+    let per_chunk: Vec<Vec<ShardPostings<'a>>> = crossbeam::thread::scope(|scope| {
+        let handles: Vec<_> = ids
+            .chunks(chunk_size)
+            .map(|chunk| scope.spawn(move |_| tokenize_chunk(store, chunk, threads)))
+            .collect();
+        handles.into_iter().map(|handle| handle.join().unwrap_or_else(|e| resume_unwind(e))).collect()
+    })
+    .unwrap_or_else(|e| resume_unwind(e));
+    
+    // Regroup by shard, keeping chunk order so appended lists stay sorted
+    let mut by_shard: Vec<Vec<ShardPostings<'a>>> = (0..threads).map(|_| Vec::new()).collect();
+    for chunk in per_chunk {
+        for (shard, postings) in chunk.into_iter().enumerate() {
+            by_shard[shard].push(postings);
+        }
+    }
+    
+    // Phase 2: merge each shard in parallel
+    crossbeam::thread::scope(|scope| {
+        let handles: Vec<_> = by_shard
+            .into_iter()
+            .map(|parts| {
+                scope.spawn(move |_| {
+                    let mut parts = parts.into_iter();
+                    let mut merged = parts.next().unwrap_or_else(ShardPostings::new);
+                    for part in parts {
+                        merged.append(part);
+                    }
+                    merged
+                })
+            })
+            .collect();
+        handles.into_iter().map(|handle| handle.join().unwrap_or_else(|e| resume_unwind(e))).collect()
+    })
+    .unwrap_or_else(|e| resume_unwind(e))
+}
 
 /// Batch indexer for efficient bulk document addition
 /// Accumulates documents and commits them in batches for better performance
@@ -39,12 +181,15 @@ impl BatchIndexer {
         }
     }
     
-    /// Add multiple documents at once
-    pub fn add_documents(&mut self, docs: &[SearchDocument]) -> Result<(), String> {
-        for doc in docs {
-            self.add_document(doc.clone());
+    /// Add multiple documents at once and index them together with the pending batch
+    /// Large batches are tokenized across threads (see SearchIndex::add_documents)
+    pub fn add_documents(&mut self, docs: Vec<SearchDocument>) -> Result<usize, String> {
+        if self.current_batch.is_empty() {
+            self.current_batch = docs;
+        } else {
+            self.current_batch.extend(docs);
         }
-        Ok(())
+        self.flush()
     }
     
     /// Flush the current batch to the index
@@ -53,15 +198,27 @@ impl BatchIndexer {
             return Ok(0);
         }
         
-        let count = self.current_batch.len();
-        for doc in self.current_batch.drain(..) {
-            self.index.add_document(doc);
-        }
+        let batch = std::mem::replace(&mut self.current_batch, Vec::with_capacity(self.batch_size));
+        let count = self.index.add_documents(batch);
         
         self.total_indexed += count;
         Ok(count)
     }
     
+    /// Flush and move everything indexed so far into `target`
+    /// An empty target takes over the built index without copying
+    pub fn commit_into(&mut self, target: &mut SearchIndex) -> Result<usize, String> {
+        self.flush()?;
+        let count = self.index.len();
+        if target.is_empty() {
+            *target = std::mem::take(&mut self.index);
+        } else {
+            target.add_documents(self.index.documents().map(|doc| doc.to_document()).collect());
+            self.index.clear();
+        }
+        Ok(count)
+    }
+    
     /// Get the underlying index reference
     pub fn inner(&self) -> &SearchIndex {
         &self.index
@@ -106,6 +263,7 @@ impl BatchProgressCallback for () {
 #[cfg(test)]
 mod tests {
     use super::*;
+    use super::super::index::SearchResult;
     
     #[test]
     fn test_batch_indexer_basic() {
@@ -144,11 +302,51 @@ mod tests {
             .map(|i| create_test_doc(&i.to_string(), &format!("Document {}", i)))
             .collect();
         
-        batcher.add_documents(&docs).unwrap();
+        batcher.add_documents(docs).unwrap();
         assert_eq!(batcher.total_indexed(), 5);
         assert_eq!(batcher.inner().len(), 5);
     }
     
+    #[test]
+    fn test_parallel_build_matches_sequential() {
+        let words = ["report", "photo", "budget", "notes", "draft", "final"];
+        let docs: Vec<SearchDocument> = (0..10_000)
+            .map(|i| {
+                let mut doc = create_test_doc(
+                    &(i % 9_000).to_string(),
+                    &format!("{} {} {}", words[i % 6], words[(i / 6) % 6], i),
+                );
+                doc.account_id = format!("acc{}", i % 3);
+                doc
+            })
+            .collect();
+        
+        let mut sequential = SearchIndex::new();
+        for doc in docs.clone() {
+            sequential.add_document(doc);
+        }
+        // Pre-existing documents are replaced, not duplicated
+        let mut parallel = SearchIndex::new();
+        parallel.add_document(create_test_doc("5", "stale name"));
+        assert_eq!(parallel.add_documents(docs), 10_000);
+        
+        assert_eq!(parallel.len(), sequential.len());
+        assert!(parallel.search_exact("stale", 10).is_empty());
+        let ids = |results: Vec<SearchResult>| {
+            let mut ids: Vec<String> = results.into_iter().map(|r| r.node_id).collect();
+            ids.sort();
+            ids
+        };
+        for query in ["report photo", "budget", "123", "draft final 17"] {
+            assert_eq!(ids(parallel.search_exact(query, 100_000)), ids(sequential.search_exact(query, 100_000)));
+            assert_eq!(ids(parallel.search_prefix(query, 100_000)), ids(sequential.search_prefix(query, 100_000)));
+        }
+        assert_eq!(
+            ids(parallel.search_by_account("notes", "acc1", 100_000)),
+            ids(sequential.search_by_account("notes", "acc1", 100_000))
+        );
+    }
+    
     fn create_test_doc(id: &str, name: &str) -> SearchDocument {
         SearchDocument {
             node_id: id.to_string(),
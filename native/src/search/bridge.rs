@@ -3,10 +3,17 @@
 
 use std::ffi::{c_void, CString, CStr};
 use std::os::raw::c_char;
+use std::path::PathBuf;
 use std::ptr;
 
 use super::fuzzy::{fuzzy_match, jaro_winkler_similarity, levenshtein_distance, soundex, metaphone};
+use super::batch::BatchIndexer;
+use super::incremental::IncrementalIndexer;
+use super::concurrent::ConcurrentSearchIndex;
 use super::index::{SearchDocument, SearchIndex};
+use super::persistent::PersistentSearchIndex;
+use super::query::SearchHit;
+use crate::watcher::{FsWatcher, WatchEvent, WatchEventKind};
 
 /// C-compatible search result structure
 #[repr(C)]
@@ -149,113 +156,54 @@ pub extern "C" fn add_documents_batch(
     }
     
     let index = unsafe { &mut *index_ptr };
-    let mut added = 0;
     
-    for i in 0..count {
-        let doc_ref = unsafe { docs.offset(i as isize).read() };
-        
-        let node_id_str = if doc_ref.node_id.is_null() {
-            String::new()
-        } else {
-            match unsafe { CStr::from_ptr(doc_ref.node_id).to_str() } {
-                Ok(s) => s.to_string(),
-                Err(_) => continue,
-            }
-        };
-        
-        let account_id_str = if doc_ref.account_id.is_null() {
-            String::new()
-        } else {
-            match unsafe { CStr::from_ptr(doc_ref.account_id).to_str() } {
-                Ok(s) => s.to_string(),
-                Err(_) => continue,
-            }
-        };
-        
-        let provider_str = if doc_ref.provider.is_null() {
-            String::new()
-        } else {
-            match unsafe { CStr::from_ptr(doc_ref.provider).to_str() } {
-                Ok(s) => s.to_string(),
-                Err(_) => continue,
-            }
-        };
-        
-        let email_str = if doc_ref.email.is_null() {
-            String::new()
-        } else {
-            match unsafe { CStr::from_ptr(doc_ref.email).to_str() } {
-                Ok(s) => s.to_string(),
-                Err(_) => continue,
-            }
-        };
-        
-        let name_str = if doc_ref.name.is_null() {
-            String::new()
-        } else {
-            match unsafe { CStr::from_ptr(doc_ref.name).to_str() } {
-                Ok(s) => s.to_string(),
-                Err(_) => continue,
-            }
-        };
-        
-        let parent_id_opt = if doc_ref.parent_id.is_null() {
-            None
-        } else {
-            match unsafe { CStr::from_ptr(doc_ref.parent_id).to_str() } {
-                Ok(s) => Some(s.to_string()),
-                Err(_) => continue,
-            }
-        };
-        
-        let doc = SearchDocument {
-            node_id: node_id_str,
-            account_id: account_id_str,
-            provider: provider_str,
-            email: email_str,
-            name: name_str,
-            is_folder: doc_ref.is_folder,
-            parent_id: parent_id_opt,
-        };
-        
-        index.add_document(doc);
-        added += 1;
+    // Large batches (e.g. the first crawl of an account) are indexed across threads
+    index.add_documents(documents_from_c(docs, count))
+}
+
+/// Convert a CSearchDocument array, skipping documents with invalid strings
+fn documents_from_c(docs: *const CSearchDocument, count: usize) -> Vec<SearchDocument> {
+    (0..count)
+        .filter_map(|i| document_from_c(unsafe { &*docs.add(i) }))
+        .collect()
+}
+
+/// Read an optional C string field (null reads as None, invalid UTF-8 as Err)
+fn optional_c_str(value: *const c_char) -> Result<Option<String>, ()> {
+    if value.is_null() {
+        return Ok(None);
+    }
+    match unsafe { CStr::from_ptr(value).to_str() } {
+        Ok(s) => Ok(Some(s.to_string())),
+        Err(_) => Err(()),
     }
-    
-    added
 }
 
-/// Search index with exact matching
-/// Returns number of results found (results_out must be freed with free_search_results)
-#[no_mangle]
-pub extern "C" fn search_index(
-    index_ptr: *mut SearchIndex,
-    query: *const c_char,
-    limit: usize,
+/// Convert a CSearchDocument (None if a field is not valid UTF-8)
+fn document_from_c(doc_ref: &CSearchDocument) -> Option<SearchDocument> {
+    Some(SearchDocument {
+        node_id: optional_c_str(doc_ref.node_id).ok()?.unwrap_or_default(),
+        account_id: optional_c_str(doc_ref.account_id).ok()?.unwrap_or_default(),
+        provider: optional_c_str(doc_ref.provider).ok()?.unwrap_or_default(),
+        email: optional_c_str(doc_ref.email).ok()?.unwrap_or_default(),
+        name: optional_c_str(doc_ref.name).ok()?.unwrap_or_default(),
+        is_folder: doc_ref.is_folder,
+        parent_id: optional_c_str(doc_ref.parent_id).ok()?,
+    })
+}
+
+/// Copy the final hits into a malloc'd CSearchResult array
+/// Strings are copied here once per returned result; hits borrow from the index
+fn write_search_results(
+    hits: &[SearchHit<'_>],
     results_out: *mut *mut CSearchResult,
     results_count: *mut usize,
 ) -> i32 {
-    if index_ptr.is_null() || results_out.is_null() || results_count.is_null() {
-        return 0;
-    }
-    
-    let index = unsafe { &mut *index_ptr };
-    
-    let query_str = if query.is_null() {
-        String::new()
-    } else {
-        match unsafe { CStr::from_ptr(query).to_str() } {
-            Ok(s) => s.to_string(),
-            Err(_) => return 0,
-        }
-    };
-    
-    let results = index.search_exact(&query_str, limit);
-    let count = results.len();
+    let count = hits.len();
     
     // Allocate results array
     let results_array = unsafe {
-        libc::malloc(count * std::mem::size_of::<CSearchResult>()) as *mut CSearchResult
+        libc::malloc(count.max(1) * std::mem::size_of::<CSearchResult>()) as *mut CSearchResult
     };
     
     if results_array.is_null() {
@@ -264,15 +212,15 @@ pub extern "C" fn search_index(
     }
     
     // Fill results array
-    for (i, result) in results.iter().enumerate() {
+    for (i, hit) in hits.iter().enumerate() {
         let c_result = CSearchResult {
-            node_id: CString::new(result.node_id.clone()).unwrap().into_raw(),
-            name: CString::new(result.name.clone()).unwrap().into_raw(),
-            score: result.score,
-            account_id: CString::new(result.account_id.clone()).unwrap().into_raw(),
-            provider: CString::new(result.provider.clone()).unwrap().into_raw(),
+            node_id: CString::new(hit.doc.node_id).unwrap_or_default().into_raw(),
+            name: CString::new(hit.doc.name).unwrap_or_default().into_raw(),
+            score: hit.score,
+            account_id: CString::new(hit.doc.account_id).unwrap_or_default().into_raw(),
+            provider: CString::new(hit.doc.provider).unwrap_or_default().into_raw(),
         };
-        unsafe { results_array.offset(i as isize).write(c_result); }
+        unsafe { results_array.add(i).write(c_result); }
     }
     
     unsafe {
@@ -283,9 +231,10 @@ pub extern "C" fn search_index(
     1
 }
 
-/// Search index with prefix matching
+/// Search index with exact matching
+/// Returns number of results found (results_out must be freed with free_search_results)
 #[no_mangle]
-pub extern "C" fn search_index_prefix(
+pub extern "C" fn search_index(
     index_ptr: *mut SearchIndex,
     query: *const c_char,
     limit: usize,
@@ -296,7 +245,7 @@ pub extern "C" fn search_index_prefix(
         return 0;
     }
     
-    let index = unsafe { &mut *index_ptr };
+    let index = unsafe { &*index_ptr };
     
     let query_str = if query.is_null() {
         String::new()
@@ -307,35 +256,36 @@ pub extern "C" fn search_index_prefix(
         }
     };
     
-    let results = index.search_prefix(&query_str, limit);
-    let count = results.len();
-    
-    let results_array = unsafe {
-        libc::malloc(count * std::mem::size_of::<CSearchResult>()) as *mut CSearchResult
-    };
-    
-    if results_array.is_null() {
-        unsafe { *results_count = 0; }
+    let hits = index.search_exact_hits(&query_str, limit);
+    write_search_results(&hits, results_out, results_count)
+}
+
+/// Search index with prefix matching
+#[no_mangle]
+pub extern "C" fn search_index_prefix(
+    index_ptr: *mut SearchIndex,
+    query: *const c_char,
+    limit: usize,
+    results_out: *mut *mut CSearchResult,
+    results_count: *mut usize,
+) -> i32 {
+    if index_ptr.is_null() || results_out.is_null() || results_count.is_null() {
         return 0;
     }
     
-    for (i, result) in results.iter().enumerate() {
-        let c_result = CSearchResult {
-            node_id: CString::new(result.node_id.clone()).unwrap().into_raw(),
-            name: CString::new(result.name.clone()).unwrap().into_raw(),
-            score: result.score,
-            account_id: CString::new(result.account_id.clone()).unwrap().into_raw(),
-            provider: CString::new(result.provider.clone()).unwrap().into_raw(),
-        };
-        unsafe { results_array.offset(i as isize).write(c_result); }
-    }
+    let index = unsafe { &*index_ptr };
     
-    unsafe {
-        *results_out = results_array;
-        *results_count = count;
-    }
+    let query_str = if query.is_null() {
+        String::new()
+    } else {
+        match unsafe { CStr::from_ptr(query).to_str() } {
+            Ok(s) => s.to_string(),
+            Err(_) => return 0,
+        }
+    };
     
-    1
+    let hits = index.search_prefix_hits(&query_str, limit);
+    write_search_results(&hits, results_out, results_count)
 }
 
 /// Search index by account
@@ -352,7 +302,7 @@ pub extern "C" fn search_index_by_account(
         return 0;
     }
     
-    let index = unsafe { &mut *index_ptr };
+    let index = unsafe { &*index_ptr };
     
     let query_str = if query.is_null() {
         String::new()
@@ -372,35 +322,38 @@ pub extern "C" fn search_index_by_account(
         }
     };
     
-    let results = index.search_by_account(&query_str, &account_id_str, limit);
-    let count = results.len();
-    
-    let results_array = unsafe {
-        libc::malloc(count * std::mem::size_of::<CSearchResult>()) as *mut CSearchResult
-    };
-    
-    if results_array.is_null() {
-        unsafe { *results_count = 0; }
+    let hits = index.search_by_account_hits(&query_str, &account_id_str, limit);
+    write_search_results(&hits, results_out, results_count)
+}
+
+/// Search index for names within max_distance edits of the query (typo tolerant)
+/// Returns 1 on success (results_out must be freed with free_search_results), 0 on error
+#[no_mangle]
+pub extern "C" fn search_index_fuzzy(
+    index_ptr: *mut SearchIndex,
+    query: *const c_char,
+    max_distance: usize,
+    limit: usize,
+    results_out: *mut *mut CSearchResult,
+    results_count: *mut usize,
+) -> i32 {
+    if index_ptr.is_null() || results_out.is_null() || results_count.is_null() {
         return 0;
     }
     
-    for (i, result) in results.iter().enumerate() {
-        let c_result = CSearchResult {
-            node_id: CString::new(result.node_id.clone()).unwrap().into_raw(),
-            name: CString::new(result.name.clone()).unwrap().into_raw(),
-            score: result.score,
-            account_id: CString::new(result.account_id.clone()).unwrap().into_raw(),
-            provider: CString::new(result.provider.clone()).unwrap().into_raw(),
-        };
-        unsafe { results_array.offset(i as isize).write(c_result); }
-    }
+    let index = unsafe { &*index_ptr };
     
-    unsafe {
-        *results_out = results_array;
-        *results_count = count;
-    }
+    let query_str = if query.is_null() {
+        String::new()
+    } else {
+        match unsafe { CStr::from_ptr(query).to_str() } {
+            Ok(s) => s.to_string(),
+            Err(_) => return 0,
+        }
+    };
     
-    1
+    let hits = index.search_fuzzy_hits(&query_str, max_distance, limit);
+    write_search_results(&hits, results_out, results_count)
 }
 
 /// Free search results memory
@@ -430,6 +383,320 @@ pub extern "C" fn free_search_results(results: *mut CSearchResult, count: usize)
     }
 }
 
+/// Create a concurrent search index (one shard per account)
+/// Safe to query from one thread while another adds or removes documents
+/// Keeps two copies of every account's index, so it needs about twice the memory of
+/// create_search_index for the same documents
+#[no_mangle]
+pub extern "C" fn create_concurrent_search_index() -> *mut ConcurrentSearchIndex {
+    Box::into_raw(Box::new(ConcurrentSearchIndex::new()))
+}
+
+/// Free a concurrent search index (no other thread may still be using it)
+#[no_mangle]
+pub extern "C" fn free_concurrent_search_index(index_ptr: *mut ConcurrentSearchIndex) {
+    if !index_ptr.is_null() {
+        unsafe {
+            let _ = Box::from_raw(index_ptr);
+        }
+    }
+}
+
+/// Add or replace documents in a concurrent index
+/// Queries on other threads keep seeing the previous state until the batch is published
+/// Returns number of documents added successfully
+#[no_mangle]
+pub extern "C" fn concurrent_index_add_documents(
+    index_ptr: *mut ConcurrentSearchIndex,
+    docs: *const CSearchDocument,
+    count: usize,
+) -> usize {
+    if index_ptr.is_null() || docs.is_null() || count == 0 {
+        return 0;
+    }
+    
+    let index = unsafe { &*index_ptr };
+    index.add_documents(documents_from_c(docs, count))
+}
+
+/// Remove a document from a concurrent index
+/// Returns 1 if the document was removed, 0 otherwise
+#[no_mangle]
+pub extern "C" fn concurrent_index_remove_document(
+    index_ptr: *mut ConcurrentSearchIndex,
+    node_id: *const c_char,
+) -> i32 {
+    if index_ptr.is_null() || node_id.is_null() {
+        return 0;
+    }
+    
+    let index = unsafe { &*index_ptr };
+    match unsafe { CStr::from_ptr(node_id).to_str() } {
+        Ok(node_id_str) if index.remove_document(node_id_str) => 1,
+        _ => 0,
+    }
+}
+
+/// Search all accounts of a concurrent index (exact substring matching)
+/// Returns 1 on success (results_out must be freed with free_search_results), 0 on error
+#[no_mangle]
+pub extern "C" fn concurrent_index_search(
+    index_ptr: *mut ConcurrentSearchIndex,
+    query: *const c_char,
+    limit: usize,
+    results_out: *mut *mut CSearchResult,
+    results_count: *mut usize,
+) -> i32 {
+    if index_ptr.is_null() || results_out.is_null() || results_count.is_null() {
+        return 0;
+    }
+    
+    let index = unsafe { &*index_ptr };
+    let query_str = match optional_c_str(query) {
+        Ok(s) => s.unwrap_or_default(),
+        Err(_) => return 0,
+    };
+    
+    let snapshot = index.snapshot();
+    let hits = snapshot.search_exact_hits(&query_str, limit);
+    write_search_results(&hits, results_out, results_count)
+}
+
+/// Search one account of a concurrent index; only that account's shard is read
+/// Returns 1 on success (results_out must be freed with free_search_results), 0 on error
+#[no_mangle]
+pub extern "C" fn concurrent_index_search_by_account(
+    index_ptr: *mut ConcurrentSearchIndex,
+    query: *const c_char,
+    account_id: *const c_char,
+    limit: usize,
+    results_out: *mut *mut CSearchResult,
+    results_count: *mut usize,
+) -> i32 {
+    if index_ptr.is_null() || results_out.is_null() || results_count.is_null() {
+        return 0;
+    }
+    
+    let index = unsafe { &*index_ptr };
+    let (query_str, account_id_str) = match (optional_c_str(query), optional_c_str(account_id)) {
+        (Ok(q), Ok(a)) => (q.unwrap_or_default(), a.unwrap_or_default()),
+        _ => return 0,
+    };
+    
+    index
+        .with_account(&account_id_str, |shard| {
+            let hits = shard.search_by_account_hits(&query_str, &account_id_str, limit);
+            write_search_results(&hits, results_out, results_count)
+        })
+        .unwrap_or_else(|| write_search_results(&[], results_out, results_count))
+}
+
+/// Search a concurrent index for names within max_distance edits of the query
+/// Returns 1 on success (results_out must be freed with free_search_results), 0 on error
+#[no_mangle]
+pub extern "C" fn concurrent_index_search_fuzzy(
+    index_ptr: *mut ConcurrentSearchIndex,
+    query: *const c_char,
+    max_distance: usize,
+    limit: usize,
+    results_out: *mut *mut CSearchResult,
+    results_count: *mut usize,
+) -> i32 {
+    if index_ptr.is_null() || results_out.is_null() || results_count.is_null() {
+        return 0;
+    }
+    
+    let index = unsafe { &*index_ptr };
+    let query_str = match optional_c_str(query) {
+        Ok(s) => s.unwrap_or_default(),
+        Err(_) => return 0,
+    };
+    
+    let snapshot = index.snapshot();
+    let hits = snapshot.search_fuzzy_hits(&query_str, max_distance, limit);
+    write_search_results(&hits, results_out, results_count)
+}
+
+/// Get concurrent index document count
+#[no_mangle]
+pub extern "C" fn concurrent_index_count(index_ptr: *mut ConcurrentSearchIndex) -> usize {
+    if index_ptr.is_null() {
+        return 0;
+    }
+    unsafe { (*index_ptr).len() }
+}
+
+/// Clear a concurrent index
+#[no_mangle]
+pub extern "C" fn concurrent_index_clear(index_ptr: *mut ConcurrentSearchIndex) -> i32 {
+    if index_ptr.is_null() {
+        return 0;
+    }
+    unsafe { (*index_ptr).clear(); }
+    1
+}
+
+/// Open (or create) a persistent search index stored at path
+/// The index file is memory-mapped; updates go to a delta log next to it
+/// Returns pointer to index (null on error)
+#[no_mangle]
+pub extern "C" fn open_persistent_search_index(path: *const c_char) -> *mut PersistentSearchIndex {
+    if path.is_null() {
+        return ptr::null_mut();
+    }
+    
+    let path_str = match unsafe { CStr::from_ptr(path).to_str() } {
+        Ok(s) => s,
+        Err(_) => return ptr::null_mut(),
+    };
+    
+    match PersistentSearchIndex::open(PathBuf::from(path_str)) {
+        Ok(index) => Box::into_raw(Box::new(index)),
+        Err(_) => ptr::null_mut(),
+    }
+}
+
+/// Free a persistent search index (pending log records are synced first)
+#[no_mangle]
+pub extern "C" fn free_persistent_search_index(index_ptr: *mut PersistentSearchIndex) {
+    if !index_ptr.is_null() {
+        unsafe {
+            let _ = Box::from_raw(index_ptr);
+        }
+    }
+}
+
+/// Add or replace documents in a persistent index
+/// Returns number of documents added successfully, or -1 if the delta log could not be
+/// written or synced (documents before the failing one stay added)
+#[no_mangle]
+pub extern "C" fn persistent_index_add_documents(
+    index_ptr: *mut PersistentSearchIndex,
+    docs: *const CSearchDocument,
+    count: usize,
+) -> isize {
+    if index_ptr.is_null() || docs.is_null() || count == 0 {
+        return 0;
+    }
+    
+    let index = unsafe { &mut *index_ptr };
+    let mut added = 0;
+    
+    for i in 0..count {
+        let doc_ref = unsafe { &*docs.add(i) };
+        if let Some(doc) = document_from_c(doc_ref) {
+            if index.add_document(doc).is_err() {
+                return -1;
+            }
+            added += 1;
+        }
+    }
+    
+    if index.flush().is_err() {
+        return -1;
+    }
+    added
+}
+
+/// Remove a document from a persistent index
+/// Returns 1 if the document was removed, 0 if it was not found, -1 if the delta log could
+/// not be written or synced
+#[no_mangle]
+pub extern "C" fn persistent_index_remove_document(
+    index_ptr: *mut PersistentSearchIndex,
+    node_id: *const c_char,
+) -> i32 {
+    if index_ptr.is_null() || node_id.is_null() {
+        return 0;
+    }
+    
+    let index = unsafe { &mut *index_ptr };
+    let node_id_str = match unsafe { CStr::from_ptr(node_id).to_str() } {
+        Ok(s) => s,
+        Err(_) => return 0,
+    };
+    
+    let removed = match index.remove_document(node_id_str) {
+        Ok(removed) => removed.is_some(),
+        Err(_) => return -1,
+    };
+    if index.flush().is_err() {
+        return -1;
+    }
+    if removed { 1 } else { 0 }
+}
+
+/// Search a persistent index with exact (substring) matching
+/// Returns 1 on success (results_out must be freed with free_search_results), 0 on error
+#[no_mangle]
+pub extern "C" fn persistent_index_search(
+    index_ptr: *mut PersistentSearchIndex,
+    query: *const c_char,
+    limit: usize,
+    results_out: *mut *mut CSearchResult,
+    results_count: *mut usize,
+) -> i32 {
+    if index_ptr.is_null() || results_out.is_null() || results_count.is_null() {
+        return 0;
+    }
+    
+    let index = unsafe { &*index_ptr };
+    let query_str = match optional_c_str(query) {
+        Ok(s) => s.unwrap_or_default(),
+        Err(_) => return 0,
+    };
+    
+    let hits = index.search_exact_hits(&query_str, limit);
+    write_search_results(&hits, results_out, results_count)
+}
+
+/// Search a persistent index within one account
+/// Returns 1 on success (results_out must be freed with free_search_results), 0 on error
+#[no_mangle]
+pub extern "C" fn persistent_index_search_by_account(
+    index_ptr: *mut PersistentSearchIndex,
+    query: *const c_char,
+    account_id: *const c_char,
+    limit: usize,
+    results_out: *mut *mut CSearchResult,
+    results_count: *mut usize,
+) -> i32 {
+    if index_ptr.is_null() || results_out.is_null() || results_count.is_null() {
+        return 0;
+    }
+    
+    let index = unsafe { &*index_ptr };
+    let (query_str, account_id_str) = match (optional_c_str(query), optional_c_str(account_id)) {
+        (Ok(q), Ok(a)) => (q.unwrap_or_default(), a.unwrap_or_default()),
+        _ => return 0,
+    };
+    
+    let hits = index.search_by_account_hits(&query_str, &account_id_str, limit);
+    write_search_results(&hits, results_out, results_count)
+}
+
+/// Fold the delta log into a new index file
+/// Returns 1 on success, 0 on error
+#[no_mangle]
+pub extern "C" fn persistent_index_compact(index_ptr: *mut PersistentSearchIndex) -> i32 {
+    if index_ptr.is_null() {
+        return 0;
+    }
+    match unsafe { (*index_ptr).compact() } {
+        Ok(()) => 1,
+        Err(_) => 0,
+    }
+}
+
+/// Get persistent index document count
+#[no_mangle]
+pub extern "C" fn persistent_index_count(index_ptr: *mut PersistentSearchIndex) -> usize {
+    if index_ptr.is_null() {
+        return 0;
+    }
+    unsafe { (*index_ptr).len() }
+}
+
 /// Get index document count
 #[no_mangle]
 pub extern "C" fn get_index_count(index_ptr: *mut SearchIndex) -> usize {
@@ -643,8 +910,8 @@ fn build_path_from_index(index: &SearchIndex, node_id: &str) -> Vec<String> {
         visited.insert(current_id.to_string());
         
         if let Some(doc) = index.get(current_id) {
-            parts.push(doc.name.clone());
-            if let Some(parent_id) = &doc.parent_id {
+            parts.push(doc.name.to_string());
+            if let Some(parent_id) = doc.parent_id {
                 current_id = parent_id;
             } else {
                 break;
@@ -663,16 +930,16 @@ fn build_path_from_index(index: &SearchIndex, node_id: &str) -> Vec<String> {
 // ============================================================================
 
 /// Create a batch indexer
+/// Documents are buffered until batch_size is reached, then indexed in parallel
 #[no_mangle]
-pub extern "C" fn create_batch_indexer(batch_size: usize) -> *mut SearchIndex {
-    // Use SearchIndex directly for batch operations
-    let index = Box::new(SearchIndex::new());
-    Box::into_raw(index)
+pub extern "C" fn create_batch_indexer(batch_size: usize) -> *mut BatchIndexer {
+    let indexer = Box::new(BatchIndexer::new(batch_size.max(1)));
+    Box::into_raw(indexer)
 }
 
 /// Free batch indexer
 #[no_mangle]
-pub extern "C" fn free_batch_indexer(indexer_ptr: *mut SearchIndex) {
+pub extern "C" fn free_batch_indexer(indexer_ptr: *mut BatchIndexer) {
     if !indexer_ptr.is_null() {
         unsafe {
             let _ = Box::from_raw(indexer_ptr);
@@ -680,30 +947,61 @@ pub extern "C" fn free_batch_indexer(indexer_ptr: *mut SearchIndex) {
     }
 }
 
-/// Commit batch to search index (no-op since we use SearchIndex directly)
+/// Add documents to a batch indexer
+/// Returns number of documents accepted
+#[no_mangle]
+pub extern "C" fn batch_indexer_add_documents(
+    indexer_ptr: *mut BatchIndexer,
+    docs: *const CSearchDocument,
+    count: usize,
+) -> usize {
+    if indexer_ptr.is_null() || docs.is_null() || count == 0 {
+        return 0;
+    }
+    
+    let indexer = unsafe { &mut *indexer_ptr };
+    let mut added = 0;
+    for doc in documents_from_c(docs, count) {
+        indexer.add_document(doc);
+        added += 1;
+    }
+    added
+}
+
+/// Commit batch to search index
+/// Indexes the pending batch and moves all built documents into index_ptr
+/// Returns 1 on success, 0 on error
 #[no_mangle]
 pub extern "C" fn batch_indexer_commit(
-    _indexer_ptr: *mut SearchIndex,
-    _index_ptr: *mut SearchIndex,
+    indexer_ptr: *mut BatchIndexer,
+    index_ptr: *mut SearchIndex,
 ) -> i32 {
-    // Batch indexing uses SearchIndex directly, no separate batch indexer needed
-    1
+    if indexer_ptr.is_null() || index_ptr.is_null() {
+        return 0;
+    }
+    
+    let indexer = unsafe { &mut *indexer_ptr };
+    let index = unsafe { &mut *index_ptr };
+    match indexer.commit_into(index) {
+        Ok(_) => 1,
+        Err(_) => 0,
+    }
 }
 
 // ============================================================================
 // Phase 2: Incremental Indexing FFI
 // ============================================================================
 
-/// Create incremental indexer (uses SearchIndex directly)
+/// Create incremental indexer
 #[no_mangle]
-pub extern "C" fn create_incremental_indexer() -> *mut SearchIndex {
-    let index = Box::new(SearchIndex::new());
-    Box::into_raw(index)
+pub extern "C" fn create_incremental_indexer() -> *mut IncrementalIndexer {
+    let indexer = Box::new(IncrementalIndexer::new());
+    Box::into_raw(indexer)
 }
 
 /// Free incremental indexer
 #[no_mangle]
-pub extern "C" fn free_incremental_indexer(indexer_ptr: *mut SearchIndex) {
+pub extern "C" fn free_incremental_indexer(indexer_ptr: *mut IncrementalIndexer) {
     if !indexer_ptr.is_null() {
         unsafe {
             let _ = Box::from_raw(indexer_ptr);
@@ -711,21 +1009,104 @@ pub extern "C" fn free_incremental_indexer(indexer_ptr: *mut SearchIndex) {
     }
 }
 
-/// Mark document for re-indexing (no-op for SearchIndex)
+/// Mark document for re-indexing
+/// Returns 1 on success, 0 on error
 #[no_mangle]
 pub extern "C" fn incremental_indexer_mark_dirty(
-    _indexer_ptr: *mut SearchIndex,
-    _node_id: *const c_char,
+    indexer_ptr: *mut IncrementalIndexer,
+    node_id: *const c_char,
 ) -> i32 {
-    // SearchIndex doesn't track dirty documents - this is a no-op
+    if indexer_ptr.is_null() || node_id.is_null() {
+        return 0;
+    }
+    
+    let indexer = unsafe { &mut *indexer_ptr };
+    match unsafe { CStr::from_ptr(node_id).to_str() } {
+        Ok(s) => {
+            indexer.mark_changed(s.to_string());
+            1
+        }
+        Err(_) => 0,
+    }
+}
+
+/// Get pending (changed, not yet re-indexed) document count
+#[no_mangle]
+pub extern "C" fn incremental_indexer_get_pending_count(indexer_ptr: *mut IncrementalIndexer) -> usize {
+    if indexer_ptr.is_null() {
+        return 0;
+    }
+    
+    let indexer = unsafe { &*indexer_ptr };
+    indexer.changed_count()
+}
+
+/// Associate a document with its local file path, so watcher events can find it
+/// Returns 1 on success, 0 on error
+#[no_mangle]
+pub extern "C" fn incremental_indexer_set_node_path(
+    indexer_ptr: *mut IncrementalIndexer,
+    node_id: *const c_char,
+    path: *const c_char,
+) -> i32 {
+    if indexer_ptr.is_null() || node_id.is_null() || path.is_null() {
+        return 0;
+    }
+    
+    let indexer = unsafe { &mut *indexer_ptr };
+    let node_id_str = match unsafe { CStr::from_ptr(node_id).to_str() } {
+        Ok(s) => s.to_string(),
+        Err(_) => return 0,
+    };
+    let path_str = match unsafe { CStr::from_ptr(path).to_str() } {
+        Ok(s) => s,
+        Err(_) => return 0,
+    };
+    
+    indexer.set_node_path(node_id_str, PathBuf::from(path_str));
     1
 }
 
-/// Get pending document count (returns 0 for SearchIndex)
+/// Mark the documents touched by a batch of watcher changes as dirty
+///
+/// `events_json` is a batch returned by fs_watcher_next_events for `watcher_ptr`; it stays
+/// owned by the caller, so the same batch can also be handed to the sync engine. The
+/// watcher is only used for its root. Paths registered with incremental_indexer_set_node_path
+/// must be absolute paths below the watched folder, spelled the same way as the folder passed
+/// to fs_watcher_start (the watcher does not canonicalize the paths it reports).
+/// Returns the number of documents marked, or -1 on error
 #[no_mangle]
-pub extern "C" fn incremental_indexer_get_pending_count(_indexer_ptr: *mut SearchIndex) -> usize {
-    // SearchIndex doesn't track pending changes
-    0
+pub extern "C" fn incremental_indexer_apply_watch_events(
+    indexer_ptr: *mut IncrementalIndexer,
+    watcher_ptr: *const FsWatcher,
+    events_json: *const c_char,
+) -> i32 {
+    if indexer_ptr.is_null() || watcher_ptr.is_null() || events_json.is_null() {
+        return -1;
+    }
+    
+    let indexer = unsafe { &mut *indexer_ptr };
+    let watcher = unsafe { &*watcher_ptr };
+    let events: Vec<WatchEvent> = match unsafe { CStr::from_ptr(events_json).to_str() } {
+        Ok(json) => match serde_json::from_str(json) {
+            Ok(events) => events,
+            Err(_) => return -1,
+        },
+        Err(_) => return -1,
+    };
+    let mut marked = 0usize;
+    
+    for event in events {
+        let path = if event.path.is_empty() {
+            watcher.root().to_path_buf()
+        } else {
+            watcher.root().join(&event.path)
+        };
+        let include_descendants = matches!(event.kind, WatchEventKind::Removed | WatchEventKind::Rescan);
+        marked += indexer.mark_path_changed(&path, include_descendants);
+    }
+    
+    marked as i32
 }
 
 // ============================================================================
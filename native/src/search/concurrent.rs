@@ -0,0 +1,553 @@
+// Concurrent search index for CloudNexus
+// One shard per account; readers never wait for index updates.
+//
+// Every shard keeps two copies of its SearchIndex (left-right), so the index takes about
+// twice the memory of a plain SearchIndex holding the same documents. Readers clone the
+// Arc of the published copy and query it without further locking. A writer updates the
+// standby copy, which no reader can see, publishes it with a pointer swap, and keeps the
+// update so it can be replayed onto the previously published copy before that copy is
+// written again.
+//
+// Updates are planned under one short lock (which shard each document lives in) and
+// queued per shard; the copies of a shard are then written under that shard's own lock.
+// A writer may wait for readers still holding the old copy of its shard (and rebuild it
+// if a snapshot is kept for long), but never blocks writers of other shards; readers
+// never wait for writers.
+
+use std::collections::HashMap;
+use std::sync::{Arc, Mutex, RwLock};
+use std::time::{Duration, Instant};
+
+use super::incremental::DocumentChange;
+use super::index::{SearchDocument, SearchIndex, SearchResult};
+use super::query::{self, SearchHit};
+
+/// Spins before a writer starts sleeping while readers drain the standby copy
+const DRAIN_SPINS: usize = 64;
+const DRAIN_SLEEP: Duration = Duration::from_micros(50);
+/// How long a writer waits for the standby copy before rebuilding it instead
+const DRAIN_TIMEOUT: Duration = Duration::from_millis(20);
+
+/// One update applied to a shard
+#[derive(Clone)]
+enum ShardOp {
+    Upsert(Vec<SearchDocument>),
+    Remove(Vec<String>),
+    Clear,
+}
+
+impl ShardOp {
+    fn apply(&self, index: &mut SearchIndex) {
+        match self {
+            ShardOp::Upsert(docs) => {
+                index.add_documents(docs.clone());
+            }
+            ShardOp::Remove(node_ids) => {
+                for node_id in node_ids {
+                    index.remove_document(node_id);
+                }
+            }
+            ShardOp::Clear => index.clear(),
+        }
+    }
+}
+
+/// Published copy of one account's index
+struct Shard {
+    published: RwLock<Arc<SearchIndex>>,
+}
+
+impl Shard {
+    fn snapshot(&self) -> Arc<SearchIndex> {
+        match self.published.read() {
+            Ok(guard) => guard.clone(),
+            Err(poisoned) => poisoned.into_inner().clone(),
+        }
+    }
+
+    fn publish(&self, index: Arc<SearchIndex>) -> Arc<SearchIndex> {
+        let mut guard = match self.published.write() {
+            Ok(guard) => guard,
+            Err(poisoned) => poisoned.into_inner(),
+        };
+        std::mem::replace(&mut *guard, index)
+    }
+}
+
+/// Writer-side state of one shard
+struct ShardWriter {
+    shard: Arc<Shard>,
+    /// The copy readers no longer receive (may still be borrowed by old readers)
+    standby: Arc<SearchIndex>,
+    /// Updates the standby copy has not seen yet
+    pending: Vec<ShardOp>,
+}
+
+impl ShardWriter {
+    /// Apply `ops` and publish the result
+    fn write(&mut self, ops: Vec<ShardOp>) {
+        let started = Instant::now();
+        let mut spins = 0;
+        while Arc::get_mut(&mut self.standby).is_none() {
+            if started.elapsed() >= DRAIN_TIMEOUT {
+                // Someone holds a snapshot of this copy for long; rebuild the standby from
+                // the published copy instead of waiting (the published copy is up to date).
+                // Only this shard's lock is held meanwhile.
+                let published = self.shard.snapshot();
+                let mut fresh = SearchIndex::new();
+                fresh.add_documents(published.documents().map(|doc| doc.to_document()).collect());
+                self.standby = Arc::new(fresh);
+                self.pending.clear();
+                break;
+            }
+            // A reader that picked up this copy before the last swap is still searching
+            if spins < DRAIN_SPINS {
+                spins += 1;
+                std::thread::yield_now();
+            } else {
+                std::thread::sleep(DRAIN_SLEEP);
+            }
+        }
+
+        if let Some(standby) = Arc::get_mut(&mut self.standby) {
+            for op in self.pending.iter().chain(ops.iter()) {
+                op.apply(standby);
+            }
+        }
+
+        let updated = std::mem::replace(&mut self.standby, Arc::new(SearchIndex::new()));
+        self.standby = self.shard.publish(updated);
+        self.pending = ops;
+    }
+}
+
+/// Writer-side view of one shard
+struct ShardSlot {
+    account_id: Arc<str>,
+    /// Planned updates not written yet, in planning order
+    queued: Mutex<Vec<ShardOp>>,
+    /// Held while the copies of this shard are written
+    writer: Mutex<ShardWriter>,
+}
+
+impl ShardSlot {
+    fn enqueue(&self, ops: Vec<ShardOp>) {
+        let mut queued = match self.queued.lock() {
+            Ok(guard) => guard,
+            Err(poisoned) => poisoned.into_inner(),
+        };
+        queued.extend(ops);
+    }
+
+    /// Write and publish everything queued so far (including updates of other writers)
+    fn flush(&self) {
+        let mut writer = match self.writer.lock() {
+            Ok(guard) => guard,
+            Err(poisoned) => poisoned.into_inner(),
+        };
+        let ops = {
+            let mut queued = match self.queued.lock() {
+                Ok(guard) => guard,
+                Err(poisoned) => poisoned.into_inner(),
+            };
+            std::mem::take(&mut *queued)
+        };
+        if !ops.is_empty() {
+            writer.write(ops);
+        }
+    }
+}
+
+/// Where every document lives, so updates can be planned without touching the shards
+struct Planner {
+    slots: HashMap<String, Arc<ShardSlot>>,
+    /// node_id -> account of the shard holding the document (once queued updates are written)
+    owners: HashMap<String, Arc<str>>,
+}
+
+/// Updates planned for one shard
+struct PlannedShard {
+    slot: Arc<ShardSlot>,
+    ops: Vec<ShardOp>,
+}
+
+impl PlannedShard {
+    fn upsert(&mut self, doc: SearchDocument) {
+        match self.ops.last_mut() {
+            Some(ShardOp::Upsert(docs)) => docs.push(doc),
+            _ => self.ops.push(ShardOp::Upsert(vec![doc])),
+        }
+    }
+
+    fn remove(&mut self, node_id: String) {
+        match self.ops.last_mut() {
+            Some(ShardOp::Remove(node_ids)) => node_ids.push(node_id),
+            _ => self.ops.push(ShardOp::Remove(vec![node_id])),
+        }
+    }
+}
+
+/// Consistent view over every shard, taken at one point in time
+///
+/// Hits borrow from the snapshot; later updates do not affect it.
+pub struct IndexSnapshot {
+    shards: Vec<Arc<SearchIndex>>,
+}
+
+impl IndexSnapshot {
+    fn merged<'a, F>(&'a self, limit: usize, run: F) -> Vec<SearchHit<'a>>
+    where
+        F: Fn(&'a SearchIndex) -> Vec<SearchHit<'a>>,
+    {
+        query::merge_hits(self.shards.iter().map(|index| run(index)).collect(), limit)
+    }
+
+    pub fn search_exact_hits(&self, query: &str, limit: usize) -> Vec<SearchHit<'_>> {
+        self.merged(limit, |index| index.search_exact_hits(query, limit))
+    }
+
+    pub fn search_prefix_hits(&self, query: &str, limit: usize) -> Vec<SearchHit<'_>> {
+        self.merged(limit, |index| index.search_prefix_hits(query, limit))
+    }
+
+    pub fn search_fuzzy_hits(&self, query: &str, max_distance: usize, limit: usize) -> Vec<SearchHit<'_>> {
+        self.merged(limit, |index| index.search_fuzzy_hits(query, max_distance, limit))
+    }
+
+    pub fn len(&self) -> usize {
+        self.shards.iter().map(|index| index.len()).sum()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+}
+
+/// Search index that can be queried from any thread while other threads update it
+///
+/// Holds two copies of every account's index (see the top of this file).
+pub struct ConcurrentSearchIndex {
+    /// account_id -> shard; the write lock is only taken to add a shard
+    shards: RwLock<HashMap<String, Arc<Shard>>>,
+    /// Serializes planning; held only while updates are queued, not while shards are written
+    planner: Mutex<Planner>,
+}
+
+impl ConcurrentSearchIndex {
+    pub fn new() -> Self {
+        ConcurrentSearchIndex {
+            shards: RwLock::new(HashMap::new()),
+            planner: Mutex::new(Planner {
+                slots: HashMap::new(),
+                owners: HashMap::new(),
+            }),
+        }
+    }
+
+    fn shard(&self, account_id: &str) -> Option<Arc<Shard>> {
+        let shards = match self.shards.read() {
+            Ok(guard) => guard,
+            Err(poisoned) => poisoned.into_inner(),
+        };
+        shards.get(account_id).cloned()
+    }
+
+    fn shard_snapshot(&self, account_id: &str) -> Option<Arc<SearchIndex>> {
+        self.shard(account_id).map(|shard| shard.snapshot())
+    }
+
+    /// Snapshot of every shard for multi-account queries
+    pub fn snapshot(&self) -> IndexSnapshot {
+        let shards = match self.shards.read() {
+            Ok(guard) => guard,
+            Err(poisoned) => poisoned.into_inner(),
+        };
+        IndexSnapshot {
+            shards: shards.values().map(|shard| shard.snapshot()).collect(),
+        }
+    }
+
+    fn lock_planner(&self) -> std::sync::MutexGuard<'_, Planner> {
+        match self.planner.lock() {
+            Ok(guard) => guard,
+            Err(poisoned) => poisoned.into_inner(),
+        }
+    }
+
+    /// Writer-side slot of an account, creating its (empty) shard on first use
+    fn slot(&self, planner: &mut Planner, account_id: &str) -> Arc<ShardSlot> {
+        if let Some(slot) = planner.slots.get(account_id) {
+            return slot.clone();
+        }
+        let shard = Arc::new(Shard { published: RwLock::new(Arc::new(SearchIndex::new())) });
+        {
+            let mut shards = match self.shards.write() {
+                Ok(guard) => guard,
+                Err(poisoned) => poisoned.into_inner(),
+            };
+            shards.insert(account_id.to_string(), shard.clone());
+        }
+        let slot = Arc::new(ShardSlot {
+            account_id: Arc::from(account_id),
+            queued: Mutex::new(Vec::new()),
+            writer: Mutex::new(ShardWriter {
+                shard,
+                standby: Arc::new(SearchIndex::new()),
+                pending: Vec::new(),
+            }),
+        });
+        planner.slots.insert(account_id.to_string(), slot.clone());
+        slot
+    }
+
+    fn planned<'a>(
+        &self,
+        planner: &mut Planner,
+        planned: &'a mut HashMap<Arc<str>, PlannedShard>,
+        account_id: &str,
+    ) -> &'a mut PlannedShard {
+        let slot = self.slot(planner, account_id);
+        planned
+            .entry(slot.account_id.clone())
+            .or_insert_with(|| PlannedShard { slot, ops: Vec::new() })
+    }
+
+    /// Queue the planned updates (caller holds the planner lock, which fixes their order)
+    /// and return the shards to write once the lock is released
+    fn enqueue(planned: HashMap<Arc<str>, PlannedShard>) -> Vec<Arc<ShardSlot>> {
+        planned
+            .into_values()
+            .map(|planned| {
+                planned.slot.enqueue(planned.ops);
+                planned.slot
+            })
+            .collect()
+    }
+
+    /// Write the given shards one after another; each waits only for its own readers
+    fn flush(slots: Vec<Arc<ShardSlot>>) {
+        for slot in slots {
+            slot.flush();
+        }
+    }
+
+    /// Add or replace documents; each account's shard is updated and published once
+    pub fn add_documents(&self, docs: Vec<SearchDocument>) -> usize {
+        let count = docs.len();
+        let slots = {
+            let mut planner = self.lock_planner();
+            let mut planned = HashMap::new();
+            for doc in docs {
+                let target = self.planned(&mut planner, &mut planned, &doc.account_id);
+                let account_id = target.slot.account_id.clone();
+                let node_id = doc.node_id.clone();
+                target.upsert(doc);
+                // A document that moved to another account leaves its old shard
+                if let Some(previous) = planner.owners.insert(node_id.clone(), account_id.clone()) {
+                    if previous != account_id {
+                        self.planned(&mut planner, &mut planned, &previous).remove(node_id);
+                    }
+                }
+            }
+            Self::enqueue(planned)
+        };
+        Self::flush(slots);
+        count
+    }
+
+    pub fn add_document(&self, doc: SearchDocument) {
+        self.add_documents(vec![doc]);
+    }
+
+    /// Remove a document; returns true if it was indexed
+    pub fn remove_document(&self, node_id: &str) -> bool {
+        let slots = {
+            let mut planner = self.lock_planner();
+            let owner = match planner.owners.remove(node_id) {
+                Some(owner) => owner,
+                None => return false,
+            };
+            let mut planned = HashMap::new();
+            self.planned(&mut planner, &mut planned, &owner).remove(node_id.to_string());
+            Self::enqueue(planned)
+        };
+        Self::flush(slots);
+        true
+    }
+
+    /// Apply incremental changes (see IncrementalIndexer)
+    pub fn apply_changes(&self, changes: &[DocumentChange]) {
+        let mut docs = Vec::new();
+        for change in changes {
+            match change {
+                DocumentChange::Added(doc) | DocumentChange::Modified(doc) => docs.push(doc.clone()),
+                DocumentChange::Removed(node_id) => {
+                    // Keep the order of upserts and removals of the same node
+                    if !docs.is_empty() {
+                        self.add_documents(std::mem::take(&mut docs));
+                    }
+                    self.remove_document(node_id);
+                }
+            }
+        }
+        if !docs.is_empty() {
+            self.add_documents(docs);
+        }
+    }
+
+    /// Remove every document
+    pub fn clear(&self) {
+        let slots: Vec<Arc<ShardSlot>> = {
+            let mut planner = self.lock_planner();
+            planner.owners.clear();
+            planner
+                .slots
+                .values()
+                .map(|slot| {
+                    slot.enqueue(vec![ShardOp::Clear]);
+                    slot.clone()
+                })
+                .collect()
+        };
+        Self::flush(slots);
+    }
+
+    pub fn len(&self) -> usize {
+        self.snapshot().len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// Owned copy of a document
+    pub fn get(&self, node_id: &str) -> Option<SearchDocument> {
+        self.snapshot()
+            .shards
+            .iter()
+            .find_map(|index| index.get(node_id).map(|doc| doc.to_document()))
+    }
+
+    /// Run `f` on the current snapshot of one account's shard (None if the account is unknown)
+    pub fn with_account<R>(&self, account_id: &str, f: impl FnOnce(&SearchIndex) -> R) -> Option<R> {
+        self.shard_snapshot(account_id).map(|index| f(&index))
+    }
+
+    pub fn search_exact(&self, query: &str, limit: usize) -> Vec<SearchResult> {
+        query::to_results(self.snapshot().search_exact_hits(query, limit))
+    }
+
+    pub fn search_prefix(&self, query: &str, limit: usize) -> Vec<SearchResult> {
+        query::to_results(self.snapshot().search_prefix_hits(query, limit))
+    }
+
+    pub fn search_fuzzy(&self, query: &str, max_distance: usize, limit: usize) -> Vec<SearchResult> {
+        query::to_results(self.snapshot().search_fuzzy_hits(query, max_distance, limit))
+    }
+
+    /// Search one account; only that account's shard is touched
+    pub fn search_by_account(&self, query: &str, account_id: &str, limit: usize) -> Vec<SearchResult> {
+        self.with_account(account_id, |index| index.search_by_account(query, account_id, limit))
+            .unwrap_or_default()
+    }
+}
+
+impl Default for ConcurrentSearchIndex {
+    fn default() -> Self {
+        ConcurrentSearchIndex::new()
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn doc(id: &str, name: &str, account: &str) -> SearchDocument {
+        SearchDocument {
+            node_id: id.to_string(),
+            account_id: account.to_string(),
+            provider: "gdrive".to_string(),
+            email: "test@example.com".to_string(),
+            name: name.to_string(),
+            is_folder: false,
+            parent_id: None,
+        }
+    }
+
+    #[test]
+    fn test_concurrent_index_shards_and_updates() {
+        let index = ConcurrentSearchIndex::new();
+        index.add_documents(vec![doc("1", "Report 2024", "acc1"), doc("2", "Report draft", "acc2")]);
+        assert_eq!(index.len(), 2);
+        assert_eq!(index.search_exact("report", 10).len(), 2);
+        assert_eq!(index.search_by_account("report", "acc2", 10).len(), 1);
+        assert!(index.search_by_account("report", "acc3", 10).is_empty());
+
+        // A snapshot is unaffected by later updates; both copies stay in sync
+        let snapshot = index.snapshot();
+        index.add_document(doc("3", "Report final", "acc1"));
+        index.add_document(doc("1", "Renamed", "acc1"));
+        assert_eq!(snapshot.search_exact_hits("report", 10).len(), 2);
+        assert_eq!(index.search_exact("report", 10).len(), 2);
+        assert_eq!(index.get("1").unwrap().name, "Renamed");
+        drop(snapshot);
+
+        // Moving a document to another account removes it from the old shard
+        index.add_document(doc("2", "Report draft", "acc1"));
+        assert!(index.search_by_account("report", "acc2", 10).is_empty());
+        assert_eq!(index.search_by_account("report", "acc1", 10).len(), 2);
+
+        assert!(index.remove_document("3"));
+        assert!(!index.remove_document("3"));
+        assert_eq!(index.len(), 2);
+        index.clear();
+        assert!(index.is_empty());
+    }
+
+    #[test]
+    fn test_concurrent_index_reads_during_writes() {
+        let index = Arc::new(ConcurrentSearchIndex::new());
+        let writer = {
+            let index = index.clone();
+            std::thread::spawn(move || {
+                for batch in 0..20 {
+                    let docs = (0..100)
+                        .map(|i| doc(&format!("{}-{}", batch, i), &format!("file {}", i), "acc1"))
+                        .collect();
+                    index.add_documents(docs);
+                }
+            })
+        };
+
+        // Every read sees a whole number of batches
+        while !writer.is_finished() {
+            assert_eq!(index.len() % 100, 0);
+        }
+        writer.join().unwrap();
+        assert_eq!(index.len(), 2000);
+        assert_eq!(index.search_exact("file 7", 5000).len(), 20 * 11);
+    }
+
+    #[test]
+    fn test_concurrent_index_moves_within_one_batch() {
+        let index = ConcurrentSearchIndex::new();
+        index.add_document(doc("1", "Report", "acc1"));
+
+        // The document moves away and back in the same batch; it ends up in one shard
+        index.add_documents(vec![doc("1", "Report moved", "acc2"), doc("1", "Report back", "acc1")]);
+        assert_eq!(index.len(), 1);
+        assert!(index.search_by_account("report", "acc2", 10).is_empty());
+        assert_eq!(index.get("1").unwrap().name, "Report back");
+
+        // A snapshot kept across writes of its shard does not hold up writers
+        let snapshot = index.snapshot();
+        for i in 0..3 {
+            index.add_document(doc(&format!("a{}", i), "Draft", "acc1"));
+            index.add_document(doc(&format!("b{}", i), "Draft", "acc2"));
+        }
+        assert_eq!(snapshot.len(), 1);
+        assert_eq!(index.search_exact("draft", 10).len(), 6);
+        assert!(index.remove_document("1"));
+        assert_eq!(index.len(), 6);
+    }
+}
@@ -3,7 +3,7 @@
 
 use std::collections::HashSet;
 use std::collections::HashMap;
-use std::path::PathBuf;
+use std::path::{Path, PathBuf};
 use serde::{Deserialize, Serialize};
 
 use super::index::{SearchDocument, SearchIndex};
@@ -26,6 +26,8 @@ pub struct IncrementalIndexer {
     changed_ids: HashSet<String>,
     /// Mapping of node_id to file path (for persistence)
     node_file_map: HashMap<String, PathBuf>,
+    /// Reverse of node_file_map, for resolving watcher events
+    path_node_map: HashMap<PathBuf, String>,
     /// Path to persistence file
     persistence_path: Option<PathBuf>,
 }
@@ -38,6 +40,7 @@ impl IncrementalIndexer {
             processed_ids: HashSet::new(),
             changed_ids: HashSet::new(),
             node_file_map: HashMap::new(),
+            path_node_map: HashMap::new(),
             persistence_path: None,
         }
     }
@@ -60,6 +63,38 @@ impl IncrementalIndexer {
         self.changed_ids.insert(node_id);
     }
     
+    /// Associate a document with a local file path
+    pub fn set_node_path(&mut self, node_id: String, path: PathBuf) {
+        if let Some(old_path) = self.node_file_map.insert(node_id.clone(), path.clone()) {
+            self.path_node_map.remove(&old_path);
+        }
+        self.path_node_map.insert(path, node_id);
+    }
+    
+    /// Mark the documents at a local path as changed
+    ///
+    /// With `include_descendants`, documents below `path` are marked too (a folder was
+    /// removed or must be rescanned). Returns the number of documents marked.
+    pub fn mark_path_changed(&mut self, path: &Path, include_descendants: bool) -> usize {
+        let mut marked: Vec<String> = Vec::new();
+        if include_descendants {
+            marked.extend(
+                self.node_file_map
+                    .iter()
+                    .filter(|(_, node_path)| node_path.starts_with(path))
+                    .map(|(node_id, _)| node_id.clone()),
+            );
+        } else if let Some(node_id) = self.path_node_map.get(path) {
+            marked.push(node_id.clone());
+        }
+        
+        let count = marked.len();
+        for node_id in marked {
+            self.mark_changed(node_id);
+        }
+        count
+    }
+    
     /// Mark a document as added
     pub fn mark_added(&mut self, doc: SearchDocument) {
         self.changed_ids.insert(doc.node_id.clone());
@@ -156,6 +191,11 @@ impl IncrementalIndexer {
             
             self.processed_ids = state.processed_ids;
             self.node_file_map = state.node_file_map;
+            self.path_node_map = self
+                .node_file_map
+                .iter()
+                .map(|(node_id, path)| (path.clone(), node_id.clone()))
+                .collect();
         }
         Ok(())
     }
@@ -166,6 +206,7 @@ impl IncrementalIndexer {
         self.processed_ids.clear();
         self.changed_ids.clear();
         self.node_file_map.clear();
+        self.path_node_map.clear();
     }
 }
 
@@ -219,6 +260,21 @@ mod tests {
         assert!(!indexer.has_pending_changes());
     }
     
+    #[test]
+    fn test_incremental_indexer_mark_path_changed() {
+        let mut indexer = IncrementalIndexer::new();
+        indexer.set_node_path("1".to_string(), PathBuf::from("/sync/docs/a.txt"));
+        indexer.set_node_path("2".to_string(), PathBuf::from("/sync/docs/b.txt"));
+        indexer.set_node_path("3".to_string(), PathBuf::from("/sync/other.txt"));
+        
+        assert_eq!(indexer.mark_path_changed(Path::new("/sync/docs/a.txt"), false), 1);
+        assert_eq!(indexer.mark_path_changed(Path::new("/sync/missing.txt"), false), 0);
+        assert_eq!(indexer.changed_count(), 1);
+        
+        assert_eq!(indexer.mark_path_changed(Path::new("/sync/docs"), true), 2);
+        assert_eq!(indexer.changed_count(), 2);
+    }
+    
     fn create_test_doc(id: &str, name: &str) -> SearchDocument {
         SearchDocument {
             node_id: id.to_string(),
@@ -1,10 +1,13 @@
 // Search index module for CloudNexus
 // Phase 1: Simple in-memory index for fuzzy search
 
-use std::collections::HashMap;
-use std::path::PathBuf;
+use std::collections::{HashMap, HashSet};
 use serde::{Deserialize, Serialize};
 
+use super::batch::{build_postings, batch_threads};
+use super::query::{self, trigrams, DocSource, Postings, SearchHit, Trigram};
+use super::store::{posting_insert, posting_merge, posting_remove, DocId, DocumentRef, DocumentStore};
+
 /// Search document structure for indexing
 #[derive(Debug, Clone, Serialize, Deserialize, PartialEq)]
 pub struct SearchDocument {
@@ -29,306 +32,274 @@ pub struct SearchResult {
 
 /// In-memory search index for Phase 1
 /// Stores documents and provides fuzzy search capabilities
+///
+/// Documents sit in a compact slot store (see store.rs); every secondary index is a
+/// posting list of sorted u32 document ids.
 pub struct SearchIndex {
-    /// Main document storage by node_id
-    documents: HashMap<String, SearchDocument>,
+    /// Main document storage, addressed by DocId
+    store: DocumentStore,
     /// Inverted index for fast name lookup
-    name_index: HashMap<String, Vec<String>>,
-    /// Account index for filtering
-    account_index: HashMap<String, Vec<String>>,
+    name_index: HashMap<Box<str>, Vec<DocId>>,
+    /// Account index for filtering (keyed by interned account id)
+    account_index: HashMap<u32, Vec<DocId>>,
+    /// Trigram posting lists over lowercase names, for substring and fuzzy candidates
+    trigram_index: HashMap<Trigram, Vec<DocId>>,
 }
 
 impl SearchIndex {
     /// Create a new empty search index
     pub fn new() -> Self {
         SearchIndex {
-            documents: HashMap::new(),
+            store: DocumentStore::new(),
             name_index: HashMap::new(),
             account_index: HashMap::new(),
+            trigram_index: HashMap::new(),
         }
     }
     
-    /// Add a document to the index
+    /// Add a document to the index (replaces an existing document with the same node_id)
     pub fn add_document(&mut self, doc: SearchDocument) {
-        let node_id = doc.node_id.clone();
-        let name_lower = doc.name.to_lowercase();
-        let account_id = doc.account_id.clone();
+        if self.store.id_of(&doc.node_id).is_some() {
+            self.remove_document(&doc.node_id);
+        }
         
         // Add to main document store
-        self.documents.insert(node_id.clone(), doc.clone());
+        let id = self.store.insert(&doc);
+        let stored = match self.store.get(id) {
+            Some(stored) => stored,
+            None => return,
+        };
+        let name_lower = stored.name_lower();
+        let account = self.store.account_of(id);
         
         // Add to name inverted index (tokenized by word)
         for word in name_lower.split_whitespace() {
             if !word.is_empty() {
-                self.name_index
-                    .entry(word.to_string())
-                    .or_insert_with(Vec::new)
-                    .push(node_id.clone());
+                let ids = match self.name_index.get_mut(word) {
+                    Some(ids) => ids,
+                    None => self.name_index.entry(word.into()).or_insert_with(Vec::new),
+                };
+                posting_insert(ids, id);
             }
         }
         
+        // Add to trigram index
+        for gram in trigrams(name_lower) {
+            posting_insert(self.trigram_index.entry(gram).or_insert_with(Vec::new), id);
+        }
+        
         // Add to account index
-        self.account_index
-            .entry(account_id)
-            .or_insert_with(Vec::new)
-            .push(node_id);
+        if let Some(account) = account {
+            posting_insert(self.account_index.entry(account).or_insert_with(Vec::new), id);
+        }
+    }
+    
+    /// Add many documents at once (upserts, like add_document)
+    ///
+    /// Documents are placed in the store first; tokenizing names and building their
+    /// posting lists then runs across threads (see batch::build_postings) and the
+    /// resulting lists are merged into the index. Returns the number of documents added.
+    pub fn add_documents(&mut self, docs: Vec<SearchDocument>) -> usize {
+        let count = docs.len();
+        let threads = batch_threads(count);
+        if threads <= 1 {
+            for doc in docs {
+                self.add_document(doc);
+            }
+            return count;
+        }
+        
+        // A node id repeated within the batch keeps its last version
+        let keep: Vec<bool> = {
+            let mut seen = HashSet::with_capacity(docs.len());
+            let mut keep: Vec<bool> = docs.iter().rev().map(|doc| seen.insert(doc.node_id.as_str())).collect();
+            keep.reverse();
+            keep
+        };
+        
+        let mut ids = Vec::with_capacity(docs.len());
+        for (doc, keep) in docs.iter().zip(keep) {
+            if !keep {
+                continue;
+            }
+            if self.store.id_of(&doc.node_id).is_some() {
+                self.remove_document(&doc.node_id);
+            }
+            ids.push(self.store.insert(doc));
+        }
+        ids.sort_unstable();
+        
+        for shard in build_postings(&self.store, &ids, threads) {
+            for (word, list) in shard.words {
+                match self.name_index.get_mut(word) {
+                    Some(existing) => posting_merge(existing, list),
+                    None => {
+                        self.name_index.insert(word.into(), list);
+                    }
+                }
+            }
+            for (gram, list) in shard.trigrams {
+                posting_merge(self.trigram_index.entry(gram).or_insert_with(Vec::new), list);
+            }
+            for (account, list) in shard.accounts {
+                posting_merge(self.account_index.entry(account).or_insert_with(Vec::new), list);
+            }
+        }
+        
+        count
     }
     
     /// Remove a document from the index
     pub fn remove_document(&mut self, node_id: &str) -> Option<SearchDocument> {
-        if let Some(doc) = self.documents.remove(node_id) {
-            let name_lower = doc.name.to_lowercase();
+        let id = self.store.id_of(node_id)?;
+        let account = self.store.account_of(id);
+        
+        if let Some(stored) = self.store.get(id) {
+            let name_lower = stored.name_lower();
             
             // Remove from name index
             for word in name_lower.split_whitespace() {
                 if let Some(ids) = self.name_index.get_mut(word) {
-                    ids.retain(|id| id != node_id);
+                    posting_remove(ids, id);
                     if ids.is_empty() {
                         self.name_index.remove(word);
                     }
                 }
             }
             
-            // Remove from account index
-            if let Some(ids) = self.account_index.get_mut(&doc.account_id) {
-                ids.retain(|id| id != node_id);
+            // Remove from trigram index
+            for gram in trigrams(name_lower) {
+                if let Some(ids) = self.trigram_index.get_mut(&gram) {
+                    posting_remove(ids, id);
+                    if ids.is_empty() {
+                        self.trigram_index.remove(&gram);
+                    }
+                }
+            }
+        }
+        
+        // Remove from account index
+        if let Some(account) = account {
+            if let Some(ids) = self.account_index.get_mut(&account) {
+                posting_remove(ids, id);
                 if ids.is_empty() {
-                    self.account_index.remove(&doc.account_id);
+                    self.account_index.remove(&account);
                 }
             }
-            
-            Some(doc)
-        } else {
-            None
         }
+        
+        self.store.remove(node_id).map(|(_, doc)| doc)
     }
     
     /// Clear all documents from the index
     pub fn clear(&mut self) {
-        self.documents.clear();
+        self.store.clear();
         self.name_index.clear();
         self.account_index.clear();
+        self.trigram_index.clear();
     }
     
     /// Get document by node_id
-    pub fn get(&self, node_id: &str) -> Option<&SearchDocument> {
-        self.documents.get(node_id)
+    pub fn get(&self, node_id: &str) -> Option<DocumentRef<'_>> {
+        self.store.get(self.store.id_of(node_id)?)
+    }
+    
+    /// Iterate over all documents
+    pub fn documents(&self) -> impl Iterator<Item = DocumentRef<'_>> + '_ {
+        self.store.iter().map(|(_, doc)| doc)
     }
     
     /// Get number of documents in index
     pub fn len(&self) -> usize {
-        self.documents.len()
+        self.store.len()
     }
     
     /// Check if index is empty
     pub fn is_empty(&self) -> bool {
-        self.documents.is_empty()
+        self.store.is_empty()
     }
     
     /// Search with exact matching
     pub fn search_exact(&self, query: &str, limit: usize) -> Vec<SearchResult> {
-        let query_lower = query.to_lowercase();
-        let mut results = Vec::new();
-        
-        for (node_id, doc) in &self.documents {
-            if doc.name.to_lowercase().contains(&query_lower) {
-                let score = if doc.name.to_lowercase() == query_lower {
-                    1.0
-                } else if doc.name.to_lowercase().starts_with(&query_lower) {
-                    0.9
-                } else {
-                    // For partial matches, calculate a more refined score
-                    // based on how much of the query matches the name
-                    let name_lower = doc.name.to_lowercase();
-                    let match_position = name_lower.find(&query_lower).unwrap_or(0);
-                    
-                    // Calculate bonus for early match position
-                    let position_bonus = if match_position == 0 {
-                        0.1
-                    } else {
-                        0.0
-                    };
-                    
-                    // Calculate bonus based on query being a word boundary match
-                    let word_boundary_bonus = if match_position == 0 ||
-                        name_lower.chars().nth(match_position - 1) == Some(' ') {
-                        0.05
-                    } else {
-                        0.0
-                    };
-                    
-                    0.7 + position_bonus + word_boundary_bonus
-                };
-                
-                results.push(SearchResult {
-                    node_id: node_id.clone(),
-                    name: doc.name.clone(),
-                    score,
-                    account_id: doc.account_id.clone(),
-                    provider: doc.provider.clone(),
-                });
-            }
-        }
-        
-        // Sort by score (descending) to return most relevant results first
-        results.sort_by(|a, b| b.score.partial_cmp(&a.score).unwrap());
-        
-        // Apply limit after sorting to get top results
-        results.into_iter().take(limit).collect()
+        query::to_results(self.search_exact_hits(query, limit))
+    }
+    
+    /// Top `limit` substring matches, borrowed from the index
+    pub fn search_exact_hits(&self, query: &str, limit: usize) -> Vec<SearchHit<'_>> {
+        query::exact_hits(self, query, limit, |_| true)
     }
     
     /// Search with prefix matching
     pub fn search_prefix(&self, query: &str, limit: usize) -> Vec<SearchResult> {
-        let query_lower = query.to_lowercase();
-        let mut results = Vec::new();
-        
-        // First, try exact prefix match in name index
-        for word in query_lower.split_whitespace() {
-            if let Some(node_ids) = self.name_index.get(word) {
-                for node_id in node_ids {
-                    if let Some(doc) = self.documents.get(node_id) {
-                        // Check if name starts with query
-                        if doc.name.to_lowercase().starts_with(&query_lower) {
-                            results.push(SearchResult {
-                                node_id: node_id.clone(),
-                                name: doc.name.clone(),
-                                score: 0.95,
-                                account_id: doc.account_id.clone(),
-                                provider: doc.provider.clone(),
-                            });
-                        }
-                    }
-                }
-            }
-        }
-        
-        // Remove duplicates and limit results
-        results.sort_by(|a, b| b.score.partial_cmp(&a.score).unwrap());
-        results.into_iter().take(limit).collect()
+        query::to_results(self.search_prefix_hits(query, limit))
+    }
+    
+    /// Top `limit` prefix matches, borrowed from the index
+    pub fn search_prefix_hits(&self, query: &str, limit: usize) -> Vec<SearchHit<'_>> {
+        query::prefix_hits(self, query, limit, |_| true)
     }
     
     /// Search within specific account
     pub fn search_by_account(&self, query: &str, account_id: &str, limit: usize) -> Vec<SearchResult> {
-        let query_lower = query.to_lowercase();
-        let mut results = Vec::new();
-        
-        if let Some(node_ids) = self.account_index.get(account_id) {
-            for node_id in node_ids {
-                if let Some(doc) = self.documents.get(node_id) {
-                    if doc.name.to_lowercase().contains(&query_lower) {
-                        let score = if doc.name.to_lowercase() == query_lower {
-                            1.0
-                        } else if doc.name.to_lowercase().starts_with(&query_lower) {
-                            0.9
-                        } else {
-                            0.7
-                        };
-                        
-                        results.push(SearchResult {
-                            node_id: node_id.clone(),
-                            name: doc.name.clone(),
-                            score,
-                            account_id: doc.account_id.clone(),
-                            provider: doc.provider.clone(),
-                        });
-                    }
-                }
-            }
-        }
-        
-        results.sort_by(|a, b| b.score.partial_cmp(&a.score).unwrap());
-        results.into_iter().take(limit).collect()
+        query::to_results(self.search_by_account_hits(query, account_id, limit))
     }
     
-    /// Get all documents for an account
-    pub fn get_by_account(&self, account_id: &str) -> Vec<&SearchDocument> {
-        if let Some(node_ids) = self.account_index.get(account_id) {
-            node_ids.iter()
-                .filter_map(|id| self.documents.get(id))
-                .collect()
-        } else {
-            Vec::new()
-        }
+    /// Top `limit` substring matches within one account, borrowed from the index
+    pub fn search_by_account_hits(&self, query: &str, account_id: &str, limit: usize) -> Vec<SearchHit<'_>> {
+        query::account_hits(self, query, account_id, limit, |_| true)
     }
-}
-
-impl Default for SearchIndex {
-    fn default() -> Self {
-        SearchIndex::new()
-    }
-}
-
-/// Persistent search index that saves to disk
-pub struct PersistentSearchIndex {
-    index: SearchIndex,
-    path: PathBuf,
-}
-
-impl PersistentSearchIndex {
-    /// Create or open a persistent index
-    pub fn new(path: PathBuf) -> Self {
-        let index = if path.exists() {
-            Self::load_from_disk(&path).unwrap_or_else(|_| SearchIndex::new())
-        } else {
-            SearchIndex::new()
-        };
-        
-        PersistentSearchIndex { index, path }
+    
+    /// Search for names within `max_distance` edits of the query (see query::fuzzy_hits)
+    pub fn search_fuzzy(&self, query: &str, max_distance: usize, limit: usize) -> Vec<SearchResult> {
+        query::to_results(self.search_fuzzy_hits(query, max_distance, limit))
     }
     
-    /// Save index to disk
-    fn save_to_disk(&self) -> Result<(), std::io::Error> {
-        // Create parent directories if needed
-        if let Some(parent) = self.path.parent() {
-            std::fs::create_dir_all(parent)?;
-        }
-        
-        let data = serde_json::to_string_pretty(&self.index.documents)?;
-        std::fs::write(&self.path, data)?;
-        
-        Ok(())
+    /// Top `limit` fuzzy matches, borrowed from the index
+    pub fn search_fuzzy_hits(&self, query: &str, max_distance: usize, limit: usize) -> Vec<SearchHit<'_>> {
+        query::fuzzy_hits(self, query, max_distance, limit, |_| true)
     }
     
-    /// Load index from disk
-    fn load_from_disk(path: &PathBuf) -> Result<SearchIndex, std::io::Error> {
-        let data = std::fs::read_to_string(path)?;
-        let documents: HashMap<String, SearchDocument> = serde_json::from_str(&data)?;
-        
-        let mut index = SearchIndex::new();
-        for (_, doc) in documents {
-            index.add_document(doc);
+    /// Get all documents for an account
+    pub fn get_by_account(&self, account_id: &str) -> Vec<DocumentRef<'_>> {
+        let ids = self
+            .store
+            .account_key(account_id)
+            .and_then(|account| self.account_index.get(&account));
+        match ids {
+            Some(ids) => ids.iter().filter_map(|&id| self.store.get(id)).collect(),
+            None => Vec::new(),
         }
-        
-        Ok(index)
     }
-    
-    /// Add document and persist
-    pub fn add_document(&mut self, doc: SearchDocument) {
-        self.index.add_document(doc);
-        let _ = self.save_to_disk();
+}
+
+impl DocSource for SearchIndex {
+    fn doc(&self, id: DocId) -> Option<DocumentRef<'_>> {
+        self.store.get(id)
     }
     
-    /// Remove document and persist
-    pub fn remove_document(&mut self, node_id: &str) -> Option<SearchDocument> {
-        let result = self.index.remove_document(node_id);
-        let _ = self.save_to_disk();
-        result
+    fn all_ids(&self) -> Box<dyn Iterator<Item = DocId> + '_> {
+        Box::new(self.store.iter().map(|(id, _)| id))
     }
     
-    /// Clear index and persist
-    pub fn clear(&mut self) {
-        self.index.clear();
-        let _ = self.save_to_disk();
+    fn trigram_postings(&self, gram: Trigram) -> Postings<'_> {
+        self.trigram_index.get(&gram).map_or(Postings::EMPTY, |ids| Postings::Ids(ids))
     }
     
-    /// Get underlying index reference
-    pub fn inner(&self) -> &SearchIndex {
-        &self.index
+    fn word_postings(&self, word: &str) -> Postings<'_> {
+        self.name_index.get(word).map_or(Postings::EMPTY, |ids| Postings::Ids(ids))
     }
     
-    /// Get mutable index reference
-    pub fn inner_mut(&mut self) -> &mut SearchIndex {
-        &mut self.index
+    fn account_postings(&self, account_id: &str) -> Postings<'_> {
+        self.store
+            .account_key(account_id)
+            .and_then(|account| self.account_index.get(&account))
+            .map_or(Postings::EMPTY, |ids| Postings::Ids(ids))
+    }
+}
+
+impl Default for SearchIndex {
+    fn default() -> Self {
+        SearchIndex::new()
     }
 }
 
@@ -380,6 +351,102 @@ mod tests {
         assert_eq!(results.len(), 0);
     }
     
+    #[test]
+    fn test_search_index_trigram_candidates() {
+        let mut index = SearchIndex::new();
+        let names = ["Quarterly Report.pdf", "report-draft.docx", "Holiday Photos", "Budget 2024.xlsx"];
+        for (i, name) in names.iter().enumerate() {
+            index.add_document(SearchDocument {
+                node_id: i.to_string(),
+                account_id: if i % 2 == 0 { "acc1" } else { "acc2" }.to_string(),
+                provider: "gdrive".to_string(),
+                email: "test@example.com".to_string(),
+                name: name.to_string(),
+                is_folder: false,
+                parent_id: None,
+            });
+        }
+        
+        let mut ids: Vec<String> = index.search_exact("report", 10).into_iter().map(|r| r.node_id).collect();
+        ids.sort();
+        assert_eq!(ids, vec!["0", "1"]);
+        assert!(index.search_exact("xyz", 10).is_empty());
+        assert_eq!(index.search_exact("o", 10).len(), 3);
+        assert_eq!(index.search_by_account("report", "acc2", 10).len(), 1);
+        
+        // One transposition away from "report"
+        let results = index.search_fuzzy("reprot", 2, 10);
+        assert_eq!(results.len(), 2);
+        assert!(index.search_fuzzy("reprot", 1, 10).is_empty());
+        
+        // Removed documents drop out of the trigram postings
+        index.remove_document("1");
+        assert_eq!(index.search_exact("report", 10).len(), 1);
+        assert_eq!(index.search_fuzzy("budgte", 2, 10)[0].node_id, "3");
+    }
+    
+    #[test]
+    fn test_search_index_prefix() {
+        let mut index = SearchIndex::new();
+        let names = ["Document.pdf", "my docs", "my doc drafts", "Old document"];
+        for (i, name) in names.iter().enumerate() {
+            index.add_document(SearchDocument {
+                node_id: i.to_string(),
+                account_id: "acc1".to_string(),
+                provider: "gdrive".to_string(),
+                email: "test@example.com".to_string(),
+                name: name.to_string(),
+                is_folder: false,
+                parent_id: None,
+            });
+        }
+        
+        let ids = |query: &str| {
+            let mut ids: Vec<String> = index.search_prefix(query, 10).into_iter().map(|r| r.node_id).collect();
+            ids.sort();
+            ids
+        };
+        // Partial words match, infix matches do not
+        assert_eq!(ids("doc"), vec!["0"]);
+        assert_eq!(ids("do"), vec!["0"]);
+        // Multi-word queries match each name once
+        assert_eq!(ids("my doc"), vec!["1", "2"]);
+        assert_eq!(ids("my doc d"), vec!["2"]);
+        assert!(ids("document.pdf x").is_empty());
+    }
+    
+    #[test]
+    fn test_search_index_top_k() {
+        let mut index = SearchIndex::new();
+        for i in 0..200 {
+            // Exact, prefix and infix matches for "report"
+            let name = match i % 3 {
+                0 => "report".to_string(),
+                1 => format!("report {}", i),
+                _ => format!("old {} report", i),
+            };
+            index.add_document(SearchDocument {
+                node_id: i.to_string(),
+                account_id: "acc1".to_string(),
+                provider: "gdrive".to_string(),
+                email: "test@example.com".to_string(),
+                name,
+                is_folder: false,
+                parent_id: None,
+            });
+        }
+        
+        let hits = index.search_exact_hits("report", 80);
+        assert_eq!(hits.len(), 80);
+        assert!(hits.windows(2).all(|w| w[0].score >= w[1].score));
+        // All 67 exact matches outrank the prefix matches that fill the rest
+        assert_eq!(hits.iter().filter(|h| h.score == 1.0).count(), 67);
+        assert!(hits[67..].iter().all(|h| h.score == 0.9));
+        
+        assert!(index.search_exact("report", 0).is_empty());
+        assert_eq!(index.search_by_account("report", "acc1", 5).len(), 5);
+    }
+    
     #[test]
     fn test_search_index_remove() {
         let mut index = SearchIndex::new();
@@ -4,6 +4,10 @@
 
 mod fuzzy;
 mod index;
+mod store;
+mod query;
+mod persistent;
+mod concurrent;
 mod path;
 mod batch;
 mod incremental;
@@ -13,6 +17,10 @@ mod bridge;
 
 pub use fuzzy::*;
 pub use index::*;
+pub use store::*;
+pub use query::SearchHit;
+pub use persistent::*;
+pub use concurrent::*;
 pub use path::*;
 pub use batch::*;
 pub use incremental::*;
@@ -116,7 +116,7 @@ mod tests {
     
     #[test]
     fn test_path_builder_single_node() {
-        let builder = PathBuilder::new();
+        let mut builder = PathBuilder::new();
         builder.add_node("node1".to_string(), "Single Node".to_string(), None);
         
         let path = builder.build_path("node1");
@@ -0,0 +1,1021 @@
+// Persistent search index for CloudNexus
+// A versioned binary index file that is memory-mapped and queried in place, plus an
+// append-only delta log for updates made since the file was written.
+//
+// Opening an index maps the file and replays the (small) delta log into an in-memory
+// overlay; nothing is parsed or rebuilt per document. Queries run against the mapped
+// base and the overlay and merge the results. Once the log grows past a threshold, the
+// merged view is written out as a new index file and the log is reset.
+//
+// Index file layout (integers little-endian):
+//
+//   header:  magic u32 "CNSI" | version u32 | doc_count u32 | reserved u32
+//            | SECTION_COUNT x (offset u64, length u64)
+//   strings:          UTF-8 string pool
+//   docs:             doc_count x 48-byte records (string refs are offset u32 + len u32):
+//                     node_id | name | name_lower | parent_id (offset u32::MAX = none)
+//                     | account u32 | provider u32 | email u32 | flags u32 (bit 0 = folder)
+//   accounts, providers, emails:  interned values as string refs
+//   node_order:       doc ids sorted by node_id (binary search by id)
+//   trigrams:         (trigram u64, postings offset u32, postings len u32), sorted
+//   words:            (word ref, postings offset u32, postings len u32), sorted by word
+//   account_postings: per account: (postings offset u32, postings len u32)
+//   postings:         u32 doc ids; each list sorted
+//
+// Delta log: magic u32 "CNSL" | version u32, then records of
+//   op u8 (1 = upsert, 2 = remove) | payload_len u32 | payload | FNV-1a u32 of op + payload
+// A torn record at the tail (crash mid-append) is dropped on replay.
+
+use std::collections::{HashMap, HashSet};
+use std::fs::{self, File, OpenOptions};
+use std::io::{self, BufWriter, Read, Seek, SeekFrom, Write};
+use std::path::{Path, PathBuf};
+
+use memmap2::Mmap;
+
+use super::index::{SearchDocument, SearchIndex, SearchResult};
+use super::query::{self, trigrams, DocSource, Postings, SearchHit, Trigram};
+use super::store::{DocId, DocumentRef};
+
+const INDEX_MAGIC: u32 = 0x49534E43; // "CNSI"
+const INDEX_VERSION: u32 = 1;
+const LOG_MAGIC: u32 = 0x4C534E43; // "CNSL"
+const LOG_VERSION: u32 = 1;
+
+const SECTION_STRINGS: usize = 0;
+const SECTION_DOCS: usize = 1;
+const SECTION_ACCOUNTS: usize = 2;
+const SECTION_PROVIDERS: usize = 3;
+const SECTION_EMAILS: usize = 4;
+const SECTION_NODE_ORDER: usize = 5;
+const SECTION_TRIGRAMS: usize = 6;
+const SECTION_WORDS: usize = 7;
+const SECTION_ACCOUNT_POSTINGS: usize = 8;
+const SECTION_POSTINGS: usize = 9;
+const SECTION_COUNT: usize = 10;
+
+const HEADER_SIZE: usize = 16 + SECTION_COUNT * 16;
+const DOC_RECORD_SIZE: usize = 48;
+const TRIGRAM_ENTRY_SIZE: usize = 16;
+const WORD_ENTRY_SIZE: usize = 16;
+const NO_STRING: u32 = u32::MAX;
+
+const LOG_HEADER_SIZE: u64 = 8;
+const LOG_OP_UPSERT: u8 = 1;
+const LOG_OP_REMOVE: u8 = 2;
+
+/// Compact once the log holds this many records, or 1/8 of the base size if larger
+const MIN_COMPACT_ENTRIES: usize = 4096;
+
+fn read_u32(bytes: &[u8], at: usize) -> u32 {
+    u32::from_le_bytes([bytes[at], bytes[at + 1], bytes[at + 2], bytes[at + 3]])
+}
+
+fn read_u64(bytes: &[u8], at: usize) -> u64 {
+    let mut b = [0u8; 8];
+    b.copy_from_slice(&bytes[at..at + 8]);
+    u64::from_le_bytes(b)
+}
+
+fn invalid(message: &str) -> io::Error {
+    io::Error::new(io::ErrorKind::InvalidData, message.to_string())
+}
+
+fn fnv1a(op: u8, payload: &[u8]) -> u32 {
+    let mut hash: u32 = 0x811C9DC5;
+    for &b in std::iter::once(&op).chain(payload) {
+        hash ^= b as u32;
+        hash = hash.wrapping_mul(0x01000193);
+    }
+    hash
+}
+
+/// Path of a sibling file (index path + suffix)
+fn with_suffix(path: &Path, suffix: &str) -> PathBuf {
+    let mut name = path.as_os_str().to_os_string();
+    name.push(suffix);
+    PathBuf::from(name)
+}
+
+// ============================================================================
+// Index file writer
+// ============================================================================
+
+/// String pool under construction
+struct PoolWriter {
+    bytes: Vec<u8>,
+}
+
+impl PoolWriter {
+    fn add(&mut self, value: &str) -> io::Result<(u32, u32)> {
+        let offset = self.bytes.len();
+        if offset + value.len() >= NO_STRING as usize {
+            return Err(invalid("search index string pool exceeds 4 GB"));
+        }
+        self.bytes.extend_from_slice(value.as_bytes());
+        Ok((offset as u32, value.len() as u32))
+    }
+}
+
+/// Interned value table under construction
+#[derive(Default)]
+struct ValueTable<'a> {
+    ids: HashMap<&'a str, u32>,
+    refs: Vec<(u32, u32)>,
+}
+
+impl<'a> ValueTable<'a> {
+    fn intern(&mut self, value: &'a str, pool: &mut PoolWriter) -> io::Result<u32> {
+        if let Some(&id) = self.ids.get(value) {
+            return Ok(id);
+        }
+        let id = self.refs.len() as u32;
+        self.refs.push(pool.add(value)?);
+        self.ids.insert(value, id);
+        Ok(id)
+    }
+}
+
+/// Write `docs` as an index file at `path` (not atomic; callers write to a temp path)
+fn write_index_file<'a>(path: &Path, docs: impl Iterator<Item = DocumentRef<'a>>) -> io::Result<()> {
+    let mut pool = PoolWriter { bytes: Vec::new() };
+    let mut accounts = ValueTable::default();
+    let mut providers = ValueTable::default();
+    let mut emails = ValueTable::default();
+    let mut records: Vec<u8> = Vec::new();
+    let mut node_order: Vec<(&'a str, DocId)> = Vec::new();
+    let mut word_postings: HashMap<&'a str, Vec<DocId>> = HashMap::new();
+    let mut trigram_postings: HashMap<Trigram, Vec<DocId>> = HashMap::new();
+    let mut account_postings: Vec<Vec<DocId>> = Vec::new();
+
+    for (i, doc) in docs.enumerate() {
+        let id = i as DocId;
+        let node_id = pool.add(doc.node_id)?;
+        let name = pool.add(doc.name)?;
+        let name_lower = if doc.name_lower() == doc.name { name } else { pool.add(doc.name_lower())? };
+        let parent = match doc.parent_id {
+            Some(parent_id) => pool.add(parent_id)?,
+            None => (NO_STRING, 0),
+        };
+        let account = accounts.intern(doc.account_id, &mut pool)?;
+        let provider = providers.intern(doc.provider, &mut pool)?;
+        let email = emails.intern(doc.email, &mut pool)?;
+
+        for value in [node_id.0, node_id.1, name.0, name.1, name_lower.0, name_lower.1, parent.0, parent.1,
+                      account, provider, email, doc.is_folder as u32] {
+            records.extend_from_slice(&value.to_le_bytes());
+        }
+
+        node_order.push((doc.node_id, id));
+        for word in doc.name_lower().split_whitespace() {
+            let ids = word_postings.entry(word).or_insert_with(Vec::new);
+            // Ids arrive in increasing order, so lists stay sorted
+            if ids.last() != Some(&id) {
+                ids.push(id);
+            }
+        }
+        for gram in trigrams(doc.name_lower()) {
+            trigram_postings.entry(gram).or_insert_with(Vec::new).push(id);
+        }
+        if account_postings.len() <= account as usize {
+            account_postings.resize_with(account as usize + 1, Vec::new);
+        }
+        account_postings[account as usize].push(id);
+    }
+
+    let doc_count = node_order.len();
+    node_order.sort_unstable_by(|a, b| a.0.as_bytes().cmp(b.0.as_bytes()));
+
+    let mut postings: Vec<u8> = Vec::new();
+    let mut append_postings = |ids: &[DocId]| -> io::Result<(u32, u32)> {
+        let offset = postings.len() / 4;
+        if offset + ids.len() > u32::MAX as usize {
+            return Err(invalid("search index postings exceed 4G entries"));
+        }
+        for id in ids {
+            postings.extend_from_slice(&id.to_le_bytes());
+        }
+        Ok((offset as u32, ids.len() as u32))
+    };
+
+    let mut grams: Vec<(Trigram, Vec<DocId>)> = trigram_postings.into_iter().collect();
+    grams.sort_unstable_by_key(|(gram, _)| *gram);
+    let mut trigram_table: Vec<u8> = Vec::with_capacity(grams.len() * TRIGRAM_ENTRY_SIZE);
+    for (gram, ids) in &grams {
+        let (offset, len) = append_postings(ids)?;
+        trigram_table.extend_from_slice(&gram.to_le_bytes());
+        trigram_table.extend_from_slice(&offset.to_le_bytes());
+        trigram_table.extend_from_slice(&len.to_le_bytes());
+    }
+
+    let mut words: Vec<(&str, Vec<DocId>)> = word_postings.into_iter().collect();
+    words.sort_unstable_by(|a, b| a.0.as_bytes().cmp(b.0.as_bytes()));
+    let mut word_table: Vec<u8> = Vec::with_capacity(words.len() * WORD_ENTRY_SIZE);
+    for (word, ids) in &words {
+        let (word_offset, word_len) = pool.add(word)?;
+        let (offset, len) = append_postings(ids)?;
+        for value in [word_offset, word_len, offset, len] {
+            word_table.extend_from_slice(&value.to_le_bytes());
+        }
+    }
+
+    let mut account_table: Vec<u8> = Vec::new();
+    for ids in &account_postings {
+        let (offset, len) = append_postings(ids)?;
+        account_table.extend_from_slice(&offset.to_le_bytes());
+        account_table.extend_from_slice(&len.to_le_bytes());
+    }
+
+    let value_table = |table: &ValueTable| -> Vec<u8> {
+        table.refs.iter().flat_map(|(offset, len)| [offset.to_le_bytes(), len.to_le_bytes()]).flatten().collect()
+    };
+    let order_bytes: Vec<u8> = node_order.iter().flat_map(|(_, id)| id.to_le_bytes()).collect();
+
+    let sections: [Vec<u8>; SECTION_COUNT] = [
+        pool.bytes,
+        records,
+        value_table(&accounts),
+        value_table(&providers),
+        value_table(&emails),
+        order_bytes,
+        trigram_table,
+        word_table,
+        account_table,
+        postings,
+    ];
+
+    let mut out = BufWriter::new(File::create(path)?);
+    out.write_all(&INDEX_MAGIC.to_le_bytes())?;
+    out.write_all(&INDEX_VERSION.to_le_bytes())?;
+    out.write_all(&(doc_count as u32).to_le_bytes())?;
+    out.write_all(&0u32.to_le_bytes())?;
+    let mut offset = HEADER_SIZE as u64;
+    for section in &sections {
+        out.write_all(&offset.to_le_bytes())?;
+        out.write_all(&(section.len() as u64).to_le_bytes())?;
+        offset += section.len() as u64;
+    }
+    for section in &sections {
+        out.write_all(section)?;
+    }
+    let file = out.into_inner().map_err(|e| e.into_error())?;
+    file.sync_all()
+}
+
+// ============================================================================
+// Memory-mapped index file
+// ============================================================================
+
+/// A read-only index file mapped into memory and queried in place
+pub struct MappedIndex {
+    map: Mmap,
+    doc_count: usize,
+    sections: [(usize, usize); SECTION_COUNT],
+}
+
+impl MappedIndex {
+    /// Map and validate an index file
+    pub fn open(path: &Path) -> io::Result<Self> {
+        let file = File::open(path)?;
+        if file.metadata()?.len() < HEADER_SIZE as u64 {
+            return Err(invalid("search index file is truncated"));
+        }
+        // The file is only replaced by rename, never modified in place
+        let map = unsafe { Mmap::map(&file)? };
+        Self::from_map(map)
+    }
+
+    fn from_map(map: Mmap) -> io::Result<Self> {
+        let bytes: &[u8] = &map;
+        if bytes.len() < HEADER_SIZE || read_u32(bytes, 0) != INDEX_MAGIC {
+            return Err(invalid("not a search index file"));
+        }
+        if read_u32(bytes, 4) != INDEX_VERSION {
+            return Err(invalid("unsupported search index version"));
+        }
+        let doc_count = read_u32(bytes, 8) as usize;
+
+        let mut sections = [(0usize, 0usize); SECTION_COUNT];
+        for (i, section) in sections.iter_mut().enumerate() {
+            let offset = read_u64(bytes, 16 + i * 16);
+            let len = read_u64(bytes, 24 + i * 16);
+            match offset.checked_add(len) {
+                Some(end) if end <= bytes.len() as u64 => *section = (offset as usize, len as usize),
+                _ => return Err(invalid("search index section out of bounds")),
+            }
+        }
+
+        let index = MappedIndex { map, doc_count, sections };
+        let record_sizes = [
+            (SECTION_DOCS, DOC_RECORD_SIZE),
+            (SECTION_ACCOUNTS, 8),
+            (SECTION_PROVIDERS, 8),
+            (SECTION_EMAILS, 8),
+            (SECTION_NODE_ORDER, 4),
+            (SECTION_TRIGRAMS, TRIGRAM_ENTRY_SIZE),
+            (SECTION_WORDS, WORD_ENTRY_SIZE),
+            (SECTION_ACCOUNT_POSTINGS, 8),
+            (SECTION_POSTINGS, 4),
+        ];
+        for (section, size) in record_sizes {
+            if index.section(section).len() % size != 0 {
+                return Err(invalid("search index section has a partial record"));
+            }
+        }
+        if index.section(SECTION_DOCS).len() != doc_count * DOC_RECORD_SIZE
+            || index.section(SECTION_NODE_ORDER).len() != doc_count * 4
+        {
+            return Err(invalid("search index document count mismatch"));
+        }
+        Ok(index)
+    }
+
+    fn section(&self, section: usize) -> &[u8] {
+        let (offset, len) = self.sections[section];
+        &self.map[offset..offset + len]
+    }
+
+    /// String from the pool; malformed references read as ""
+    fn string(&self, offset: u32, len: u32) -> &str {
+        let pool = self.section(SECTION_STRINGS);
+        pool.get(offset as usize..offset as usize + len as usize)
+            .and_then(|bytes| std::str::from_utf8(bytes).ok())
+            .unwrap_or("")
+    }
+
+    fn value(&self, section: usize, id: u32) -> &str {
+        let table = self.section(section);
+        let at = id as usize * 8;
+        if at + 8 > table.len() {
+            return "";
+        }
+        self.string(read_u32(table, at), read_u32(table, at + 4))
+    }
+
+    /// Posting list stored at (offset, len) in the postings section
+    fn postings(&self, offset: u32, len: u32) -> Postings<'_> {
+        let all = self.section(SECTION_POSTINGS);
+        let start = offset as usize * 4;
+        match all.get(start..start + len as usize * 4) {
+            Some(bytes) => Postings::Packed(bytes),
+            None => Postings::EMPTY,
+        }
+    }
+
+    pub fn len(&self) -> usize {
+        self.doc_count
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.doc_count == 0
+    }
+
+    /// Id of the document with `node_id`
+    pub fn find(&self, node_id: &str) -> Option<DocId> {
+        let order = self.section(SECTION_NODE_ORDER);
+        let (mut low, mut high) = (0usize, self.doc_count);
+        while low < high {
+            let mid = (low + high) / 2;
+            let id = read_u32(order, mid * 4);
+            let candidate = self.doc(id)?.node_id;
+            match candidate.as_bytes().cmp(node_id.as_bytes()) {
+                std::cmp::Ordering::Less => low = mid + 1,
+                std::cmp::Ordering::Greater => high = mid,
+                std::cmp::Ordering::Equal => return Some(id),
+            }
+        }
+        None
+    }
+
+    pub fn get(&self, node_id: &str) -> Option<DocumentRef<'_>> {
+        self.doc(self.find(node_id)?)
+    }
+
+    pub fn documents(&self) -> impl Iterator<Item = DocumentRef<'_>> + '_ {
+        (0..self.doc_count as DocId).filter_map(move |id| self.doc(id))
+    }
+}
+
+impl DocSource for MappedIndex {
+    fn doc(&self, id: DocId) -> Option<DocumentRef<'_>> {
+        if id as usize >= self.doc_count {
+            return None;
+        }
+        let docs = self.section(SECTION_DOCS);
+        let at = id as usize * DOC_RECORD_SIZE;
+        let field = |i: usize| read_u32(docs, at + i * 4);
+
+        let name = self.string(field(2), field(3));
+        let parent_id = if field(6) == NO_STRING { None } else { Some(self.string(field(6), field(7))) };
+        Some(DocumentRef::from_parts(
+            self.string(field(0), field(1)),
+            self.value(SECTION_ACCOUNTS, field(8)),
+            self.value(SECTION_PROVIDERS, field(9)),
+            self.value(SECTION_EMAILS, field(10)),
+            name,
+            self.string(field(4), field(5)),
+            field(11) & 1 != 0,
+            parent_id,
+        ))
+    }
+
+    fn all_ids(&self) -> Box<dyn Iterator<Item = DocId> + '_> {
+        Box::new(0..self.doc_count as DocId)
+    }
+
+    fn trigram_postings(&self, gram: Trigram) -> Postings<'_> {
+        let table = self.section(SECTION_TRIGRAMS);
+        let (mut low, mut high) = (0usize, table.len() / TRIGRAM_ENTRY_SIZE);
+        while low < high {
+            let mid = (low + high) / 2;
+            let at = mid * TRIGRAM_ENTRY_SIZE;
+            match read_u64(table, at).cmp(&gram) {
+                std::cmp::Ordering::Less => low = mid + 1,
+                std::cmp::Ordering::Greater => high = mid,
+                std::cmp::Ordering::Equal => return self.postings(read_u32(table, at + 8), read_u32(table, at + 12)),
+            }
+        }
+        Postings::EMPTY
+    }
+
+    fn word_postings(&self, word: &str) -> Postings<'_> {
+        let table = self.section(SECTION_WORDS);
+        let (mut low, mut high) = (0usize, table.len() / WORD_ENTRY_SIZE);
+        while low < high {
+            let mid = (low + high) / 2;
+            let at = mid * WORD_ENTRY_SIZE;
+            let candidate = self.string(read_u32(table, at), read_u32(table, at + 4));
+            match candidate.as_bytes().cmp(word.as_bytes()) {
+                std::cmp::Ordering::Less => low = mid + 1,
+                std::cmp::Ordering::Greater => high = mid,
+                std::cmp::Ordering::Equal => return self.postings(read_u32(table, at + 8), read_u32(table, at + 12)),
+            }
+        }
+        Postings::EMPTY
+    }
+
+    fn account_postings(&self, account_id: &str) -> Postings<'_> {
+        // Few distinct accounts: a linear scan of the value table is fine
+        let count = self.section(SECTION_ACCOUNTS).len() / 8;
+        let table = self.section(SECTION_ACCOUNT_POSTINGS);
+        for account in 0..count as u32 {
+            if self.value(SECTION_ACCOUNTS, account) == account_id {
+                let at = account as usize * 8;
+                if at + 8 <= table.len() {
+                    return self.postings(read_u32(table, at), read_u32(table, at + 4));
+                }
+            }
+        }
+        Postings::EMPTY
+    }
+}
+
+// ============================================================================
+// Delta log
+// ============================================================================
+
+/// One logged update
+#[derive(Debug, Clone, PartialEq)]
+enum LogRecord {
+    Upsert(SearchDocument),
+    Remove(String),
+}
+
+impl LogRecord {
+    fn encode(&self) -> (u8, Vec<u8>) {
+        fn put_str(out: &mut Vec<u8>, s: &str) {
+            out.extend_from_slice(&(s.len() as u32).to_le_bytes());
+            out.extend_from_slice(s.as_bytes());
+        }
+
+        let mut payload = Vec::new();
+        match self {
+            LogRecord::Upsert(doc) => {
+                for field in [&doc.node_id, &doc.account_id, &doc.provider, &doc.email, &doc.name] {
+                    put_str(&mut payload, field);
+                }
+                payload.push(doc.is_folder as u8);
+                match &doc.parent_id {
+                    Some(parent_id) => {
+                        payload.push(1);
+                        put_str(&mut payload, parent_id);
+                    }
+                    None => payload.push(0),
+                }
+                (LOG_OP_UPSERT, payload)
+            }
+            LogRecord::Remove(node_id) => {
+                put_str(&mut payload, node_id);
+                (LOG_OP_REMOVE, payload)
+            }
+        }
+    }
+
+    fn decode(op: u8, payload: &[u8]) -> Option<Self> {
+        let mut reader = PayloadReader { payload, pos: 0 };
+        match op {
+            LOG_OP_UPSERT => {
+                let node_id = reader.string()?;
+                let account_id = reader.string()?;
+                let provider = reader.string()?;
+                let email = reader.string()?;
+                let name = reader.string()?;
+                let is_folder = reader.byte()? != 0;
+                let parent_id = if reader.byte()? != 0 { Some(reader.string()?) } else { None };
+                Some(LogRecord::Upsert(SearchDocument {
+                    node_id,
+                    account_id,
+                    provider,
+                    email,
+                    name,
+                    is_folder,
+                    parent_id,
+                }))
+            }
+            LOG_OP_REMOVE => Some(LogRecord::Remove(reader.string()?)),
+            _ => None,
+        }
+    }
+}
+
+/// Bounds-checked reader over a log record payload
+struct PayloadReader<'a> {
+    payload: &'a [u8],
+    pos: usize,
+}
+
+impl PayloadReader<'_> {
+    fn byte(&mut self) -> Option<u8> {
+        let value = *self.payload.get(self.pos)?;
+        self.pos += 1;
+        Some(value)
+    }
+
+    fn string(&mut self) -> Option<String> {
+        let len_bytes = self.payload.get(self.pos..self.pos + 4)?;
+        let len = read_u32(len_bytes, 0) as usize;
+        let bytes = self.payload.get(self.pos + 4..self.pos + 4 + len)?;
+        self.pos += 4 + len;
+        Some(std::str::from_utf8(bytes).ok()?.to_string())
+    }
+}
+
+/// Append-only log of updates since the index file was written
+struct DeltaLog {
+    file: File,
+    entries: usize,
+}
+
+impl DeltaLog {
+    /// Open (or create) the log and return the records it holds
+    fn open(path: &Path) -> io::Result<(DeltaLog, Vec<LogRecord>)> {
+        let mut file = OpenOptions::new().read(true).write(true).create(true).open(path)?;
+        let mut data = Vec::new();
+        file.read_to_end(&mut data)?;
+
+        let header_ok = data.len() >= LOG_HEADER_SIZE as usize
+            && read_u32(&data, 0) == LOG_MAGIC
+            && read_u32(&data, 4) == LOG_VERSION;
+        let mut records = Vec::new();
+        let mut valid_len = LOG_HEADER_SIZE as usize;
+
+        if header_ok {
+            let mut pos = valid_len;
+            while pos + 5 <= data.len() {
+                let op = data[pos];
+                let len = read_u32(&data, pos + 1) as usize;
+                let end = pos + 5 + len + 4;
+                if end > data.len() {
+                    break;
+                }
+                let payload = &data[pos + 5..pos + 5 + len];
+                if read_u32(&data, pos + 5 + len) != fnv1a(op, payload) {
+                    break;
+                }
+                match LogRecord::decode(op, payload) {
+                    Some(record) => records.push(record),
+                    None => break,
+                }
+                pos = end;
+                valid_len = end;
+            }
+        }
+
+        if !header_ok || valid_len < data.len() {
+            // New log, foreign file or torn tail: keep only the valid prefix
+            if !header_ok {
+                file.set_len(0)?;
+                file.seek(SeekFrom::Start(0))?;
+                file.write_all(&LOG_MAGIC.to_le_bytes())?;
+                file.write_all(&LOG_VERSION.to_le_bytes())?;
+            } else {
+                file.set_len(valid_len as u64)?;
+            }
+        }
+        file.seek(SeekFrom::End(0))?;
+
+        let entries = records.len();
+        Ok((DeltaLog { file, entries }, records))
+    }
+
+    fn append(&mut self, record: &LogRecord) -> io::Result<()> {
+        let (op, payload) = record.encode();
+        let mut buf = Vec::with_capacity(payload.len() + 9);
+        buf.push(op);
+        buf.extend_from_slice(&(payload.len() as u32).to_le_bytes());
+        buf.extend_from_slice(&payload);
+        buf.extend_from_slice(&fnv1a(op, &payload).to_le_bytes());
+        self.file.write_all(&buf)?;
+        self.entries += 1;
+        Ok(())
+    }
+
+    /// Drop every record (after they were folded into a new index file)
+    fn reset(&mut self) -> io::Result<()> {
+        self.file.set_len(LOG_HEADER_SIZE)?;
+        self.file.seek(SeekFrom::End(0))?;
+        self.entries = 0;
+        Ok(())
+    }
+
+    fn sync(&self) -> io::Result<()> {
+        self.file.sync_data()
+    }
+}
+
+// ============================================================================
+// Persistent index
+// ============================================================================
+
+/// Persistent search index: mapped base file + delta log + in-memory overlay
+pub struct PersistentSearchIndex {
+    path: PathBuf,
+    /// Index file as of the last compaction
+    base: Option<MappedIndex>,
+    /// Documents added or replaced since then
+    overlay: SearchIndex,
+    /// Base documents that were removed or replaced by an overlay document
+    hidden: HashSet<Box<str>>,
+    log: DeltaLog,
+}
+
+impl PersistentSearchIndex {
+    /// Open a persistent index, migrating a legacy JSON index file if present
+    pub fn open(path: PathBuf) -> io::Result<Self> {
+        if let Some(parent) = path.parent() {
+            fs::create_dir_all(parent)?;
+        }
+
+        let mut legacy: Option<Vec<SearchDocument>> = None;
+        let base = if path.exists() {
+            match MappedIndex::open(&path) {
+                Ok(base) => Some(base),
+                Err(e) => {
+                    legacy = Some(Self::load_legacy_json(&path).map_err(|_| e)?);
+                    None
+                }
+            }
+        } else {
+            None
+        };
+
+        let (log, records) = DeltaLog::open(&with_suffix(&path, ".log"))?;
+        let mut index = PersistentSearchIndex {
+            path,
+            base,
+            overlay: SearchIndex::new(),
+            hidden: HashSet::new(),
+            log,
+        };
+
+        for record in records {
+            index.apply(record);
+        }
+        if let Some(documents) = legacy {
+            for doc in documents {
+                index.apply(LogRecord::Upsert(doc));
+            }
+            index.compact()?;
+        }
+
+        Ok(index)
+    }
+
+    /// Documents of an index file written by the JSON format used before the binary one
+    fn load_legacy_json(path: &Path) -> io::Result<Vec<SearchDocument>> {
+        let data = fs::read_to_string(path)?;
+        let documents: HashMap<String, SearchDocument> = serde_json::from_str(&data)?;
+        Ok(documents.into_values().collect())
+    }
+
+    fn base_contains(&self, node_id: &str) -> bool {
+        self.base.as_ref().map_or(false, |base| base.find(node_id).is_some())
+    }
+
+    /// Apply an update to the in-memory state (no logging)
+    fn apply(&mut self, record: LogRecord) -> Option<SearchDocument> {
+        match record {
+            LogRecord::Upsert(doc) => {
+                if self.base_contains(&doc.node_id) {
+                    self.hidden.insert(doc.node_id.as_str().into());
+                }
+                self.overlay.add_document(doc);
+                None
+            }
+            LogRecord::Remove(node_id) => {
+                let removed = self.overlay.remove_document(&node_id);
+                let from_base = if self.hidden.contains(node_id.as_str()) {
+                    None
+                } else {
+                    self.base.as_ref().and_then(|base| base.get(&node_id)).map(|doc| doc.to_document())
+                };
+                if from_base.is_some() {
+                    self.hidden.insert(node_id.as_str().into());
+                }
+                removed.or(from_base)
+            }
+        }
+    }
+
+    /// Log an update, then apply it
+    ///
+    /// If the record cannot be written nothing changes. An error after that comes from the
+    /// compaction the update triggered: the update itself is logged and applied.
+    fn log_and_apply(&mut self, record: LogRecord) -> io::Result<Option<SearchDocument>> {
+        self.log.append(&record)?;
+        let result = self.apply(record);
+        self.maybe_compact()?;
+        Ok(result)
+    }
+
+    fn maybe_compact(&mut self) -> io::Result<()> {
+        let base_len = self.base.as_ref().map_or(0, |base| base.len());
+        if self.log.entries >= MIN_COMPACT_ENTRIES.max(base_len / 8) {
+            self.compact()?;
+        }
+        Ok(())
+    }
+
+    /// Add (or replace) a document and log it
+    pub fn add_document(&mut self, doc: SearchDocument) -> io::Result<()> {
+        self.log_and_apply(LogRecord::Upsert(doc)).map(|_| ())
+    }
+
+    /// Remove a document and log it
+    pub fn remove_document(&mut self, node_id: &str) -> io::Result<Option<SearchDocument>> {
+        self.log_and_apply(LogRecord::Remove(node_id.to_string()))
+    }
+
+    /// Remove every document and rewrite the index file
+    pub fn clear(&mut self) -> io::Result<()> {
+        self.replace_base(false)
+    }
+
+    /// Write the merged view as a new index file and reset the delta log
+    pub fn compact(&mut self) -> io::Result<()> {
+        self.replace_base(true)
+    }
+
+    /// Write a new index file (the merged view, or nothing) and switch to it
+    ///
+    /// The new file is mapped before anything is swapped, and on failure the current base,
+    /// overlay and log are left as they were.
+    fn replace_base(&mut self, keep_documents: bool) -> io::Result<()> {
+        let temp_path = with_suffix(&self.path, ".tmp");
+        let written = if keep_documents {
+            let hidden = &self.hidden;
+            let base_docs = self
+                .base
+                .iter()
+                .flat_map(|base| base.documents())
+                .filter(|doc| !hidden.contains(doc.node_id));
+            write_index_file(&temp_path, base_docs.chain(self.overlay.documents()))
+        } else {
+            write_index_file(&temp_path, std::iter::empty())
+        };
+        let new_base = match written.and_then(|_| MappedIndex::open(&temp_path)) {
+            Ok(new_base) => new_base,
+            Err(e) => {
+                let _ = fs::remove_file(&temp_path);
+                return Err(e);
+            }
+        };
+
+        // Windows cannot replace a mapped file: unmap the old base first and map it again
+        // if the rename fails. Elsewhere it stays mapped until the swap.
+        let had_base = self.base.is_some();
+        if cfg!(windows) {
+            self.base = None;
+        }
+        if let Err(e) = fs::rename(&temp_path, &self.path) {
+            drop(new_base);
+            let _ = fs::remove_file(&temp_path);
+            if had_base && self.base.is_none() {
+                self.base = MappedIndex::open(&self.path).ok();
+            }
+            return Err(e);
+        }
+
+        self.base = Some(new_base);
+        self.overlay.clear();
+        self.hidden.clear();
+        self.log.reset()
+    }
+
+    /// Make logged updates durable
+    pub fn flush(&self) -> io::Result<()> {
+        self.log.sync()
+    }
+
+    /// Number of updates waiting in the delta log
+    pub fn pending_log_entries(&self) -> usize {
+        self.log.entries
+    }
+
+    pub fn len(&self) -> usize {
+        // Hidden documents are base documents, but never let a stale set underflow
+        (self.base.as_ref().map_or(0, |base| base.len()) + self.overlay.len()).saturating_sub(self.hidden.len())
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    pub fn get(&self, node_id: &str) -> Option<DocumentRef<'_>> {
+        if let Some(doc) = self.overlay.get(node_id) {
+            return Some(doc);
+        }
+        if self.hidden.contains(node_id) {
+            return None;
+        }
+        self.base.as_ref()?.get(node_id)
+    }
+
+    /// Run a query against base and overlay and merge the top `limit` hits
+    fn merged<'a, F>(&'a self, limit: usize, run: F) -> Vec<SearchHit<'a>>
+    where
+        F: Fn(&'a dyn DocSource, &dyn Fn(&DocumentRef<'a>) -> bool) -> Vec<SearchHit<'a>>,
+    {
+        let visible = |doc: &DocumentRef<'a>| !self.hidden.contains(doc.node_id);
+        let mut lists = vec![run(&self.overlay, &|_| true)];
+        if let Some(base) = &self.base {
+            lists.push(run(base, &visible));
+        }
+        query::merge_hits(lists, limit)
+    }
+
+    pub fn search_exact_hits(&self, query: &str, limit: usize) -> Vec<SearchHit<'_>> {
+        self.merged(limit, |source, keep| query::exact_hits(source, query, limit, keep))
+    }
+
+    pub fn search_prefix_hits(&self, query: &str, limit: usize) -> Vec<SearchHit<'_>> {
+        self.merged(limit, |source, keep| query::prefix_hits(source, query, limit, keep))
+    }
+
+    pub fn search_by_account_hits(&self, query: &str, account_id: &str, limit: usize) -> Vec<SearchHit<'_>> {
+        self.merged(limit, |source, keep| query::account_hits(source, query, account_id, limit, keep))
+    }
+
+    pub fn search_fuzzy_hits(&self, query: &str, max_distance: usize, limit: usize) -> Vec<SearchHit<'_>> {
+        self.merged(limit, |source, keep| query::fuzzy_hits(source, query, max_distance, limit, keep))
+    }
+
+    pub fn search_exact(&self, query: &str, limit: usize) -> Vec<SearchResult> {
+        query::to_results(self.search_exact_hits(query, limit))
+    }
+
+    pub fn search_by_account(&self, query: &str, account_id: &str, limit: usize) -> Vec<SearchResult> {
+        query::to_results(self.search_by_account_hits(query, account_id, limit))
+    }
+}
+
+impl Drop for PersistentSearchIndex {
+    fn drop(&mut self) {
+        let _ = self.flush();
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn doc(id: &str, name: &str, account: &str) -> SearchDocument {
+        SearchDocument {
+            node_id: id.to_string(),
+            account_id: account.to_string(),
+            provider: "gdrive".to_string(),
+            email: "test@example.com".to_string(),
+            name: name.to_string(),
+            is_folder: id.starts_with('f'),
+            parent_id: if id == "root" { None } else { Some("root".to_string()) },
+        }
+    }
+
+    fn test_path(name: &str) -> PathBuf {
+        let path = std::env::temp_dir().join(format!("cn_search_{}_{}.idx", name, std::process::id()));
+        let _ = fs::remove_file(&path);
+        let _ = fs::remove_file(with_suffix(&path, ".log"));
+        path
+    }
+
+    #[test]
+    fn test_mapped_index_roundtrip() {
+        let path = test_path("mapped");
+        let mut memory = SearchIndex::new();
+        memory.add_document(doc("root", "My Drive", "acc1"));
+        memory.add_document(doc("1", "Quarterly Report.pdf", "acc1"));
+        memory.add_document(doc("f2", "Reports", "acc2"));
+        memory.add_document(doc("3", "holiday photo.jpg", "acc2"));
+        write_index_file(&path, memory.documents()).unwrap();
+
+        let mapped = MappedIndex::open(&path).unwrap();
+        assert_eq!(mapped.len(), 4);
+        let folder = mapped.get("f2").unwrap();
+        assert_eq!((folder.name, folder.account_id, folder.is_folder), ("Reports", "acc2", true));
+        assert_eq!(mapped.get("root").unwrap().parent_id, None);
+        assert!(mapped.get("missing").is_none());
+
+        // The mapped file answers queries exactly like the in-memory index
+        let ids = |hits: Vec<SearchHit>| {
+            let mut ids: Vec<String> = hits.iter().map(|h| h.doc.node_id.to_string()).collect();
+            ids.sort();
+            ids
+        };
+        assert_eq!(ids(query::exact_hits(&mapped, "report", 10, |_| true)), vec!["1", "f2"]);
+        assert_eq!(ids(query::prefix_hits(&mapped, "holiday", 10, |_| true)), vec!["3"]);
+        assert_eq!(ids(query::account_hits(&mapped, "rep", "acc2", 10, |_| true)), vec!["f2"]);
+        assert_eq!(ids(query::fuzzy_hits(&mapped, "reprot", 2, 10, |_| true)), vec!["1"]);
+        let _ = fs::remove_file(&path);
+    }
+
+    #[test]
+    fn test_persistent_index_log_and_compaction() {
+        let path = test_path("persistent");
+        {
+            let mut index = PersistentSearchIndex::open(path.clone()).unwrap();
+            index.add_document(doc("1", "Budget 2024.xlsx", "acc1")).unwrap();
+            index.add_document(doc("2", "Budget draft", "acc1")).unwrap();
+            index.compact().unwrap();
+            assert_eq!(index.pending_log_entries(), 0);
+
+            // Updates after compaction go to the log only
+            index.add_document(doc("2", "Final budget", "acc1")).unwrap();
+            index.add_document(doc("3", "Notes", "acc2")).unwrap();
+            assert_eq!(index.remove_document("1").unwrap().unwrap().name, "Budget 2024.xlsx");
+            assert_eq!(index.pending_log_entries(), 3);
+        }
+
+        // Reopen: mapped base + replayed log
+        let mut index = PersistentSearchIndex::open(path.clone()).unwrap();
+        assert_eq!(index.len(), 2);
+        assert!(index.get("1").is_none());
+        assert_eq!(index.get("2").unwrap().name, "Final budget");
+        let results = index.search_exact("budget", 10);
+        assert_eq!(results.len(), 1);
+        assert_eq!(results[0].node_id, "2");
+
+        index.compact().unwrap();
+        assert_eq!(index.len(), 2);
+        assert_eq!(index.search_by_account("notes", "acc2", 10).len(), 1);
+
+        // A torn record at the end of the log is ignored
+        index.add_document(doc("4", "Torn", "acc1")).unwrap();
+        drop(index);
+        let log_path = with_suffix(&path, ".log");
+        let log_len = fs::metadata(&log_path).unwrap().len();
+        OpenOptions::new().write(true).open(&log_path).unwrap().set_len(log_len - 2).unwrap();
+        let index = PersistentSearchIndex::open(path.clone()).unwrap();
+        assert_eq!(index.len(), 2);
+        assert!(index.get("4").is_none());
+
+        drop(index);
+        let _ = fs::remove_file(&path);
+        let _ = fs::remove_file(&log_path);
+    }
+
+    #[test]
+    fn test_failed_compaction_keeps_documents() {
+        let path = test_path("failed_compact");
+        let mut index = PersistentSearchIndex::open(path.clone()).unwrap();
+        index.add_document(doc("1", "Budget 2024.xlsx", "acc1")).unwrap();
+        index.add_document(doc("2", "Notes", "acc1")).unwrap();
+        index.compact().unwrap();
+        index.add_document(doc("2", "Final notes", "acc1")).unwrap();
+
+        // A directory in place of the index file makes the rename fail
+        fs::remove_file(&path).unwrap();
+        fs::create_dir(&path).unwrap();
+        fs::write(path.join("blocker"), b"x").unwrap();
+        assert!(index.compact().is_err());
+
+        assert_eq!(index.len(), 2);
+        assert_eq!(index.get("1").unwrap().name, "Budget 2024.xlsx");
+        assert_eq!(index.get("2").unwrap().name, "Final notes");
+        assert_eq!(index.search_exact("budget", 10).len(), 1);
+        assert_eq!(index.pending_log_entries(), 1);
+
+        drop(index);
+        let _ = fs::remove_dir_all(&path);
+        let _ = fs::remove_file(with_suffix(&path, ".log"));
+    }
+}
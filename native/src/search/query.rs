@@ -0,0 +1,369 @@
+// Query evaluation shared by the in-memory and memory-mapped search indexes
+// Both expose their documents and posting lists through DocSource; the search
+// algorithms below only see that interface.
+
+use std::cmp::{Ordering, Reverse};
+use std::collections::{BinaryHeap, HashMap};
+
+use super::fuzzy::{jaro_winkler_similarity, levenshtein_distance};
+use super::index::SearchResult;
+use super::store::{DocId, DocumentRef};
+
+/// Three consecutive lowercase characters packed into one key (21 bits per char)
+pub(crate) type Trigram = u64;
+
+/// Distinct trigrams of an already lowercased string (empty if shorter than 3 chars)
+pub(crate) fn trigrams(text_lower: &str) -> Vec<Trigram> {
+    let chars: Vec<char> = text_lower.chars().collect();
+    let mut grams: Vec<Trigram> = chars
+        .windows(3)
+        .map(|w| ((w[0] as u64) << 42) | ((w[1] as u64) << 21) | (w[2] as u64))
+        .collect();
+    grams.sort_unstable();
+    grams.dedup();
+    grams
+}
+
+/// A sorted posting list, either in memory or packed little-endian in a mapped file
+#[derive(Clone, Copy)]
+pub(crate) enum Postings<'a> {
+    Ids(&'a [DocId]),
+    Packed(&'a [u8]),
+}
+
+impl<'a> Postings<'a> {
+    pub(crate) const EMPTY: Postings<'static> = Postings::Ids(&[]);
+
+    pub(crate) fn len(&self) -> usize {
+        match self {
+            Postings::Ids(ids) => ids.len(),
+            Postings::Packed(bytes) => bytes.len() / 4,
+        }
+    }
+
+    pub(crate) fn iter(self) -> impl Iterator<Item = DocId> + 'a {
+        let (ids, packed): (&'a [DocId], &'a [u8]) = match self {
+            Postings::Ids(ids) => (ids, &[]),
+            Postings::Packed(bytes) => (&[], bytes),
+        };
+        ids.iter().copied().chain(
+            packed
+                .chunks_exact(4)
+                .map(|b| u32::from_le_bytes([b[0], b[1], b[2], b[3]])),
+        )
+    }
+}
+
+/// Read access to an index's documents and posting lists
+pub(crate) trait DocSource {
+    fn doc(&self, id: DocId) -> Option<DocumentRef<'_>>;
+    /// Every live document id
+    fn all_ids(&self) -> Box<dyn Iterator<Item = DocId> + '_>;
+    fn trigram_postings(&self, gram: Trigram) -> Postings<'_>;
+    /// Documents whose lowercase name contains `word` as a whitespace-separated word
+    fn word_postings(&self, word: &str) -> Postings<'_>;
+    fn account_postings(&self, account_id: &str) -> Postings<'_>;
+}
+
+/// Search match borrowing the indexed document (no string copies)
+#[derive(Debug, Clone, Copy)]
+pub struct SearchHit<'a> {
+    pub doc: DocumentRef<'a>,
+    pub score: f64,
+}
+
+/// Keeps the `limit` highest-scoring hits seen so far
+///
+/// A min-heap of size `limit`: a new hit only displaces the current worst one, so
+/// broad queries cost O(matches * log limit) and never hold more than `limit` hits.
+pub(crate) struct TopK<'a> {
+    limit: usize,
+    heap: BinaryHeap<Reverse<ByScore<'a>>>,
+}
+
+/// Orders hits by score (NaN-safe)
+struct ByScore<'a>(SearchHit<'a>);
+
+impl PartialEq for ByScore<'_> {
+    fn eq(&self, other: &Self) -> bool {
+        self.cmp(other) == Ordering::Equal
+    }
+}
+
+impl Eq for ByScore<'_> {}
+
+impl PartialOrd for ByScore<'_> {
+    fn partial_cmp(&self, other: &Self) -> Option<Ordering> {
+        Some(self.cmp(other))
+    }
+}
+
+impl Ord for ByScore<'_> {
+    fn cmp(&self, other: &Self) -> Ordering {
+        self.0.score.total_cmp(&other.0.score)
+    }
+}
+
+impl<'a> TopK<'a> {
+    pub(crate) fn new(limit: usize) -> Self {
+        TopK {
+            limit,
+            heap: BinaryHeap::with_capacity(limit.min(1024) + 1),
+        }
+    }
+
+    pub(crate) fn push(&mut self, hit: SearchHit<'a>) {
+        if self.limit == 0 {
+            return;
+        }
+        if self.heap.len() < self.limit {
+            self.heap.push(Reverse(ByScore(hit)));
+        } else if let Some(Reverse(worst)) = self.heap.peek() {
+            if hit.score > worst.0.score {
+                self.heap.pop();
+                self.heap.push(Reverse(ByScore(hit)));
+            }
+        }
+    }
+
+    /// Hits ordered by descending score
+    pub(crate) fn into_sorted(self) -> Vec<SearchHit<'a>> {
+        // Ascending order of Reverse = descending score
+        self.heap.into_sorted_vec().into_iter().map(|Reverse(ByScore(hit))| hit).collect()
+    }
+}
+
+/// Merge already-ranked hit lists into the top `limit`
+pub(crate) fn merge_hits<'a>(lists: Vec<Vec<SearchHit<'a>>>, limit: usize) -> Vec<SearchHit<'a>> {
+    let mut top = TopK::new(limit);
+    for hit in lists.into_iter().flatten() {
+        top.push(hit);
+    }
+    top.into_sorted()
+}
+
+/// Copy borrowed hits into owned results
+pub(crate) fn to_results(hits: Vec<SearchHit<'_>>) -> Vec<SearchResult> {
+    hits.into_iter()
+        .map(|hit| SearchResult {
+            node_id: hit.doc.node_id.to_string(),
+            name: hit.doc.name.to_string(),
+            score: hit.score,
+            account_id: hit.doc.account_id.to_string(),
+            provider: hit.doc.provider.to_string(),
+        })
+        .collect()
+}
+
+/// Documents whose name may contain `query_lower`
+///
+/// A substring match contains every trigram of the query, so only the posting list of
+/// the query's rarest trigram needs checking. Queries under three characters have no
+/// trigrams and visit every document.
+fn substring_candidates<'a, S: DocSource + ?Sized>(
+    source: &'a S,
+    query_lower: &str,
+) -> Box<dyn Iterator<Item = DocId> + 'a> {
+    let grams = trigrams(query_lower);
+    if grams.is_empty() {
+        return source.all_ids();
+    }
+
+    // A query trigram that occurs in no name yields an empty list here
+    let rarest = grams
+        .iter()
+        .map(|&gram| source.trigram_postings(gram))
+        .min_by_key(|postings| postings.len())
+        .unwrap_or(Postings::EMPTY);
+    Box::new(rarest.iter())
+}
+
+/// Top `limit` substring matches; `keep` can hide documents (e.g. superseded ones)
+pub(crate) fn exact_hits<'a, S, F>(source: &'a S, query: &str, limit: usize, keep: F) -> Vec<SearchHit<'a>>
+where
+    S: DocSource + ?Sized,
+    F: Fn(&DocumentRef<'a>) -> bool,
+{
+    let query_lower = query.to_lowercase();
+    let mut top = TopK::new(limit);
+
+    for id in substring_candidates(source, &query_lower) {
+        let doc = match source.doc(id) {
+            Some(doc) if keep(&doc) => doc,
+            _ => continue,
+        };
+        let name_lower = doc.name_lower();
+        if let Some(match_position) = name_lower.find(&query_lower) {
+            let score = if name_lower == query_lower {
+                1.0
+            } else if match_position == 0 {
+                0.9
+            } else {
+                // For partial matches, calculate a more refined score
+                // based on how much of the query matches the name
+
+                // Calculate bonus based on query being a word boundary match
+                let word_boundary_bonus = if name_lower.chars().nth(match_position - 1) == Some(' ') {
+                    0.05
+                } else {
+                    0.0
+                };
+
+                0.7 + word_boundary_bonus
+            };
+
+            top.push(SearchHit { doc, score });
+        }
+    }
+
+    // Most relevant results first
+    top.into_sorted()
+}
+
+/// Top `limit` documents whose name starts with the query
+///
+/// A name that starts with the query also contains it, so the candidates are the same
+/// trigram ones as for substring matches ("doc" finds "Document.pdf"). When the query's
+/// first word is followed by more text, that word is a whole word of every match, so its
+/// word posting list is the candidate set instead.
+pub(crate) fn prefix_hits<'a, S, F>(source: &'a S, query: &str, limit: usize, keep: F) -> Vec<SearchHit<'a>>
+where
+    S: DocSource + ?Sized,
+    F: Fn(&DocumentRef<'a>) -> bool,
+{
+    let query_lower = query.to_lowercase();
+    let mut top = TopK::new(limit);
+
+    let first_word = query_lower
+        .split_once(char::is_whitespace)
+        .map(|(word, _)| word)
+        .filter(|word| !word.is_empty());
+    let candidates: Box<dyn Iterator<Item = DocId> + 'a> = match first_word {
+        Some(word) => Box::new(source.word_postings(word).iter()),
+        None => substring_candidates(source, &query_lower),
+    };
+
+    for id in candidates {
+        if let Some(doc) = source.doc(id) {
+            if keep(&doc) && doc.name_lower().starts_with(&query_lower) {
+                top.push(SearchHit { doc, score: 0.95 });
+            }
+        }
+    }
+
+    top.into_sorted()
+}
+
+/// Top `limit` substring matches within one account
+pub(crate) fn account_hits<'a, S, F>(
+    source: &'a S,
+    query: &str,
+    account_id: &str,
+    limit: usize,
+    keep: F,
+) -> Vec<SearchHit<'a>>
+where
+    S: DocSource + ?Sized,
+    F: Fn(&DocumentRef<'a>) -> bool,
+{
+    let query_lower = query.to_lowercase();
+    let mut top = TopK::new(limit);
+
+    let account_ids = source.account_postings(account_id);
+    if account_ids.len() == 0 {
+        return Vec::new();
+    }
+
+    // Narrow by trigrams when the query has any, otherwise walk the account's documents
+    let candidates: Box<dyn Iterator<Item = DocId> + 'a> = if query_lower.chars().count() >= 3 {
+        substring_candidates(source, &query_lower)
+    } else {
+        Box::new(account_ids.iter())
+    };
+
+    for id in candidates {
+        let doc = match source.doc(id) {
+            Some(doc) if doc.account_id == account_id && keep(&doc) => doc,
+            _ => continue,
+        };
+        let name_lower = doc.name_lower();
+        if let Some(match_position) = name_lower.find(&query_lower) {
+            let score = if name_lower == query_lower {
+                1.0
+            } else if match_position == 0 {
+                0.9
+            } else {
+                0.7
+            };
+
+            top.push(SearchHit { doc, score });
+        }
+    }
+
+    top.into_sorted()
+}
+
+/// Top `limit` names within `max_distance` edits of the query
+///
+/// The query is compared with the whole lowercase name and with each of its words, so
+/// "reprot" finds "Quarterly Report.pdf". Scores are Jaro-Winkler similarities.
+///
+/// A string within k edits of the query shares at least |trigrams(query)| - 3k of its
+/// trigrams, so only names reaching that overlap in the trigram index are compared.
+pub(crate) fn fuzzy_hits<'a, S, F>(
+    source: &'a S,
+    query: &str,
+    max_distance: usize,
+    limit: usize,
+    keep: F,
+) -> Vec<SearchHit<'a>>
+where
+    S: DocSource + ?Sized,
+    F: Fn(&DocumentRef<'a>) -> bool,
+{
+    let query_lower = query.to_lowercase();
+    if query_lower.is_empty() {
+        return Vec::new();
+    }
+
+    let grams = trigrams(&query_lower);
+    let min_shared = grams.len().saturating_sub(3 * max_distance);
+    let candidates: Box<dyn Iterator<Item = DocId> + 'a> = if min_shared == 0 {
+        // The trigram bound rules nothing out (short query or large distance)
+        source.all_ids()
+    } else {
+        let mut shared: HashMap<DocId, usize> = HashMap::new();
+        for &gram in &grams {
+            for id in source.trigram_postings(gram).iter() {
+                *shared.entry(id).or_insert(0) += 1;
+            }
+        }
+        Box::new(
+            shared
+                .into_iter()
+                .filter(move |(_, count)| *count >= min_shared)
+                .map(|(id, _)| id),
+        )
+    };
+
+    let mut top = TopK::new(limit);
+    for id in candidates {
+        let doc = match source.doc(id) {
+            Some(doc) if keep(&doc) => doc,
+            _ => continue,
+        };
+        let name_lower = doc.name_lower();
+        let best = std::iter::once(name_lower)
+            .chain(name_lower.split(|c: char| !c.is_alphanumeric()).filter(|w| !w.is_empty()))
+            .map(|target| (levenshtein_distance(&query_lower, target), target))
+            .min_by_key(|(distance, _)| *distance);
+
+        if let Some((distance, target)) = best {
+            if distance <= max_distance {
+                top.push(SearchHit { doc, score: jaro_winkler_similarity(&query_lower, target) });
+            }
+        }
+    }
+
+    top.into_sorted()
+}
@@ -0,0 +1,298 @@
+// Compact document storage for the search index
+// Documents live in a dense slot array addressed by u32 ids. Account, provider and email
+// values repeat across millions of documents and are interned; the node id string is
+// shared between its slot and the id lookup map.
+
+use std::collections::HashMap;
+use std::sync::Arc;
+
+use super::index::SearchDocument;
+
+/// Dense document id (slot index)
+pub type DocId = u32;
+
+/// Insert `id` into a sorted posting list (no duplicates)
+pub(crate) fn posting_insert(list: &mut Vec<DocId>, id: DocId) {
+    match list.last() {
+        // Fresh ids are increasing, so this is the common case
+        Some(&last) if last < id => list.push(id),
+        None => list.push(id),
+        _ => {
+            if let Err(pos) = list.binary_search(&id) {
+                list.insert(pos, id);
+            }
+        }
+    }
+}
+
+/// Merge a sorted list of ids into a sorted posting list
+pub(crate) fn posting_merge(list: &mut Vec<DocId>, ids: Vec<DocId>) {
+    match (list.last(), ids.first()) {
+        (_, None) => {}
+        (None, _) => *list = ids,
+        // Fresh ids are usually all above the existing ones
+        (Some(&last), Some(&first)) if last < first => list.extend(ids),
+        _ => {
+            list.extend(ids);
+            list.sort_unstable();
+            list.dedup();
+        }
+    }
+}
+
+/// Remove `id` from a sorted posting list
+pub(crate) fn posting_remove(list: &mut Vec<DocId>, id: DocId) {
+    if let Ok(pos) = list.binary_search(&id) {
+        list.remove(pos);
+    }
+}
+
+/// Deduplicated string table; ids stay valid for the lifetime of the store
+#[derive(Default)]
+struct StringInterner {
+    lookup: HashMap<Arc<str>, u32>,
+    values: Vec<Arc<str>>,
+}
+
+impl StringInterner {
+    fn intern(&mut self, value: &str) -> u32 {
+        if let Some(&id) = self.lookup.get(value) {
+            return id;
+        }
+        let id = self.values.len() as u32;
+        let shared: Arc<str> = Arc::from(value);
+        self.values.push(shared.clone());
+        self.lookup.insert(shared, id);
+        id
+    }
+
+    fn find(&self, value: &str) -> Option<u32> {
+        self.lookup.get(value).copied()
+    }
+
+    fn resolve(&self, id: u32) -> &str {
+        &self.values[id as usize]
+    }
+
+    fn clear(&mut self) {
+        self.lookup.clear();
+        self.values.clear();
+    }
+}
+
+/// One stored document
+struct DocSlot {
+    node_id: Arc<str>,
+    name: Box<str>,
+    /// Lowercase name, only stored when it differs from `name`
+    name_lower: Option<Box<str>>,
+    parent_id: Option<Box<str>>,
+    account: u32,
+    provider: u32,
+    email: u32,
+    is_folder: bool,
+}
+
+/// Borrowed view of a stored document
+#[derive(Debug, Clone, Copy)]
+pub struct DocumentRef<'a> {
+    pub node_id: &'a str,
+    pub account_id: &'a str,
+    pub provider: &'a str,
+    pub email: &'a str,
+    pub name: &'a str,
+    pub is_folder: bool,
+    pub parent_id: Option<&'a str>,
+    name_lower: &'a str,
+}
+
+impl<'a> DocumentRef<'a> {
+    /// View over fields stored elsewhere (e.g. a mapped index file)
+    #[allow(clippy::too_many_arguments)]
+    pub(crate) fn from_parts(
+        node_id: &'a str,
+        account_id: &'a str,
+        provider: &'a str,
+        email: &'a str,
+        name: &'a str,
+        name_lower: &'a str,
+        is_folder: bool,
+        parent_id: Option<&'a str>,
+    ) -> Self {
+        DocumentRef { node_id, account_id, provider, email, name, is_folder, parent_id, name_lower }
+    }
+
+    /// Lowercase name (cached, no allocation)
+    pub fn name_lower(&self) -> &'a str {
+        self.name_lower
+    }
+
+    /// Copy into an owned SearchDocument
+    pub fn to_document(&self) -> SearchDocument {
+        SearchDocument {
+            node_id: self.node_id.to_string(),
+            account_id: self.account_id.to_string(),
+            provider: self.provider.to_string(),
+            email: self.email.to_string(),
+            name: self.name.to_string(),
+            is_folder: self.is_folder,
+            parent_id: self.parent_id.map(|p| p.to_string()),
+        }
+    }
+}
+
+/// Slot array of documents with interned metadata
+#[derive(Default)]
+pub struct DocumentStore {
+    slots: Vec<Option<DocSlot>>,
+    /// Vacated slots, reused by later inserts
+    free: Vec<DocId>,
+    ids: HashMap<Arc<str>, DocId>,
+    accounts: StringInterner,
+    providers: StringInterner,
+    emails: StringInterner,
+}
+
+impl DocumentStore {
+    pub fn new() -> Self {
+        DocumentStore::default()
+    }
+
+    /// Store a document whose node id is not present yet
+    pub fn insert(&mut self, doc: &SearchDocument) -> DocId {
+        let node_id: Arc<str> = Arc::from(doc.node_id.as_str());
+        let name_lower = doc.name.to_lowercase();
+        let slot = DocSlot {
+            node_id: node_id.clone(),
+            name_lower: if name_lower == doc.name { None } else { Some(name_lower.into_boxed_str()) },
+            name: doc.name.as_str().into(),
+            parent_id: doc.parent_id.as_deref().map(Into::into),
+            account: self.accounts.intern(&doc.account_id),
+            provider: self.providers.intern(&doc.provider),
+            email: self.emails.intern(&doc.email),
+            is_folder: doc.is_folder,
+        };
+
+        let id = match self.free.pop() {
+            Some(id) => {
+                self.slots[id as usize] = Some(slot);
+                id
+            }
+            None => {
+                self.slots.push(Some(slot));
+                (self.slots.len() - 1) as DocId
+            }
+        };
+        self.ids.insert(node_id, id);
+        id
+    }
+
+    /// Remove a document, returning its id and an owned copy
+    pub fn remove(&mut self, node_id: &str) -> Option<(DocId, SearchDocument)> {
+        let id = self.ids.remove(node_id)?;
+        let doc = self.get(id)?.to_document();
+        self.slots[id as usize] = None;
+        self.free.push(id);
+        Some((id, doc))
+    }
+
+    pub fn id_of(&self, node_id: &str) -> Option<DocId> {
+        self.ids.get(node_id).copied()
+    }
+
+    pub fn get(&self, id: DocId) -> Option<DocumentRef<'_>> {
+        let slot = self.slots.get(id as usize)?.as_ref()?;
+        Some(DocumentRef {
+            node_id: &slot.node_id,
+            account_id: self.accounts.resolve(slot.account),
+            provider: self.providers.resolve(slot.provider),
+            email: self.emails.resolve(slot.email),
+            name: &slot.name,
+            is_folder: slot.is_folder,
+            parent_id: slot.parent_id.as_deref(),
+            name_lower: slot.name_lower.as_deref().unwrap_or(&slot.name),
+        })
+    }
+
+    /// Interned id of an account (None if no document ever used it)
+    pub fn account_key(&self, account_id: &str) -> Option<u32> {
+        self.accounts.find(account_id)
+    }
+
+    /// Interned account id of a stored document
+    pub fn account_of(&self, id: DocId) -> Option<u32> {
+        Some(self.slots.get(id as usize)?.as_ref()?.account)
+    }
+
+    pub fn iter(&self) -> impl Iterator<Item = (DocId, DocumentRef<'_>)> + '_ {
+        (0..self.slots.len() as DocId).filter_map(move |id| self.get(id).map(|doc| (id, doc)))
+    }
+
+    pub fn len(&self) -> usize {
+        self.ids.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.ids.is_empty()
+    }
+
+    pub fn clear(&mut self) {
+        self.slots.clear();
+        self.free.clear();
+        self.ids.clear();
+        self.accounts.clear();
+        self.providers.clear();
+        self.emails.clear();
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn doc(id: &str, name: &str, account: &str) -> SearchDocument {
+        SearchDocument {
+            node_id: id.to_string(),
+            account_id: account.to_string(),
+            provider: "gdrive".to_string(),
+            email: "test@example.com".to_string(),
+            name: name.to_string(),
+            is_folder: false,
+            parent_id: Some("root".to_string()),
+        }
+    }
+
+    #[test]
+    fn test_store_reuses_slots_and_interns() {
+        let mut store = DocumentStore::new();
+        let a = store.insert(&doc("a", "Report.PDF", "acc1"));
+        let b = store.insert(&doc("b", "notes", "acc1"));
+        assert_eq!((a, b), (0, 1));
+        assert_eq!(store.account_of(a), store.account_of(b));
+        assert_eq!(store.get(a).unwrap().name_lower(), "report.pdf");
+        assert_eq!(store.get(b).unwrap().name_lower(), "notes");
+
+        let (removed, owned) = store.remove("a").unwrap();
+        assert_eq!(removed, a);
+        assert_eq!(owned, doc("a", "Report.PDF", "acc1"));
+        assert!(store.get(a).is_none());
+
+        // The vacated slot is reused
+        assert_eq!(store.insert(&doc("c", "photo", "acc2")), a);
+        assert_eq!(store.id_of("c"), Some(a));
+        assert_eq!(store.len(), 2);
+        assert_eq!(store.iter().count(), 2);
+    }
+
+    #[test]
+    fn test_posting_list_stays_sorted() {
+        let mut list = Vec::new();
+        for id in [5, 1, 9, 3, 9] {
+            posting_insert(&mut list, id);
+        }
+        assert_eq!(list, vec![1, 3, 5, 9]);
+        posting_remove(&mut list, 3);
+        posting_remove(&mut list, 4);
+        assert_eq!(list, vec![1, 5, 9]);
+    }
+}
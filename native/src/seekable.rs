@@ -0,0 +1,452 @@
+/// Random-access (seekable) decryption for CloudNexus streaming-format files
+///
+/// Streaming files are a sequence of independently encrypted chunks, so any plaintext
+/// byte range can be recovered from just the chunks that cover it. The chunk offset table
+/// is computed rather than stored: every encoder cuts chunks of one fixed plaintext size
+/// (only the last chunk is shorter), so the first chunk's header plus the total file size
+/// determine where every chunk starts.
+///
+/// Typical use with HTTP range reads:
+/// 1. Fetch the first `seekable_decrypt_probe_size()` bytes and call `seekable_decrypt_init`
+/// 2. Call `seekable_decrypt_range_for` to get the encrypted byte range for a plaintext range
+/// 3. Fetch exactly that range and pass it to `seekable_decrypt_range`
+///
+/// Files cut into variable-size chunks (adaptive or content-defined uploads) cannot be
+/// recognised from the probe alone. They are rejected by `seekable_decrypt_range` with
+/// ERROR_INVALID_FORMAT as soon as a chunk header disagrees with the computed layout;
+/// callers should then fall back to a full download.
+use std::ffi::c_int;
+use std::ptr;
+use std::slice;
+
+use zeroize::Zeroizing;
+
+use crate::{decrypt_chunk_into_impl, parse_header, unwrap_key, CHUNK_HEADER_SIZE, CHUNK_PREFIX_SIZE,
+            ERROR_BUFFER_TOO_SMALL, ERROR_DECRYPTION_FAILED, ERROR_INVALID_FORMAT, ERROR_NULL_POINTER,
+            HEADER_SIZE, KEY_SIZE, MAC_SIZE, MAGIC, SUCCESS, VERSION};
+
+/// Seekable decryption context
+/// Holds the FEK and the computed chunk layout of one encrypted file
+#[repr(C)]
+pub struct SeekableDecryptContext {
+    fek: Zeroizing<Vec<u8>>,
+    /// Offset of the first chunk (header + wrapped FEK)
+    data_offset: u64,
+    /// Plaintext bytes in every chunk except the last
+    chunk_plain_size: u64,
+    chunk_count: u64,
+    plaintext_size: u64,
+}
+
+impl SeekableDecryptContext {
+    /// Build the context from the leading bytes of an encrypted file
+    ///
+    /// Returns None if the key is wrong, the prefix is too short, or the file size cannot
+    /// come from fixed-size chunks. Other variable-size layouts are only caught per range.
+    pub(crate) fn from_prefix(prefix: &[u8], encrypted_file_size: u64, master_key: &[u8]) -> Option<Self> {
+        if prefix.len() < HEADER_SIZE || master_key.len() != KEY_SIZE {
+            return None;
+        }
+
+        // Parse main header and unwrap FEK
+        let fek_length = match parse_header(&prefix[..HEADER_SIZE]) {
+            Ok((MAGIC, VERSION, fek_length)) => fek_length,
+            _ => return None,
+        };
+        let data_offset = HEADER_SIZE + fek_length;
+        if prefix.len() < data_offset || encrypted_file_size < data_offset as u64 {
+            return None;
+        }
+
+        let fek = unwrap_key(&prefix[HEADER_SIZE..data_offset], master_key).ok()?;
+
+        let data_len = encrypted_file_size - data_offset as u64;
+        let (chunk_plain_size, chunk_count, plaintext_size) = if data_len == 0 {
+            // Empty file: no chunks
+            (1, 0, 0)
+        } else {
+            if prefix.len() < data_offset + CHUNK_PREFIX_SIZE {
+                return None;
+            }
+            let first = &prefix[data_offset..data_offset + CHUNK_PREFIX_SIZE];
+            let first_size = u32::from_le_bytes([first[4], first[5], first[6], first[7]]) as u64;
+            if first_size <= MAC_SIZE as u64 {
+                return None;
+            }
+
+            // All chunks but the last share the first chunk's size; the last one must be a
+            // non-empty remainder, otherwise this file was not cut into fixed-size chunks
+            let chunk_plain_size = first_size - MAC_SIZE as u64;
+            let stride = chunk_plain_size + CHUNK_HEADER_SIZE as u64;
+            let chunk_count = (data_len + stride - 1) / stride;
+            let last_len = data_len - (chunk_count - 1) * stride;
+            if last_len <= CHUNK_HEADER_SIZE as u64 {
+                return None;
+            }
+            let plaintext_size = (chunk_count - 1) * chunk_plain_size + (last_len - CHUNK_HEADER_SIZE as u64);
+            (chunk_plain_size, chunk_count, plaintext_size)
+        };
+
+        Some(SeekableDecryptContext {
+            fek,
+            data_offset: data_offset as u64,
+            chunk_plain_size,
+            chunk_count,
+            plaintext_size,
+        })
+    }
+
+    pub(crate) fn fek(&self) -> &[u8] {
+        &self.fek
+    }
+
+    pub(crate) fn data_offset(&self) -> u64 {
+        self.data_offset
+    }
+
+    pub(crate) fn chunk_plain_size(&self) -> u64 {
+        self.chunk_plain_size
+    }
+
+    pub(crate) fn chunk_count(&self) -> u64 {
+        self.chunk_count
+    }
+
+    pub(crate) fn plaintext_size(&self) -> u64 {
+        self.plaintext_size
+    }
+
+    pub(crate) fn chunk_plain_len(&self, index: u64) -> u64 {
+        if index + 1 == self.chunk_count {
+            self.plaintext_size - index * self.chunk_plain_size
+        } else {
+            self.chunk_plain_size
+        }
+    }
+
+    pub(crate) fn chunk_offset(&self, index: u64) -> u64 {
+        self.data_offset + index * (self.chunk_plain_size + CHUNK_HEADER_SIZE as u64)
+    }
+
+    /// Chunks covering `[offset, offset + len)`, clamped to the file
+    /// Returns (first chunk, last chunk, clamped end) or None for an empty range
+    fn chunk_span(&self, offset: u64, len: u64) -> Option<(u64, u64, u64)> {
+        let end = offset.saturating_add(len).min(self.plaintext_size);
+        if offset >= end {
+            return None;
+        }
+        Some((offset / self.chunk_plain_size, (end - 1) / self.chunk_plain_size, end))
+    }
+}
+
+/// Number of leading file bytes needed by `seekable_decrypt_init`
+///
+/// Covers the main header, the wrapped FEK and the first chunk header.
+///
+/// # Returns
+/// Probe size in bytes
+#[no_mangle]
+pub extern "C" fn seekable_decrypt_probe_size() -> usize {
+    HEADER_SIZE + KEY_SIZE + 12 + MAC_SIZE + CHUNK_PREFIX_SIZE
+}
+
+/// Initialize a seekable decryption context
+///
+/// # Arguments
+/// * `file_prefix` - Leading bytes of the encrypted file (at least `seekable_decrypt_probe_size()`,
+///   or the whole file if it is shorter)
+/// * `prefix_len` - Length of file_prefix
+/// * `encrypted_file_size` - Total size of the encrypted file in bytes
+/// * `master_key` - Pointer to 32-byte Master Key
+/// * `master_key_len` - Length of master key (must be 32)
+///
+/// # Returns
+/// Pointer to SeekableDecryptContext, or null if the key is wrong or the file size rules out
+/// a fixed-size chunk layout. A variable-size file that passes this check is rejected by
+/// `seekable_decrypt_range`.
+#[no_mangle]
+pub extern "C" fn seekable_decrypt_init(
+    file_prefix: *const u8,
+    prefix_len: usize,
+    encrypted_file_size: u64,
+    master_key: *const u8,
+    master_key_len: usize,
+) -> *mut SeekableDecryptContext {
+    if file_prefix.is_null() || master_key.is_null() {
+        return ptr::null_mut();
+    }
+
+    let prefix = unsafe { slice::from_raw_parts(file_prefix, prefix_len) };
+    let master_key_slice = unsafe { slice::from_raw_parts(master_key, master_key_len) };
+
+    let context = match SeekableDecryptContext::from_prefix(prefix, encrypted_file_size, master_key_slice) {
+        Some(ctx) => Box::new(ctx),
+        None => return ptr::null_mut(),
+    };
+
+    // Leak the box and return the pointer (caller must free with seekable_decrypt_free)
+    Box::leak(context) as *mut SeekableDecryptContext
+}
+
+/// Get the plaintext size of the file
+///
+/// # Arguments
+/// * `context` - Pointer to SeekableDecryptContext
+///
+/// # Returns
+/// Plaintext size in bytes, or 0 if invalid context
+#[no_mangle]
+pub extern "C" fn seekable_decrypt_get_plaintext_size(context: *mut SeekableDecryptContext) -> u64 {
+    if context.is_null() {
+        return 0;
+    }
+    unsafe { (&*context).plaintext_size }
+}
+
+/// Get the encrypted byte range that covers a plaintext range
+///
+/// # Arguments
+/// * `context` - Pointer to SeekableDecryptContext
+/// * `plaintext_offset` - Start of the plaintext range
+/// * `plaintext_len` - Length of the plaintext range (clamped to end of file)
+/// * `encrypted_offset` - Pointer to store the file offset to start reading at
+/// * `encrypted_len` - Pointer to store the number of bytes to read (0 for an empty range)
+///
+/// # Returns
+/// SUCCESS, or error code on failure
+#[no_mangle]
+pub extern "C" fn seekable_decrypt_range_for(
+    context: *mut SeekableDecryptContext,
+    plaintext_offset: u64,
+    plaintext_len: u64,
+    encrypted_offset: *mut u64,
+    encrypted_len: *mut u64,
+) -> c_int {
+    if context.is_null() || encrypted_offset.is_null() || encrypted_len.is_null() {
+        return ERROR_NULL_POINTER;
+    }
+
+    let ctx = unsafe { &*context };
+
+    let (start, len) = match ctx.chunk_span(plaintext_offset, plaintext_len) {
+        Some((first, last, _)) => {
+            let start = ctx.chunk_offset(first);
+            let end = ctx.chunk_offset(last) + ctx.chunk_plain_len(last) + CHUNK_HEADER_SIZE as u64;
+            (start, end - start)
+        }
+        None => (ctx.data_offset, 0),
+    };
+
+    unsafe {
+        *encrypted_offset = start;
+        *encrypted_len = len;
+    }
+
+    SUCCESS
+}
+
+/// Decrypt a plaintext range from the chunks returned by `seekable_decrypt_range_for`
+///
+/// Every chunk's index and size are checked against the computed layout, so a range
+/// fetched from the wrong offset is rejected instead of decrypting to the wrong bytes.
+/// Fully covered chunks are decrypted straight into `output`; only partially covered
+/// edge chunks go through a scratch buffer.
+///
+/// # Arguments
+/// * `context` - Pointer to SeekableDecryptContext
+/// * `encrypted_data` - The encrypted bytes at the range reported by seekable_decrypt_range_for
+/// * `encrypted_data_len` - Length of encrypted_data (must equal the reported length)
+/// * `plaintext_offset` - Start of the plaintext range (same value passed to range_for)
+/// * `plaintext_len` - Length of the plaintext range (same value passed to range_for)
+/// * `output` - Buffer to receive the plaintext
+/// * `output_capacity` - Size of output
+/// * `output_len` - Pointer to store the number of plaintext bytes written
+///
+/// # Returns
+/// SUCCESS, or error code on failure
+#[no_mangle]
+pub extern "C" fn seekable_decrypt_range(
+    context: *mut SeekableDecryptContext,
+    encrypted_data: *const u8,
+    encrypted_data_len: usize,
+    plaintext_offset: u64,
+    plaintext_len: u64,
+    output: *mut u8,
+    output_capacity: usize,
+    output_len: *mut usize,
+) -> c_int {
+    if context.is_null() || output_len.is_null() {
+        return ERROR_NULL_POINTER;
+    }
+
+    let ctx = unsafe { &*context };
+
+    let (first, last, end) = match ctx.chunk_span(plaintext_offset, plaintext_len) {
+        Some(span) => span,
+        None => {
+            unsafe { *output_len = 0; }
+            return SUCCESS;
+        }
+    };
+
+    if encrypted_data.is_null() || output.is_null() {
+        return ERROR_NULL_POINTER;
+    }
+
+    let wanted = (end - plaintext_offset) as usize;
+    if output_capacity < wanted {
+        return ERROR_BUFFER_TOO_SMALL;
+    }
+
+    let range_start = ctx.chunk_offset(first);
+    let range_end = ctx.chunk_offset(last) + ctx.chunk_plain_len(last) + CHUNK_HEADER_SIZE as u64;
+    if encrypted_data_len as u64 != range_end - range_start {
+        return ERROR_INVALID_FORMAT;
+    }
+
+    let encrypted = unsafe { slice::from_raw_parts(encrypted_data, encrypted_data_len) };
+    let out = unsafe { slice::from_raw_parts_mut(output, wanted) };
+    let mut scratch = Vec::new();
+    let mut written = 0;
+
+    for index in first..=last {
+        let chunk_plain = ctx.chunk_plain_len(index) as usize;
+        let local = (ctx.chunk_offset(index) - range_start) as usize;
+        let chunk = &encrypted[local..local + chunk_plain + CHUNK_HEADER_SIZE];
+
+        // Chunk header must match the computed layout
+        let chunk_index = u32::from_le_bytes([chunk[0], chunk[1], chunk[2], chunk[3]]) as u64;
+        let chunk_size = u32::from_le_bytes([chunk[4], chunk[5], chunk[6], chunk[7]]) as usize;
+        if chunk_index != index || chunk_size != chunk_plain + MAC_SIZE {
+            return ERROR_INVALID_FORMAT;
+        }
+
+        // Part of this chunk inside the requested range
+        let chunk_start = index * ctx.chunk_plain_size;
+        let lo = plaintext_offset.saturating_sub(chunk_start) as usize;
+        let hi = (end - chunk_start).min(chunk_plain as u64) as usize;
+
+        if lo == 0 && hi == chunk_plain {
+            if decrypt_chunk_into_impl(chunk, &mut out[written..written + chunk_plain], &ctx.fek).is_none() {
+                return ERROR_DECRYPTION_FAILED;
+            }
+        } else {
+            scratch.resize(chunk_plain, 0);
+            if decrypt_chunk_into_impl(chunk, &mut scratch, &ctx.fek).is_none() {
+                return ERROR_DECRYPTION_FAILED;
+            }
+            out[written..written + (hi - lo)].copy_from_slice(&scratch[lo..hi]);
+        }
+        written += hi - lo;
+    }
+
+    unsafe {
+        *output_len = written;
+    }
+
+    SUCCESS
+}
+
+/// Free seekable decryption context
+///
+/// # Arguments
+/// * `context` - Pointer to SeekableDecryptContext to free
+#[no_mangle]
+pub extern "C" fn seekable_decrypt_free(context: *mut SeekableDecryptContext) {
+    if !context.is_null() {
+        unsafe {
+            let _ = Box::from_raw(context);
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::{build_header, encrypt_chunk, encrypt_file_finalize, encrypt_file_get_wrapped_fek,
+                encrypt_file_init, encrypt_file_streaming, free_buffer, DEFAULT_CHUNK_SIZE};
+
+    #[test]
+    fn test_seekable_range_decrypt() {
+        let master_key = [8u8; KEY_SIZE];
+        let plaintext: Vec<u8> = (0..(3 * DEFAULT_CHUNK_SIZE + 999)).map(|i| (i % 227) as u8).collect();
+
+        let mut encrypted_len = 0usize;
+        let encrypted_ptr = encrypt_file_streaming(plaintext.as_ptr(), plaintext.len(), master_key.as_ptr(),
+                                                   KEY_SIZE, &mut encrypted_len, None, ptr::null_mut());
+        assert!(!encrypted_ptr.is_null());
+        let encrypted = unsafe { slice::from_raw_parts(encrypted_ptr, encrypted_len) }.to_vec();
+        free_buffer(encrypted_ptr);
+
+        let probe = &encrypted[..seekable_decrypt_probe_size()];
+        let ctx = seekable_decrypt_init(probe.as_ptr(), probe.len(), encrypted.len() as u64,
+                                        master_key.as_ptr(), KEY_SIZE);
+        assert!(!ctx.is_null());
+        assert_eq!(seekable_decrypt_get_plaintext_size(ctx), plaintext.len() as u64);
+
+        // Ranges inside one chunk, across a boundary, and past the end of file
+        let ranges = [(10u64, 100u64), (DEFAULT_CHUNK_SIZE as u64 - 5, 2 * DEFAULT_CHUNK_SIZE as u64 + 10),
+                      (3 * DEFAULT_CHUNK_SIZE as u64 + 900, 1000)];
+        for (offset, len) in ranges {
+            let (mut enc_offset, mut enc_len) = (0u64, 0u64);
+            assert_eq!(seekable_decrypt_range_for(ctx, offset, len, &mut enc_offset, &mut enc_len), SUCCESS);
+            let fetched = &encrypted[enc_offset as usize..(enc_offset + enc_len) as usize];
+
+            let mut output = vec![0u8; len as usize];
+            let mut output_len = 0usize;
+            assert_eq!(seekable_decrypt_range(ctx, fetched.as_ptr(), fetched.len(), offset, len,
+                                              output.as_mut_ptr(), output.len(), &mut output_len), SUCCESS);
+            let end = ((offset + len) as usize).min(plaintext.len());
+            assert_eq!(&output[..output_len], &plaintext[offset as usize..end]);
+        }
+
+        // The wrong encrypted range is detected from the chunk headers
+        let (mut enc_offset, mut enc_len) = (0u64, 0u64);
+        seekable_decrypt_range_for(ctx, 0, 10, &mut enc_offset, &mut enc_len);
+        let shifted_start = enc_offset as usize + DEFAULT_CHUNK_SIZE + CHUNK_HEADER_SIZE;
+        let shifted = &encrypted[shifted_start..shifted_start + enc_len as usize];
+        let mut output = vec![0u8; 10];
+        let mut output_len = 0usize;
+        assert_eq!(seekable_decrypt_range(ctx, shifted.as_ptr(), shifted.len(), 0, 10,
+                                          output.as_mut_ptr(), output.len(), &mut output_len), ERROR_INVALID_FORMAT);
+
+        seekable_decrypt_free(ctx);
+    }
+
+    #[test]
+    fn test_variable_chunks_rejected_by_range() {
+        let master_key = [9u8; KEY_SIZE];
+        let mut header_len = 0usize;
+        let enc_ctx = encrypt_file_init(master_key.as_ptr(), KEY_SIZE, &mut header_len);
+        let mut fek_len = 0usize;
+        let fek_ptr = encrypt_file_get_wrapped_fek(enc_ctx, &mut fek_len);
+        let mut encrypted = build_header(fek_len as u32).to_vec();
+        encrypted.extend_from_slice(unsafe { slice::from_raw_parts(fek_ptr, fek_len) });
+        free_buffer(fek_ptr);
+
+        // Chunk sizes that still look like a fixed layout from the first header and the size
+        for (index, len) in [100usize, 250, 150].into_iter().enumerate() {
+            let plaintext = vec![index as u8; len];
+            let mut chunk_len = 0usize;
+            let chunk = encrypt_chunk(enc_ctx, plaintext.as_ptr(), len, index as u32, &mut chunk_len);
+            encrypted.extend_from_slice(unsafe { slice::from_raw_parts(chunk, chunk_len) });
+            free_buffer(chunk);
+        }
+        encrypt_file_finalize(enc_ctx);
+
+        let ctx = seekable_decrypt_init(encrypted.as_ptr(), seekable_decrypt_probe_size(), encrypted.len() as u64,
+                                        master_key.as_ptr(), KEY_SIZE);
+        assert!(!ctx.is_null());
+
+        let mut output = vec![0u8; 10];
+        let mut output_len = 0usize;
+        for (offset, expected) in [(0u64, SUCCESS), (150, ERROR_INVALID_FORMAT)] {
+            let (mut enc_offset, mut enc_len) = (0u64, 0u64);
+            assert_eq!(seekable_decrypt_range_for(ctx, offset, 10, &mut enc_offset, &mut enc_len), SUCCESS);
+            let fetched = &encrypted[enc_offset as usize..(enc_offset + enc_len) as usize];
+            assert_eq!(seekable_decrypt_range(ctx, fetched.as_ptr(), fetched.len(), offset, 10,
+                                              output.as_mut_ptr(), output.len(), &mut output_len), expected);
+        }
+        seekable_decrypt_free(ctx);
+    }
+}
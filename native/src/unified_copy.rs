@@ -12,7 +12,8 @@
 /// 3. Clear RAM buffer (automatic on next iteration)
 /// 4. Repeat until EOF
 
-use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::atomic::{AtomicBool, AtomicU32, AtomicU64, AtomicUsize, Ordering};
+use std::sync::{mpsc, Mutex};
 use std::ffi::{c_char, c_void};
 use std::ptr;
 
@@ -44,28 +45,61 @@ pub type UnifiedWriteCallback = extern "C" fn(
     user_data: *mut c_void,    // User data
 ) -> i32;
 
+/// Server-side copy callback: the provider copies the file itself (same provider and
+/// account on both ends), so no bytes pass through this device
+/// Called repeatedly until it returns 0; each call stores the bytes the provider reports
+/// as copied so far in `bytes_done` (left untouched if unknown)
+/// Returns: 1 while the copy is still running, 0 when complete, negative on error
+/// (ERROR_SERVER_COPY_UNSUPPORTED falls back to chunked copy)
+pub type UnifiedServerCopyCallback = extern "C" fn(
+    bytes_done: *mut u64,      // Bytes copied by the provider so far
+    user_data: *mut c_void,    // User data
+) -> i32;
+
 /// Error codes
 const SUCCESS: i32 = 0;
 const ERROR_NULL_POINTER: i32 = -1;
 const ERROR_CANCELLED: i32 = -10;
+const ERROR_SERVER_COPY_UNSUPPORTED: i32 = -14;
+
+/// Server-side copy callback results
+const SERVER_COPY_DONE: i32 = 0;
+const SERVER_COPY_PENDING: i32 = 1;
+
+/// Pause between polls of a running server-side copy
+const SERVER_COPY_POLL_INTERVAL: std::time::Duration = std::time::Duration::from_millis(100);
+
+/// Default and maximum number of files copied at once by unified_copy_files
+const DEFAULT_ACTIVE_FILES: u32 = 4;
+const MAX_ACTIVE_FILES: u32 = 32;
+
+/// Upper bound on chunk buffers in one file's read/write ring
+const MAX_PIPELINE_DEPTH: usize = 16;
+
+/// Files of at most this many chunks are scheduled first (see unified_copy_files)
+const SMALL_FILE_CHUNKS: u64 = 2;
 
 /// Unified copy context - works for ANY source/destination combination
+///
+/// Counters are atomic so progress can be read while unified_copy_files runs.
 #[repr(C)]
 pub struct UnifiedCopyContext {
     /// Total bytes to copy
     total_bytes: u64,
     /// Bytes copied so far
-    bytes_copied: u64,
+    bytes_copied: AtomicU64,
     /// Size of each chunk in bytes
     chunk_size: usize,
     /// Number of files processed
-    files_processed: u32,
+    files_processed: AtomicU32,
     /// Total number of files
     total_files: u32,
     /// Cancellation flag pointer
     cancel_flag: *const AtomicBool,
     /// Current file offset
     file_offset: u64,
+    /// Chunk buffers in the read/write ring (1 = read and write alternate)
+    pipeline_depth: usize,
 }
 
 impl UnifiedCopyContext {
@@ -78,15 +112,22 @@ impl UnifiedCopyContext {
     ) -> Self {
         Self {
             total_bytes,
-            bytes_copied: 0,
+            bytes_copied: AtomicU64::new(0),
             chunk_size,
-            files_processed: 0,
+            files_processed: AtomicU32::new(0),
             total_files,
             cancel_flag,
             file_offset: 0,
+            pipeline_depth: 1,
         }
     }
     
+    /// Overlap downloads and uploads through a ring of `depth` chunk buffers
+    pub fn with_pipeline_depth(mut self, depth: usize) -> Self {
+        self.pipeline_depth = depth.max(1).min(MAX_PIPELINE_DEPTH);
+        self
+    }
+    
     /// Check if operation is cancelled
     pub fn is_cancelled(&self) -> bool {
         if self.cancel_flag.is_null() {
@@ -94,6 +135,267 @@ impl UnifiedCopyContext {
         }
         unsafe { (*self.cancel_flag).load(Ordering::SeqCst) }
     }
+    
+    /// Bytes copied across all files so far
+    pub fn bytes_copied(&self) -> u64 {
+        self.bytes_copied.load(Ordering::Relaxed)
+    }
+    
+    /// Files completed so far
+    pub fn files_processed(&self) -> u32 {
+        self.files_processed.load(Ordering::Relaxed)
+    }
+}
+
+// The cancel flag is an AtomicBool the caller keeps alive for the context's lifetime,
+// and every other field is immutable or atomic, so worker threads may share the context.
+unsafe impl Send for UnifiedCopyContext {}
+unsafe impl Sync for UnifiedCopyContext {}
+
+/// Copy one file chunk by chunk
+///
+/// Uses the context's read/write ring when it has one and the file spans more than one
+/// chunk, otherwise alternates reads and writes through `buffer`.
+/// `on_chunk` is called with the size of every chunk after it was written.
+/// Returns SUCCESS, ERROR_CANCELLED or the negative code of a failed callback.
+fn copy_file_chunks(
+    ctx: &UnifiedCopyContext,
+    buffer: &mut [u8],
+    file_size: u64,
+    read_cb: UnifiedReadCallback,
+    write_cb: UnifiedWriteCallback,
+    user_data: *mut c_void,
+    on_chunk: impl FnMut(u64),
+) -> i32 {
+    if ctx.pipeline_depth > 1 && file_size > ctx.chunk_size as u64 {
+        copy_file_pipelined(ctx, file_size, read_cb, write_cb, user_data, on_chunk)
+    } else {
+        copy_file_serial(ctx, buffer, file_size, read_cb, write_cb, user_data, on_chunk)
+    }
+}
+
+/// Copy one file with a provider-side copy
+///
+/// Polls `server_cb` until the provider finishes, crediting the reported bytes to the
+/// context and calling `on_chunk` with each increase, so progress and cancellation
+/// behave like the chunked path. A copy that completes without intermediate reports is
+/// credited in full at the end. If the provider gives up with ERROR_SERVER_COPY_UNSUPPORTED
+/// the credited bytes are taken back, since the chunked fallback copies them again.
+/// Returns SUCCESS, ERROR_CANCELLED or the negative code of the callback.
+fn copy_file_server_side(
+    ctx: &UnifiedCopyContext,
+    file_size: u64,
+    server_cb: UnifiedServerCopyCallback,
+    user_data: *mut c_void,
+    mut on_chunk: impl FnMut(u64),
+) -> i32 {
+    let mut credited = 0u64;
+    let mut credit = |done: u64, credited: &mut u64| {
+        let done = done.min(file_size);
+        if done > *credited {
+            let delta = done - *credited;
+            *credited = done;
+            ctx.bytes_copied.fetch_add(delta, Ordering::Relaxed);
+            on_chunk(delta);
+        }
+    };
+    
+    loop {
+        // Checked between polls; the provider may finish a copy already accepted
+        if ctx.is_cancelled() {
+            return ERROR_CANCELLED;
+        }
+        
+        let mut bytes_done = credited;
+        let result = server_cb(&mut bytes_done, user_data);
+        match result {
+            SERVER_COPY_DONE => {
+                credit(file_size, &mut credited);
+                return SUCCESS;
+            }
+            SERVER_COPY_PENDING => {
+                credit(bytes_done, &mut credited);
+                std::thread::sleep(SERVER_COPY_POLL_INTERVAL);
+            }
+            ERROR_SERVER_COPY_UNSUPPORTED => {
+                ctx.bytes_copied.fetch_sub(credited, Ordering::Relaxed);
+                return ERROR_SERVER_COPY_UNSUPPORTED;
+            }
+            error if error < 0 => return error,
+            // Unknown positive status: keep polling
+            _ => std::thread::sleep(SERVER_COPY_POLL_INTERVAL),
+        }
+    }
+}
+
+/// User data handed to the read-ahead thread (the caller keeps it valid for the copy)
+#[derive(Clone, Copy)]
+struct CallbackData(*mut c_void);
+unsafe impl Send for CallbackData {}
+
+/// Copy one file with reads running ahead of writes
+///
+/// A background thread downloads into a ring of `pipeline_depth` buffers while this
+/// thread uploads, so chunk N+1 is read while chunk N is written. Writes keep file order.
+/// The read callback runs on the background thread, so it must be a native function.
+fn copy_file_pipelined(
+    ctx: &UnifiedCopyContext,
+    file_size: u64,
+    read_cb: UnifiedReadCallback,
+    write_cb: UnifiedWriteCallback,
+    user_data: *mut c_void,
+    mut on_chunk: impl FnMut(u64),
+) -> i32 {
+    let (free_tx, free_rx) = mpsc::channel::<Vec<u8>>();
+    let (ready_tx, ready_rx) = mpsc::channel::<Result<(Vec<u8>, usize, u64), i32>>();
+    let chunk_size = ctx.chunk_size.min((file_size).min(usize::MAX as u64) as usize);
+    for _ in 0..ctx.pipeline_depth {
+        let _ = free_tx.send(vec![0u8; chunk_size]);
+    }
+    let reader_data = CallbackData(user_data);
+    
+    std::thread::scope(|scope| {
+        // Read stage: fill free buffers in file order
+        scope.spawn(move || {
+            let reader_data = reader_data;
+            let mut offset = 0u64;
+            while offset < file_size {
+                // Blocks here once every buffer is waiting to be written
+                let mut buffer = match free_rx.recv() {
+                    Ok(buffer) => buffer,
+                    Err(_) => return,
+                };
+                if ctx.is_cancelled() {
+                    let _ = ready_tx.send(Err(ERROR_CANCELLED));
+                    return;
+                }
+                
+                let want = ((file_size - offset).min(buffer.len() as u64)) as usize;
+                let bytes_read = read_cb(buffer.as_mut_ptr(), want, offset, reader_data.0);
+                if bytes_read < 0 {
+                    let _ = ready_tx.send(Err(bytes_read as i32));
+                    return;
+                }
+                if bytes_read == 0 {
+                    return; // EOF
+                }
+                
+                let chunk_len = (bytes_read as usize).min(want);
+                if ready_tx.send(Ok((buffer, chunk_len, offset))).is_err() {
+                    return;
+                }
+                offset += chunk_len as u64;
+            }
+        });
+        
+        // Write stage: upload chunks as they arrive and recycle their buffers
+        let mut result = SUCCESS;
+        for item in ready_rx.iter() {
+            let (buffer, chunk_len, offset) = match item {
+                Ok(chunk) => chunk,
+                Err(code) => {
+                    result = code;
+                    break;
+                }
+            };
+            if ctx.is_cancelled() {
+                result = ERROR_CANCELLED;
+                break;
+            }
+            
+            let write_result = write_cb(buffer.as_ptr(), chunk_len, offset, user_data);
+            if write_result < 0 {
+                result = write_result;
+                break;
+            }
+            
+            ctx.bytes_copied.fetch_add(chunk_len as u64, Ordering::Relaxed);
+            on_chunk(chunk_len as u64);
+            let _ = free_tx.send(buffer);
+        }
+        
+        // Unblock the read stage if we stopped early
+        drop(free_tx);
+        drop(ready_rx);
+        result
+    })
+}
+
+/// Copy one file alternating reads and writes through `buffer`
+fn copy_file_serial(
+    ctx: &UnifiedCopyContext,
+    buffer: &mut [u8],
+    file_size: u64,
+    read_cb: UnifiedReadCallback,
+    write_cb: UnifiedWriteCallback,
+    user_data: *mut c_void,
+    mut on_chunk: impl FnMut(u64),
+) -> i32 {
+    let mut file_offset = 0u64;
+    
+    // Download → Upload → Clear loop
+    // This loop processes the file in chunks, keeping memory usage constant
+    while file_offset < file_size {
+        // Check cancellation at start of each iteration
+        if ctx.is_cancelled() {
+            return ERROR_CANCELLED;
+        }
+        
+        // Calculate bytes to read for this chunk
+        let bytes_to_read = ((file_size - file_offset).min(usize::MAX as u64) as usize)
+            .min(ctx.chunk_size)
+            .min(buffer.len());
+        
+        // === STEP 1: Download chunk from source into RAM ===
+        // Dart reads from cloud API (e.g., GET with Range header)
+        // The buffer is filled with downloaded data
+        let bytes_read = read_cb(
+            buffer.as_mut_ptr(),
+            bytes_to_read,
+            file_offset,
+            user_data,
+        );
+        
+        if bytes_read < 0 {
+            // Error from read callback
+            return bytes_read as i32;
+        }
+        
+        if bytes_read == 0 {
+            // EOF - file copy complete
+            break;
+        }
+        
+        // A callback reporting more than it was given must not make us read past the buffer
+        let chunk_len = (bytes_read as usize).min(bytes_to_read);
+        
+        // === CHUNK NOW IN RAM ===
+        // buffer contains [chunk_len] bytes of data
+        
+        // === STEP 2: Upload chunk from RAM to destination ===
+        // Dart uploads to cloud API (e.g., PATCH with Content-Range)
+        let write_result = write_cb(
+            buffer.as_ptr(),
+            chunk_len,
+            file_offset,
+            user_data,
+        );
+        
+        if write_result < 0 {
+            // Error from write callback
+            return write_result;
+        }
+        
+        // === STEP 3: Clear RAM buffer (automatic) ===
+        // The buffer will be overwritten in the next iteration
+        // No explicit clear needed - this is the key memory optimization
+        
+        file_offset += chunk_len as u64;
+        ctx.bytes_copied.fetch_add(chunk_len as u64, Ordering::Relaxed);
+        on_chunk(chunk_len as u64);
+    }
+    
+    SUCCESS
 }
 
 /// Initialize unified copy context
@@ -112,16 +414,50 @@ pub extern "C" fn unified_copy_init(
     total_files: u32,
     chunk_size: usize,
     cancel_flag: *const AtomicBool,
+) -> *mut UnifiedCopyContext {
+    unified_copy_init_with_depth(total_bytes, total_files, chunk_size, 1, cancel_flag)
+}
+
+/// Initialize unified copy context with overlapped reads and writes
+///
+/// With `pipeline_depth` of 2 or more, each file larger than one chunk is copied through
+/// a ring of that many chunk buffers: the read callback runs on a background thread and
+/// downloads chunk N+1 while the write callback uploads chunk N on the calling thread.
+/// The ring is allocated per file (`pipeline_depth * chunk_size` bytes) and the caller's
+/// buffer is not used for such files. A depth of 1 is the plain alternating loop.
+///
+/// Only for native callbacks: a Dart callback may only run on its isolate's thread.
+/// Dart overlaps transfers across files with unified_copy_batch_begin instead.
+///
+/// # Arguments
+/// * `total_bytes` - Total bytes to copy across all files
+/// * `total_files` - Total number of files to copy
+/// * `chunk_size` - Size of chunks in bytes (64KB minimum, 10MB maximum)
+/// * `pipeline_depth` - Chunk buffers per file (0 or 1 = no overlap, maximum 16)
+/// * `cancel_flag` - Pointer to AtomicBool for cancellation (can be null)
+///
+/// # Returns
+/// Pointer to UnifiedCopyContext, or null on error
+#[no_mangle]
+pub extern "C" fn unified_copy_init_with_depth(
+    total_bytes: u64,
+    total_files: u32,
+    chunk_size: usize,
+    pipeline_depth: u32,
+    cancel_flag: *const AtomicBool,
 ) -> *mut UnifiedCopyContext {
     // Validate chunk size: 64KB minimum, 10MB maximum
     let chunk_size = chunk_size.max(64 * 1024).min(10 * 1024 * 1024);
     
-    let context = Box::new(UnifiedCopyContext::new(
-        total_bytes,
-        total_files,
-        chunk_size,
-        cancel_flag,
-    ));
+    let context = Box::new(
+        UnifiedCopyContext::new(
+            total_bytes,
+            total_files,
+            chunk_size,
+            cancel_flag,
+        )
+        .with_pipeline_depth(pipeline_depth as usize),
+    );
     
     // Leak the box and return the pointer (caller must free with unified_copy_free)
     Box::leak(context) as *mut UnifiedCopyContext
@@ -136,6 +472,10 @@ pub extern "C" fn unified_copy_init(
 /// 4. Clear RAM buffer (automatic - buffer reused for next chunk)
 /// 5. Repeat until EOF
 ///
+/// With a context from unified_copy_init_with_depth, steps 1 and 3 overlap for files
+/// larger than one chunk (see there); the read callback then runs on a background thread
+/// and must be a native function.
+///
 /// # Arguments
 /// * `context` - Pointer to UnifiedCopyContext
 /// * `read_buffer` - Pre-allocated RAM buffer for chunk data
@@ -168,7 +508,7 @@ pub extern "C" fn unified_copy_file(
         return ERROR_NULL_POINTER;
     }
     
-    let ctx = unsafe { &mut *context };
+    let ctx = unsafe { &*context };
     
     // Validate callbacks
     let read_cb = match read_callback {
@@ -181,94 +521,527 @@ pub extern "C" fn unified_copy_file(
         None => return ERROR_NULL_POINTER,
     };
     
-    // Initialize file offset
-    let mut file_offset = 0u64;
-    let mut bytes_copied_this_file = 0u64;
+    if buffer_size == 0 {
+        return ERROR_NULL_POINTER;
+    }
+    let buffer = unsafe { std::slice::from_raw_parts_mut(read_buffer, buffer_size) };
     
-    // Download → Upload → Clear loop
-    // This loop processes the file in chunks, keeping memory usage constant
-    while bytes_copied_this_file < file_size {
-        // Check cancellation at start of each iteration
-        if ctx.is_cancelled() {
-            return ERROR_CANCELLED;
-        }
-        
-        // Calculate bytes to read for this chunk
-        let bytes_to_read = ((file_size - bytes_copied_this_file) as usize)
-            .min(ctx.chunk_size)
-            .min(buffer_size);
-        
-        // === STEP 1: Download chunk from source into RAM ===
-        // Dart reads from cloud API (e.g., GET with Range header)
-        // The buffer is filled with downloaded data
-        let bytes_read = read_cb(
-            read_buffer,
-            bytes_to_read,
-            file_offset,
-            user_data,
-        );
-        
-        if bytes_read < 0 {
-            // Error from read callback
-            return bytes_read as i32;
-        }
-        
-        if bytes_read == 0 {
-            // EOF - file copy complete
-            break;
-        }
-        
-        // === CHUNK NOW IN RAM ===
-        // read_buffer contains [bytes_read] bytes of data
-        // This is the only time the buffer contains data
-        
-        // === STEP 2: Upload chunk from RAM to destination ===
-        // Dart uploads to cloud API (e.g., PATCH with Content-Range)
-        let write_result = write_cb(
-            read_buffer,
-            bytes_read as usize,
-            file_offset,
-            user_data,
-        );
-        
-        if write_result < 0 {
-            // Error from write callback
-            return write_result;
-        }
-        
-        // === STEP 3: Clear RAM buffer (automatic) ===
-        // The buffer will be overwritten in the next iteration
-        // No explicit clear needed - this is the key memory optimization
-        
-        // Update progress
-        file_offset += bytes_read as u64;
-        bytes_copied_this_file += bytes_read as u64;
-        ctx.bytes_copied += bytes_read as u64;
-        
+    let result = copy_file_chunks(ctx, buffer, file_size, read_cb, write_cb, user_data, |_| {
         // Progress callback (throttled by Dart if needed)
         if let Some(cb) = progress_callback {
             cb(
-                ctx.bytes_copied,
+                ctx.bytes_copied(),
                 ctx.total_bytes,
-                ctx.files_processed + 1,
+                ctx.files_processed() + 1,
                 ctx.total_files,
                 user_data,
             );
         }
+    });
+    if result != SUCCESS {
+        return result;
     }
     
     // Mark file as processed
-    ctx.files_processed += 1;
-    ctx.file_offset = 0;
+    let files_processed = ctx.files_processed.fetch_add(1, Ordering::Relaxed) + 1;
     
     // Return 1 if more files to copy, 0 if done
-    if ctx.files_processed < ctx.total_files {
+    if files_processed < ctx.total_files {
         1
     } else {
         0
     }
 }
 
+/// One file for unified_copy_files
+///
+/// Each file has its own callbacks and user data, so per-file transfer state (source
+/// and destination handles, upload session) stays on the caller's side.
+/// The caller sets `server_copy_callback` when source and destination are the same
+/// provider account; the file is then copied provider-side and the read/write
+/// callbacks are only used if the provider reports ERROR_SERVER_COPY_UNSUPPORTED.
+#[repr(C)]
+#[derive(Clone, Copy)]
+pub struct UnifiedCopyJob {
+    /// Size of the file in bytes
+    pub file_size: u64,
+    /// Callback to download chunks of this file
+    pub read_callback: Option<UnifiedReadCallback>,
+    /// Callback to upload chunks of this file
+    pub write_callback: Option<UnifiedWriteCallback>,
+    /// User data passed to this file's callbacks
+    pub user_data: *mut c_void,
+    /// Optional provider-side copy of this file (NULL = always copy chunk by chunk)
+    pub server_copy_callback: Option<UnifiedServerCopyCallback>,
+}
+
+impl UnifiedCopyJob {
+    /// Whether the job has a way to copy its file
+    fn is_valid(&self) -> bool {
+        self.server_copy_callback.is_some() || (self.read_callback.is_some() && self.write_callback.is_some())
+    }
+}
+
+/// Copy one job, provider-side when possible
+fn copy_job(ctx: &UnifiedCopyContext, buffer: &mut [u8], job: &UnifiedCopyJob, mut on_chunk: impl FnMut(u64)) -> i32 {
+    if let Some(server_cb) = job.server_copy_callback {
+        let result = copy_file_server_side(ctx, job.file_size, server_cb, job.user_data, &mut on_chunk);
+        if result != ERROR_SERVER_COPY_UNSUPPORTED {
+            return result;
+        }
+    }
+    match (job.read_callback, job.write_callback) {
+        (Some(read_cb), Some(write_cb)) => {
+            copy_file_chunks(ctx, buffer, job.file_size, read_cb, write_cb, job.user_data, on_chunk)
+        }
+        _ => ERROR_SERVER_COPY_UNSUPPORTED,
+    }
+}
+
+/// Job list shared with worker threads (the caller keeps user data valid for the call)
+struct JobList<'a>(&'a [UnifiedCopyJob]);
+unsafe impl Send for JobList<'_> {}
+unsafe impl Sync for JobList<'_> {}
+
+/// Progress callback and its user data, called from one worker at a time
+struct ProgressReporter {
+    callback: Option<UnifiedProgressCallback>,
+    user_data: *mut c_void,
+}
+unsafe impl Send for ProgressReporter {}
+
+/// Order in which files are started, from (file size, copied provider-side) pairs
+///
+/// Provider-side copies go first: they cost no device bandwidth and run on the
+/// provider while the chunked files stream. Then files of up to SMALL_FILE_CHUNKS chunks go first, smallest first, so many files
+/// finish early. Larger files follow largest first: every worker starts on a large file
+/// at about the same time and the remaining ones fill in behind, which keeps the
+/// workers' total bytes balanced (longest-processing-time-first).
+fn schedule_order(files: &[(u64, bool)], chunk_size: usize) -> Vec<usize> {
+    let small_limit = SMALL_FILE_CHUNKS.saturating_mul(chunk_size as u64);
+    let (mut order, chunked): (Vec<usize>, Vec<usize>) = (0..files.len()).partition(|&i| files[i].1);
+    let (mut small, mut large): (Vec<usize>, Vec<usize>) =
+        chunked.into_iter().partition(|&i| files[i].0 <= small_limit);
+    small.sort_by_key(|&i| files[i].0);
+    large.sort_by_key(|&i| std::cmp::Reverse(files[i].0));
+    order.extend(small);
+    order.extend(large);
+    order
+}
+
+/// Copy many files concurrently
+///
+/// Up to `max_active_files` files are copied at once, each by its own worker thread with
+/// its own chunk buffer (0 selects the default of 4). Callbacks are called from those
+/// worker threads and must be safe to call concurrently for different files, so they
+/// must be native functions: a Dart callback may only run on its isolate's thread.
+/// Dart drives the same schedule with unified_copy_batch_begin instead.
+/// `progress_callback` receives the aggregate progress of the context, like
+/// unified_copy_file, one call at a time. Setting `cancel_flag` stops every worker after
+/// its current chunk.
+///
+/// # Arguments
+/// * `context` - Pointer to UnifiedCopyContext
+/// * `jobs` - Array of files to copy
+/// * `job_count` - Number of files in `jobs`
+/// * `max_active_files` - Maximum number of files in flight
+/// * `results_out` - Optional array of `job_count` i32 receiving each file's result
+///   (0 on success, negative error code, ERROR_CANCELLED if never started)
+/// * `progress_callback` - Optional progress callback
+/// * `progress_user_data` - User data for the progress callback
+///
+/// # Returns
+/// 0 if every file was copied, otherwise the first error code encountered
+#[no_mangle]
+pub extern "C" fn unified_copy_files(
+    context: *mut UnifiedCopyContext,
+    jobs: *const UnifiedCopyJob,
+    job_count: usize,
+    max_active_files: u32,
+    results_out: *mut i32,
+    progress_callback: Option<UnifiedProgressCallback>,
+    progress_user_data: *mut c_void,
+) -> i32 {
+    if context.is_null() || (jobs.is_null() && job_count > 0) {
+        return ERROR_NULL_POINTER;
+    }
+    
+    let ctx = unsafe { &*context };
+    let jobs = if job_count == 0 { &[][..] } else { unsafe { std::slice::from_raw_parts(jobs, job_count) } };
+    if jobs.iter().any(|job| !job.is_valid()) {
+        return ERROR_NULL_POINTER;
+    }
+    
+    let max_active = match max_active_files {
+        0 => DEFAULT_ACTIVE_FILES,
+        n => n.min(MAX_ACTIVE_FILES),
+    } as usize;
+    let workers = max_active.min(jobs.len());
+    
+    let files: Vec<(u64, bool)> = jobs.iter().map(|job| (job.file_size, job.server_copy_callback.is_some())).collect();
+    let order = schedule_order(&files, ctx.chunk_size);
+    let next_job = AtomicUsize::new(0);
+    let results: Vec<AtomicU32> = (0..jobs.len()).map(|_| AtomicU32::new(ERROR_CANCELLED as u32)).collect();
+    let job_list = JobList(jobs);
+    let reporter = Mutex::new(ProgressReporter {
+        callback: progress_callback,
+        user_data: progress_user_data,
+    });
+    
+    std::thread::scope(|scope| {
+        for _ in 0..workers {
+            scope.spawn(|| {
+                let jobs = &job_list;
+                let mut buffer = vec![0u8; ctx.chunk_size];
+                let report = |files_done: u32| {
+                    if let Ok(reporter) = reporter.lock() {
+                        if let Some(cb) = reporter.callback {
+                            cb(ctx.bytes_copied(), ctx.total_bytes, files_done, ctx.total_files, reporter.user_data);
+                        }
+                    }
+                };
+                
+                loop {
+                    if ctx.is_cancelled() {
+                        break;
+                    }
+                    let slot = next_job.fetch_add(1, Ordering::Relaxed);
+                    let index = match order.get(slot) {
+                        Some(&index) => index,
+                        None => break,
+                    };
+                    let result = copy_job(ctx, &mut buffer, &jobs.0[index], |_| {
+                        report(ctx.files_processed());
+                    });
+                    results[index].store(result as u32, Ordering::Relaxed);
+                    if result == SUCCESS {
+                        let files_done = ctx.files_processed.fetch_add(1, Ordering::Relaxed) + 1;
+                        report(files_done);
+                    }
+                }
+            });
+        }
+    });
+    
+    let mut first_error = SUCCESS;
+    for (i, result) in results.iter().enumerate() {
+        let result = result.load(Ordering::Relaxed) as i32;
+        if !results_out.is_null() {
+            unsafe { *results_out.add(i) = result; }
+        }
+        if first_error == SUCCESS && result != SUCCESS {
+            first_error = result;
+        }
+    }
+    first_error
+}
+
+/// Step kinds of UnifiedCopyStep
+pub const UNIFIED_COPY_STEP_CHUNK: i32 = 0;
+pub const UNIFIED_COPY_STEP_SERVER_COPY: i32 = 1;
+
+/// One piece of work handed to the caller by unified_copy_batch_next
+#[repr(C)]
+#[derive(Clone, Copy)]
+pub struct UnifiedCopyStep {
+    /// Index of the file in the batch
+    pub file_index: u32,
+    /// UNIFIED_COPY_STEP_CHUNK: download `length` bytes at `offset` into `buffer`, then
+    /// upload them from there; UNIFIED_COPY_STEP_SERVER_COPY: copy the whole file
+    /// provider-side (`buffer` is null)
+    pub kind: i32,
+    pub offset: u64,
+    pub length: usize,
+    /// Chunk buffer owned by the batch, valid until the step is completed
+    pub buffer: *mut u8,
+}
+
+/// Copy state of one file in a batch
+struct BatchFile {
+    file_size: u64,
+    server_side: bool,
+    /// Offset of the next chunk to hand out
+    next_offset: u64,
+    /// Buffer of the step the caller is working on (one step per file at a time, so
+    /// writes reach the destination in file order)
+    lent: Option<Vec<u8>>,
+    in_flight: bool,
+    /// Set once the file is done (ERROR_CANCELLED if it never finished)
+    result: Option<i32>,
+}
+
+/// Files copied under a caller-driven schedule (see unified_copy_batch_begin)
+pub struct UnifiedCopyBatch {
+    context: *const UnifiedCopyContext,
+    files: Vec<BatchFile>,
+    order: Vec<usize>,
+    /// Position in `order` of the next file to start
+    next_file: usize,
+    /// Files started and not finished
+    active: Vec<usize>,
+    /// Where the round-robin over `active` continues
+    cursor: usize,
+    max_active: usize,
+    free_buffers: Vec<Vec<u8>>,
+}
+
+impl UnifiedCopyBatch {
+    fn context(&self) -> &UnifiedCopyContext {
+        unsafe { &*self.context }
+    }
+
+    fn finish(&mut self, index: usize, result: i32) {
+        self.files[index].result = Some(result);
+        self.active.retain(|&i| i != index);
+        if result == SUCCESS {
+            self.context().files_processed.fetch_add(1, Ordering::Relaxed);
+        }
+    }
+
+    /// Start files until `max_active` are in progress; empty chunked files finish at once
+    fn start_files(&mut self) {
+        while self.active.len() < self.max_active && self.next_file < self.order.len() {
+            let index = self.order[self.next_file];
+            self.next_file += 1;
+            self.active.push(index);
+            if !self.files[index].server_side && self.files[index].file_size == 0 {
+                self.finish(index, SUCCESS);
+            }
+        }
+    }
+
+    fn next_step(&mut self) -> Option<UnifiedCopyStep> {
+        self.start_files();
+        let count = self.active.len();
+        for k in 0..count {
+            let index = self.active[(self.cursor + k) % count];
+            if self.files[index].in_flight {
+                continue;
+            }
+            self.cursor = (self.cursor + k + 1) % count;
+            let chunk_size = self.context().chunk_size;
+            let file = &mut self.files[index];
+            file.in_flight = true;
+            if file.server_side {
+                return Some(UnifiedCopyStep {
+                    file_index: index as u32,
+                    kind: UNIFIED_COPY_STEP_SERVER_COPY,
+                    offset: 0,
+                    length: file.file_size.min(usize::MAX as u64) as usize,
+                    buffer: ptr::null_mut(),
+                });
+            }
+            let mut buffer = self.free_buffers.pop().unwrap_or_else(|| vec![0u8; chunk_size]);
+            let length = (file.file_size - file.next_offset).min(chunk_size as u64) as usize;
+            let step = UnifiedCopyStep {
+                file_index: index as u32,
+                kind: UNIFIED_COPY_STEP_CHUNK,
+                offset: file.next_offset,
+                length,
+                buffer: buffer.as_mut_ptr(),
+            };
+            file.lent = Some(buffer);
+            return Some(step);
+        }
+        None
+    }
+
+    fn complete_step(&mut self, step: &UnifiedCopyStep, bytes_done: u64, result: i32) -> i32 {
+        let ctx = unsafe { &*self.context };
+        let index = step.file_index as usize;
+        let file = match self.files.get_mut(index) {
+            Some(file) if file.in_flight && file.result.is_none() => file,
+            _ => return ERROR_NULL_POINTER,
+        };
+        file.in_flight = false;
+        if let Some(buffer) = file.lent.take() {
+            self.free_buffers.push(buffer);
+        }
+        
+        if step.kind == UNIFIED_COPY_STEP_SERVER_COPY {
+            match result {
+                SUCCESS => {
+                    ctx.bytes_copied.fetch_add(file.file_size, Ordering::Relaxed);
+                    self.finish(index, SUCCESS);
+                }
+                ERROR_SERVER_COPY_UNSUPPORTED => {
+                    // Copy the bytes instead; the file keeps its place among the active ones
+                    file.server_side = false;
+                    if file.file_size == 0 {
+                        self.finish(index, SUCCESS);
+                    }
+                }
+                error => self.finish(index, error),
+            }
+            return SUCCESS;
+        }
+        
+        if result < 0 {
+            self.finish(index, result);
+            return SUCCESS;
+        }
+        // A short chunk continues at the next offset; an empty one is EOF
+        let copied = bytes_done.min(step.length as u64);
+        file.next_offset += copied;
+        let done = copied == 0 || file.next_offset >= file.file_size;
+        ctx.bytes_copied.fetch_add(copied, Ordering::Relaxed);
+        if done {
+            self.finish(index, SUCCESS);
+        }
+        SUCCESS
+    }
+}
+
+/// Start copying many files under a schedule driven from the calling thread
+///
+/// Counterpart of unified_copy_files for callers whose callbacks must stay on one
+/// thread (Dart): no callback is involved. unified_copy_batch_next hands out the next
+/// chunk or provider-side copy to perform, the caller runs it (for example as one of
+/// several concurrent downloads and uploads) and reports it with
+/// unified_copy_batch_complete. Files start in unified_copy_files order, at most
+/// `max_active_files` at a time (0 = default of 4), with one step per file outstanding
+/// so each file is written in order. Progress is kept in the context.
+///
+/// # Arguments
+/// * `context` - Pointer to UnifiedCopyContext (must outlive the batch)
+/// * `file_sizes` - Size of every file
+/// * `server_side` - Optional array, nonzero for files to copy provider-side first
+/// * `file_count` - Number of files
+/// * `max_active_files` - Maximum number of files in progress
+///
+/// # Returns
+/// Pointer to UnifiedCopyBatch (free with unified_copy_batch_finish), or null on error
+#[no_mangle]
+pub extern "C" fn unified_copy_batch_begin(
+    context: *mut UnifiedCopyContext,
+    file_sizes: *const u64,
+    server_side: *const u8,
+    file_count: usize,
+    max_active_files: u32,
+) -> *mut UnifiedCopyBatch {
+    if context.is_null() || (file_sizes.is_null() && file_count > 0) {
+        return ptr::null_mut();
+    }
+    
+    let ctx = unsafe { &*context };
+    let files: Vec<(u64, bool)> = (0..file_count)
+        .map(|i| unsafe { (*file_sizes.add(i), !server_side.is_null() && *server_side.add(i) != 0) })
+        .collect();
+    let order = schedule_order(&files, ctx.chunk_size);
+    let max_active = match max_active_files {
+        0 => DEFAULT_ACTIVE_FILES,
+        n => n.min(MAX_ACTIVE_FILES),
+    } as usize;
+    
+    let batch = Box::new(UnifiedCopyBatch {
+        context,
+        files: files
+            .into_iter()
+            .map(|(file_size, server_side)| BatchFile {
+                file_size,
+                server_side,
+                next_offset: 0,
+                lent: None,
+                in_flight: false,
+                result: None,
+            })
+            .collect(),
+        order,
+        next_file: 0,
+        active: Vec::new(),
+        cursor: 0,
+        max_active,
+        free_buffers: Vec::new(),
+    });
+    Box::into_raw(batch)
+}
+
+/// Get the next step of a batch
+///
+/// # Arguments
+/// * `batch` - Pointer to UnifiedCopyBatch
+/// * `step_out` - Receives the step
+///
+/// # Returns
+/// 1 if a step was stored, 0 if none is available until an outstanding step completes
+/// (or every file is done when none is outstanding), ERROR_CANCELLED once the context's
+/// cancel flag is set, ERROR_NULL_POINTER on invalid arguments
+#[no_mangle]
+pub extern "C" fn unified_copy_batch_next(batch: *mut UnifiedCopyBatch, step_out: *mut UnifiedCopyStep) -> i32 {
+    if batch.is_null() || step_out.is_null() {
+        return ERROR_NULL_POINTER;
+    }
+    
+    let batch = unsafe { &mut *batch };
+    if batch.context().is_cancelled() {
+        return ERROR_CANCELLED;
+    }
+    match batch.next_step() {
+        Some(step) => {
+            unsafe { *step_out = step; }
+            1
+        }
+        None => 0,
+    }
+}
+
+/// Report a step of a batch as done
+///
+/// # Arguments
+/// * `batch` - Pointer to UnifiedCopyBatch
+/// * `step` - The step from unified_copy_batch_next
+/// * `bytes_done` - Bytes of a chunk step that were downloaded and uploaded (fewer
+///   than `length` continues the file from there, 0 ends it); ignored for server copies
+/// * `result` - 0 on success, negative error code to fail the file
+///   (ERROR_SERVER_COPY_UNSUPPORTED on a server copy falls back to chunk steps)
+///
+/// # Returns
+/// 0 on success, ERROR_NULL_POINTER if the step is not outstanding
+#[no_mangle]
+pub extern "C" fn unified_copy_batch_complete(
+    batch: *mut UnifiedCopyBatch,
+    step: *const UnifiedCopyStep,
+    bytes_done: u64,
+    result: i32,
+) -> i32 {
+    if batch.is_null() || step.is_null() {
+        return ERROR_NULL_POINTER;
+    }
+    
+    let batch = unsafe { &mut *batch };
+    let step = unsafe { *step };
+    batch.complete_step(&step, bytes_done, result)
+}
+
+/// Free a batch and collect its results
+///
+/// # Arguments
+/// * `batch` - Pointer to UnifiedCopyBatch
+/// * `results_out` - Optional array of `file_count` i32 receiving each file's result
+///   (0 on success, negative error code, ERROR_CANCELLED if not finished)
+///
+/// # Returns
+/// 0 if every file was copied, otherwise the first error code
+#[no_mangle]
+pub extern "C" fn unified_copy_batch_finish(batch: *mut UnifiedCopyBatch, results_out: *mut i32) -> i32 {
+    if batch.is_null() {
+        return ERROR_NULL_POINTER;
+    }
+    
+    let batch = unsafe { Box::from_raw(batch) };
+    let mut first_error = SUCCESS;
+    for (i, file) in batch.files.iter().enumerate() {
+        let result = file.result.unwrap_or(ERROR_CANCELLED);
+        if !results_out.is_null() {
+            unsafe { *results_out.add(i) = result; }
+        }
+        if first_error == SUCCESS && result != SUCCESS {
+            first_error = result;
+        }
+    }
+    first_error
+}
+
 /// Finalize copy operation and send final progress update
 ///
 /// # Arguments
@@ -293,9 +1066,9 @@ pub extern "C" fn unified_copy_finalize(
     // Final progress update
     if let Some(cb) = progress_callback {
         cb(
-            ctx.bytes_copied,
+            ctx.bytes_copied(),
             ctx.total_bytes,
-            ctx.files_processed,
+            ctx.files_processed(),
             ctx.total_files,
             user_data,
         );
@@ -341,13 +1114,13 @@ pub extern "C" fn unified_copy_get_progress(
     let ctx = unsafe { &*context };
     
     if !bytes_copied.is_null() {
-        unsafe { *bytes_copied = ctx.bytes_copied; }
+        unsafe { *bytes_copied = ctx.bytes_copied(); }
     }
     if !total_bytes.is_null() {
         unsafe { *total_bytes = ctx.total_bytes; }
     }
     if !files_processed.is_null() {
-        unsafe { *files_processed = ctx.files_processed; }
+        unsafe { *files_processed = ctx.files_processed(); }
     }
     if !total_files.is_null() {
         unsafe { *total_files = ctx.total_files; }
@@ -366,7 +1139,7 @@ pub extern "C" fn unified_copy_get_bytes_copied(context: *mut UnifiedCopyContext
     if context.is_null() {
         return 0;
     }
-    unsafe { (&*context).bytes_copied }
+    unsafe { (&*context).bytes_copied() }
 }
 
 /// Get total bytes (simple accessor)
@@ -396,7 +1169,7 @@ pub extern "C" fn unified_copy_get_files_processed(context: *mut UnifiedCopyCont
     if context.is_null() {
         return 0;
     }
-    unsafe { (&*context).files_processed }
+    unsafe { (&*context).files_processed() }
 }
 
 /// Get total files (simple accessor)
@@ -412,4 +1185,228 @@ pub extern "C" fn unified_copy_get_total_files(context: *mut UnifiedCopyContext)
         return 0;
     }
     unsafe { (&*context).total_files }
-}
\ No newline at end of file
+}
+#[cfg(test)]
+mod tests {
+    use super::*;
+    
+    /// Per-file state for the test callbacks: a source buffer and the copied bytes
+    struct TestFile {
+        source: Vec<u8>,
+        copied: Mutex<Vec<u8>>,
+    }
+    
+    extern "C" fn read_test_file(buffer: *mut u8, buffer_size: usize, offset: u64, user_data: *mut c_void) -> isize {
+        let file = unsafe { &*(user_data as *const TestFile) };
+        let start = offset as usize;
+        let len = buffer_size.min(file.source.len() - start);
+        unsafe { ptr::copy_nonoverlapping(file.source[start..].as_ptr(), buffer, len); }
+        len as isize
+    }
+    
+    extern "C" fn write_test_file(data: *const u8, data_len: usize, offset: u64, user_data: *mut c_void) -> i32 {
+        let file = unsafe { &*(user_data as *const TestFile) };
+        let mut copied = file.copied.lock().unwrap();
+        if copied.len() as u64 != offset {
+            return -1;
+        }
+        copied.extend_from_slice(unsafe { std::slice::from_raw_parts(data, data_len) });
+        0
+    }
+    
+    /// Provider-side copy that advances half of the remaining bytes per poll
+    extern "C" fn server_copy_test_file(bytes_done: *mut u64, user_data: *mut c_void) -> i32 {
+        let file = unsafe { &*(user_data as *const TestFile) };
+        let mut copied = file.copied.lock().unwrap();
+        let start = copied.len();
+        let step = (file.source.len() - start + 1) / 2;
+        copied.extend_from_slice(&file.source[start..start + step]);
+        unsafe { *bytes_done = copied.len() as u64; }
+        if copied.len() == file.source.len() { SERVER_COPY_DONE } else { SERVER_COPY_PENDING }
+    }
+    
+    extern "C" fn server_copy_unsupported(_bytes_done: *mut u64, _user_data: *mut c_void) -> i32 {
+        ERROR_SERVER_COPY_UNSUPPORTED
+    }
+    
+    /// Provider-side copy that reports half the file, then gives up
+    extern "C" fn server_copy_gives_up(bytes_done: *mut u64, user_data: *mut c_void) -> i32 {
+        let file = unsafe { &*(user_data as *const TestFile) };
+        let reported = unsafe { &mut *bytes_done };
+        if *reported == 0 {
+            *reported = file.source.len() as u64 / 2;
+            SERVER_COPY_PENDING
+        } else {
+            ERROR_SERVER_COPY_UNSUPPORTED
+        }
+    }
+    
+    #[test]
+    fn test_unified_copy_files_server_side() {
+        let chunk = 64 * 1024;
+        let files: Vec<TestFile> = [chunk * 3, 40, chunk * 2 + 5, chunk + 9]
+            .iter()
+            .map(|&size| TestFile {
+                source: (0..size).map(|i| (i % 233) as u8).collect(),
+                copied: Mutex::new(Vec::new()),
+            })
+            .collect();
+        let server_callbacks: [Option<UnifiedServerCopyCallback>; 4] =
+            [Some(server_copy_test_file), None, Some(server_copy_unsupported), Some(server_copy_gives_up)];
+        let jobs: Vec<UnifiedCopyJob> = files
+            .iter()
+            .zip(server_callbacks)
+            .map(|(file, server_copy_callback)| UnifiedCopyJob {
+                file_size: file.source.len() as u64,
+                read_callback: Some(read_test_file),
+                write_callback: Some(write_test_file),
+                user_data: file as *const TestFile as *mut c_void,
+                server_copy_callback,
+            })
+            .collect();
+        
+        // Provider-side copies are scheduled before chunked ones
+        let order: Vec<(u64, bool)> = jobs.iter().map(|j| (j.file_size, j.server_copy_callback.is_some())).collect();
+        assert_eq!(schedule_order(&order, chunk), vec![0, 2, 3, 1]);
+        
+        let total: u64 = files.iter().map(|f| f.source.len() as u64).sum();
+        let context = unified_copy_init(total, jobs.len() as u32, chunk, ptr::null());
+        let result = unified_copy_files(context, jobs.as_ptr(), jobs.len(), 2, ptr::null_mut(), None, ptr::null_mut());
+        
+        // The unsupported jobs fell back to chunks; every byte is accounted for once, also
+        // the half the provider reported before giving up
+        assert_eq!(result, SUCCESS);
+        for file in &files {
+            assert_eq!(*file.copied.lock().unwrap(), file.source);
+        }
+        assert_eq!(unified_copy_get_bytes_copied(context), total);
+        assert_eq!(unified_copy_get_files_processed(context), 4);
+        unified_copy_free(context);
+    }
+    
+    #[test]
+    fn test_unified_copy_files_concurrently() {
+        let chunk = 64 * 1024;
+        let sizes = [0usize, 10, chunk * 5 + 3, 100, chunk * 2, chunk * 9];
+        let files: Vec<TestFile> = sizes
+            .iter()
+            .map(|&size| TestFile {
+                source: (0..size).map(|i| (i % 251) as u8).collect(),
+                copied: Mutex::new(Vec::new()),
+            })
+            .collect();
+        let jobs: Vec<UnifiedCopyJob> = files
+            .iter()
+            .map(|file| UnifiedCopyJob {
+                file_size: file.source.len() as u64,
+                read_callback: Some(read_test_file),
+                write_callback: Some(write_test_file),
+                user_data: file as *const TestFile as *mut c_void,
+                server_copy_callback: None,
+            })
+            .collect();
+        
+        // Small files first (smallest first), then large files largest first
+        let order: Vec<(u64, bool)> = jobs.iter().map(|j| (j.file_size, false)).collect();
+        assert_eq!(schedule_order(&order, chunk), vec![0, 1, 3, 4, 5, 2]);
+        
+        let total: u64 = sizes.iter().map(|&s| s as u64).sum();
+        let context = unified_copy_init(total, jobs.len() as u32, chunk, ptr::null());
+        let mut results = vec![1i32; jobs.len()];
+        let result = unified_copy_files(context, jobs.as_ptr(), jobs.len(), 3, results.as_mut_ptr(), None, ptr::null_mut());
+        
+        assert_eq!(result, SUCCESS);
+        assert!(results.iter().all(|&r| r == SUCCESS));
+        for file in &files {
+            assert_eq!(*file.copied.lock().unwrap(), file.source);
+        }
+        assert_eq!(unified_copy_get_bytes_copied(context), total);
+        assert_eq!(unified_copy_get_files_processed(context), jobs.len() as u32);
+        unified_copy_free(context);
+    }
+    
+    #[test]
+    fn test_unified_copy_file_overlapped() {
+        let chunk = 64 * 1024;
+        let file = TestFile {
+            source: (0..chunk * 7 + 11).map(|i| (i % 239) as u8).collect(),
+            copied: Mutex::new(Vec::new()),
+        };
+        let size = file.source.len() as u64;
+        let user_data = &file as *const TestFile as *mut c_void;
+        
+        let context = unified_copy_init_with_depth(size, 1, chunk, 3, ptr::null());
+        let mut buffer = vec![0u8; chunk];
+        let result = unified_copy_file(
+            context,
+            buffer.as_mut_ptr(),
+            buffer.len(),
+            size,
+            Some(read_test_file),
+            Some(write_test_file),
+            None,
+            user_data,
+        );
+        
+        // Writes arrive in order (write_test_file rejects gaps) and nothing is lost
+        assert_eq!(result, 0);
+        assert_eq!(*file.copied.lock().unwrap(), file.source);
+        assert_eq!(unified_copy_get_bytes_copied(context), size);
+        unified_copy_free(context);
+    }
+
+    #[test]
+    fn test_unified_copy_batch_on_calling_thread() {
+        let chunk = 64 * 1024;
+        let files: Vec<TestFile> = [chunk * 3 + 7, 0, 50, chunk * 2]
+            .iter()
+            .map(|&size| TestFile {
+                source: (0..size).map(|i| (i % 241) as u8).collect(),
+                copied: Mutex::new(Vec::new()),
+            })
+            .collect();
+        let sizes: Vec<u64> = files.iter().map(|f| f.source.len() as u64).collect();
+        let server_side = [0u8, 0, 0, 1];
+        let total: u64 = sizes.iter().sum();
+        let context = unified_copy_init(total, files.len() as u32, chunk, ptr::null());
+        let batch = unified_copy_batch_begin(context, sizes.as_ptr(), server_side.as_ptr(), sizes.len(), 2);
+        assert!(!batch.is_null());
+        
+        // Take every available step, then complete them newest first
+        let mut server_polls = 0;
+        loop {
+            let mut outstanding = Vec::new();
+            let mut step = UnifiedCopyStep { file_index: 0, kind: 0, offset: 0, length: 0, buffer: ptr::null_mut() };
+            while unified_copy_batch_next(batch, &mut step) == 1 {
+                outstanding.push(step);
+            }
+            if outstanding.is_empty() {
+                break;
+            }
+            for step in outstanding.iter().rev() {
+                let file = &files[step.file_index as usize];
+                let user_data = file as *const TestFile as *mut c_void;
+                if step.kind == UNIFIED_COPY_STEP_SERVER_COPY {
+                    // The provider refuses; the file continues chunk by chunk
+                    server_polls += 1;
+                    assert_eq!(unified_copy_batch_complete(batch, step, 0, ERROR_SERVER_COPY_UNSUPPORTED), SUCCESS);
+                    continue;
+                }
+                let read = read_test_file(step.buffer, step.length, step.offset, user_data);
+                assert_eq!(write_test_file(step.buffer, read as usize, step.offset, user_data), 0);
+                assert_eq!(unified_copy_batch_complete(batch, step, read as u64, SUCCESS), SUCCESS);
+            }
+        }
+        
+        assert_eq!(server_polls, 1);
+        let mut results = vec![1i32; files.len()];
+        assert_eq!(unified_copy_batch_finish(batch, results.as_mut_ptr()), SUCCESS);
+        assert!(results.iter().all(|&r| r == SUCCESS));
+        for file in &files {
+            assert_eq!(*file.copied.lock().unwrap(), file.source);
+        }
+        assert_eq!(unified_copy_get_bytes_copied(context), total);
+        assert_eq!(unified_copy_get_files_processed(context), files.len() as u32);
+        unified_copy_free(context);
+    }
+}
@@ -3,16 +3,32 @@
 use std::fs::File;
 use std::io::{Read, Write, BufReader, BufWriter};
 use std::path::{Path, PathBuf};
-use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::atomic::{AtomicBool, AtomicUsize, Ordering};
+use std::sync::{mpsc, Arc};
+use std::thread::JoinHandle;
 use std::ffi::{c_char, c_void, CStr};
 use std::ptr;
 use std::slice;
 
-use crate::file_io::{ProgressThrottler, ERROR_NULL_POINTER, ERROR_FILE_NOT_FOUND,
+use zeroize::Zeroizing;
+
+use crate::file_io::{ProgressThrottler, ChunkSizer, ERROR_NULL_POINTER, ERROR_FILE_NOT_FOUND,
                      ERROR_PERMISSION_DENIED, ERROR_IO_FAILED, ERROR_CANCELLED,
                      ERROR_INVALID_PATH, SUCCESS, c_str_to_path, is_cancelled, string_to_c_char};
-use crate::{EncryptionContext, encrypt_chunk, encrypt_file_init,
-                        encrypt_file_get_wrapped_fek, encrypt_file_finalize, MAGIC, VERSION};
+use crate::{EncryptionContext, encrypt_chunk, encrypt_chunk_in_place_impl, encrypt_file_init,
+                        encrypt_file_get_wrapped_fek, encrypt_file_finalize, encrypt_chunk_output_size,
+                        encryption_context_from_wrapped_fek, build_header, KEY_SIZE, MAGIC, VERSION};
+use crate::cdc::{CdcReader, ChunkManifest, FastCdc};
+use crate::metrics::{Metrics, MetricsSnapshot, Stage};
+
+/// Default number of chunk buffers owned by a pipelined upload
+const DEFAULT_PIPELINE_DEPTH: usize = 4;
+
+/// Room left in front of the plaintext for in-place encryption (index + size + nonce)
+const PIPELINE_CHUNK_PREFIX: usize = 20;
+
+/// Room left after the plaintext for the AES-GCM tag
+const PIPELINE_CHUNK_SUFFIX: usize = 16;
 
 /// Progress callback for upload operations
 pub type UploadProgressCallback = extern "C" fn(bytes_processed: usize, total_bytes: usize, user_data: *mut c_void);
@@ -34,11 +50,33 @@ pub struct UploadContext {
     should_encrypt: bool,
     cancel_flag: *const AtomicBool,
     progress_throttler: ProgressThrottler,
+    chunk_sizer: ChunkSizer,
     is_finalized: bool,
+    pipeline: Option<UploadPipeline>,
+    /// Content-defined chunking state (see upload_enable_content_chunking)
+    content_chunking: Option<Box<ContentChunking>>,
+    metrics: Arc<Metrics>,
+}
+
+/// Content-defined chunking state of a delta upload
+struct ContentChunking {
+    reader: CdcReader<File>,
+    max_chunk_size: usize,
+    /// Manifest of the version being uploaded
+    manifest: ChunkManifest,
+    /// Manifest of the last uploaded version, if any
+    previous: Option<ChunkManifest>,
+    /// Chunks of the previous version are still valid in this upload (same FEK, checked
+    /// against the stored header, or no encryption), so identical chunks at identical
+    /// positions need not be resent
+    reuse_previous: bool,
+    /// Offset of the next chunk in the uploaded object
+    encrypted_offset: u64,
+    last_unchanged: bool,
 }
 
 impl UploadContext {
-    pub fn new(file_path: PathBuf, total_bytes: usize, should_encrypt: bool, 
+    pub fn new(file_path: PathBuf, total_bytes: usize, chunk_size: usize, should_encrypt: bool,
                master_key: Vec<u8>, cancel_flag: *const AtomicBool) -> Self {
         Self {
             input_file: ptr::null_mut(),
@@ -51,7 +89,205 @@ impl UploadContext {
             should_encrypt,
             cancel_flag,
             progress_throttler: ProgressThrottler::new(500), // 500ms interval
+            chunk_sizer: ChunkSizer::new(chunk_size),
             is_finalized: false,
+            pipeline: None,
+            content_chunking: None,
+            metrics: Arc::new(Metrics::new()),
+        }
+    }
+
+    /// Create the encryption context on first use so header and chunks share one FEK
+    fn ensure_encryption_context(&mut self) -> Option<*mut EncryptionContext> {
+        if self.encryption_context.is_none() {
+            let output_len: usize = 0;
+            let enc_ctx = encrypt_file_init(
+                self.master_key.as_ptr(),
+                self.master_key.len(),
+                &output_len as *const usize as *mut usize,
+            );
+
+            if enc_ctx.is_null() {
+                return None;
+            }
+            self.encryption_context = Some(enc_ctx);
+        }
+        self.encryption_context
+    }
+
+    /// Stop pipeline threads (if any) before the file or encryption context is released
+    fn shutdown_pipeline(&mut self) {
+        if let Some(pipeline) = self.pipeline.take() {
+            pipeline.shutdown();
+        }
+    }
+}
+
+/// One chunk buffer moving through the upload pipeline
+///
+/// The buffer is sized for the largest encrypted chunk. Plaintext is read to
+/// `PIPELINE_CHUNK_PREFIX` so it can be encrypted in place; `data_offset..data_offset + data_len`
+/// is what gets handed to the caller.
+struct PipelineChunk {
+    buffer: Vec<u8>,
+    plaintext_len: usize,
+    data_offset: usize,
+    data_len: usize,
+}
+
+/// Raw pointers handed to pipeline threads
+///
+/// The cancel flag is owned by the caller for the whole upload, so it outlives the threads.
+#[derive(Clone, Copy)]
+struct PipelineShared {
+    cancel_flag: *const AtomicBool,
+}
+
+unsafe impl Send for PipelineShared {}
+
+/// Read-ahead and encrypt stages running behind `upload_process_chunk`
+///
+/// A fixed pool of chunk buffers circulates reader → encryptor → caller → reader, so memory
+/// use is bounded by the pool size no matter how far the disk gets ahead of the network.
+struct UploadPipeline {
+    ready_rx: mpsc::Receiver<Result<PipelineChunk, i32>>,
+    free_tx: mpsc::Sender<Vec<u8>>,
+    chunk_size: Arc<AtomicUsize>,
+    stop: Arc<AtomicBool>,
+    workers: Vec<JoinHandle<()>>,
+}
+
+impl UploadPipeline {
+    fn start(
+        mut reader: BufReader<File>,
+        remaining_bytes: usize,
+        first_chunk_index: u32,
+        chunk_size: usize,
+        max_chunk_size: usize,
+        max_in_flight: usize,
+        shared: PipelineShared,
+        fek: Option<Zeroizing<[u8; KEY_SIZE]>>,
+        metrics: Arc<Metrics>,
+    ) -> Self {
+        let (free_tx, free_rx) = mpsc::channel::<Vec<u8>>();
+        let (read_tx, read_rx) = mpsc::channel::<Result<PipelineChunk, i32>>();
+        let (ready_tx, ready_rx) = mpsc::channel::<Result<PipelineChunk, i32>>();
+        let stop = Arc::new(AtomicBool::new(false));
+        let chunk_size = Arc::new(AtomicUsize::new(chunk_size));
+
+        // Buffers are sized for the largest chunk the sizer may ask for
+        for _ in 0..max_in_flight {
+            let buffer_len = PIPELINE_CHUNK_PREFIX + max_chunk_size + PIPELINE_CHUNK_SUFFIX;
+            metrics.record_allocation(buffer_len);
+            let _ = free_tx.send(vec![0u8; buffer_len]);
+        }
+
+        // Stage 1: read ahead into free buffers
+        let reader_stop = stop.clone();
+        let reader_chunk_size = chunk_size.clone();
+        let reader_metrics = metrics.clone();
+        let read_stage = std::thread::spawn(move || {
+            let shared = shared;
+            let mut remaining = remaining_bytes;
+            while remaining > 0 {
+                // Blocks here once every buffer is in flight
+                let mut buffer = match free_rx.recv() {
+                    Ok(buffer) => buffer,
+                    Err(_) => return,
+                };
+                if reader_stop.load(Ordering::SeqCst) {
+                    return;
+                }
+                if unsafe { is_cancelled(shared.cancel_flag) } {
+                    let _ = read_tx.send(Err(ERROR_CANCELLED));
+                    return;
+                }
+
+                let want = remaining
+                    .min(reader_chunk_size.load(Ordering::Relaxed))
+                    .min(max_chunk_size);
+                let region = &mut buffer[PIPELINE_CHUNK_PREFIX..PIPELINE_CHUNK_PREFIX + want];
+                let mut read_timer = reader_metrics.time(Stage::DiskRead);
+                let mut filled = 0;
+                while filled < want {
+                    match reader.read(&mut region[filled..]) {
+                        Ok(0) => break,
+                        Ok(n) => filled += n,
+                        Err(ref e) if e.kind() == std::io::ErrorKind::Interrupted => {}
+                        Err(_) => {
+                            let _ = read_tx.send(Err(ERROR_IO_FAILED));
+                            return;
+                        }
+                    }
+                }
+                if filled == 0 {
+                    return; // EOF
+                }
+                read_timer.set_bytes(filled);
+                drop(read_timer);
+
+                remaining -= filled;
+                let chunk = PipelineChunk {
+                    buffer,
+                    plaintext_len: filled,
+                    data_offset: PIPELINE_CHUNK_PREFIX,
+                    data_len: filled,
+                };
+                reader_metrics.queue_push();
+                if read_tx.send(Ok(chunk)).is_err() {
+                    reader_metrics.queue_pop();
+                    return;
+                }
+            }
+        });
+
+        // Stage 2: encrypt in place, preserving chunk order
+        // Works from its own copy of the FEK, so the caller's thread can keep reading the
+        // encryption context (header, wrapped FEK) while chunks are being encrypted
+        let encrypt_stage = std::thread::spawn(move || {
+            let fek = fek;
+            let metrics = metrics;
+            let mut chunk_index = first_chunk_index;
+            for item in read_rx {
+                let item = item.and_then(|mut chunk| {
+                    if let Some(fek) = fek.as_ref() {
+                        let _timer = metrics.time(Stage::Encrypt).with_bytes(chunk.plaintext_len);
+                        let output_len = encrypt_chunk_in_place_impl(
+                            &mut chunk.buffer,
+                            chunk.plaintext_len,
+                            &fek[..],
+                            chunk_index,
+                        ).ok_or(ERROR_IO_FAILED)?;
+                        chunk.data_offset = 0;
+                        chunk.data_len = output_len;
+                    }
+                    chunk_index += 1;
+                    Ok(chunk)
+                });
+                if ready_tx.send(item).is_err() {
+                    return;
+                }
+            }
+        });
+
+        UploadPipeline {
+            ready_rx,
+            free_tx,
+            chunk_size,
+            stop,
+            workers: vec![read_stage, encrypt_stage],
+        }
+    }
+
+    /// Stop both stages and wait for them to exit
+    fn shutdown(self) {
+        let UploadPipeline { ready_rx, free_tx, stop, workers, .. } = self;
+        stop.store(true, Ordering::SeqCst);
+        // Dropping our channel ends unblocks any stage waiting on a send or a free buffer
+        drop(ready_rx);
+        drop(free_tx);
+        for worker in workers {
+            let _ = worker.join();
         }
     }
 }
@@ -62,7 +298,7 @@ impl UploadContext {
 /// * `local_file_path` - Path to the local file to upload
 /// * `master_key` - Pointer to 32-byte master encryption key (can be null for no encryption)
 /// * `master_key_len` - Length of master key (must be 0 or 32)
-/// * `chunk_size` - Size of chunks in bytes
+/// * `chunk_size` - Plaintext bytes per chunk (0 = 1MB default, clamped to 64KB..64MB)
 /// * `should_encrypt` - 1 if encryption should be used, 0 otherwise
 /// * `progress_callback` - Optional progress callback
 /// * `data_callback` - Callback for receiving encrypted data chunks
@@ -117,6 +353,7 @@ pub extern "C" fn upload_init(
     let context = Box::new(UploadContext::new(
         path,
         total_bytes,
+        chunk_size,
         should_encrypt == 1,
         key,
         cancel_flag,
@@ -163,69 +400,110 @@ pub extern "C" fn upload_process_chunk(
         return ERROR_CANCELLED as isize;
     }
 
-    // Open file on first call
-    if ctx.input_file.is_null() {
-        let file = match File::open(&ctx.file_path) {
-            Ok(f) => f,
-            Err(_) => return ERROR_IO_FAILED as isize,
+    // Pipelined mode: the chunk has already been read (and encrypted) in the background
+    if let Some(pipeline) = ctx.pipeline.as_ref() {
+        let wait_timer = ctx.metrics.time(Stage::QueueWait);
+        let chunk = match pipeline.ready_rx.recv() {
+            Ok(Ok(chunk)) => chunk,
+            Ok(Err(code)) => return code as isize,
+            Err(_) => return 0, // Stages finished: EOF
         };
-        ctx.input_file = Box::into_raw(Box::new(BufReader::new(file)));
-    }
+        drop(wait_timer);
+        ctx.metrics.queue_pop();
 
-    // Determine chunk size
-    let chunk_size = (ctx.total_bytes - ctx.bytes_read).min(1024 * 1024); // 1MB default
+        // Chunks already read ahead keep their size; the reader picks up the new one
+        ctx.chunk_sizer.record_chunk(chunk.plaintext_len);
+        pipeline.chunk_size.store(ctx.chunk_sizer.chunk_size(), Ordering::Relaxed);
 
-    // Read chunk from file
-    let mut chunk_data = vec![0u8; chunk_size];
-    let reader = unsafe { &mut *ctx.input_file };
-    
-    match reader.read(&mut chunk_data) {
-        Ok(0) => return 0, // EOF
-        Ok(n) if n < chunk_size => {
-            chunk_data.truncate(n);
+        if chunk.data_len <= buffer_size {
+            unsafe {
+                ptr::copy_nonoverlapping(chunk.buffer.as_ptr().add(chunk.data_offset), buffer, chunk.data_len);
+            }
         }
-        Ok(_) => {}
-        Err(_) => return ERROR_IO_FAILED as isize,
+
+        let actual_size = chunk.plaintext_len;
+        // Hand the buffer back to the reader so it can start on the next chunk
+        let _ = pipeline.free_tx.send(chunk.buffer);
+
+        ctx.bytes_read += actual_size;
+        ctx.chunk_index += 1;
+        ctx.metrics.add_chunk();
+
+        if let Some(cb) = progress_callback {
+            if ctx.progress_throttler.should_update(ctx.bytes_read, ctx.total_bytes) {
+                let _timer = ctx.metrics.time(Stage::CallbackWait);
+                cb(ctx.bytes_read, ctx.total_bytes, user_data);
+            }
+        }
+
+        return actual_size as isize;
     }
 
+    let read_timer = ctx.metrics.time(Stage::DiskRead);
+    let chunk_data = if let Some(cc) = ctx.content_chunking.as_mut() {
+        // Content-defined chunking: cut at the next content boundary
+        let chunk = match cc.reader.next_chunk() {
+            Ok(chunk) if chunk.is_empty() => return 0, // EOF
+            Ok(chunk) => chunk.to_vec(),
+            Err(_) => return ERROR_IO_FAILED as isize,
+        };
+
+        let index = cc.manifest.chunks.len();
+        let stored_len = if ctx.should_encrypt && !ctx.master_key.is_empty() {
+            encrypt_chunk_output_size(chunk.len())
+        } else {
+            chunk.len()
+        };
+        cc.manifest.push(&chunk, cc.encrypted_offset, stored_len as u32);
+        cc.encrypted_offset += stored_len as u64;
+        cc.last_unchanged = cc.reuse_previous
+            && cc.previous.as_ref().map_or(false, |previous| cc.manifest.chunk_unchanged(index, previous));
+        chunk
+    } else {
+        // Open file on first call (content-defined chunking reads through its own reader)
+        if ctx.input_file.is_null() {
+            let file = match File::open(&ctx.file_path) {
+                Ok(f) => f,
+                Err(_) => return ERROR_IO_FAILED as isize,
+            };
+            ctx.input_file = Box::into_raw(Box::new(BufReader::new(file)));
+        }
+
+        // Determine chunk size
+        let chunk_size = (ctx.total_bytes - ctx.bytes_read).min(ctx.chunk_sizer.chunk_size());
+        ctx.chunk_sizer.record_chunk(chunk_size);
+
+        // Read chunk from file
+        ctx.metrics.record_allocation(chunk_size);
+        let mut chunk_data = vec![0u8; chunk_size];
+        let reader = unsafe { &mut *ctx.input_file };
+        
+        match reader.read(&mut chunk_data) {
+            Ok(0) => return 0, // EOF
+            Ok(n) if n < chunk_size => {
+                chunk_data.truncate(n);
+            }
+            Ok(_) => {}
+            Err(_) => return ERROR_IO_FAILED as isize,
+        }
+        chunk_data
+    };
+
     let actual_size = chunk_data.len();
+    read_timer.finish(actual_size);
     let mut encrypted_data = chunk_data;
     let mut chunk_index = ctx.chunk_index;
 
     // Encrypt if needed
     if ctx.should_encrypt && !ctx.master_key.is_empty() {
-        // Initialize encryption on first chunk
-        if ctx.encryption_context.is_none() {
-            let output_len: usize = 0;
-            let enc_ctx = unsafe { 
-                encrypt_file_init(
-                    ctx.master_key.as_ptr(),
-                    ctx.master_key.len(),
-                    &output_len as *const usize as *mut usize,
-                )
-            };
-            
-            if enc_ctx.is_null() {
-                return ERROR_IO_FAILED as isize;
-            }
-            ctx.encryption_context = Some(enc_ctx);
-
-            // Get wrapped FEK and write it first (not returned here, handled separately)
-            let wrapped_fek_len: usize = 0;
-            let wrapped_fek = unsafe { encrypt_file_get_wrapped_fek(enc_ctx, &wrapped_fek_len as *const usize as *mut usize) };
-            
-            // Write header + wrapped FEK to buffer first
-            if wrapped_fek_len + 12 <= buffer_size {
-                unsafe {
-                    // Header will be written by the caller
-                    ptr::copy_nonoverlapping(wrapped_fek, buffer.add(12), wrapped_fek_len);
-                }
-                unsafe { libc::free(wrapped_fek as *mut c_void); }
-            }
-        }
+        // Initialize encryption on first chunk (the header is fetched separately)
+        let enc_ctx = match ctx.ensure_encryption_context() {
+            Some(enc_ctx) => enc_ctx,
+            None => return ERROR_IO_FAILED as isize,
+        };
 
         // Encrypt chunk
-        let enc_ctx = ctx.encryption_context.unwrap();
+        let _timer = ctx.metrics.time(Stage::Encrypt).with_bytes(actual_size);
         let output_len: usize = 0;
         let encrypted = unsafe { 
             encrypt_chunk(
@@ -264,10 +542,12 @@ pub extern "C" fn upload_process_chunk(
     // Update progress
     ctx.bytes_read += actual_size;
     ctx.chunk_index += 1;
+    ctx.metrics.add_chunk();
 
     // Call progress callback if throttled
     if let Some(cb) = progress_callback {
         if ctx.progress_throttler.should_update(ctx.bytes_read, ctx.total_bytes) {
+            let _timer = ctx.metrics.time(Stage::CallbackWait);
             cb(ctx.bytes_read, ctx.total_bytes, user_data);
         }
     }
@@ -275,6 +555,327 @@ pub extern "C" fn upload_process_chunk(
     actual_size as isize
 }
 
+/// Configure chunk sizing for an upload
+///
+/// Must be called before the first chunk is processed and before `upload_enable_pipeline`.
+/// Variable-size chunks are fine for the encrypted format: every chunk header records its
+/// own size, so downloads decrypt them regardless of how they were cut.
+///
+/// # Arguments
+/// * `context` - Pointer to UploadContext
+/// * `chunk_alignment` - Chunk sizes are rounded down to a multiple of this (e.g. 327680 for
+///   OneDrive's 320 KiB granularity), 0 or 1 for no alignment
+/// * `adaptive` - 1 to resize chunks from measured throughput, 0 for a fixed size
+/// * `min_chunk_size` - Smallest adaptive chunk size (0 = 64KB)
+/// * `max_chunk_size` - Largest adaptive chunk size (0 = 64MB)
+///
+/// # Returns
+/// 0 on success, error code on failure
+#[no_mangle]
+pub extern "C" fn upload_configure_chunking(
+    context: *mut UploadContext,
+    chunk_alignment: usize,
+    adaptive: i32,
+    min_chunk_size: usize,
+    max_chunk_size: usize,
+) -> i32 {
+    if context.is_null() {
+        return ERROR_NULL_POINTER;
+    }
+
+    let ctx = unsafe { &mut *context };
+
+    // Buffers may already be sized and chunks already cut
+    if ctx.bytes_read > 0 || ctx.pipeline.is_some() {
+        return ERROR_IO_FAILED;
+    }
+
+    ctx.chunk_sizer.configure(chunk_alignment, adaptive == 1, min_chunk_size, max_chunk_size);
+
+    SUCCESS
+}
+
+/// Get the plaintext size of the next chunk
+///
+/// # Arguments
+/// * `context` - Pointer to UploadContext
+///
+/// # Returns
+/// Chunk size in bytes, or 0 if invalid
+#[no_mangle]
+pub extern "C" fn upload_get_chunk_size(context: *mut UploadContext) -> usize {
+    if context.is_null() {
+        return 0;
+    }
+    unsafe { (&*context).chunk_sizer.chunk_size() }
+}
+
+/// Get the buffer size `upload_process_chunk` needs for any chunk of this upload
+///
+/// Covers the largest (adaptive) chunk plus per-chunk encryption overhead.
+///
+/// # Arguments
+/// * `context` - Pointer to UploadContext
+///
+/// # Returns
+/// Buffer size in bytes, or 0 if invalid
+#[no_mangle]
+pub extern "C" fn upload_get_chunk_buffer_size(context: *mut UploadContext) -> usize {
+    if context.is_null() {
+        return 0;
+    }
+    let ctx = unsafe { &*context };
+    let max_chunk = match ctx.content_chunking.as_ref() {
+        Some(cc) => cc.max_chunk_size,
+        None => ctx.chunk_sizer.max_chunk_size(),
+    };
+    max_chunk + PIPELINE_CHUNK_PREFIX + PIPELINE_CHUNK_SUFFIX
+}
+
+/// Cut an upload at content-defined boundaries and track its chunk manifest
+///
+/// Chunks are cut with FastCDC instead of at fixed sizes, so an edit only changes the
+/// chunks around it. Each chunk's SHA-256 and position are recorded; save the manifest
+/// next to the encrypted object with `upload_save_manifest` once the upload is done.
+///
+/// Given the manifest of the previously uploaded version, the upload keeps that
+/// version's FEK (when encrypting) so its header and unchanged chunks remain valid.
+/// After each `upload_process_chunk`, `upload_last_chunk_unchanged` then tells whether
+/// the copy the provider already stores at that position is still valid (same plaintext,
+/// offset and length; only the nonce differs); callers writing to providers with
+/// ranged/resumable writes can skip sending it.
+///
+/// Only in-place edits are skipped this way. Providers store the object as one byte
+/// range, so a chunk that moved (every chunk after an insertion or deletion) is written
+/// again even though its content is unchanged.
+///
+/// The previous FEK is only kept when `remote_header` (the first bytes of the object the
+/// provider stores now, at least the 12-byte header and the wrapped FEK) matches the
+/// manifest. A manifest that no longer describes the stored object (another device
+/// uploaded since, or the object was replaced) then gives a full upload with a new FEK
+/// instead of wrong "unchanged" answers. Unencrypted objects have no header to check;
+/// the caller must know the manifest belongs to the stored object.
+///
+/// Must be called before the first chunk; not available in pipelined mode.
+///
+/// # Arguments
+/// * `context` - Pointer to UploadContext
+/// * `avg_chunk_size` - Average chunk size (0 = 1MB default, chunks range from avg/4 to avg*4)
+/// * `previous_manifest_path` - Manifest of the last uploaded version (can be null)
+/// * `remote_header` - Leading bytes of the stored object (can be null: no FEK reuse)
+/// * `remote_header_len` - Length of `remote_header`
+///
+/// # Returns
+/// 0 on success, error code on failure
+#[no_mangle]
+pub extern "C" fn upload_enable_content_chunking(
+    context: *mut UploadContext,
+    avg_chunk_size: usize,
+    previous_manifest_path: *const c_char,
+    remote_header: *const u8,
+    remote_header_len: usize,
+) -> i32 {
+    if context.is_null() {
+        return ERROR_NULL_POINTER;
+    }
+
+    let ctx = unsafe { &mut *context };
+    if ctx.bytes_read > 0 || ctx.pipeline.is_some() || ctx.is_finalized {
+        return ERROR_IO_FAILED;
+    }
+
+    // A missing or unreadable manifest just means a full upload
+    let previous = if previous_manifest_path.is_null() {
+        None
+    } else {
+        unsafe { c_str_to_path(previous_manifest_path) }.ok().and_then(|path| ChunkManifest::load(&path).ok())
+    };
+
+    let chunker = FastCdc::new(avg_chunk_size);
+    let mut manifest = ChunkManifest::new(chunker.avg_size());
+    let encrypt = ctx.should_encrypt && !ctx.master_key.is_empty();
+    let mut reuse_previous = previous.is_some() && !encrypt;
+    let mut encrypted_offset = 0u64;
+
+    if encrypt {
+        if ctx.encryption_context.is_none() {
+            let stored = if remote_header.is_null() {
+                &[][..]
+            } else {
+                unsafe { slice::from_raw_parts(remote_header, remote_header_len) }
+            };
+            let resumed = previous
+                .as_ref()
+                .filter(|previous| !previous.wrapped_fek.is_empty() && stores_manifest_fek(stored, previous))
+                .and_then(|previous| encryption_context_from_wrapped_fek(&ctx.master_key, &previous.wrapped_fek));
+            reuse_previous = resumed.is_some();
+            ctx.encryption_context = resumed;
+        }
+        let enc_ctx = match ctx.ensure_encryption_context() {
+            Some(enc_ctx) => enc_ctx,
+            None => return ERROR_IO_FAILED,
+        };
+        manifest.wrapped_fek = unsafe { (*enc_ctx).wrapped_fek.clone() };
+        // Chunks follow the file header and wrapped FEK in the uploaded object
+        encrypted_offset = (12 + manifest.wrapped_fek.len()) as u64;
+    }
+
+    let file = match File::open(&ctx.file_path) {
+        Ok(f) => f,
+        Err(_) => return ERROR_FILE_NOT_FOUND,
+    };
+
+    ctx.content_chunking = Some(Box::new(ContentChunking {
+        reader: CdcReader::new(file, chunker),
+        max_chunk_size: chunker.max_size(),
+        manifest,
+        previous,
+        reuse_previous,
+        encrypted_offset,
+        last_unchanged: false,
+    }));
+    SUCCESS
+}
+
+/// Whether `stored` (leading bytes of the stored object) starts with the header and
+/// wrapped FEK recorded in `manifest`
+fn stores_manifest_fek(stored: &[u8], manifest: &ChunkManifest) -> bool {
+    let header = build_header(manifest.wrapped_fek.len() as u32);
+    let fek_end = header.len() + manifest.wrapped_fek.len();
+    stored.len() >= fek_end
+        && stored[..header.len()] == header
+        && stored[header.len()..fek_end] == manifest.wrapped_fek[..]
+}
+
+/// Whether the chunk returned by the last `upload_process_chunk` is unchanged
+///
+/// # Arguments
+/// * `context` - Pointer to UploadContext (with content chunking enabled)
+///
+/// # Returns
+/// 1 if the stored copy of this chunk at this position is still valid, 0 otherwise
+#[no_mangle]
+pub extern "C" fn upload_last_chunk_unchanged(context: *mut UploadContext) -> i32 {
+    if context.is_null() {
+        return 0;
+    }
+    match unsafe { &*context }.content_chunking.as_ref() {
+        Some(cc) if cc.last_unchanged => 1,
+        _ => 0,
+    }
+}
+
+/// Save the chunk manifest of a content-chunked upload
+///
+/// Call after the last chunk; the manifest is what the next delta upload of this file
+/// passes to `upload_enable_content_chunking`.
+///
+/// # Arguments
+/// * `context` - Pointer to UploadContext (with content chunking enabled)
+/// * `manifest_path` - Where to store the manifest (replaced atomically)
+///
+/// # Returns
+/// 0 on success, error code on failure
+#[no_mangle]
+pub extern "C" fn upload_save_manifest(context: *mut UploadContext, manifest_path: *const c_char) -> i32 {
+    if context.is_null() || manifest_path.is_null() {
+        return ERROR_NULL_POINTER;
+    }
+    let path = match unsafe { c_str_to_path(manifest_path) } {
+        Ok(p) => p,
+        Err(_) => return ERROR_INVALID_PATH,
+    };
+    match unsafe { &*context }.content_chunking.as_ref() {
+        Some(cc) => match cc.manifest.save(&path) {
+            Ok(()) => SUCCESS,
+            Err(_) => ERROR_IO_FAILED,
+        },
+        None => ERROR_IO_FAILED,
+    }
+}
+
+/// Switch an upload to pipelined mode
+///
+/// Starts a background read-ahead stage and a background encrypt stage, so the next chunks
+/// are read from disk and encrypted while the caller is still sending the current one.
+/// `upload_process_chunk` then just collects the next finished chunk; its buffer contents,
+/// return value and chunk order are the same as in serial mode.
+///
+/// Memory is bounded by `max_in_flight` chunk buffers (each `upload_get_chunk_buffer_size` bytes), shared
+/// by both stages and the chunk currently being handed to the caller.
+///
+/// # Arguments
+/// * `context` - Pointer to UploadContext
+/// * `max_in_flight` - Maximum number of chunk buffers in flight (0 = default of 4, minimum 2)
+///
+/// # Returns
+/// 0 on success, error code on failure
+#[no_mangle]
+pub extern "C" fn upload_enable_pipeline(context: *mut UploadContext, max_in_flight: u32) -> i32 {
+    if context.is_null() {
+        return ERROR_NULL_POINTER;
+    }
+
+    let ctx = unsafe { &mut *context };
+
+    if ctx.is_finalized {
+        return ERROR_IO_FAILED;
+    }
+
+    // Already pipelined
+    if ctx.pipeline.is_some() {
+        return SUCCESS;
+    }
+
+    // Content-defined cuts are made by the serial path only
+    if ctx.content_chunking.is_some() {
+        return ERROR_IO_FAILED;
+    }
+
+    // Encrypt stage needs the FEK fixed before any chunk is produced
+    let fek = if ctx.should_encrypt && !ctx.master_key.is_empty() {
+        match ctx.ensure_encryption_context() {
+            Some(enc_ctx) => Some(Zeroizing::new(unsafe { (*enc_ctx).fek })),
+            None => return ERROR_IO_FAILED,
+        }
+    } else {
+        None
+    };
+
+    // Reader stage takes over the file, continuing from where serial mode left off
+    let reader = if ctx.input_file.is_null() {
+        match File::open(&ctx.file_path) {
+            Ok(f) => BufReader::new(f),
+            Err(_) => return ERROR_IO_FAILED,
+        }
+    } else {
+        let reader = unsafe { *Box::from_raw(ctx.input_file) };
+        ctx.input_file = ptr::null_mut();
+        reader
+    };
+
+    let max_in_flight = match max_in_flight {
+        0 => DEFAULT_PIPELINE_DEPTH,
+        n => (n as usize).max(2),
+    };
+
+    ctx.pipeline = Some(UploadPipeline::start(
+        reader,
+        ctx.total_bytes - ctx.bytes_read,
+        ctx.chunk_index,
+        ctx.chunk_sizer.chunk_size(),
+        ctx.chunk_sizer.max_chunk_size(),
+        max_in_flight,
+        PipelineShared {
+            cancel_flag: ctx.cancel_flag,
+        },
+        fek,
+        ctx.metrics.clone(),
+    ));
+
+    SUCCESS
+}
+
 /// Get header and wrapped FEK for upload
 /// Must be called before processing chunks if encryption is enabled
 ///
@@ -311,20 +912,8 @@ pub extern "C" fn upload_get_header(
     }
 
     // Initialize encryption if not already done
-    if ctx.encryption_context.is_none() {
-        let output_len: usize = 0;
-        let enc_ctx = unsafe { 
-            encrypt_file_init(
-                ctx.master_key.as_ptr(),
-                ctx.master_key.len(),
-                &output_len as *const usize as *mut usize,
-            )
-        };
-        
-        if enc_ctx.is_null() {
-            return ERROR_IO_FAILED;
-        }
-        ctx.encryption_context = Some(enc_ctx);
+    if ctx.ensure_encryption_context().is_none() {
+        return ERROR_IO_FAILED;
     }
 
     // Get wrapped FEK
@@ -382,6 +971,9 @@ pub extern "C" fn upload_finalize(context: *mut UploadContext) -> i32 {
 
     let ctx = unsafe { &mut *context };
 
+    // Background stages still reference the encryption context
+    ctx.shutdown_pipeline();
+
     // Finalize encryption context
     if let Some(enc_ctx) = ctx.encryption_context {
         unsafe { encrypt_file_finalize(enc_ctx); }
@@ -412,6 +1004,7 @@ pub extern "C" fn upload_free(context: *mut UploadContext) {
             if !context.is_null() {
                 let ctx = &mut *context;
                 if !ctx.is_finalized {
+                    ctx.shutdown_pipeline();
                     if let Some(enc_ctx) = ctx.encryption_context {
                         encrypt_file_finalize(enc_ctx);
                     }
@@ -454,3 +1047,175 @@ pub extern "C" fn upload_get_bytes_processed(context: *mut UploadContext) -> usi
     }
     unsafe { (&*context).bytes_read }
 }
+
+/// Take a snapshot of one upload's metrics
+///
+/// # Arguments
+/// * `context` - Pointer to UploadContext
+/// * `out` - Receives the snapshot
+///
+/// # Returns
+/// 0 on success, error code on failure
+#[no_mangle]
+pub extern "C" fn upload_get_metrics(context: *mut UploadContext, out: *mut MetricsSnapshot) -> i32 {
+    if context.is_null() || out.is_null() {
+        return ERROR_NULL_POINTER;
+    }
+    unsafe { (&*context).metrics.snapshot(&mut *out) };
+    SUCCESS
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::{decrypt_chunk_into, decrypt_file_finalize, decrypt_file_init};
+    use std::ffi::CString;
+
+    #[test]
+    fn test_pipelined_upload_roundtrip() {
+        let path = std::env::temp_dir().join(format!("cn_upload_pipeline_{}.bin", std::process::id()));
+        let plaintext: Vec<u8> = (0..(2 * 1024 * 1024 + 777)).map(|i| (i % 239) as u8).collect();
+        std::fs::write(&path, &plaintext).unwrap();
+
+        let master_key = [5u8; 32];
+        let c_path = CString::new(path.to_str().unwrap()).unwrap();
+        let ctx = upload_init(c_path.as_ptr(), master_key.as_ptr(), 32, 0, 1, None, None,
+                              ptr::null(), ptr::null_mut());
+        assert!(!ctx.is_null());
+
+        // OneDrive-style 320 KiB granularity: 1MB rounds down to 3 units
+        assert_eq!(upload_configure_chunking(ctx, 320 * 1024, 0, 0, 0), SUCCESS);
+        assert_eq!(upload_get_chunk_size(ctx), 3 * 320 * 1024);
+        assert_eq!(upload_enable_pipeline(ctx, 2), SUCCESS);
+
+        // Header is available after the pipeline has started and matches its FEK
+        let mut file_header = vec![0u8; 12 + 128];
+        let mut fek_len = 0usize;
+        let (header, fek) = file_header.split_at_mut(12);
+        assert_eq!(upload_get_header(ctx, header.as_mut_ptr(), fek.as_mut_ptr(), fek.len(), &mut fek_len), SUCCESS);
+        file_header.truncate(12 + fek_len);
+        let dec_ctx = decrypt_file_init(file_header.as_ptr(), file_header.len(), master_key.as_ptr(), 32);
+        assert!(!dec_ctx.is_null());
+
+        let mut buffer = vec![0u8; upload_get_chunk_buffer_size(ctx)];
+        let mut decoded = Vec::new();
+        loop {
+            let n = upload_process_chunk(ctx, buffer.as_mut_ptr(), buffer.len(), None, None, ptr::null_mut());
+            assert!(n >= 0);
+            if n == 0 {
+                break;
+            }
+            assert!(n as usize <= 3 * 320 * 1024);
+            let mut chunk = vec![0u8; n as usize];
+            let mut chunk_len = 0usize;
+            assert_eq!(decrypt_chunk_into(dec_ctx, buffer.as_ptr(), n as usize + 36,
+                                          chunk.as_mut_ptr(), chunk.len(), &mut chunk_len), SUCCESS);
+            decoded.extend_from_slice(&chunk[..chunk_len]);
+        }
+
+        assert_eq!(decoded, plaintext);
+        assert_eq!(upload_get_bytes_processed(ctx), plaintext.len());
+
+        let mut metrics = MetricsSnapshot::default();
+        assert_eq!(upload_get_metrics(ctx, &mut metrics), SUCCESS);
+        assert_eq!(metrics.stages[Stage::DiskRead as usize].bytes, plaintext.len() as u64);
+        assert_eq!(metrics.stages[Stage::Encrypt as usize].count, metrics.chunks);
+        assert_eq!(metrics.allocations, 2);
+
+        decrypt_file_finalize(dec_ctx);
+        assert_eq!(upload_finalize(ctx), SUCCESS);
+        upload_free(ctx);
+        let _ = std::fs::remove_file(&path);
+    }
+
+    #[test]
+    fn test_content_chunked_upload_skips_unchanged() {
+        let dir = std::env::temp_dir();
+        let path = dir.join(format!("cn_upload_cdc_{}.bin", std::process::id()));
+        let manifest_path = dir.join(format!("cn_upload_cdc_{}.cncm", std::process::id()));
+        let mut state = 0x2545f4914f6cdd1du64;
+        let mut plaintext: Vec<u8> = (0..600_000).map(|_| {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            state as u8
+        }).collect();
+        std::fs::write(&path, &plaintext).unwrap();
+
+        let master_key = [9u8; 32];
+        let c_path = CString::new(path.to_str().unwrap()).unwrap();
+        let c_manifest = CString::new(manifest_path.to_str().unwrap()).unwrap();
+
+        // Returns the stored header and one (chunk, unchanged) pair per processed chunk
+        let upload = |previous: *const c_char, remote_header: &[u8]| -> (Vec<u8>, Vec<(Vec<u8>, bool)>) {
+            let ctx = upload_init(c_path.as_ptr(), master_key.as_ptr(), 32, 0, 1, None, None,
+                                  ptr::null(), ptr::null_mut());
+            assert!(!ctx.is_null());
+            assert_eq!(upload_enable_content_chunking(ctx, 16 * 1024, previous, remote_header.as_ptr(), remote_header.len()), SUCCESS);
+            assert_eq!(upload_enable_pipeline(ctx, 2), ERROR_IO_FAILED);
+
+            let mut buffer = vec![0u8; upload_get_chunk_buffer_size(ctx)];
+            let mut chunks = Vec::new();
+            loop {
+                let n = upload_process_chunk(ctx, buffer.as_mut_ptr(), buffer.len(), None, None, ptr::null_mut());
+                assert!(n >= 0);
+                if n == 0 {
+                    break;
+                }
+                chunks.push((buffer[..n as usize + 36].to_vec(), upload_last_chunk_unchanged(ctx) == 1));
+            }
+            assert_eq!(upload_save_manifest(ctx, c_manifest.as_ptr()), SUCCESS);
+
+            let mut stored_header = vec![0u8; 12 + 128];
+            let mut fek_len = 0usize;
+            let (header, fek) = stored_header.split_at_mut(12);
+            assert_eq!(upload_get_header(ctx, header.as_mut_ptr(), fek.as_mut_ptr(), fek.len(), &mut fek_len), SUCCESS);
+            stored_header.truncate(12 + fek_len);
+            upload_free(ctx);
+            (stored_header, chunks)
+        };
+
+        let (stored_header, first) = upload(ptr::null(), &[]);
+        assert!(first.len() > 4);
+        assert!(first.iter().all(|(_, unchanged)| !unchanged));
+
+        // A header that is not the one the manifest recorded (the object was replaced
+        // since): nothing is reported unchanged
+        let mut other_header = stored_header.clone();
+        *other_header.last_mut().unwrap() ^= 1;
+        let (_, replaced) = upload(c_manifest.as_ptr(), &other_header);
+        assert!(replaced.iter().all(|(_, unchanged)| !unchanged));
+        let (stored_header, _) = upload(ptr::null(), &[]);
+
+        // Edit a few bytes near the end: only the chunks around the edit are resent
+        for b in &mut plaintext[590_000..590_010] {
+            *b = !*b;
+        }
+        std::fs::write(&path, &plaintext).unwrap();
+        let (stored_header_edit, second) = upload(c_manifest.as_ptr(), &stored_header);
+        assert_eq!(stored_header_edit, stored_header);
+        let unchanged = second.iter().filter(|(_, unchanged)| *unchanged).count();
+        assert!(unchanged + 2 >= second.len(), "{} of {} unchanged", unchanged, second.len());
+        // Nonces are fresh, so only the chunk prefix (index + size) repeats byte-for-byte;
+        // the stored copy decrypts with the same FEK either way
+        for (i, (chunk, is_unchanged)) in second.iter().enumerate() {
+            if *is_unchanged {
+                assert_eq!(chunk.len(), first[i].0.len());
+                assert_eq!(chunk[..8], first[i].0[..8]);
+            }
+        }
+
+        // An insertion moves every later chunk: those are resent, only earlier ones are skipped
+        plaintext.splice(100_000..100_000, [7u8; 100]);
+        std::fs::write(&path, &plaintext).unwrap();
+        let manifest_before = ChunkManifest::load(&manifest_path).unwrap();
+        let (_, third) = upload(c_manifest.as_ptr(), &stored_header);
+        let moved = manifest_before.chunks.iter().position(|c| c.offset + c.len as u64 > 100_000).unwrap();
+        assert!(moved > 0);
+        assert!(third[..moved].iter().all(|(_, unchanged)| *unchanged));
+        assert!(third[moved..].iter().all(|(_, unchanged)| !unchanged));
+
+        let _ = std::fs::remove_file(&path);
+        let _ = std::fs::remove_file(&manifest_path);
+    }
+}
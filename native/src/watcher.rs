@@ -0,0 +1,1203 @@
+/// Filesystem change notifications for CloudNexus
+///
+/// Keeping a local folder in sync used to mean a periodic full rescan. A watcher instead
+/// subscribes to the OS change feed for a folder tree and hands out the changed paths:
+///
+/// - Linux: inotify (one watch per directory, new directories are watched as they appear)
+/// - Windows: ReadDirectoryChangesW on the root with subtree watching
+/// - macOS: FSEvents with per-file events
+/// - Anything else, or when the native backend cannot be set up or gives out later (e.g.
+///   the inotify watch limit is exhausted): snapshot rescans (see scan_snapshot.rs) on a
+///   timer. A switch after startup reports a `rescan` of the root first.
+///
+/// Raw events are coalesced per path and debounced: a batch is released once the tree has
+/// been quiet for `debounce_ms` (or after at most 8x that while changes keep coming), so
+/// an editor's save-as-temp-then-rename or a large copy turns into one event per path.
+///
+/// When the OS drops events (queue overflow) a `rescan` event is reported for the affected
+/// subtree; callers should fall back to `scan_folder_rescan` for that subtree.
+use serde::{Deserialize, Serialize};
+use std::collections::{HashMap, VecDeque};
+use std::ffi::{c_char, CStr, CString};
+use std::path::{Path, PathBuf};
+use std::ptr;
+use std::sync::atomic::{AtomicBool, AtomicU64, Ordering};
+use std::sync::mpsc::{self, Receiver, RecvTimeoutError, Sender};
+use std::sync::{Arc, Condvar, Mutex};
+use std::thread::{self, JoinHandle};
+use std::time::{Duration, Instant};
+
+use crate::file_io::ERROR_NULL_POINTER;
+use crate::scan_snapshot::rescan_folder;
+
+/// Default quiet period before a batch of changes is released
+const DEFAULT_DEBOUNCE_MS: u64 = 200;
+
+/// A batch is released after at most this many debounce periods of continuous changes
+const MAX_DELAY_FACTOR: u32 = 8;
+
+/// Beyond this many distinct pending paths, report a rescan of the root instead
+const MAX_PENDING_PATHS: usize = 65536;
+
+/// How often blocking backends check the stop flag
+const STOP_CHECK_INTERVAL_MS: u64 = 100;
+
+/// Minimum interval between rescans of the polling backend
+const MIN_POLL_INTERVAL_MS: u64 = 1000;
+
+/// Kind of change reported for a path
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Serialize, Deserialize)]
+#[serde(rename_all = "lowercase")]
+pub enum WatchEventKind {
+    Created,
+    Modified,
+    Removed,
+    /// Events were dropped; the subtree at `path` must be rescanned
+    Rescan,
+}
+
+/// One coalesced change
+#[derive(Debug, Clone, PartialEq, Serialize, Deserialize)]
+pub struct WatchEvent {
+    /// Path relative to the watched root ('/' separated, "" = the root itself)
+    pub path: String,
+    pub kind: WatchEventKind,
+}
+
+impl WatchEvent {
+    fn new(path: String, kind: WatchEventKind) -> Self {
+        WatchEvent { path, kind }
+    }
+}
+
+/// Combine a pending change with a newer one for the same path
+///
+/// Returns None when the two cancel out (created, then removed before anyone looked).
+fn merge_kinds(old: WatchEventKind, new: WatchEventKind) -> Option<WatchEventKind> {
+    use WatchEventKind::*;
+    match (old, new) {
+        (Rescan, _) | (_, Rescan) => Some(Rescan),
+        (Created, Removed) => None,
+        (Created, _) => Some(Created),
+        // Replaced by a new item with the same name
+        (Removed, Created) | (Removed, Modified) => Some(Modified),
+        (_, kind) => Some(kind),
+    }
+}
+
+/// Pending changes per path, merged as they arrive
+struct Coalescer {
+    pending: HashMap<String, WatchEventKind>,
+    first_event: Option<Instant>,
+    last_event: Option<Instant>,
+}
+
+impl Coalescer {
+    fn new() -> Self {
+        Coalescer {
+            pending: HashMap::new(),
+            first_event: None,
+            last_event: None,
+        }
+    }
+
+    fn push(&mut self, event: WatchEvent) {
+        let now = Instant::now();
+        self.first_event.get_or_insert(now);
+        self.last_event = Some(now);
+
+        if self.pending.len() >= MAX_PENDING_PATHS && !self.pending.contains_key(&event.path) {
+            self.pending.clear();
+            self.pending.insert(String::new(), WatchEventKind::Rescan);
+            return;
+        }
+
+        match self.pending.get(&event.path).copied() {
+            Some(old) => match merge_kinds(old, event.kind) {
+                Some(kind) => {
+                    self.pending.insert(event.path, kind);
+                }
+                None => {
+                    self.pending.remove(&event.path);
+                }
+            },
+            None => {
+                self.pending.insert(event.path, event.kind);
+            }
+        }
+    }
+
+    /// Whether the pending batch should be released now
+    fn is_due(&self, debounce: Duration) -> bool {
+        match (self.first_event, self.last_event) {
+            (Some(first), Some(last)) => {
+                last.elapsed() >= debounce || first.elapsed() >= debounce * MAX_DELAY_FACTOR
+            }
+            _ => false,
+        }
+    }
+
+    /// Time until the pending batch becomes due (None if nothing is pending)
+    fn time_until_due(&self, debounce: Duration) -> Option<Duration> {
+        let first = self.first_event?;
+        let last = self.last_event?;
+        let quiet = debounce.saturating_sub(last.elapsed());
+        let cap = (debounce * MAX_DELAY_FACTOR).saturating_sub(first.elapsed());
+        Some(quiet.min(cap))
+    }
+
+    /// Take the pending changes, parents before children
+    fn take(&mut self) -> Vec<WatchEvent> {
+        self.first_event = None;
+        self.last_event = None;
+        let mut events: Vec<WatchEvent> = self
+            .pending
+            .drain()
+            .map(|(path, kind)| WatchEvent::new(path, kind))
+            .collect();
+        events.sort_by(|a, b| a.path.cmp(&b.path));
+        events
+    }
+}
+
+/// State shared between the watcher threads and the FFI handle
+struct WatcherShared {
+    /// Debounced events not yet handed out
+    ready: Mutex<VecDeque<WatchEvent>>,
+    ready_signal: Condvar,
+    stop: AtomicBool,
+    raw_events: AtomicU64,
+    delivered_events: AtomicU64,
+}
+
+/// Convert an OS path below the root into a watcher-relative path
+#[cfg(target_os = "macos")]
+fn relative_path(root: &Path, path: &Path) -> Option<String> {
+    let relative = path.strip_prefix(root).ok()?;
+    Some(relative.to_string_lossy().replace('\\', "/"))
+}
+
+/// Watch a tree until `stop` is set, sending raw events to `events`
+///
+/// Calls `ready` once the watch is installed. Returns an error (before calling `ready`)
+/// if the native backend is unavailable, or later if it can no longer cover the tree;
+/// either way the caller switches to the polling backend.
+#[cfg(target_os = "linux")]
+fn run_native_backend(
+    root: &Path,
+    events: &Sender<WatchEvent>,
+    stop: &AtomicBool,
+    ready: &mut dyn FnMut(),
+) -> Result<(), String> {
+    inotify::run(root, events, stop, ready)
+}
+
+#[cfg(target_os = "windows")]
+fn run_native_backend(
+    root: &Path,
+    events: &Sender<WatchEvent>,
+    stop: &AtomicBool,
+    ready: &mut dyn FnMut(),
+) -> Result<(), String> {
+    read_directory_changes::run(root, events, stop, ready)
+}
+
+#[cfg(target_os = "macos")]
+fn run_native_backend(
+    root: &Path,
+    events: &Sender<WatchEvent>,
+    stop: &AtomicBool,
+    ready: &mut dyn FnMut(),
+) -> Result<(), String> {
+    fsevents::run(root, events, stop, ready)
+}
+
+#[cfg(not(any(target_os = "linux", target_os = "windows", target_os = "macos")))]
+fn run_native_backend(
+    _root: &Path,
+    _events: &Sender<WatchEvent>,
+    _stop: &AtomicBool,
+    _ready: &mut dyn FnMut(),
+) -> Result<(), String> {
+    Err("No native change notifications on this platform".to_string())
+}
+
+/// Fallback backend: diff snapshot rescans on a timer
+fn run_polling_backend(
+    root: &Path,
+    events: &Sender<WatchEvent>,
+    stop: &AtomicBool,
+    ready: &mut dyn FnMut(),
+    interval: Duration,
+) -> Result<(), String> {
+    let root_str = root.to_string_lossy().to_string();
+    let (_, mut snapshot) = rescan_folder(&root_str, None, false)?;
+    ready();
+
+    loop {
+        let wake = Instant::now() + interval;
+        while Instant::now() < wake {
+            if stop.load(Ordering::Relaxed) {
+                return Ok(());
+            }
+            thread::sleep(Duration::from_millis(STOP_CHECK_INTERVAL_MS));
+        }
+
+        let (diff, next) = match rescan_folder(&root_str, Some(&snapshot), true) {
+            Ok(result) => result,
+            Err(_) => {
+                // Root is gone (or unreadable); report it and keep trying
+                let _ = events.send(WatchEvent::new(String::new(), WatchEventKind::Removed));
+                continue;
+            }
+        };
+        snapshot = next;
+
+        let changes = diff
+            .added
+            .into_iter()
+            .map(|item| WatchEvent::new(item.relative_path, WatchEventKind::Created))
+            .chain(diff.modified.into_iter().map(|item| WatchEvent::new(item.relative_path, WatchEventKind::Modified)))
+            .chain(diff.removed.into_iter().map(|path| WatchEvent::new(path, WatchEventKind::Removed)));
+        for event in changes {
+            if events.send(event).is_err() {
+                return Ok(());
+            }
+        }
+    }
+}
+
+/// Merge raw events and release them to `shared.ready` once debounced
+///
+/// Runs until the backend drops its sender.
+fn run_coalescer(events: Receiver<WatchEvent>, shared: Arc<WatcherShared>, debounce: Duration) {
+    let mut coalescer = Coalescer::new();
+    loop {
+        let wait = coalescer
+            .time_until_due(debounce)
+            .unwrap_or(Duration::from_millis(STOP_CHECK_INTERVAL_MS));
+        let disconnected = match events.recv_timeout(wait) {
+            Ok(event) => {
+                shared.raw_events.fetch_add(1, Ordering::Relaxed);
+                coalescer.push(event);
+                // Drain whatever else is already queued before checking the deadline
+                while let Ok(event) = events.try_recv() {
+                    shared.raw_events.fetch_add(1, Ordering::Relaxed);
+                    coalescer.push(event);
+                }
+                false
+            }
+            Err(RecvTimeoutError::Timeout) => false,
+            Err(RecvTimeoutError::Disconnected) => true,
+        };
+
+        if disconnected || coalescer.is_due(debounce) {
+            let batch = coalescer.take();
+            if !batch.is_empty() {
+                if let Ok(mut ready) = shared.ready.lock() {
+                    ready.extend(batch);
+                }
+                shared.ready_signal.notify_all();
+            }
+        }
+        if disconnected {
+            return;
+        }
+    }
+}
+
+/// Handle for a folder being watched
+pub struct FsWatcher {
+    root: PathBuf,
+    shared: Arc<WatcherShared>,
+    backend: Option<JoinHandle<()>>,
+    coalescer: Option<JoinHandle<()>>,
+}
+
+impl FsWatcher {
+    /// Start watching `root` (blocks until the watch is installed)
+    pub fn start(root: &Path, debounce: Duration) -> Result<Self, String> {
+        if !root.is_dir() {
+            return Err(format!("Path is not a directory: {}", root.display()));
+        }
+        // FSEvents reports canonical paths (e.g. /private/var for /var), so the backends
+        // watch the canonical root. Events are relative, and root() keeps the caller's form
+        // so joined paths match the ones the caller registered elsewhere.
+        let canonical_root = root.canonicalize().map_err(|e| e.to_string())?;
+        let root = root.to_path_buf();
+
+        let shared = Arc::new(WatcherShared {
+            ready: Mutex::new(VecDeque::new()),
+            ready_signal: Condvar::new(),
+            stop: AtomicBool::new(false),
+            raw_events: AtomicU64::new(0),
+            delivered_events: AtomicU64::new(0),
+        });
+
+        let (event_tx, event_rx) = mpsc::channel::<WatchEvent>();
+        let (ready_tx, ready_rx) = mpsc::channel::<()>();
+        let poll_interval = debounce.max(Duration::from_millis(MIN_POLL_INTERVAL_MS));
+
+        let backend_root = canonical_root;
+        let backend_shared = shared.clone();
+        let backend = thread::spawn(move || {
+            let mut ready = || {
+                let _ = ready_tx.send(());
+            };
+            // Also taken when the native backend gives up after it was ready
+            if run_native_backend(&backend_root, &event_tx, &backend_shared.stop, &mut ready).is_err() {
+                let _ = run_polling_backend(&backend_root, &event_tx, &backend_shared.stop, &mut ready, poll_interval);
+            }
+        });
+
+        if ready_rx.recv().is_err() {
+            // Backend exited without installing a watch
+            let _ = backend.join();
+            return Err(format!("Failed to watch {}", root.display()));
+        }
+
+        let coalescer_shared = shared.clone();
+        let coalescer = thread::spawn(move || run_coalescer(event_rx, coalescer_shared, debounce));
+
+        Ok(FsWatcher {
+            root,
+            shared,
+            backend: Some(backend),
+            coalescer: Some(coalescer),
+        })
+    }
+
+    /// Watched root as passed to `start` (event paths are relative to it)
+    pub fn root(&self) -> &Path {
+        &self.root
+    }
+
+    /// Take up to `max_events` debounced events, waiting up to `timeout` for the first one
+    pub fn next_events(&self, max_events: usize, timeout: Duration) -> Vec<WatchEvent> {
+        let deadline = Instant::now() + timeout;
+        let mut ready = match self.shared.ready.lock() {
+            Ok(ready) => ready,
+            Err(_) => return Vec::new(),
+        };
+        while ready.is_empty() {
+            let now = Instant::now();
+            if now >= deadline {
+                return Vec::new();
+            }
+            ready = match self.shared.ready_signal.wait_timeout(ready, deadline - now) {
+                Ok((ready, _)) => ready,
+                Err(_) => return Vec::new(),
+            };
+        }
+
+        let count = if max_events == 0 { ready.len() } else { max_events.min(ready.len()) };
+        let events: Vec<WatchEvent> = ready.drain(..count).collect();
+        self.shared.delivered_events.fetch_add(events.len() as u64, Ordering::Relaxed);
+        events
+    }
+
+    /// (raw OS events received, coalesced events delivered)
+    pub fn stats(&self) -> (u64, u64) {
+        (
+            self.shared.raw_events.load(Ordering::Relaxed),
+            self.shared.delivered_events.load(Ordering::Relaxed),
+        )
+    }
+
+    fn shutdown(&mut self) {
+        self.shared.stop.store(true, Ordering::Relaxed);
+        if let Some(backend) = self.backend.take() {
+            let _ = backend.join();
+        }
+        if let Some(coalescer) = self.coalescer.take() {
+            let _ = coalescer.join();
+        }
+        self.shared.ready_signal.notify_all();
+    }
+}
+
+impl Drop for FsWatcher {
+    fn drop(&mut self) {
+        self.shutdown();
+    }
+}
+
+// ============================================================================
+// Linux: inotify
+// ============================================================================
+
+#[cfg(target_os = "linux")]
+mod inotify {
+    use super::*;
+    use std::ffi::OsStr;
+    use std::io;
+    use std::os::unix::ffi::OsStrExt;
+
+    const WATCH_MASK: u32 = libc::IN_CREATE
+        | libc::IN_DELETE
+        | libc::IN_MODIFY
+        | libc::IN_CLOSE_WRITE
+        | libc::IN_ATTRIB
+        | libc::IN_MOVED_FROM
+        | libc::IN_MOVED_TO
+        | libc::IN_DELETE_SELF
+        | libc::IN_MOVE_SELF
+        | libc::IN_ONLYDIR
+        | libc::IN_DONT_FOLLOW
+        | libc::IN_EXCL_UNLINK;
+
+    const EVENT_HEADER_SIZE: usize = std::mem::size_of::<libc::inotify_event>();
+
+    struct Watches<'a> {
+        fd: i32,
+        root: &'a Path,
+        /// Watch descriptor -> relative directory path
+        dirs: HashMap<i32, String>,
+    }
+
+    impl<'a> Watches<'a> {
+        fn add_watch(&mut self, relative: &str) -> io::Result<()> {
+            let path = self.root.join(relative);
+            let c_path = CString::new(path.as_os_str().as_bytes()).map_err(|_| io::ErrorKind::InvalidInput)?;
+            let wd = unsafe { libc::inotify_add_watch(self.fd, c_path.as_ptr(), WATCH_MASK) };
+            if wd < 0 {
+                return Err(io::Error::last_os_error());
+            }
+            self.dirs.insert(wd, relative.to_string());
+            Ok(())
+        }
+
+        /// Watch `relative` and every directory below it
+        ///
+        /// With `announce`, existing entries are reported as created: they may have been
+        /// added before the watch was in place. Subdirectories that vanish or cannot be
+        /// opened are skipped, but running out of watches or descriptors is an error: the
+        /// rest of the subtree would go unwatched.
+        fn add_tree(&mut self, relative: &str, announce: Option<&Sender<WatchEvent>>) -> io::Result<()> {
+            self.add_watch(relative)?;
+            let mut pending = vec![relative.to_string()];
+            while let Some(dir) = pending.pop() {
+                let entries = match std::fs::read_dir(self.root.join(&dir)) {
+                    Ok(entries) => entries,
+                    Err(_) => continue,
+                };
+                for entry in entries.flatten() {
+                    let name = entry.file_name().to_string_lossy().to_string();
+                    let child = if dir.is_empty() { name } else { format!("{}/{}", dir, name) };
+                    if let Some(events) = announce {
+                        let _ = events.send(WatchEvent::new(child.clone(), WatchEventKind::Created));
+                    }
+                    if !entry.file_type().map(|t| t.is_dir()).unwrap_or(false) {
+                        continue;
+                    }
+                    match self.add_watch(&child) {
+                        Ok(()) => pending.push(child),
+                        Err(e) if is_watch_limit(&e) => return Err(e),
+                        Err(_) => {}
+                    }
+                }
+            }
+            Ok(())
+        }
+
+        /// Stop watching `relative` and everything below it (it was moved away)
+        fn remove_tree(&mut self, relative: &str) {
+            let prefix = format!("{}/", relative);
+            let fd = self.fd;
+            self.dirs.retain(|&wd, dir| {
+                let inside = dir == relative || dir.starts_with(&prefix);
+                if inside {
+                    unsafe { libc::inotify_rm_watch(fd, wd) };
+                }
+                !inside
+            });
+        }
+
+        /// Handle one raw event; fails only when a new directory could not be watched
+        /// for lack of watches or descriptors
+        fn handle(&mut self, wd: i32, mask: u32, name: &OsStr, events: &Sender<WatchEvent>) -> io::Result<()> {
+            if mask & libc::IN_Q_OVERFLOW != 0 {
+                let _ = events.send(WatchEvent::new(String::new(), WatchEventKind::Rescan));
+                return Ok(());
+            }
+            if mask & libc::IN_IGNORED != 0 {
+                self.dirs.remove(&wd);
+                return Ok(());
+            }
+            let dir = match self.dirs.get(&wd) {
+                Some(dir) => dir.clone(),
+                None => return Ok(()),
+            };
+
+            if name.is_empty() {
+                // Event about the watched directory itself; its parent reports the rest
+                if dir.is_empty() && mask & (libc::IN_DELETE_SELF | libc::IN_MOVE_SELF) != 0 {
+                    let _ = events.send(WatchEvent::new(String::new(), WatchEventKind::Removed));
+                }
+                return Ok(());
+            }
+
+            let name = name.to_string_lossy();
+            let path = if dir.is_empty() { name.to_string() } else { format!("{}/{}", dir, name) };
+            let is_dir = mask & libc::IN_ISDIR != 0;
+
+            if mask & (libc::IN_CREATE | libc::IN_MOVED_TO) != 0 {
+                let _ = events.send(WatchEvent::new(path.clone(), WatchEventKind::Created));
+                if is_dir {
+                    match self.add_tree(&path, Some(events)) {
+                        Err(e) if is_watch_limit(&e) => return Err(e),
+                        // Already gone again; its parent reports the removal
+                        _ => {}
+                    }
+                }
+            } else if mask & (libc::IN_DELETE | libc::IN_MOVED_FROM) != 0 {
+                if is_dir && mask & libc::IN_MOVED_FROM != 0 {
+                    self.remove_tree(&path);
+                }
+                let _ = events.send(WatchEvent::new(path, WatchEventKind::Removed));
+            } else if mask & (libc::IN_MODIFY | libc::IN_CLOSE_WRITE | libc::IN_ATTRIB) != 0 {
+                let _ = events.send(WatchEvent::new(path, WatchEventKind::Modified));
+            }
+            Ok(())
+        }
+    }
+
+    /// Out of inotify watches (ENOSPC) or file descriptors (EMFILE)
+    fn is_watch_limit(error: &io::Error) -> bool {
+        matches!(error.raw_os_error(), Some(libc::ENOSPC) | Some(libc::EMFILE))
+    }
+
+    pub(super) fn run(
+        root: &Path,
+        events: &Sender<WatchEvent>,
+        stop: &AtomicBool,
+        ready: &mut dyn FnMut(),
+    ) -> Result<(), String> {
+        let fd = unsafe { libc::inotify_init1(libc::IN_NONBLOCK | libc::IN_CLOEXEC) };
+        if fd < 0 {
+            return Err(io::Error::last_os_error().to_string());
+        }
+
+        let mut watches = Watches { fd, root, dirs: HashMap::new() };
+        if let Err(e) = watches.add_tree("", None) {
+            unsafe { libc::close(fd) };
+            return Err(e.to_string());
+        }
+        ready();
+
+        // u64 storage keeps the buffer aligned for inotify_event
+        let mut buffer = vec![0u64; 8192];
+        let buffer_len = buffer.len() * 8;
+
+        let mut result = Ok(());
+        'watch: while !stop.load(Ordering::Relaxed) {
+            let mut poll_fd = libc::pollfd { fd, events: libc::POLLIN, revents: 0 };
+            let ready_fds = unsafe { libc::poll(&mut poll_fd, 1, STOP_CHECK_INTERVAL_MS as i32) };
+            if ready_fds <= 0 {
+                continue;
+            }
+
+            let bytes_read = unsafe { libc::read(fd, buffer.as_mut_ptr() as *mut libc::c_void, buffer_len) };
+            if bytes_read <= 0 {
+                continue;
+            }
+
+            let bytes = unsafe { std::slice::from_raw_parts(buffer.as_ptr() as *const u8, bytes_read as usize) };
+            let mut offset = 0usize;
+            while offset + EVENT_HEADER_SIZE <= bytes.len() {
+                let event = unsafe { ptr::read_unaligned(bytes.as_ptr().add(offset) as *const libc::inotify_event) };
+                let name_start = offset + EVENT_HEADER_SIZE;
+                let name_end = (name_start + event.len as usize).min(bytes.len());
+                let raw_name = &bytes[name_start..name_end];
+                let name_len = raw_name.iter().position(|&b| b == 0).unwrap_or(raw_name.len());
+                if let Err(e) = watches.handle(event.wd, event.mask, OsStr::from_bytes(&raw_name[..name_len]), events) {
+                    // Part of the tree is unwatched; the polling backend takes over from a
+                    // fresh snapshot, so whatever happened until then needs a rescan
+                    let _ = events.send(WatchEvent::new(String::new(), WatchEventKind::Rescan));
+                    result = Err(e.to_string());
+                    break 'watch;
+                }
+                offset = name_end;
+            }
+        }
+
+        unsafe { libc::close(fd) };
+        result
+    }
+}
+
+// ============================================================================
+// Windows: ReadDirectoryChangesW
+// ============================================================================
+
+#[cfg(target_os = "windows")]
+mod read_directory_changes {
+    use super::*;
+    use std::ffi::c_void;
+    use std::io;
+    use std::os::windows::ffi::OsStrExt;
+
+    type Handle = *mut c_void;
+
+    const INVALID_HANDLE_VALUE: Handle = -1isize as Handle;
+    const FILE_LIST_DIRECTORY: u32 = 0x0001;
+    const FILE_SHARE_ALL: u32 = 0x0001 | 0x0002 | 0x0004; // read | write | delete
+    const OPEN_EXISTING: u32 = 3;
+    const FILE_FLAG_BACKUP_SEMANTICS: u32 = 0x0200_0000;
+    const FILE_FLAG_OVERLAPPED: u32 = 0x4000_0000;
+    const NOTIFY_FILTER: u32 = 0x0001 | 0x0002 | 0x0008 | 0x0010; // file name | dir name | size | last write
+    const WAIT_OBJECT_0: u32 = 0;
+
+    const FILE_ACTION_ADDED: u32 = 1;
+    const FILE_ACTION_REMOVED: u32 = 2;
+    const FILE_ACTION_MODIFIED: u32 = 3;
+    const FILE_ACTION_RENAMED_OLD_NAME: u32 = 4;
+    const FILE_ACTION_RENAMED_NEW_NAME: u32 = 5;
+
+    /// Notification buffer size (network shares reject more than 64KB)
+    const BUFFER_SIZE: usize = 64 * 1024;
+
+    #[repr(C)]
+    struct Overlapped {
+        internal: usize,
+        internal_high: usize,
+        offset: u32,
+        offset_high: u32,
+        event: Handle,
+    }
+
+    extern "system" {
+        fn CreateFileW(
+            file_name: *const u16,
+            desired_access: u32,
+            share_mode: u32,
+            security_attributes: *mut c_void,
+            creation_disposition: u32,
+            flags_and_attributes: u32,
+            template_file: Handle,
+        ) -> Handle;
+        fn ReadDirectoryChangesW(
+            directory: Handle,
+            buffer: *mut c_void,
+            buffer_length: u32,
+            watch_subtree: i32,
+            notify_filter: u32,
+            bytes_returned: *mut u32,
+            overlapped: *mut Overlapped,
+            completion_routine: *mut c_void,
+        ) -> i32;
+        fn GetOverlappedResult(file: Handle, overlapped: *mut Overlapped, bytes_transferred: *mut u32, wait: i32) -> i32;
+        fn CreateEventW(attributes: *mut c_void, manual_reset: i32, initial_state: i32, name: *const u16) -> Handle;
+        fn WaitForSingleObject(handle: Handle, milliseconds: u32) -> u32;
+        fn CancelIoEx(file: Handle, overlapped: *mut Overlapped) -> i32;
+        fn CloseHandle(handle: Handle) -> i32;
+    }
+
+    pub(super) fn run(
+        root: &Path,
+        events: &Sender<WatchEvent>,
+        stop: &AtomicBool,
+        ready: &mut dyn FnMut(),
+    ) -> Result<(), String> {
+        let wide_path: Vec<u16> = root.as_os_str().encode_wide().chain(std::iter::once(0)).collect();
+        let directory = unsafe {
+            CreateFileW(
+                wide_path.as_ptr(),
+                FILE_LIST_DIRECTORY,
+                FILE_SHARE_ALL,
+                ptr::null_mut(),
+                OPEN_EXISTING,
+                FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+                ptr::null_mut(),
+            )
+        };
+        if directory == INVALID_HANDLE_VALUE {
+            return Err(io::Error::last_os_error().to_string());
+        }
+        let event = unsafe { CreateEventW(ptr::null_mut(), 0, 0, ptr::null()) };
+        if event.is_null() {
+            unsafe { CloseHandle(directory) };
+            return Err(io::Error::last_os_error().to_string());
+        }
+
+        // u32 storage keeps FILE_NOTIFY_INFORMATION records DWORD-aligned
+        let mut buffer = vec![0u32; BUFFER_SIZE / 4];
+        let mut overlapped = Overlapped { internal: 0, internal_high: 0, offset: 0, offset_high: 0, event };
+        let mut result = Ok(());
+        let mut announced = false;
+
+        'watch: while !stop.load(Ordering::Relaxed) {
+            let issued = unsafe {
+                ReadDirectoryChangesW(
+                    directory,
+                    buffer.as_mut_ptr() as *mut c_void,
+                    BUFFER_SIZE as u32,
+                    1,
+                    NOTIFY_FILTER,
+                    ptr::null_mut(),
+                    &mut overlapped,
+                    ptr::null_mut(),
+                )
+            };
+            if issued == 0 {
+                if !announced {
+                    result = Err(io::Error::last_os_error().to_string());
+                }
+                break;
+            }
+            if !announced {
+                announced = true;
+                ready();
+            }
+
+            // Wait for the read to complete, checking the stop flag in between
+            loop {
+                if stop.load(Ordering::Relaxed) {
+                    unsafe {
+                        CancelIoEx(directory, &mut overlapped);
+                        let mut ignored = 0u32;
+                        GetOverlappedResult(directory, &mut overlapped, &mut ignored, 1);
+                    }
+                    break 'watch;
+                }
+                if unsafe { WaitForSingleObject(event, STOP_CHECK_INTERVAL_MS as u32) } == WAIT_OBJECT_0 {
+                    break;
+                }
+            }
+
+            let mut bytes_returned = 0u32;
+            if unsafe { GetOverlappedResult(directory, &mut overlapped, &mut bytes_returned, 0) } == 0 {
+                break;
+            }
+            if bytes_returned == 0 {
+                // The kernel buffer overflowed and the changes were dropped
+                let _ = events.send(WatchEvent::new(String::new(), WatchEventKind::Rescan));
+                continue;
+            }
+
+            let bytes = unsafe { std::slice::from_raw_parts(buffer.as_ptr() as *const u8, bytes_returned as usize) };
+            let mut offset = 0usize;
+            while offset + 12 <= bytes.len() {
+                let read_u32 = |at: usize| u32::from_le_bytes([bytes[at], bytes[at + 1], bytes[at + 2], bytes[at + 3]]);
+                let next_entry = read_u32(offset) as usize;
+                let action = read_u32(offset + 4);
+                let name_len = read_u32(offset + 8) as usize;
+                let name_end = (offset + 12 + name_len).min(bytes.len());
+                let name: Vec<u16> = bytes[offset + 12..name_end]
+                    .chunks_exact(2)
+                    .map(|c| u16::from_le_bytes([c[0], c[1]]))
+                    .collect();
+                let path = String::from_utf16_lossy(&name).replace('\\', "/");
+
+                let kind = match action {
+                    FILE_ACTION_ADDED | FILE_ACTION_RENAMED_NEW_NAME => Some(WatchEventKind::Created),
+                    FILE_ACTION_REMOVED | FILE_ACTION_RENAMED_OLD_NAME => Some(WatchEventKind::Removed),
+                    FILE_ACTION_MODIFIED => Some(WatchEventKind::Modified),
+                    _ => None,
+                };
+                if let Some(kind) = kind {
+                    let _ = events.send(WatchEvent::new(path, kind));
+                }
+
+                if next_entry == 0 {
+                    break;
+                }
+                offset += next_entry;
+            }
+        }
+
+        unsafe {
+            CloseHandle(event);
+            CloseHandle(directory);
+        }
+        result
+    }
+}
+
+// ============================================================================
+// macOS: FSEvents
+// ============================================================================
+
+#[cfg(target_os = "macos")]
+mod fsevents {
+    use super::*;
+    use std::ffi::c_void;
+    use std::os::raw::c_double;
+
+    type CFIndex = isize;
+    type CFRef = *const c_void;
+
+    const CF_STRING_ENCODING_UTF8: u32 = 0x0800_0100;
+    const EVENT_ID_SINCE_NOW: u64 = 0xFFFF_FFFF_FFFF_FFFF;
+    const CREATE_FLAG_NO_DEFER: u32 = 0x0000_0002;
+    const CREATE_FLAG_FILE_EVENTS: u32 = 0x0000_0010;
+    /// FSEvents' own coalescing latency; the watcher debounce comes on top
+    const STREAM_LATENCY_SECONDS: c_double = 0.05;
+
+    const FLAG_MUST_SCAN_SUBDIRS: u32 = 0x0000_0001;
+    const FLAG_USER_DROPPED: u32 = 0x0000_0002;
+    const FLAG_KERNEL_DROPPED: u32 = 0x0000_0004;
+    const FLAG_ROOT_CHANGED: u32 = 0x0000_0020;
+    const FLAG_ITEM_CREATED: u32 = 0x0000_0100;
+    const FLAG_ITEM_RENAMED: u32 = 0x0000_0800;
+
+    #[repr(C)]
+    struct StreamContext {
+        version: CFIndex,
+        info: *mut c_void,
+        retain: *const c_void,
+        release: *const c_void,
+        copy_description: *const c_void,
+    }
+
+    type StreamCallback = extern "C" fn(
+        stream: CFRef,
+        info: *mut c_void,
+        num_events: usize,
+        event_paths: *mut c_void,
+        event_flags: *const u32,
+        event_ids: *const u64,
+    );
+
+    #[link(name = "CoreFoundation", kind = "framework")]
+    extern "C" {
+        static kCFTypeArrayCallBacks: c_void;
+        fn CFStringCreateWithCString(allocator: CFRef, string: *const c_char, encoding: u32) -> CFRef;
+        fn CFArrayCreate(allocator: CFRef, values: *const CFRef, count: CFIndex, callbacks: *const c_void) -> CFRef;
+        fn CFRelease(object: CFRef);
+    }
+
+    #[link(name = "CoreServices", kind = "framework")]
+    extern "C" {
+        fn FSEventStreamCreate(
+            allocator: CFRef,
+            callback: StreamCallback,
+            context: *mut StreamContext,
+            paths: CFRef,
+            since_when: u64,
+            latency: c_double,
+            flags: u32,
+        ) -> CFRef;
+        fn FSEventStreamSetDispatchQueue(stream: CFRef, queue: *mut c_void);
+        fn FSEventStreamStart(stream: CFRef) -> u8;
+        fn FSEventStreamStop(stream: CFRef);
+        fn FSEventStreamInvalidate(stream: CFRef);
+        fn FSEventStreamRelease(stream: CFRef);
+    }
+
+    extern "C" {
+        fn dispatch_queue_create(label: *const c_char, attr: *const c_void) -> *mut c_void;
+        fn dispatch_release(object: *mut c_void);
+    }
+
+    struct CallbackState {
+        root: PathBuf,
+        events: Sender<WatchEvent>,
+    }
+
+    extern "C" fn on_events(
+        _stream: CFRef,
+        info: *mut c_void,
+        num_events: usize,
+        event_paths: *mut c_void,
+        event_flags: *const u32,
+        _event_ids: *const u64,
+    ) {
+        let state = unsafe { &*(info as *const CallbackState) };
+        let paths = unsafe { std::slice::from_raw_parts(event_paths as *const *const c_char, num_events) };
+        let flags = unsafe { std::slice::from_raw_parts(event_flags, num_events) };
+
+        for (&path, &flag) in paths.iter().zip(flags) {
+            let path = PathBuf::from(unsafe { CStr::from_ptr(path) }.to_string_lossy().to_string());
+            let relative = match relative_path(&state.root, &path) {
+                Some(relative) => relative,
+                None => continue,
+            };
+
+            let kind = if flag & (FLAG_MUST_SCAN_SUBDIRS | FLAG_USER_DROPPED | FLAG_KERNEL_DROPPED | FLAG_ROOT_CHANGED) != 0 {
+                WatchEventKind::Rescan
+            } else if std::fs::symlink_metadata(&path).is_err() {
+                // FSEvents merges flags per path; what matters is whether it exists now
+                WatchEventKind::Removed
+            } else if flag & (FLAG_ITEM_CREATED | FLAG_ITEM_RENAMED) != 0 {
+                WatchEventKind::Created
+            } else {
+                WatchEventKind::Modified
+            };
+            let _ = state.events.send(WatchEvent::new(relative, kind));
+        }
+    }
+
+    pub(super) fn run(
+        root: &Path,
+        events: &Sender<WatchEvent>,
+        stop: &AtomicBool,
+        ready: &mut dyn FnMut(),
+    ) -> Result<(), String> {
+        let c_root = CString::new(root.to_string_lossy().as_bytes()).map_err(|e| e.to_string())?;
+        let state = Box::into_raw(Box::new(CallbackState {
+            root: root.to_path_buf(),
+            events: events.clone(),
+        }));
+
+        unsafe {
+            let cf_root = CFStringCreateWithCString(ptr::null(), c_root.as_ptr(), CF_STRING_ENCODING_UTF8);
+            let paths = CFArrayCreate(ptr::null(), &cf_root, 1, &kCFTypeArrayCallBacks as *const c_void);
+            CFRelease(cf_root);
+
+            let mut context = StreamContext {
+                version: 0,
+                info: state as *mut c_void,
+                retain: ptr::null(),
+                release: ptr::null(),
+                copy_description: ptr::null(),
+            };
+            let stream = FSEventStreamCreate(
+                ptr::null(),
+                on_events,
+                &mut context,
+                paths,
+                EVENT_ID_SINCE_NOW,
+                STREAM_LATENCY_SECONDS,
+                CREATE_FLAG_FILE_EVENTS | CREATE_FLAG_NO_DEFER,
+            );
+            CFRelease(paths);
+            if stream.is_null() {
+                drop(Box::from_raw(state));
+                return Err("FSEventStreamCreate failed".to_string());
+            }
+
+            let queue = dispatch_queue_create(b"cloudnexus.fswatcher\0".as_ptr() as *const c_char, ptr::null());
+            FSEventStreamSetDispatchQueue(stream, queue);
+            if FSEventStreamStart(stream) == 0 {
+                FSEventStreamInvalidate(stream);
+                FSEventStreamRelease(stream);
+                dispatch_release(queue);
+                drop(Box::from_raw(state));
+                return Err("FSEventStreamStart failed".to_string());
+            }
+            ready();
+
+            while !stop.load(Ordering::Relaxed) {
+                thread::sleep(Duration::from_millis(STOP_CHECK_INTERVAL_MS));
+            }
+
+            // After invalidation no further callbacks run, so the state can be freed
+            FSEventStreamStop(stream);
+            FSEventStreamInvalidate(stream);
+            FSEventStreamRelease(stream);
+            dispatch_release(queue);
+            drop(Box::from_raw(state));
+        }
+        Ok(())
+    }
+}
+
+// ============================================================================
+// FFI
+// ============================================================================
+
+/// Start watching a folder tree for changes
+///
+/// # Arguments
+/// * `folder_path` - Path to the folder to watch (null-terminated)
+/// * `debounce_ms` - Quiet period before changes are released (0 = 200ms)
+///
+/// # Returns
+/// Pointer to FsWatcher (free with fs_watcher_free), or null if the path is not a
+/// directory or cannot be watched
+#[no_mangle]
+pub extern "C" fn fs_watcher_start(folder_path: *const c_char, debounce_ms: u32) -> *mut FsWatcher {
+    if folder_path.is_null() {
+        return ptr::null_mut();
+    }
+
+    let path_str = match unsafe { CStr::from_ptr(folder_path).to_str() } {
+        Ok(s) => s,
+        Err(_) => return ptr::null_mut(),
+    };
+    let debounce = Duration::from_millis(if debounce_ms == 0 { DEFAULT_DEBOUNCE_MS } else { debounce_ms as u64 });
+
+    match FsWatcher::start(Path::new(path_str), debounce) {
+        Ok(watcher) => Box::leak(Box::new(watcher)) as *mut FsWatcher,
+        Err(_) => ptr::null_mut(),
+    }
+}
+
+/// Take the next debounced changes as a JSON array
+///
+/// # Arguments
+/// * `watcher` - Pointer to FsWatcher
+/// * `max_events` - Maximum number of events to return (0 = all available)
+/// * `timeout_ms` - Maximum time to wait for changes (0 = don't wait)
+/// * `output_len` - Pointer to store output length
+///
+/// # Returns
+/// Pointer to JSON string (caller must free with scan_folder_free_string); "[]" if nothing
+/// changed within the timeout, null on error
+#[no_mangle]
+pub extern "C" fn fs_watcher_next_events(
+    watcher: *mut FsWatcher,
+    max_events: u32,
+    timeout_ms: u32,
+    output_len: *mut usize,
+) -> *mut c_char {
+    if watcher.is_null() {
+        return ptr::null_mut();
+    }
+
+    let watcher = unsafe { &*watcher };
+    let events = watcher.next_events(max_events as usize, Duration::from_millis(timeout_ms as u64));
+    let json = match serde_json::to_string(&events) {
+        Ok(json) => json,
+        Err(_) => return ptr::null_mut(),
+    };
+
+    let c_string = match CString::new(json) {
+        Ok(c_string) => c_string,
+        Err(_) => return ptr::null_mut(),
+    };
+    if !output_len.is_null() {
+        unsafe { *output_len = c_string.as_bytes_with_nul().len() };
+    }
+    c_string.into_raw()
+}
+
+/// Get watcher statistics
+///
+/// # Arguments
+/// * `watcher` - Pointer to FsWatcher
+/// * `raw_events` - Pointer to store the number of OS events received (can be null)
+/// * `delivered_events` - Pointer to store the number of coalesced events handed out (can be null)
+///
+/// # Returns
+/// 0 on success, error code on failure
+#[no_mangle]
+pub extern "C" fn fs_watcher_get_stats(
+    watcher: *mut FsWatcher,
+    raw_events: *mut u64,
+    delivered_events: *mut u64,
+) -> i32 {
+    if watcher.is_null() {
+        return ERROR_NULL_POINTER;
+    }
+
+    let (raw, delivered) = unsafe { (&*watcher).stats() };
+    unsafe {
+        if !raw_events.is_null() {
+            *raw_events = raw;
+        }
+        if !delivered_events.is_null() {
+            *delivered_events = delivered;
+        }
+    }
+    0
+}
+
+/// Stop watching and free the watcher
+#[no_mangle]
+pub extern "C" fn fs_watcher_free(watcher: *mut FsWatcher) {
+    if !watcher.is_null() {
+        unsafe {
+            let _ = Box::from_raw(watcher);
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::fs;
+
+    #[test]
+    fn test_coalescer_merges_per_path() {
+        let mut coalescer = Coalescer::new();
+        coalescer.push(WatchEvent::new("a.txt".into(), WatchEventKind::Created));
+        coalescer.push(WatchEvent::new("a.txt".into(), WatchEventKind::Modified));
+        coalescer.push(WatchEvent::new("tmp".into(), WatchEventKind::Created));
+        coalescer.push(WatchEvent::new("tmp".into(), WatchEventKind::Removed));
+        coalescer.push(WatchEvent::new("b.txt".into(), WatchEventKind::Removed));
+        coalescer.push(WatchEvent::new("b.txt".into(), WatchEventKind::Created));
+
+        assert!(!coalescer.is_due(Duration::from_secs(60)));
+        assert!(coalescer.is_due(Duration::ZERO));
+        assert_eq!(
+            coalescer.take(),
+            vec![
+                WatchEvent::new("a.txt".into(), WatchEventKind::Created),
+                WatchEvent::new("b.txt".into(), WatchEventKind::Modified),
+            ]
+        );
+        assert!(coalescer.time_until_due(Duration::ZERO).is_none());
+    }
+
+    #[test]
+    fn test_watcher_reports_changes() {
+        let root = std::env::temp_dir().join(format!("cn_watcher_{}", std::process::id()));
+        let _ = fs::remove_dir_all(&root);
+        fs::create_dir_all(&root).unwrap();
+        fs::write(root.join("existing.txt"), b"old").unwrap();
+
+        let watcher = FsWatcher::start(&root, Duration::from_millis(50)).unwrap();
+        fs::write(root.join("existing.txt"), b"new contents").unwrap();
+        fs::create_dir(root.join("sub")).unwrap();
+        fs::write(root.join("sub/new.txt"), b"x").unwrap();
+
+        let deadline = Instant::now() + Duration::from_secs(10);
+        let mut seen: HashMap<String, WatchEventKind> = HashMap::new();
+        while Instant::now() < deadline && !(seen.contains_key("existing.txt") && seen.contains_key("sub/new.txt")) {
+            for event in watcher.next_events(0, Duration::from_millis(200)) {
+                seen.entry(event.path).or_insert(event.kind);
+            }
+        }
+
+        assert_eq!(seen.get("existing.txt"), Some(&WatchEventKind::Modified));
+        assert_eq!(seen.get("sub"), Some(&WatchEventKind::Created));
+        assert_eq!(seen.get("sub/new.txt"), Some(&WatchEventKind::Created));
+
+        let (raw, delivered) = watcher.stats();
+        assert!(delivered >= 3 && raw >= delivered);
+
+        drop(watcher);
+        let _ = fs::remove_dir_all(&root);
+    }
+
+    #[cfg(unix)]
+    #[test]
+    fn test_watch_events_resolve_through_symlinked_root() {
+        use crate::search::{incremental_indexer_apply_watch_events, IncrementalIndexer};
+
+        let base = std::env::temp_dir().join(format!("cn_watcher_link_{}", std::process::id()));
+        let _ = fs::remove_dir_all(&base);
+        fs::create_dir_all(base.join("real")).unwrap();
+        fs::write(base.join("real/doc.txt"), b"v1").unwrap();
+        std::os::unix::fs::symlink(base.join("real"), base.join("link")).unwrap();
+
+        // Node paths are registered in the form the caller uses, not the canonical one
+        let link = base.join("link");
+        let mut indexer = IncrementalIndexer::new();
+        indexer.set_node_path("doc".to_string(), link.join("doc.txt"));
+        let mut watcher = FsWatcher::start(&link, Duration::from_millis(50)).unwrap();
+        assert_eq!(watcher.root(), link.as_path());
+
+        fs::write(base.join("real/doc.txt"), b"v2").unwrap();
+        let deadline = Instant::now() + Duration::from_secs(10);
+        let mut marked = 0;
+        while marked == 0 && Instant::now() < deadline {
+            let batch = fs_watcher_next_events(&mut watcher, 0, 200, ptr::null_mut());
+            assert!(!batch.is_null());
+            marked = incremental_indexer_apply_watch_events(&mut indexer, &watcher, batch);
+            // The batch is still the caller's, e.g. for the sync engine
+            let events: Vec<WatchEvent> =
+                serde_json::from_str(unsafe { CStr::from_ptr(batch) }.to_str().unwrap()).unwrap();
+            if marked > 0 {
+                assert!(events.iter().any(|e| e.path == "doc.txt"));
+            }
+            crate::scan::scan_folder_free_string(batch);
+        }
+        assert_eq!(marked, 1);
+
+        drop(watcher);
+        let _ = fs::remove_dir_all(&base);
+    }
+}
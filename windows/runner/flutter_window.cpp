@@ -1,15 +1,42 @@
 #include "flutter_window.h"
 
 #include <optional>
+#include <thread>
 
 #include "flutter/generated_plugin_registrant.h"
 
+namespace {
+
+// Exported by cloud_nexus_encryption.dll (native/src/preload.rs).
+using PreloadStartFunc = int32_t (*)();
+
+// Loads the native library and lets it warm up while the engine starts. The
+// module is never freed, so Dart's DynamicLibrary.open reuses the loaded copy.
+void StartNativePreload() {
+  std::thread([]() {
+    HMODULE library = LoadLibraryW(L"cloud_nexus_encryption.dll");
+    if (!library) {
+      return;
+    }
+    auto preload_start = reinterpret_cast<PreloadStartFunc>(
+        GetProcAddress(library, "cloud_nexus_preload_start"));
+    if (preload_start) {
+      preload_start();
+    }
+  }).detach();
+}
+
+}  // namespace
+
 FlutterWindow::FlutterWindow(const flutter::DartProject& project)
     : project_(project) {}
 
 FlutterWindow::~FlutterWindow() {}
 
 bool FlutterWindow::OnCreate() {
+  // Kick this off first so it overlaps with engine creation.
+  StartNativePreload();
+
   if (!Win32Window::OnCreate()) {
     return false;
   }